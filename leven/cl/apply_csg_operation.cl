@@ -13,6 +13,11 @@ typedef struct CSGOperation_s
 }
 CSGOperation;
 
+// names the variant of a brush function or kernel for BRUSH_SHAPE, see cl/csg_brush.cl
+#define BRUSH_FN_PASTE(name, shape) name##_##shape
+#define BRUSH_FN_EXPAND(name, shape) BRUSH_FN_PASTE(name, shape)
+#define BRUSH_FN(name) BRUSH_FN_EXPAND(name, BRUSH_SHAPE)
+
 // ---------------------------------------------------------------------------
 
 float4 RotateX(const float4 v, const float angle)
@@ -69,144 +74,52 @@ float Density_Cuboid(
 
 // ---------------------------------------------------------------------------
 
-float BrushDensity(
-	const float4 worldspaceOffset, 
-	const CSGOperation* op)
-{
-	float brushDensity[NUM_CSG_BRUSHES] = { FLT_MAX, FLT_MAX };
-	brushDensity[0] = Density_Cuboid(worldspaceOffset, op->origin, op->dimensions, op->rotateY);
-	brushDensity[1] = Density_Sphere(worldspaceOffset, op->origin, op->dimensions.x);
+// the brush densities, each variant of the brush kernels (see cl/csg_brush.cl) 
+// evaluates a single shape so there is no per sample switch on the op's shape. The
+// dimensions are the brush's half size, see CalcCSGOperationBounds
 
-	return brushDensity[op->brushFunction];
+float3 BrushLocalPos(const float4 world_pos, const CSGOperation* op)
+{
+	float3 p = (world_pos - op->origin).xyz;
+	float2 pxz = p.xz;
+	pR(&pxz, op->rotateY);
+	p.xz = pxz;
+	return p;
 }
 
-// ---------------------------------------------------------------------------
-
-// "concatenate" the brush operations to get the final density for the brush in isolation
-float BrushZeroCrossing(
-	const float4 p0, 
-	const float4 p1, 
-	const int numOperations,
-	global const CSGOperation* operations)
+float BrushDensity_Cube(const float4 world_pos, const CSGOperation* op)
 {
-	float minDensity = FLT_MAX;
-	float crossing = 0.f;
-	for (float t = 0.f; t <= 1.f; t += (1.f/16.f))
-	{
-		const float4 p = mix(p0, p1, t);
-		for (int i = 0; i < numOperations; i++)
-		{
-			const CSGOperation op = operations[i];
-			const float d = fabs(BrushDensity(p, &op));
-			if (d < minDensity)
-			{
-				crossing = t;
-				minDensity = d;
-			}
-		}
-	}
-
-	return crossing;
+	return Density_Cuboid(world_pos, op->origin, op->dimensions, op->rotateY);
 }
 
-// ---------------------------------------------------------------------------
-
-int BrushMaterial(
-	const float4 world_pos, 
-	const int numOperations,
-	global const CSGOperation* operations,
-	const int material)
+float BrushDensity_Sphere(const float4 world_pos, const CSGOperation* op)
 {
-	int m = material;
-
-	for (int i = 0; i < numOperations; i++)
-	{
-		const CSGOperation op = operations[i];
-
-		const int operationMaterial[2] =
-		{
-			op.brushMaterial,
-			MATERIAL_AIR,
-		};
-
-		const float d = BrushDensity(world_pos, &op);
-		if (d <= 0.f)
-		{
-			m = operationMaterial[op.type];
-		}
-	}
-
-	return m;
+	return Density_Sphere(world_pos, op->origin, op->dimensions.x);
 }
 
-// ---------------------------------------------------------------------------
-
-float3 BrushNormal(
-	const float4 world_pos, 
-	const int numOperations,
-	global const CSGOperation* operations)
+// upright, i.e. the caps are at +/- dimensions.y
+float BrushDensity_Capsule(const float4 world_pos, const CSGOperation* op)
 {
-	float3 normal = { 0.f, 0.f, 0.f };
-	for (int i = 0; i < numOperations; i++)
-	{
-		const CSGOperation op = operations[i];
-		const float d = BrushDensity(world_pos, &op);
-		if (d > 0.f)
-		{
-		//	 flip = operationType[i] == 0 ? 1.f : -1.f;
-			continue;
-		}
-
-		const float h = 0.001f;
-		const float dx0 = BrushDensity(world_pos + (float4)(h, 0, 0, 0), &op);
-		const float dx1 = BrushDensity(world_pos - (float4)(h, 0, 0, 0), &op);
-
-		const float dy0 = BrushDensity(world_pos + (float4)(0, h, 0, 0), &op);
-		const float dy1 = BrushDensity(world_pos - (float4)(0, h, 0, 0), &op);
-		
-		const float dz0 = BrushDensity(world_pos + (float4)(0, 0, h, 0), &op);
-		const float dz1 = BrushDensity(world_pos - (float4)(0, 0, h, 0), &op);
-
-		const float flip = op.type == 0 ? 1.f : -1.f;
-		normal = flip * normalize((float3)(dx0 - dx1, dy0 - dy1, dz0 - dz1));
-	}
+	const float radius = op->dimensions.x;
+	return fCapsule(BrushLocalPos(world_pos, op), radius, max(op->dimensions.y - radius, 0.f));
+}
 
-	return normal;
+// in the XZ plane
+float BrushDensity_Torus(const float4 world_pos, const CSGOperation* op)
+{
+	const float smallRadius = min(op->dimensions.y, op->dimensions.x * 0.5f);
+	return fTorus(BrushLocalPos(world_pos, op), smallRadius, op->dimensions.x - smallRadius);
 }
 
-// ---------------------------------------------------------------------------
+float BrushDensity_Cylinder(const float4 world_pos, const CSGOperation* op)
+{
+	return fCylinder(BrushLocalPos(world_pos, op), op->dimensions.x, op->dimensions.y);
+}
 
-kernel
-void CSG_HermiteIndices(
-	const int4 worldspaceOffset,
-	const int numOperations,
-	global const CSGOperation* operations,
-	const int sampleScale,
-	global const int* field_materials,
-	global int* updated_indices,
-	global int4* updated_positions,
-	global int* updatedMaterials)
+float BrushDensity_RoundedBox(const float4 world_pos, const CSGOperation* op)
 {
-	const int x = get_global_id(0);
-	const int y = get_global_id(1);
-	const int z = get_global_id(2);
-	const int4 local_pos = { x, y, z, 0 };
-
-	const int sx = sampleScale * x;
-	const int sy = sampleScale * y;
-	const int sz = sampleScale * z;
-
-	const int index = field_index(local_pos);
-	const int oldMaterial = field_materials[index];
-	int material = field_materials[index];
-
-	const float4 world_pos = { worldspaceOffset.x + sx, worldspaceOffset.y + sy, worldspaceOffset.z + sz, 0 };
-	material = BrushMaterial(world_pos, numOperations, operations, material);
-
-	const int updated = material != oldMaterial;
-	updated_indices[index] = updated;
-	updated_positions[index] = local_pos;
-	updatedMaterials[index] = material;
+	const float radius = 0.25f * vmin3(op->dimensions.xyz);
+	return fBox(BrushLocalPos(world_pos, op), op->dimensions.xyz - radius) - radius;
 }
 
 // ---------------------------------------------------------------------------
@@ -438,42 +351,3 @@ kernel void CompactFieldEdges(
 
 // ---------------------------------------------------------------------------
 
-// TODO this is almost identical to the FindEdgeIntersectionInfo in density_field.cl except it uses 
-// the BrushDensity func rather than DensityFunc
-kernel void FindEdgeIntersectionInfo(
-	const int4 offset,
-	const int numOperations,
-	global const CSGOperation* operations,
-	const int sampleScale,
-	global const int* compactEdges,
-	global float4* normals)
-{
-	const int index = get_global_id(0);
-	const int globalEdgeIndex = compactEdges[index];
-
-	const int edgeIndex = 4 * (globalEdgeIndex & 3);
-	const int voxelIndex = globalEdgeIndex >> 2;
-
-	const int4 local_pos =
-	{
-		(voxelIndex >> (VOXEL_INDEX_SHIFT * 0)) & VOXEL_INDEX_MASK,
-		(voxelIndex >> (VOXEL_INDEX_SHIFT * 1)) & VOXEL_INDEX_MASK,
-		(voxelIndex >> (VOXEL_INDEX_SHIFT * 2)) & VOXEL_INDEX_MASK,
-		0
-	};
-
-	const int e0 = EDGE_MAP[edgeIndex][0];
-	const int e1 = EDGE_MAP[edgeIndex][1];
-
-	const int4 world_pos = (sampleScale * local_pos) + offset;
-	const float4 p0 = convert_float4(world_pos + CHILD_MIN_OFFSETS[e0]);
-	const float4 p1 = convert_float4(world_pos + (sampleScale * CHILD_MIN_OFFSETS[e1]));
-
-	const float t = BrushZeroCrossing(p0, p1, numOperations, operations);
-	const float4 p = mix(p0, p1, t);
-
-	const float3 n = BrushNormal(p, numOperations, operations);
-	normals[index] = (float4)(n, t);
-} 
-
-
@@ -0,0 +1,188 @@
+// ---------------------------------------------------------------------------
+// The brush functions and kernels, included once per brush shape by the source
+// generated in Compute_CreateMeshGenContext with BRUSH_SHAPE set to the shape's
+// name, e.g. CSG_HermiteIndices_Sphere uses BrushDensity_Sphere. The kernels only
+// evaluate the ops in operationIndices, the operations buffer holds the whole
+// batch and is shared by every node the batch touches.
+// ---------------------------------------------------------------------------
+
+#define BRUSH_DENSITY BRUSH_FN(BrushDensity)
+
+// "concatenate" the brush operations to get the final density for the brush in isolation
+float BRUSH_FN(BrushZeroCrossing)(
+	const float4 p0, 
+	const float4 p1, 
+	const int numOperations,
+	global const int* operationIndices,
+	global const CSGOperation* operations)
+{
+	float minDensity = FLT_MAX;
+	float crossing = 0.f;
+	for (float t = 0.f; t <= 1.f; t += (1.f/16.f))
+	{
+		const float4 p = mix(p0, p1, t);
+		for (int i = 0; i < numOperations; i++)
+		{
+			const CSGOperation op = operations[operationIndices[i]];
+			const float d = fabs(BRUSH_DENSITY(p, &op));
+			if (d < minDensity)
+			{
+				crossing = t;
+				minDensity = d;
+			}
+		}
+	}
+
+	return crossing;
+}
+
+// ---------------------------------------------------------------------------
+
+int BRUSH_FN(BrushMaterial)(
+	const float4 world_pos, 
+	const int numOperations,
+	global const int* operationIndices,
+	global const CSGOperation* operations,
+	const int material)
+{
+	int m = material;
+
+	for (int i = 0; i < numOperations; i++)
+	{
+		const CSGOperation op = operations[operationIndices[i]];
+
+		const int operationMaterial[2] =
+		{
+			op.brushMaterial,
+			MATERIAL_AIR,
+		};
+
+		const float d = BRUSH_DENSITY(world_pos, &op);
+		if (d <= 0.f)
+		{
+			m = operationMaterial[op.type];
+		}
+	}
+
+	return m;
+}
+
+// ---------------------------------------------------------------------------
+
+float3 BRUSH_FN(BrushNormal)(
+	const float4 world_pos, 
+	const int numOperations,
+	global const int* operationIndices,
+	global const CSGOperation* operations)
+{
+	float3 normal = { 0.f, 0.f, 0.f };
+	for (int i = 0; i < numOperations; i++)
+	{
+		const CSGOperation op = operations[operationIndices[i]];
+		const float d = BRUSH_DENSITY(world_pos, &op);
+		if (d > 0.f)
+		{
+		//	 flip = operationType[i] == 0 ? 1.f : -1.f;
+			continue;
+		}
+
+		const float h = 0.001f;
+		const float dx0 = BRUSH_DENSITY(world_pos + (float4)(h, 0, 0, 0), &op);
+		const float dx1 = BRUSH_DENSITY(world_pos - (float4)(h, 0, 0, 0), &op);
+
+		const float dy0 = BRUSH_DENSITY(world_pos + (float4)(0, h, 0, 0), &op);
+		const float dy1 = BRUSH_DENSITY(world_pos - (float4)(0, h, 0, 0), &op);
+		
+		const float dz0 = BRUSH_DENSITY(world_pos + (float4)(0, 0, h, 0), &op);
+		const float dz1 = BRUSH_DENSITY(world_pos - (float4)(0, 0, h, 0), &op);
+
+		const float flip = op.type == 0 ? 1.f : -1.f;
+		normal = flip * normalize((float3)(dx0 - dx1, dy0 - dy1, dz0 - dz1));
+	}
+
+	return normal;
+}
+
+// ---------------------------------------------------------------------------
+
+kernel
+void BRUSH_FN(CSG_HermiteIndices)(
+	const int4 worldspaceOffset,
+	const int numOperations,
+	global const int* operationIndices,
+	global const CSGOperation* operations,
+	const int sampleScale,
+	global const int* field_materials,
+	global int* updated_indices,
+	global int4* updated_positions,
+	global int* updatedMaterials)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int z = get_global_id(2);
+	const int4 local_pos = { x, y, z, 0 };
+
+	const int sx = sampleScale * x;
+	const int sy = sampleScale * y;
+	const int sz = sampleScale * z;
+
+	const int oldMaterial = field_materials[field_index(local_pos)];
+	int material = oldMaterial;
+
+	const float4 world_pos = { worldspaceOffset.x + sx, worldspaceOffset.y + sy, worldspaceOffset.z + sz, 0 };
+	material = BRUSH_FN(BrushMaterial)(world_pos, numOperations, operationIndices, operations, material);
+
+	// the outputs are linear rather than using the field layout so the padding 
+	// in the field buffer doesn't need to be cleared/scanned
+	const int index = x + (y * FIELD_DIM) + (z * FIELD_DIM * FIELD_DIM);
+	const int updated = material != oldMaterial;
+	updated_indices[index] = updated;
+	updated_positions[index] = local_pos;
+	updatedMaterials[index] = material;
+}
+
+// ---------------------------------------------------------------------------
+
+// TODO this is almost identical to the FindEdgeIntersectionInfo in density_field.cl except it uses 
+// the BrushDensity func rather than DensityFunc
+kernel void BRUSH_FN(FindEdgeIntersectionInfo)(
+	const int4 offset,
+	const int numOperations,
+	global const int* operationIndices,
+	global const CSGOperation* operations,
+	const int sampleScale,
+	global const int* compactEdges,
+	global float4* normals)
+{
+	const int index = get_global_id(0);
+	const int globalEdgeIndex = compactEdges[index];
+
+	const int edgeIndex = 4 * (globalEdgeIndex & 3);
+	const int voxelIndex = globalEdgeIndex >> 2;
+
+	const int4 local_pos =
+	{
+		(voxelIndex >> (VOXEL_INDEX_SHIFT * 0)) & VOXEL_INDEX_MASK,
+		(voxelIndex >> (VOXEL_INDEX_SHIFT * 1)) & VOXEL_INDEX_MASK,
+		(voxelIndex >> (VOXEL_INDEX_SHIFT * 2)) & VOXEL_INDEX_MASK,
+		0
+	};
+
+	const int e0 = EDGE_MAP[edgeIndex][0];
+	const int e1 = EDGE_MAP[edgeIndex][1];
+
+	const int4 world_pos = (sampleScale * local_pos) + offset;
+	const float4 p0 = convert_float4(world_pos + CHILD_MIN_OFFSETS[e0]);
+	const float4 p1 = convert_float4(world_pos + (sampleScale * CHILD_MIN_OFFSETS[e1]));
+
+	const float t = BRUSH_FN(BrushZeroCrossing)(p0, p1, numOperations, operationIndices, operations);
+	const float4 p = mix(p0, p1, t);
+
+	const float3 n = BRUSH_FN(BrushNormal)(p, numOperations, operationIndices, operations);
+	normals[index] = (float4)(n, t);
+}
+
+// ---------------------------------------------------------------------------
+
+#undef BRUSH_DENSITY
+
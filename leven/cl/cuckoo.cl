@@ -1,30 +1,37 @@
 #pragma OPENCL EXTENSION cl_khr_int64_base_atomics : enable
 
-unsigned long Cuckoo_CreateEntry(uint key, uint value)
+// The keys are 64-bit but an entry has to fit in a single ulong to be swapped 
+// atomically, so the low CUCKOO_KEY_BITS hold the key and the rest the value.
+// The all-ones key is never generated (it's the empty entry's key)
+#define CUCKOO_KEY_MASK ((1UL << CUCKOO_KEY_BITS) - 1)
+
+unsigned long Cuckoo_CreateEntry(unsigned long key, uint value)
 {
-	return (unsigned long)(((unsigned long)value << 32) | key);
+	return ((unsigned long)value << CUCKOO_KEY_BITS) | (key & CUCKOO_KEY_MASK);
 }
 
-uint Cuckoo_GetKey(unsigned long entry)
+unsigned long Cuckoo_GetKey(unsigned long entry)
 {
-	return entry & 0xffffffff;
+	return entry & CUCKOO_KEY_MASK;
 }
 
 uint Cuckoo_GetValue(unsigned long entry)
 {
-	return entry >> 32;
+	return entry >> CUCKOO_KEY_BITS;
 }
 
-uint Cuckoo_Hash(int whichHash, uint key, uint a, uint b, uint prime)
+uint Cuckoo_Hash(int whichHash, unsigned long key, uint a, uint b, uint prime)
 {
 	const uint p = 4294967291;		// largest 32-bit prime
-	unsigned long h = a * key;
+	const uint k = (uint)key ^ (uint)(key >> 32);
+	unsigned long h = a * k;
 	uint mod = whichHash < CUCKOO_STASH_HASH_INDEX ? prime : CUCKOO_STASH_SIZE;
 	return ((h + b) % p) % mod;
 }
 
-kernel void Cuckoo_InsertKeys(
-	global uint* keys,
+void Cuckoo_InsertKey(
+	const int index,
+	unsigned long key,
 	global unsigned long* data,
 	global unsigned long* stash,
 	const uint prime,
@@ -32,8 +39,6 @@ kernel void Cuckoo_InsertKeys(
 	global int* inserted,
 	global int* stashUsed)
 {
-	const int index = get_global_id(0);
-	uint key = keys[index];
 	uint value = index;
 	unsigned long entry = Cuckoo_CreateEntry(key, value);
 
@@ -64,14 +69,42 @@ kernel void Cuckoo_InsertKeys(
 
 	stashUsed[index] = 1;
 	key = Cuckoo_GetKey(entry);
-	h = Cuckoo_Hash(0, key, hashParams[CUCKOO_STASH_HASH_INDEX * 2 + 0], 
+	h = Cuckoo_Hash(CUCKOO_STASH_HASH_INDEX, key, hashParams[CUCKOO_STASH_HASH_INDEX * 2 + 0], 
 		hashParams[CUCKOO_STASH_HASH_INDEX * 2 + 1], prime);
 	const unsigned long stashEntry = atom_cmpxchg(&stash[h], CUCKOO_EMPTY_VALUE, entry);
 	inserted[index] = stashEntry == CUCKOO_EMPTY_VALUE ? 1 : 0;
 }
 
+kernel void Cuckoo_InsertKeys(
+	global unsigned long* keys,
+	global unsigned long* data,
+	global unsigned long* stash,
+	const uint prime,
+	global uint* hashParams,
+	global int* inserted,
+	global int* stashUsed)
+{
+	const int index = get_global_id(0);
+	Cuckoo_InsertKey(index, keys[index], data, stash, prime, hashParams, inserted, stashUsed);
+}
+
+// the edge indices are still 32-bit so they get their own entry point rather 
+// than being widened into a temp buffer before every insert
+kernel void Cuckoo_InsertIntKeys(
+	global uint* keys,
+	global unsigned long* data,
+	global unsigned long* stash,
+	const uint prime,
+	global uint* hashParams,
+	global int* inserted,
+	global int* stashUsed)
+{
+	const int index = get_global_id(0);
+	Cuckoo_InsertKey(index, keys[index], data, stash, prime, hashParams, inserted, stashUsed);
+}
+
 uint Cuckoo_Find(
-	uint key,
+	unsigned long key,
 	global unsigned long* data,
 	global unsigned long* stash,
 	const uint prime,
@@ -93,7 +126,7 @@ uint Cuckoo_Find(
 	{
 		const uint h = Cuckoo_Hash(CUCKOO_STASH_HASH_INDEX, key, 
 			hashParams[CUCKOO_STASH_HASH_INDEX * 2 + 0], hashParams[CUCKOO_STASH_HASH_INDEX * 2 + 1], prime);
-		const unsigned long entry = data[h];
+		const unsigned long entry = stash[h];
 		if (Cuckoo_GetKey(entry) == key)
 		{
 			return Cuckoo_GetValue(entry);
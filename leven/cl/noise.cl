@@ -222,9 +222,16 @@ float Terrain(const float4 position, read_only image2d_t permTexture)
 	return noise;
 }
 
+#ifdef DENSITY_GRAPH
+// generated from the graph file, see Compute_SetDensityGraph
+float DensityGraph(const float4 position, read_only image2d_t permTexture);
+#endif
+
 float DensityFunc(const float4 position, read_only image2d_t permTexture)
 {
-#if 0 
+#if defined(DENSITY_GRAPH)
+	return DensityGraph(position, permTexture);
+#elif 0 
 	float3 p = (float3)(position.x, position.y, position.z);
 	p -= (float3)(0, 100.f, 0.f);
 
@@ -24,16 +24,18 @@ uint EncodeVoxelIndex(int4 pos)
 
 // ---------------------------------------------------------------------------
 
-inline int MSB(uint n)
+inline int MSB(ulong n)
 {
-	return 32 - clz(n);
+	return 64 - (int)clz(n);
 }
 
 // ---------------------------------------------------------------------------
 
-uint CodeForPosition(int4 p, int nodeDepth)
+// the codes are 64-bit, note the cuckoo tables only store the low CUCKOO_KEY_BITS 
+// which limits the depth to (CUCKOO_KEY_BITS - 1) / 3
+ulong CodeForPosition(int4 p, int nodeDepth)
 {
-	uint code = 1;
+	ulong code = 1;
 	for (int depth = MAX_OCTREE_DEPTH - 1; depth >= (MAX_OCTREE_DEPTH - nodeDepth); depth--)
 	{
 		int x = (p.x >> depth) & 1;
@@ -48,7 +50,7 @@ uint CodeForPosition(int4 p, int nodeDepth)
 
 // ---------------------------------------------------------------------------
 
-int4 PositionForCode(uint code)
+int4 PositionForCode(ulong code)
 {
 	const int msb = MSB(code);
 	const int nodeDepth = (msb / 3);
@@ -56,7 +58,7 @@ int4 PositionForCode(uint code)
 	int4 pos = { 0, 0, 0, 0 };
 	for (int i = MAX_OCTREE_DEPTH - nodeDepth; i < MAX_OCTREE_DEPTH; i++)
 	{
-		uint c = code & 7;
+		const int c = code & 7;
 		code >>= 3;
 
 		int x = (c >> 2) & 1;
@@ -139,91 +141,6 @@ int FindDominantMaterial(const int m[8])
 
 // ---------------------------------------------------------------------------
 
-kernel void FindActiveVoxels(
-	global int* materials,
-	global int* voxelOccupancy,
-	global int* voxelEdgeInfo,
-	global int* voxelPositions,
-	global int* voxelMaterials)
-{
-	const int x = get_global_id(0);
-	const int y = get_global_id(1);
-	const int z = get_global_id(2);
-	
-	const int index = x + (y * VOXELS_PER_CHUNK) + (z * VOXELS_PER_CHUNK * VOXELS_PER_CHUNK);
-	const int4 pos = { x, y, z, 0 };
-
-	const int cornerMaterials[8] = 
-	{
-		materials[field_index(pos + CHILD_MIN_OFFSETS[0])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[1])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[2])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[3])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[4])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[5])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[6])],
-		materials[field_index(pos + CHILD_MIN_OFFSETS[7])],
-	};
-
-	// record the on/off values at the corner of each voxel
-	int cornerValues = 0;
-	cornerValues |= (((cornerMaterials[0]) == MATERIAL_AIR ? 0 : 1) << 0);
-	cornerValues |= (((cornerMaterials[1]) == MATERIAL_AIR ? 0 : 1) << 1);
-	cornerValues |= (((cornerMaterials[2]) == MATERIAL_AIR ? 0 : 1) << 2);
-	cornerValues |= (((cornerMaterials[3]) == MATERIAL_AIR ? 0 : 1) << 3);
-	cornerValues |= (((cornerMaterials[4]) == MATERIAL_AIR ? 0 : 1) << 4);
-	cornerValues |= (((cornerMaterials[5]) == MATERIAL_AIR ? 0 : 1) << 5);
-	cornerValues |= (((cornerMaterials[6]) == MATERIAL_AIR ? 0 : 1) << 6);
-	cornerValues |= (((cornerMaterials[7]) == MATERIAL_AIR ? 0 : 1) << 7);
-
-	// record which of the 12 voxel edges are on/off
-	int edgeList = 0;
-
-#pragma unroll
-	for (int i = 0; i < 12; i++)
-	{
-		const int i0 = EDGE_MAP[i][0];	
-		const int i1 = EDGE_MAP[i][1];	
-		const int edgeStart = (cornerValues >> i0) & 1;
-		const int edgeEnd = (cornerValues >> i1) & 1;
-
-		const int signChange = (!edgeStart && edgeEnd) || (edgeStart && !edgeEnd);
-		edgeList |= (signChange << i);
-	}
-
-	voxelOccupancy[index] = cornerValues != 0 && cornerValues != 255;
-	voxelPositions[index] = CodeForPosition(pos, MAX_OCTREE_DEPTH);
-	voxelEdgeInfo[index] = edgeList;
-
-	// store cornerValues here too as its needed by the CPU side and edgeInfo isn't exported
-	int materialIndex = FindDominantMaterial(cornerMaterials);
-	voxelMaterials[index] = (materialIndex << 8) | cornerValues;
-}
-
-// ---------------------------------------------------------------------------
-
-kernel void CompactVoxels(
-	global int* voxelValid,
-	global int* voxelEdgeInfo,
-	global int* voxelPositions,
-	global int* voxelMaterials,
-	global int* voxelScan,
-	global int* compactPositions,
-	global int* compactEdgeInfo,
-	global int* compactMaterials)
-{
-	const int index = get_global_id(0);
-
-	if (voxelValid[index])
-	{
-		compactPositions[voxelScan[index]] = voxelPositions[index];
-		compactEdgeInfo[voxelScan[index]] = voxelEdgeInfo[index];
-		compactMaterials[voxelScan[index]] = voxelMaterials[index];
-	}
-}
-
-// ---------------------------------------------------------------------------
-
 constant int EDGE_VERTEX_MAP[12][2] = 
 {
 	{0,4},{1,5},{2,6},{3,7},	// x-axis 
@@ -233,29 +150,21 @@ constant int EDGE_VERTEX_MAP[12][2] =
 
 // ---------------------------------------------------------------------------
 
-kernel void CreateLeafNodes(
+// finds the positions (scaled by sampleScale) and normals of the voxel's edge crossings
+int FindEdgeCrossings(
 	const int sampleScale,
-	global int* voxelPositions,
-	global int* voxelEdgeInfo,
+	const int4 position,
+	const int edgeList,
 	global float4* edgeDataTable,
-	global float4* vertexNormals,
-	global QEFData* leafQEFs,
 	global ulong* cuckoo_table,
 	global ulong* cuckoo_stash,
 	const uint   cuckoo_prime,
 	global uint* cuckoo_hashParams,
-	const int    cuckoo_checkStash)
+	const int    cuckoo_checkStash,
+	float4* edgePositions,
+	float4* edgeNormals)
 {
-	const int index = get_global_id(0);
-
-	const int encodedPosition = voxelPositions[index];
-	const int4 position = PositionForCode(encodedPosition);
 	const float4 position_f = convert_float4(position);
-
-	const int edgeInfo = voxelEdgeInfo[index];
-	const int edgeList = edgeInfo;
-
-	float4 edgePositions[12], edgeNormals[12];
 	int edgeCount = 0;
 
 #pragma unroll
@@ -294,10 +203,13 @@ kernel void CreateLeafNodes(
 		}
 	}
 
-	QEFData qef;
-	qef_create_from_points(edgePositions, edgeNormals, edgeCount, &qef);
-	leafQEFs[index] = qef;
+	return edgeCount;
+}
+
+// ---------------------------------------------------------------------------
 
+float4 AverageNormal(const float4* edgeNormals, const int edgeCount)
+{
 	float4 normal = { 0.f, 0.f, 0.f, 0.f };
 	for (int i = 0; i < edgeCount; i++)
 	{
@@ -308,7 +220,217 @@ kernel void CreateLeafNodes(
 	normal /= normal.w;
 	normal.w = 0.f;
 
-	vertexNormals[index] = normal;
+	return normal;
+}
+
+// ---------------------------------------------------------------------------
+
+void CreateLeafNode(
+	const int sampleScale,
+	const int4 position,
+	const int edgeList,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	global QEFData* leafQEF,
+	global float4* vertexNormal)
+{
+	float4 edgePositions[12], edgeNormals[12];
+	const int edgeCount = FindEdgeCrossings(sampleScale, position, edgeList, edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		edgePositions, edgeNormals);
+
+	QEFData qef;
+	qef_create_from_points(edgePositions, edgeNormals, edgeCount, &qef);
+	*leafQEF = qef;
+
+	*vertexNormal = AverageNormal(edgeNormals, edgeCount);
+}
+
+// ---------------------------------------------------------------------------
+
+// Reads the voxel's corner materials and reserves a slot in the leaf arrays if the
+// voxel is active: only a few percent of the voxels contain the surface so rather 
+// than writing every voxel out and then scanning/compacting, the active voxels are 
+// appended straight to the leaf arrays. The append is aggregated per work-group so
+// there is only one global atomic per group. Returns -1 for the inactive voxels.
+int AppendLeafNode(
+	global int* materials,
+	const int4 pos,
+	const int leafCapacity,
+	global int* leafCount,
+	local int* groupCount,
+	local int* groupBase,
+	int* cornerMaterials,
+	int* cornerValues)
+{
+	const int isFirstInGroup = get_local_id(0) == 0 && get_local_id(1) == 0 && get_local_id(2) == 0;
+	if (isFirstInGroup)
+	{
+		*groupCount = 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// record the on/off values at the corner of each voxel
+	int corners = 0;
+
+#pragma unroll
+	for (int i = 0; i < 8; i++)
+	{
+		cornerMaterials[i] = materials[field_index(pos + CHILD_MIN_OFFSETS[i])];
+		corners |= ((cornerMaterials[i] == MATERIAL_AIR ? 0 : 1) << i);
+	}
+
+	*cornerValues = corners;
+
+	const int active = corners != 0 && corners != 255;
+	const int groupSlot = active ? atomic_inc(groupCount) : -1;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (isFirstInGroup)
+	{
+		*groupBase = *groupCount > 0 ? atomic_add(leafCount, *groupCount) : 0;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// the count is still incremented past the capacity so the host can detect the overflow
+	const int index = *groupBase + groupSlot;
+	return active && index < leafCapacity ? index : -1;
+}
+
+// ---------------------------------------------------------------------------
+
+// record which of the 12 voxel edges have a sign change
+int FindEdgeList(const int cornerValues)
+{
+	int edgeList = 0;
+
+#pragma unroll
+	for (int i = 0; i < 12; i++)
+	{
+		const int i0 = EDGE_MAP[i][0];	
+		const int i1 = EDGE_MAP[i][1];	
+		const int edgeStart = (cornerValues >> i0) & 1;
+		const int edgeEnd = (cornerValues >> i1) & 1;
+
+		const int signChange = (!edgeStart && edgeEnd) || (edgeStart && !edgeEnd);
+		edgeList |= (signChange << i);
+	}
+
+	return edgeList;
+}
+
+// ---------------------------------------------------------------------------
+
+void CreateLeafNodeForVoxel(
+	const int4 pos,
+	global int* materials,
+	const int sampleScale,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexNormals,
+	global QEFData* leafQEFs,
+	local int* groupCount,
+	local int* groupBase)
+{
+	int cornerMaterials[8];
+	int cornerValues = 0;
+	const int index = AppendLeafNode(materials, pos, leafCapacity, leafCount,
+		groupCount, groupBase, cornerMaterials, &cornerValues);
+	if (index < 0)
+	{
+		return;
+	}
+
+	leafCodes[index] = CodeForPosition(pos, MAX_OCTREE_DEPTH);
+
+	// store cornerValues here too as its needed by the CPU side and edgeInfo isn't exported
+	const int materialIndex = FindDominantMaterial(cornerMaterials);
+	leafMaterials[index] = (materialIndex << 8) | cornerValues;
+
+	CreateLeafNode(sampleScale, pos, FindEdgeList(cornerValues), edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		&leafQEFs[index], &vertexNormals[index]);
+}
+
+// ---------------------------------------------------------------------------
+
+// Finds the active voxels and creates their leaf nodes in one pass, see AppendLeafNode.
+// The leaf order is nondeterministic but nothing depends on it, the node lookups all 
+// go via the cuckoo table.
+kernel void CreateLeafNodes(
+	global int* materials,
+	const int sampleScale,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexNormals,
+	global QEFData* leafQEFs)
+{
+	local int groupCount;
+	local int groupBase;
+
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int z = get_global_id(2);
+	const int4 pos = { x, y, z, 0 };
+
+	CreateLeafNodeForVoxel(pos, materials, sampleScale, edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		leafCapacity, leafCount, leafCodes, leafMaterials, vertexNormals, leafQEFs,
+		&groupCount, &groupBase);
+}
+
+// ---------------------------------------------------------------------------
+
+// CreateLeafNodes for a list of voxels rather than the whole chunk, the args are the 
+// same with the encoded voxel indices appended, see PatchOctree
+kernel void CreateLeafNodesForVoxels(
+	global int* materials,
+	const int sampleScale,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexNormals,
+	global QEFData* leafQEFs,
+	global uint* voxelIndices)
+{
+	local int groupCount;
+	local int groupBase;
+
+	const int4 pos = DecodeVoxelIndex(voxelIndices[get_global_id(0)]);
+
+	CreateLeafNodeForVoxel(pos, materials, sampleScale, edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		leafCapacity, leafCount, leafCodes, leafMaterials, vertexNormals, leafQEFs,
+		&groupCount, &groupBase);
 }
 
 // ---------------------------------------------------------------------------
@@ -330,6 +452,301 @@ kernel void SolveQEFs(
 	solvedPositions[index] = pos;
 }
 
+// ---------------------------------------------------------------------------
+// The leaf vertices are clustered bottom up over dense grids, one per level: a
+// cell at level L covers 2^L voxels and collapses into a single vertex when all
+// its children collapsed (the leaves always can) and the merged vertex is within
+// the max error of each child's tangent plane. Cells touching the chunk bounds
+// are never collapsed so the seam nodes are left as they are.
+// ---------------------------------------------------------------------------
+
+#define CELL_EMPTY		(0)
+#define CELL_COLLAPSED	(1)
+#define CELL_KEPT		(2)
+
+// ---------------------------------------------------------------------------
+
+int CollapseCell(
+	const QEFData* qef,
+	const float4* childPositions,
+	const float4* childNormals,
+	const int numChildren,
+	const float childError,
+	const int4 cellMin,
+	const int cellSize,
+	const int sampleScale,
+	const float maxErrorSq,
+	global QEFData* cellQEF,
+	global float4* cellPosition,
+	global float4* cellNormal)
+{
+	if (numChildren == 0)
+	{
+		return CELL_EMPTY;
+	}
+
+	const int4 cellMax = cellMin + cellSize;
+	if (cellMin.x == 0 || cellMin.y == 0 || cellMin.z == 0 ||
+		cellMax.x == VOXELS_PER_CHUNK || cellMax.y == VOXELS_PER_CHUNK || cellMax.z == VOXELS_PER_CHUNK)
+	{
+		return CELL_KEPT;
+	}
+
+	QEFData solveQEF = *qef;
+	float4 position = { 0.f, 0.f, 0.f, 0.f };
+	qef_solve(&solveQEF, &position);
+
+	// the positions are in the same space as the leaf QEFs, i.e. scaled by sampleScale
+	const float4 boundsMin = convert_float4(cellMin * sampleScale);
+	const float4 boundsMax = convert_float4(cellMax * sampleScale);
+	if (any(position.xyz < boundsMin.xyz) || any(position.xyz > boundsMax.xyz))
+	{
+		position = solveQEF.masspoint;
+	}
+
+	float error = childError;
+	float4 normal = { 0.f, 0.f, 0.f, 0.f };
+	for (int i = 0; i < numChildren; i++)
+	{
+		const float3 n = normalize(childNormals[i].xyz);
+		const float d = dot(n, position.xyz - childPositions[i].xyz);
+		error = max(error, d * d);
+		normal += childNormals[i];
+	}
+
+	if (error > maxErrorSq)
+	{
+		return CELL_KEPT;
+	}
+
+	// the error is carried up so the parent can't drift further than the max from the leaves
+	position.w = error;
+	normal.w = 0.f;
+
+	*cellQEF = *qef;
+	*cellPosition = position;
+	*cellNormal = normalize(normal);
+
+	return CELL_COLLAPSED;
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void CollapseLeafCells(
+	const float4 worldSpaceOffset,
+	const int sampleScale,
+	const float maxErrorSq,
+	global QEFData* leafQEFs,
+	global float4* leafPositions,
+	global float4* leafNormals,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	global QEFData* cellQEFs,
+	global float4* cellPositions,
+	global float4* cellNormals,
+	global int* cellStates)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int z = get_global_id(2);
+	const int4 cell = { x, y, z, 0 };
+	const int dim = get_global_size(0);
+	const int cellIndex = cell.x + (cell.y * dim) + (cell.z * dim * dim);
+	const int4 cellMin = cell * 2;
+
+	QEFData qef;
+	qef_initialise(&qef);
+
+	float4 childPositions[8], childNormals[8];
+	int numChildren = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		const ulong code = CodeForPosition(cellMin + CHILD_MIN_OFFSETS[i], MAX_OCTREE_DEPTH);
+		const uint leaf = Cuckoo_Find(code,
+			cuckoo_table, cuckoo_stash, cuckoo_prime,
+			cuckoo_hashParams, cuckoo_checkStash);
+
+		if (leaf == ~0U)
+		{
+			continue;
+		}
+
+		const QEFData leafQEF = leafQEFs[leaf];
+		qef_accumulate(&qef, &leafQEF);
+
+		// undo the world space transform applied in SolveQEFs
+		childPositions[numChildren] = (leafPositions[leaf] - worldSpaceOffset) / LEAF_SIZE_SCALE;
+		childNormals[numChildren] = leafNormals[leaf];
+		numChildren++;
+	}
+
+	cellStates[cellIndex] = CollapseCell(&qef, childPositions, childNormals, numChildren, 0.f,
+		cellMin, 2, sampleScale, maxErrorSq,
+		&cellQEFs[cellIndex], &cellPositions[cellIndex], &cellNormals[cellIndex]);
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void CollapseCells(
+	const int cellSize,
+	const int sampleScale,
+	const float maxErrorSq,
+	const int childOffset,
+	const int cellOffset,
+	global QEFData* cellQEFs,
+	global float4* cellPositions,
+	global float4* cellNormals,
+	global int* cellStates)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int z = get_global_id(2);
+	const int4 cell = { x, y, z, 0 };
+	const int dim = get_global_size(0);
+	const int childDim = dim * 2;
+	const int cellIndex = cellOffset + cell.x + (cell.y * dim) + (cell.z * dim * dim);
+
+	QEFData qef;
+	qef_initialise(&qef);
+
+	float4 childPositions[8], childNormals[8];
+	float childError = 0.f;
+	int numChildren = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		const int4 child = (cell * 2) + CHILD_MIN_OFFSETS[i];
+		const int childIndex = childOffset + child.x + (child.y * childDim) + (child.z * childDim * childDim);
+
+		const int state = cellStates[childIndex];
+		if (state == CELL_EMPTY)
+		{
+			continue;
+		}
+		else if (state == CELL_KEPT)
+		{
+			cellStates[cellIndex] = CELL_KEPT;
+			return;
+		}
+
+		const QEFData childQEF = cellQEFs[childIndex];
+		qef_accumulate(&qef, &childQEF);
+
+		childPositions[numChildren] = cellPositions[childIndex];
+		childNormals[numChildren] = cellNormals[childIndex];
+		childError = max(childError, childPositions[numChildren].w);
+		numChildren++;
+	}
+
+	cellStates[cellIndex] = CollapseCell(&qef, childPositions, childNormals, numChildren, childError,
+		cell * cellSize, cellSize, sampleScale, maxErrorSq,
+		&cellQEFs[cellIndex], &cellPositions[cellIndex], &cellNormals[cellIndex]);
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void AssignNodeClusters(
+	const int numLevels,
+	global ulong* nodeCodes,
+	global int* cellStates,
+	global int* cellLeaders,
+	global int* nodeClusters)
+{
+	const int index = get_global_id(0);
+	const int4 position = PositionForCode(nodeCodes[index]);
+
+	// a cell can only collapse if all its children did, so the node's cluster is the
+	// last collapsed cell found walking up the levels
+	int cluster = -1;
+	int levelOffset = 0;
+	int dim = VOXELS_PER_CHUNK / 2;
+	for (int level = 1; level <= numLevels; level++)
+	{
+		const int4 cell = position >> level;
+		const int cellIndex = levelOffset + cell.x + (cell.y * dim) + (cell.z * dim * dim);
+		if (cellStates[cellIndex] != CELL_COLLAPSED)
+		{
+			break;
+		}
+
+		cluster = cellIndex;
+		levelOffset += dim * dim * dim;
+		dim /= 2;
+	}
+
+	nodeClusters[index] = cluster;
+	if (cluster != -1)
+	{
+		// the lowest node index keeps the vertex so the result doesn't depend on the scheduling
+		atomic_min(&cellLeaders[cluster], index);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void ResolveNodeClusters(
+	const float4 worldSpaceOffset,
+	global int* nodeClusters,
+	global int* cellLeaders,
+	global float4* cellPositions,
+	global float4* cellNormals,
+	global int* nodeLeaders,
+	global int* isVertex,
+	global float4* vertexPositions,
+	global float4* vertexNormals)
+{
+	const int index = get_global_id(0);
+	const int cluster = nodeClusters[index];
+	const int leader = cluster != -1 ? cellLeaders[cluster] : index;
+
+	nodeLeaders[index] = leader;
+	isVertex[index] = leader == index;
+
+	if (cluster != -1 && leader == index)
+	{
+		float4 pos = (cellPositions[cluster] * LEAF_SIZE_SCALE) + worldSpaceOffset;
+		pos.w = 1.f;
+
+		vertexPositions[index] = pos;
+		vertexNormals[index] = cellNormals[cluster];
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+// the nodes sharing another node's vertex store the complement of the index so only
+// the leader writes the vertex in GenerateMeshVertexBuffer
+kernel void AssignNodeVertices(
+	global int* nodeLeaders,
+	global int* vertexScan,
+	global int* nodeVertices)
+{
+	const int index = get_global_id(0);
+	const int leader = nodeLeaders[index];
+	const int vertex = vertexScan[leader];
+	nodeVertices[index] = leader == index ? vertex : ~vertex;
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void InitialiseNodeVertices(
+	global int* nodeVertices)
+{
+	const int index = get_global_id(0);
+	nodeVertices[index] = index;
+}
+
+// ---------------------------------------------------------------------------
+
+int VertexForNode(const int nodeVertex)
+{
+	return nodeVertex >= 0 ? nodeVertex : ~nodeVertex;
+}
+
 // ---------------------------------------------------------------------------
 
 int ProcessEdge(
@@ -383,8 +800,9 @@ constant int4 EDGE_NODE_OFFSETS[3][4] =
 // ---------------------------------------------------------------------------
 
 kernel void GenerateMesh(
-	global uint* octreeNodeCodes,
+	global ulong* octreeNodeCodes,
 	global int* octreeMaterials,
+	global int* nodeVertices,
 	global int* meshIndexBuffer,
 	global int* trianglesValid,
 	global ulong* cuckoo_table,
@@ -394,8 +812,8 @@ kernel void GenerateMesh(
 	const int    cuckoo_checkStash)
 {
 	const int index = get_global_id(0);
-	const uint code = octreeNodeCodes[index];
-	const int triIndex = index * 3;
+	const ulong code = octreeNodeCodes[index];
+	const int triIndex = index * 6;
 	
 	const int4 offset = PositionForCode(code);
 	const int pos[3] = { offset.x, offset.y, offset.z };
@@ -403,7 +821,10 @@ kernel void GenerateMesh(
 	int nodeIndices[4] = { ~0, ~0, ~0, ~0 };
 	for (int axis = 0; axis < 3; axis++)
 	{
-		trianglesValid[triIndex + axis] = 0;
+		// two triangles per axis
+		const int axisTriIndex = triIndex + (axis * 2);
+		trianglesValid[axisTriIndex + 0] = 0;
+		trianglesValid[axisTriIndex + 1] = 0;
 
 		// need to check that the position generated when the offsets are added won't exceed 
 		// the chunk bounds -- if this happens rather than failing the octree lookup 
@@ -422,7 +843,7 @@ kernel void GenerateMesh(
 		for (int n = 1; n < 4; n++)
 		{
 			const int4 p = offset + EDGE_NODE_OFFSETS[axis][n];
-			const uint c = CodeForPosition(p, MAX_OCTREE_DEPTH);
+			const ulong c = CodeForPosition(p, MAX_OCTREE_DEPTH);
 
 			nodeIndices[n] = Cuckoo_Find(c,
 				cuckoo_table, cuckoo_stash, cuckoo_prime,
@@ -433,16 +854,55 @@ kernel void GenerateMesh(
 			nodeIndices[2] != ~0 &&
 			nodeIndices[3] != ~0)
 		{
-			const int bufferOffset = (triIndex * 6) + (axis * 6);
-			const int trisEmitted = 
-				ProcessEdge(&nodeIndices[0], octreeMaterials[index], axis, &meshIndexBuffer[bufferOffset]);
-			trianglesValid[triIndex + axis] = trisEmitted;
+			// the nodes in a collapsed cluster share a vertex
+			const int vertexIndices[4] = 
+			{
+				VertexForNode(nodeVertices[nodeIndices[0]]),
+				VertexForNode(nodeVertices[nodeIndices[1]]),
+				VertexForNode(nodeVertices[nodeIndices[2]]),
+				VertexForNode(nodeVertices[nodeIndices[3]]),
+			};
+
+			const int bufferOffset = axisTriIndex * 3;
+			global int* tris = &meshIndexBuffer[bufferOffset];
+			if (ProcessEdge(&vertexIndices[0], octreeMaterials[index], axis, tris))
+			{
+				// drop the degenerate triangles, i.e. two corners in the same cluster
+				trianglesValid[axisTriIndex + 0] = tris[0] != tris[1] && tris[1] != tris[2] && tris[0] != tris[2];
+				trianglesValid[axisTriIndex + 1] = tris[3] != tris[4] && tris[4] != tris[5] && tris[3] != tris[5];
+			}
 		}
 	}
 }
 
 // ---------------------------------------------------------------------------
 
+// Finds the region (see MESH_REGIONS_PER_AXIS in compute.h) of the node which generated
+// each of the GenerateMesh triangles, the triangles outside the selected regions are 
+// dropped before the scan so only those regions' triangles are compacted
+kernel void SelectMeshRegions(
+	const ulong regionMask,
+	global ulong* nodeCodes,
+	global int* trianglesValid,
+	global int* triangleRegions)
+{
+	const int index = get_global_id(0);
+
+	// GenerateMesh writes 6 triangles per node
+	const int4 regionPos = PositionForCode(nodeCodes[index / 6]) / (VOXELS_PER_CHUNK / MESH_REGIONS_PER_AXIS);
+	const int region = regionPos.x + 
+		(regionPos.y * MESH_REGIONS_PER_AXIS) + 
+		(regionPos.z * MESH_REGIONS_PER_AXIS * MESH_REGIONS_PER_AXIS);
+
+	triangleRegions[index] = region;
+	if (((regionMask >> region) & 1) == 0)
+	{
+		trianglesValid[index] = 0;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
 kernel void CompactMeshTriangles(
 	global int* trianglesValid,
 	global int* trianglesScan,
@@ -452,11 +912,11 @@ kernel void CompactMeshTriangles(
 	const int index = get_global_id(0);
 	if (trianglesValid[index])
 	{
-		const int scanOffset = trianglesScan[index] * 6;
-		const int bufferOffset = (index * 6);
+		const int scanOffset = trianglesScan[index] * 3;
+		const int bufferOffset = (index * 3);
 
 #pragma unroll
-		for (int i = 0; i < 6; i++)
+		for (int i = 0; i < 3; i++)
 		{
 			compactMeshIndexBuffer[scanOffset + i] = meshIndexBuffer[bufferOffset + i];
 		}
@@ -465,25 +925,65 @@ kernel void CompactMeshTriangles(
 
 // ---------------------------------------------------------------------------
 
-struct MeshVertex
+// see PackedMeshVertex in render_types.h
+struct PackedMeshVertex
 {
-	float4		position, normal, colour;
+	ushort4		position;
+	short2		normal;
+	uchar4		colour;
 };
 
 // ---------------------------------------------------------------------------
 
+float2 OctahedralEncode(const float4 normal)
+{
+	const float sum = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+	if (sum <= 0.f)
+	{
+		return (float2)(0.f, 0.f);
+	}
+
+	const float4 p = normal / sum;
+	if (p.z >= 0.f)
+	{
+		return p.xy;
+	}
+
+	return (float2)(
+		(1.f - fabs(p.y)) * (p.x >= 0.f ? 1.f : -1.f),
+		(1.f - fabs(p.x)) * (p.y >= 0.f ? 1.f : -1.f));
+}
+
+// ---------------------------------------------------------------------------
+
 kernel void GenerateMeshVertexBuffer(
 	global float4* vertexPositions,
 	global float4* vertexNormals,
 	global int* nodeMaterials,
+	global int* nodeVertices,
 	const float4 colour,
-	global struct MeshVertex* meshVertexBuffer)
+	const float4 boundsOrigin,
+	const float4 boundsScale,
+	global struct PackedMeshVertex* meshVertexBuffer)
 {
 	const int index = get_global_id(0);
+	const int vertex = nodeVertices[index];
+	if (vertex < 0)
+	{
+		// shares the vertex written by the cluster's leader
+		return;
+	}
+
 	const int material = nodeMaterials[index];
-	meshVertexBuffer[index].position = vertexPositions[index];
-	meshVertexBuffer[index].normal = vertexNormals[index];
-	meshVertexBuffer[index].colour = (float4)(colour.x, colour.y, colour.z, (float)(material >> 8));
+	const float4 q = clamp((vertexPositions[index] - boundsOrigin) / boundsScale, 0.f, 65535.f);
+	const float2 n = clamp(OctahedralEncode(vertexNormals[index]), -1.f, 1.f) * 32767.f;
+	const float4 c = clamp(colour, 0.f, 1.f) * 255.f;
+
+	struct PackedMeshVertex packed;
+	packed.position = (ushort4)((ushort)(q.x + 0.5f), (ushort)(q.y + 0.5f), (ushort)(q.z + 0.5f), 0);
+	packed.normal = (short2)((short)round(n.x), (short)round(n.y));
+	packed.colour = (uchar4)((uchar)(c.x + 0.5f), (uchar)(c.y + 0.5f), (uchar)(c.z + 0.5f), (uchar)(material >> 8));
+	meshVertexBuffer[vertex] = packed;
 }
 
 // ---------------------------------------------------------------------------
@@ -491,10 +991,10 @@ kernel void GenerateMeshVertexBuffer(
 kernel void UpdateNodeCodes(
 	const int4 chunkOffset,
 	const int selectedNodeSize,
-	global uint* nodeCodes)
+	global ulong* nodeCodes)
 {
 	const int index = get_global_id(0);
-	const int code = nodeCodes[index];
+	const ulong code = nodeCodes[index];
 	int4 position = PositionForCode(code);
 	position /= selectedNodeSize;
 	position += chunkOffset;
@@ -504,11 +1004,11 @@ kernel void UpdateNodeCodes(
 // ---------------------------------------------------------------------------
 
 kernel void FindSeamNodes(
-	global uint* nodeCodes,
+	global ulong* nodeCodes,
 	global int* isSeamNode)
 {
 	const int index = get_global_id(0);
-	const uint code = nodeCodes[index];
+	const ulong code = nodeCodes[index];
 	
 	int4 position = PositionForCode(code);
 	int xSeam = position.x == 0 || position.x == (VOXELS_PER_CHUNK - 1);
@@ -529,7 +1029,7 @@ typedef struct SeamNodeInfo_s
 kernel void ExtractSeamNodeInfo(
 	global int* isSeamNode,
 	global int* isSeamNodeScan,
-	global uint* octreeCodes,
+	global ulong* octreeCodes,
 	global int* octreeMaterials,
 	global float4* octreePositions,
 	global float4* octreeNormals,
@@ -550,9 +1050,104 @@ kernel void ExtractSeamNodeInfo(
 	}
 }
 
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+// Patching the octree after an edit, see PatchOctree. The edited edges are the 
+// ones with an updated end point so the 4 voxels sharing each edge cover every
+// voxel with an updated corner. Those voxels' nodes are removed and their leafs 
+// recreated, the rest of the octree is left as it is.
+// ---------------------------------------------------------------------------
+
+kernel void FindEditedVoxels(
+	global int* edgeIndices,
+	global int* voxelIndices)
+{
+	const int id = get_global_id(0);
+	const int edgeIndex = edgeIndices[id];
+	const int4 edgePos = DecodeVoxelIndex(edgeIndex >> 2);
+	const int axis = edgeIndex & 3;
+
+#pragma unroll
+	for (int i = 0; i < 4; i++)
+	{
+		// the offsets are symmetric so subtracting gives the voxels around the edge
+		const int4 pos = edgePos - EDGE_NODE_OFFSETS[axis][i];
+		const int inBounds = 
+			pos.x >= 0 && pos.x < VOXELS_PER_CHUNK &&
+			pos.y >= 0 && pos.y < VOXELS_PER_CHUNK &&
+			pos.z >= 0 && pos.z < VOXELS_PER_CHUNK;
+
+		voxelIndices[(id * 4) + i] = inBounds ? (int)EncodeVoxelIndex(pos) : -1;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void RemoveEditedNodes(
+	global uint* voxelIndices,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	global int* nodeValid)
+{
+	const int id = get_global_id(0);
+	const int4 pos = DecodeVoxelIndex(voxelIndices[id]);
+	const ulong code = CodeForPosition(pos, MAX_OCTREE_DEPTH);
+
+	const uint node = Cuckoo_Find(code,
+		cuckoo_table, cuckoo_stash, cuckoo_prime,
+		cuckoo_hashParams, cuckoo_checkStash);
+
+	if (node != ~0U)
+	{
+		nodeValid[node] = 0;
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void CompactOctreeNodes(
+	global int* nodeValid,
+	global int* nodeScan,
+	global ulong* nodeCodes,
+	global int* nodeMaterials,
+	global float4* vertexPositions,
+	global float4* vertexNormals,
+	global ulong* compactCodes,
+	global int* compactMaterials,
+	global float4* compactPositions,
+	global float4* compactNormals)
+{
+	const int index = get_global_id(0);
+	if (nodeValid[index])
+	{
+		const int compactIndex = nodeScan[index];
+		compactCodes[compactIndex] = nodeCodes[index];
+		compactMaterials[compactIndex] = nodeMaterials[index];
+		compactPositions[compactIndex] = vertexPositions[index];
+		compactNormals[compactIndex] = vertexNormals[index];
+	}
+}
 
 // ---------------------------------------------------------------------------
 
+kernel void CompactNodeQEFs(
+	global int* nodeValid,
+	global int* nodeScan,
+	global QEFData* qefs,
+	global QEFData* compactQEFs)
+{
+	const int index = get_global_id(0);
+	if (nodeValid[index])
+	{
+		compactQEFs[nodeScan[index]] = qefs[index];
+	}
+}
 
+// ---------------------------------------------------------------------------
 
+#include "cl/surface_nets.cl"
 
@@ -207,6 +207,23 @@ void qef_add(
 	result->masspoint /= result->masspoint.w;
 }
 
+// unlike qef_add the masspoint isn't normalised, masspoint.w counts the QEFs
+// accumulated so the result can itself be accumulated (qef_solve normalises)
+void qef_accumulate(
+	QEFData* result,
+	const QEFData* qef)
+{
+	result->ATA[0] += qef->ATA[0];
+	result->ATA[1] += qef->ATA[1];
+	result->ATA[2] += qef->ATA[2];
+	result->ATA[3] += qef->ATA[3];
+	result->ATA[4] += qef->ATA[4];
+	result->ATA[5] += qef->ATA[5];
+
+	result->ATb += qef->ATb;
+	result->masspoint += qef->masspoint;
+}
+
 float qef_calc_error(mat3x3_tri A, float4 x, float4 b) {
 	float4 tmp;
 
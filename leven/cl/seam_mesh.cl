@@ -0,0 +1,206 @@
+// ---------------------------------------------------------------------------
+// The seam meshes joining neighbouring chunks, see Compute_GenerateSeamMesh. The
+// seam nodes are the leafs of an octree whose depth depends on the node sizes, so
+// rather than MAX_OCTREE_DEPTH the codes are created for the treeDepth passed in
+// and each node's depth comes from its size (see SeamNodeCodes). Every minimal
+// edge is found from the smallest leaf touching it (the other leafs are looked up
+// by trying each of the larger sizes), which matches the edges ContourCellProc
+// would process in the CPU octree.
+// ---------------------------------------------------------------------------
+
+ulong SeamCodeForPosition(const int4 p, const int nodeDepth, const int treeDepth)
+{
+	ulong code = 1;
+	for (int depth = treeDepth - 1; depth >= (treeDepth - nodeDepth); depth--)
+	{
+		int x = (p.x >> depth) & 1;
+		int y = (p.y >> depth) & 1;
+		int z = (p.z >> depth) & 1;
+		int c = (x << 2) | (y << 1) | z;
+		code = (code << 3) | c;
+	}
+
+	return code;
+}
+
+// ---------------------------------------------------------------------------
+
+// the nodes are (min, log2(size)) in units of the smallest node size
+kernel void SeamNodeCodes(
+	global int4* nodes,
+	const int treeDepth,
+	global ulong* nodeCodes)
+{
+	const int index = get_global_id(0);
+	const int4 node = nodes[index];
+	nodeCodes[index] = SeamCodeForPosition(node, treeDepth - node.w, treeDepth);
+}
+
+// ---------------------------------------------------------------------------
+
+constant int EDGE_VERTEX_MAP[12][2] =
+{
+	{0,4},{1,5},{2,6},{3,7},	// x-axis
+	{0,2},{1,3},{4,6},{5,7},	// y-axis
+	{0,1},{2,3},{4,5},{6,7}		// z-axis
+};
+
+// the same order as GenerateMesh in octree.cl and processEdgeMask in contour_constants.h
+constant int4 EDGE_NODE_OFFSETS[3][4] =
+{
+	{ (int4)(0, 0, 0, 0), (int4)(0, 0, 1, 0), (int4)(0, 1, 0, 0), (int4)(0, 1, 1, 0) },
+	{ (int4)(0, 0, 0, 0), (int4)(1, 0, 0, 0), (int4)(0, 0, 1, 0), (int4)(1, 0, 1, 0) },
+	{ (int4)(0, 0, 0, 0), (int4)(0, 1, 0, 0), (int4)(1, 0, 0, 0), (int4)(1, 1, 0, 0) },
+};
+
+// the edge of the node in each of the EDGE_NODE_OFFSETS positions which lies on the shared edge
+constant int EDGE_NODE_EDGES[3][4] =
+{
+	{ 3, 2, 1, 0 }, { 7, 5, 6, 4 }, { 11, 10, 9, 8 }
+};
+
+// ---------------------------------------------------------------------------
+
+// each node writes 2 triangles for each of its 12 edges
+kernel void GenerateSeamMesh(
+	global int4* nodes,
+	global int* nodeCorners,
+	const int treeDepth,
+	const int4 rootMin,
+	const int unitSize,
+	const int chunkSize,
+	global int* meshIndexBuffer,
+	global int* trianglesValid,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash)
+{
+	const int index = get_global_id(0);
+	const int4 node = nodes[index];
+	const int nodeSize = 1 << node.w;
+	const int nodeDepth = treeDepth - node.w;
+	const int treeSize = 1 << treeDepth;
+	const int corners = nodeCorners[index];
+	const int4 chunkMask = (int4)(~(chunkSize - 1));
+
+	for (int edge = 0; edge < 12; edge++)
+	{
+		const int triIndex = (index * 24) + (edge * 2);
+		trianglesValid[triIndex + 0] = 0;
+		trianglesValid[triIndex + 1] = 0;
+
+		const int m0 = (corners >> EDGE_VERTEX_MAP[edge][0]) & 1;
+		const int m1 = (corners >> EDGE_VERTEX_MAP[edge][1]) & 1;
+		if (m0 == m1)
+		{
+			continue;
+		}
+
+		const int axis = edge / 4;
+		int slot = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			slot = EDGE_NODE_EDGES[axis][i] == edge ? i : slot;
+		}
+
+		const int4 baseMin = node - (nodeSize * EDGE_NODE_OFFSETS[axis][slot]);
+		int nodeIndices[4] = { index, index, index, index };
+		int4 nodeChunks[4];
+		bool valid = true;
+		for (int i = 0; i < 4; i++)
+		{
+			if (i == slot)
+			{
+				nodeChunks[i] = ((rootMin + (node * unitSize)) & chunkMask);
+				continue;
+			}
+
+			const int4 p = baseMin + (nodeSize * EDGE_NODE_OFFSETS[axis][i]);
+			if (any(p.xyz < 0) || any(p.xyz >= treeSize))
+			{
+				valid = false;
+				break;
+			}
+
+			// the edge is only this node's when the others are the same size or larger
+			// (i.e. found at this depth or above), and when they're the same size only
+			// the first of them generates it
+			nodeIndices[i] = ~0;
+			for (int depth = nodeDepth; depth >= 0 && nodeIndices[i] == ~0; depth--)
+			{
+				nodeIndices[i] = Cuckoo_Find(SeamCodeForPosition(p, depth, treeDepth),
+					cuckoo_table, cuckoo_stash, cuckoo_prime,
+					cuckoo_hashParams, cuckoo_checkStash);
+			}
+
+			if (nodeIndices[i] == ~0)
+			{
+				valid = false;
+				break;
+			}
+
+			const int4 neighbour = nodes[nodeIndices[i]];
+			if (i < slot && neighbour.w == node.w)
+			{
+				valid = false;
+				break;
+			}
+
+			nodeChunks[i] = ((rootMin + (neighbour * unitSize)) & chunkMask);
+		}
+
+		// the edges within a single chunk are already part of the chunk's mesh
+		if (!valid ||
+			(all(nodeChunks[0].xyz == nodeChunks[1].xyz) &&
+			 all(nodeChunks[0].xyz == nodeChunks[2].xyz) &&
+			 all(nodeChunks[0].xyz == nodeChunks[3].xyz)))
+		{
+			continue;
+		}
+
+		// flip the winding depending on which end of the edge is outside the volume
+		const int flip = m0 != 0 ? 1 : 0;
+		const int indices[2][6] =
+		{
+			{ 0, 1, 3, 0, 3, 2 },
+			{ 0, 3, 1, 0, 2, 3 },
+		};
+
+		global int* tris = &meshIndexBuffer[triIndex * 3];
+		for (int i = 0; i < 6; i++)
+		{
+			tris[i] = nodeIndices[indices[flip][i]];
+		}
+
+		// a larger node can be in two of the positions, drop the degenerate triangle
+		trianglesValid[triIndex + 0] = tris[0] != tris[1] && tris[1] != tris[2] && tris[0] != tris[2];
+		trianglesValid[triIndex + 1] = tris[3] != tris[4] && tris[4] != tris[5] && tris[3] != tris[5];
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void CompactSeamTriangles(
+	global int* trianglesValid,
+	global int* trianglesScan,
+	global int* meshIndexBuffer,
+	global int* compactMeshIndexBuffer)
+{
+	const int index = get_global_id(0);
+	if (trianglesValid[index])
+	{
+		const int scanOffset = trianglesScan[index] * 3;
+		const int bufferOffset = (index * 3);
+
+#pragma unroll
+		for (int i = 0; i < 3; i++)
+		{
+			compactMeshIndexBuffer[scanOffset + i] = meshIndexBuffer[bufferOffset + i];
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------
+
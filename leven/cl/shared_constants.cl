@@ -21,13 +21,6 @@ constant int4 CHILD_MIN_OFFSETS[8] =
 	(int4)( 1, 1, 1, 0 ),
 };
 
-inline int field_index(const int4 pos)
-{
-	return pos.x + (pos.y * FIELD_DIM) + (pos.z * FIELD_DIM * FIELD_DIM);
-}
-
-
-
 // "Insert" a 0 bit after each of the 16 low bits of x
 uint Part1By1(uint x)
 {
@@ -55,5 +48,18 @@ uint EncodeMorton3(uint x, uint y, uint z)
   return (Part1By2(z) << 2) + (Part1By2(y) << 1) + Part1By2(x);
 }
 
+// The field is stored as bricks of (1 << FIELD_BRICK_SIZE_LOG2)^3 samples with the
+// samples in Morton order inside each brick, so the corners read for a voxel/edge are
+// usually in the same brick instead of being spread over two z-slices FIELD_DIM^2 
+// apart. FIELD_BRICK_SIZE_LOG2=0 gives the plain x + y*N + z*N*N layout.
+inline int field_index(const int4 pos)
+{
+	const int brickMask = (1 << FIELD_BRICK_SIZE_LOG2) - 1;
+	const int4 brick = pos >> FIELD_BRICK_SIZE_LOG2;
+	const int brickIndex = brick.x + (brick.y * FIELD_BRICKS) + (brick.z * FIELD_BRICKS * FIELD_BRICKS);
+	const uint sampleIndex = EncodeMorton3(pos.x & brickMask, pos.y & brickMask, pos.z & brickMask);
+	return (brickIndex << (FIELD_BRICK_SIZE_LOG2 * 3)) | sampleIndex;
+}
+
 #endif	//	HAS_SHARED_CONSTANTS_CL_BEEN_INCLUDED
 
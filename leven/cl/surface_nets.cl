@@ -0,0 +1,130 @@
+// ---------------------------------------------------------------------------
+// Naive surface nets, used instead of dual contouring for the distant LODs (see
+// Compute_SetMeshExtractors). The vertex for each active voxel is the average of
+// its edge crossings so there is no QEF to accumulate or solve, and the leafs are
+// written with their final positions. The leafs are otherwise identical to the
+// CreateLeafNodes ones so the mesh generation and seam nodes work unchanged.
+// Included at the end of octree.cl, the CPU version is in surface_nets.cpp.
+// ---------------------------------------------------------------------------
+
+void CreateSurfaceNetsLeafNodeForVoxel(
+	const int4 pos,
+	global int* materials,
+	const int sampleScale,
+	const float4 worldSpaceOffset,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexPositions,
+	global float4* vertexNormals,
+	local int* groupCount,
+	local int* groupBase)
+{
+	int cornerMaterials[8];
+	int cornerValues = 0;
+	const int index = AppendLeafNode(materials, pos, leafCapacity, leafCount,
+		groupCount, groupBase, cornerMaterials, &cornerValues);
+	if (index < 0)
+	{
+		return;
+	}
+
+	leafCodes[index] = CodeForPosition(pos, MAX_OCTREE_DEPTH);
+
+	const int materialIndex = FindDominantMaterial(cornerMaterials);
+	leafMaterials[index] = (materialIndex << 8) | cornerValues;
+
+	float4 edgePositions[12], edgeNormals[12];
+	const int edgeCount = FindEdgeCrossings(sampleScale, pos, FindEdgeList(cornerValues), edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		edgePositions, edgeNormals);
+
+	float4 position = { 0.f, 0.f, 0.f, 0.f };
+	for (int i = 0; i < edgeCount; i++)
+	{
+		position += edgePositions[i];
+	}
+
+	// same transform as SolveQEFs
+	position /= max(edgeCount, 1);
+	position = (position * LEAF_SIZE_SCALE) + worldSpaceOffset;
+	position.w = 1.f;
+
+	vertexPositions[index] = position;
+	vertexNormals[index] = AverageNormal(edgeNormals, edgeCount);
+}
+
+// ---------------------------------------------------------------------------
+
+kernel void CreateSurfaceNetsLeafNodes(
+	global int* materials,
+	const int sampleScale,
+	const float4 worldSpaceOffset,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexPositions,
+	global float4* vertexNormals)
+{
+	local int groupCount;
+	local int groupBase;
+
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int z = get_global_id(2);
+	const int4 pos = { x, y, z, 0 };
+
+	CreateSurfaceNetsLeafNodeForVoxel(pos, materials, sampleScale, worldSpaceOffset, edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		leafCapacity, leafCount, leafCodes, leafMaterials, vertexPositions, vertexNormals,
+		&groupCount, &groupBase);
+}
+
+// ---------------------------------------------------------------------------
+
+// see CreateLeafNodesForVoxels
+kernel void CreateSurfaceNetsLeafNodesForVoxels(
+	global int* materials,
+	const int sampleScale,
+	const float4 worldSpaceOffset,
+	global float4* edgeDataTable,
+	global ulong* cuckoo_table,
+	global ulong* cuckoo_stash,
+	const uint   cuckoo_prime,
+	global uint* cuckoo_hashParams,
+	const int    cuckoo_checkStash,
+	const int leafCapacity,
+	global int* leafCount,
+	global ulong* leafCodes,
+	global int* leafMaterials,
+	global float4* vertexPositions,
+	global float4* vertexNormals,
+	global uint* voxelIndices)
+{
+	local int groupCount;
+	local int groupBase;
+
+	const int4 pos = DecodeVoxelIndex(voxelIndices[get_global_id(0)]);
+
+	CreateSurfaceNetsLeafNodeForVoxel(pos, materials, sampleScale, worldSpaceOffset, edgeDataTable,
+		cuckoo_table, cuckoo_stash, cuckoo_prime, cuckoo_hashParams, cuckoo_checkStash,
+		leafCapacity, leafCount, leafCodes, leafMaterials, vertexPositions, vertexNormals,
+		&groupCount, &groupBase);
+}
+
+// ---------------------------------------------------------------------------
+
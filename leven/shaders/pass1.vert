@@ -1,6 +1,7 @@
 #if DRAW_MODE == VOXEL_DRAW
+// see PackedMeshVertex, the position is unpacked by modelToWorldMatrix
 layout(location=0) in vec4 position;
-layout(location=1) in vec4 normal;
+layout(location=1) in vec2 normal;
 layout(location=2) in vec4 colour;
 #elif DRAW_MODE == ACTOR_DRAW
 layout(location=0) in vec4 position;
@@ -29,6 +30,19 @@ out vec4 vs_shadowPosition;
 uniform mat4 shadowMVP;
 #endif
 
+#if DRAW_MODE == VOXEL_DRAW
+vec3 OctahedralDecode(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.f - abs(e.x) - abs(e.y));
+	if (n.z < 0.f)
+	{
+		n.xy = (1.f - abs(n.yx)) * vec2(n.x >= 0.f ? 1.f : -1.f, n.y >= 0.f ? 1.f : -1.f);
+	}
+
+	return normalize(n);
+}
+#endif
+
 void main()
 {
 	vec4 p = vec4(position.xyz, 1.f);
@@ -37,8 +51,8 @@ void main()
 
 #if DRAW_MODE == VOXEL_DRAW
 	vs_vertexColour = vec4(colour.xyz, 0.f);
-	vs_vertexMaterial = int(colour.w);
-	vs_vertexNormal = normal;
+	vs_vertexMaterial = int(colour.w * 255.f + 0.5f);
+	vs_vertexNormal = vec4(OctahedralDecode(normal), 0.f);
 #elif DRAW_MODE == ACTOR_DRAW
 	vs_vertexColour = u_colour;
 #endif
@@ -47,7 +61,7 @@ void main()
 	vs_vertexDepth = -viewspaceP.z;
 	
 #ifdef USE_SHADOWS
-	vs_shadowPosition = shadowMVP * p;
+	vs_shadowPosition = shadowMVP * vs_vertexWorldPosition;
 #endif
 
 	gl_Position = (projectionMatrix * modelView) * p;
@@ -0,0 +1,328 @@
+#include	<string>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<vector>
+#include	<thread>
+#include	<algorithm>
+#include	<atomic>
+
+#include	<glm/glm.hpp>
+
+#include	"compute.h"
+#include	"clipmap.h"
+#include	"config.h"
+#include	"mesh_pack.h"
+#include	"options.h"
+#include	"threadpool.h"
+#include	"timer.h"
+#include	"volume.h"
+#include	"volume_constants.h"
+
+// ----------------------------------------------------------------------------
+// leven_bake generates the meshes for every clipmap node of a world offline and
+// writes them to a mesh pack, which the clipmap then loads instead of generating
+// the meshes at runtime.
+//
+//		leven_bake <pack path> [world brick count XZ] [noise seed]
+//
+// The world size and seed default to the values the viewer would use, and must
+// match when the pack is loaded. The meshes are generated on the GPU from the
+// main thread while the previous batch is simplified on the thread pool.
+// ----------------------------------------------------------------------------
+
+struct BakeNode
+{
+	glm::ivec3					min;
+	int							size = 0;
+	Compute_MeshGenContext*		meshGen = nullptr;			// i.e. for the node's LOD
+	MeshBuffer*					meshBuffer = nullptr;
+	std::vector<SeamNodeInfo>	seamNodes;
+};
+
+// ----------------------------------------------------------------------------
+
+static void CollectNodes(
+	const glm::ivec3& min, 
+	const int size, 
+	const int maxNodeSize,
+	std::vector<BakeNode>& nodes)
+{
+	if (size <= maxNodeSize)
+	{
+		BakeNode node;
+		node.min = min;
+		node.size = size;
+		nodes.push_back(node);
+	}
+
+	if (size > CLIPMAP_LEAF_SIZE)
+	{
+		const int childSize = size / 2;
+		for (int i = 0; i < 8; i++)
+		{
+			CollectNodes(min + (CHILD_MIN_OFFSETS[i] * childSize), childSize, maxNodeSize, nodes);
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static bool GenerateBatch(
+	std::vector<BakeNode>& nodes,
+	const size_t first,
+	const size_t last,
+	std::vector<MeshBuffer*>& meshBuffers)
+{
+	std::atomic<bool> success(true);
+	const auto generateNode = [&](const size_t i)
+	{
+		BakeNode& node = nodes[i];
+		node.meshBuffer = meshBuffers[i - first];
+
+		// the mesh is kept rather than simplified from the readback so the next batch 
+		// can be generated while this one is simplified
+		const int error = node.meshGen->generateChunkMesh(node.min, node.size, [&node](const ChunkMeshData& data)
+		{
+			Compute_UnpackChunkMesh(data, node.meshBuffer);
+			node.seamNodes.assign(data.seamNodes, data.seamNodes + data.numSeamNodes);
+		});
+
+		if (error)
+		{
+			printf("Error generating node [%d %d %d] size=%d: %s (%d)\n",
+				node.min.x, node.min.y, node.min.z, node.size, GetCLErrorString(error), error);
+			success = false;
+		}
+	};
+
+	if (Compute_NumDevices() > 1)
+	{
+		// each device has its own queue so the nodes can be generated in parallel
+		JobGroup generateJobs;
+		for (size_t i = first; i < last; i++)
+		{
+			generateJobs.schedule([&generateNode, i]() { generateNode(i); });
+		}
+
+		generateJobs.wait();
+	}
+	else
+	{
+		for (size_t i = first; i < last && success; i++)
+		{
+			generateNode(i);
+		}
+	}
+
+	return success;
+}
+
+// ----------------------------------------------------------------------------
+
+static void SimplifyBatch(
+	std::vector<BakeNode>& nodes,
+	const size_t first,
+	const size_t last,
+	JobGroup& jobGroup)
+{
+	const Options& options = Options::get();
+	for (size_t i = first; i < last; i++)
+	{
+		BakeNode* node = &nodes[i];
+		if (node->meshBuffer->numTriangles == 0)
+		{
+			continue;
+		}
+
+		jobGroup.schedule([node, &options]()
+		{
+			Clipmap_SimplifyNodeMesh(node->meshBuffer, node->min, node->size, node->meshGen->voxelsPerChunk(),
+				options.meshMaxError_, options.meshMaxEdgeLen_, options.meshMinCosAngle_);
+		});
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static bool WriteBatch(
+	MeshPackWriter& writer,
+	std::vector<BakeNode>& nodes,
+	const size_t first,
+	const size_t last)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		BakeNode& node = nodes[i];
+		if (!writer.addNode(node.min, node.size, node.meshGen->voxelsPerChunk(), node.meshBuffer, node.seamNodes))
+		{
+			return false;
+		}
+
+		node.meshBuffer = nullptr;
+		std::vector<SeamNodeInfo>().swap(node.seamNodes);
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: leven_bake <pack path> [world brick count XZ] [noise seed]\n");
+		return EXIT_FAILURE;
+	}
+
+	Config config;
+	if (!Config_Load(config, "default.cfg"))
+	{
+		printf("Unable to load default.cfg!\n");
+		return EXIT_FAILURE;
+	}
+
+	const std::string packPath = argv[1];
+	const int worldBrickCountXZ = argc >= 3 ? atoi(argv[2]) : 2;
+	const int noiseSeed = argc >= 4 ? atoi(argv[3]) : config.noiseSeed;
+
+	const int numThreads = glm::max(1, (int)std::thread::hardware_concurrency() - 1);
+	ThreadPool_Initialise(numThreads);
+
+	Compute_SetDeviceSelection(config.computeDevices);
+	if (int error = Compute_Initialise(noiseSeed, 0))
+	{
+		printf("Compute_Initialise: a fatal error occured: %d\n", error);
+		return EXIT_FAILURE;
+	}
+
+	// each node is only generated once so there's no point keeping the evicted octrees
+	Compute_SetSpillOptions(0, "");
+	Compute_SetCollapseOptions(config.meshCollapseMaxError);
+	Compute_SetMeshExtractors(config.meshExtractors);
+
+	if (Compute_SetDensityGraph(config.densityGraph))
+	{
+		printf("Unable to load the density graph '%s', using the default terrain\n", config.densityGraph.c_str());
+	}
+
+	if (!Clipmap_SetConfig(config.lodVoxelsPerChunk, config.lodActiveDistances))
+	{
+		return EXIT_FAILURE;
+	}
+
+	// one mesh generator per resolution, as in Clipmap::initialise
+	const ClipmapConfig& clipmapConfig = Clipmap_GetConfig();
+	std::vector<Compute_MeshGenContext*> meshGens(clipmapConfig.numLODs, nullptr);
+	for (int lod = 0; lod < clipmapConfig.numLODs; lod++)
+	{
+		for (int i = 0; i < lod; i++)
+		{
+			if (clipmapConfig.lodVoxelsPerChunk[i] == clipmapConfig.lodVoxelsPerChunk[lod])
+			{
+				meshGens[lod] = meshGens[i];
+			}
+		}
+
+		if (!meshGens[lod])
+		{
+			meshGens[lod] = Compute_MeshGenContext::create(clipmapConfig.lodVoxelsPerChunk[lod]);
+		}
+
+		if (!meshGens[lod])
+		{
+			printf("Unable to create mesh generator\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	const AABB worldBounds = WorldBoundsForBrickCount(worldBrickCountXZ);
+
+	glm::ivec3 rootMin;
+	int rootSize = 0;
+	Clipmap_CalculateRootNode(worldBounds, rootMin, rootSize);
+
+	// bake in index order so the nodes close together in the index are close together in the file
+	std::vector<BakeNode> nodes;
+	CollectNodes(rootMin, rootSize, clipmapConfig.maxNodeSize(), nodes);
+	for (BakeNode& node: nodes)
+	{
+		node.meshGen = meshGens[clipmapConfig.lodForNodeSize(node.size)];
+	}
+
+	std::sort(begin(nodes), end(nodes),
+		[&](const BakeNode& a, const BakeNode& b)
+		{
+			return MeshPack_NodeKey(rootMin, a.min, a.size) < MeshPack_NodeKey(rootMin, b.min, b.size);
+		});
+
+	printf("Baking '%s': seed=%d bricks=%d nodes=%d threads=%d\n",
+		packPath.c_str(), noiseSeed, worldBrickCountXZ, (int)nodes.size(), numThreads);
+
+	MeshPackWriter writer;
+	if (!writer.open(packPath, noiseSeed, Compute_DensityGraphHash(), rootMin, rootSize))
+	{
+		return EXIT_FAILURE;
+	}
+
+	// two sets of buffers so one batch can be generated while the other is simplified
+	const size_t batchSize = numThreads * 2;
+	std::vector<MeshBuffer*> meshBuffers[2];
+	for (int i = 0; i < 2; i++)
+	{
+		for (size_t j = 0; j < batchSize; j++)
+		{
+			meshBuffers[i].push_back(new MeshBuffer);
+		}
+	}
+
+	Timer timer;
+	timer.start();
+
+	bool success = true;
+	size_t pendingFirst = 0, pendingLast = 0;
+	JobGroup pendingJobs;
+	for (size_t first = 0, batch = 0; success && first < nodes.size(); first += batchSize, batch++)
+	{
+		const size_t last = std::min(first + batchSize, nodes.size());
+		success = GenerateBatch(nodes, first, last, meshBuffers[batch & 1]);
+
+		pendingJobs.wait();
+		success = success && WriteBatch(writer, nodes, pendingFirst, pendingLast);
+
+		pendingFirst = first;
+		pendingLast = last;
+		SimplifyBatch(nodes, first, last, pendingJobs);
+
+		if ((batch % 64) == 0)
+		{
+			printf("  %d / %d nodes\n", (int)first, (int)nodes.size());
+		}
+	}
+
+	pendingJobs.wait();
+	success = success && WriteBatch(writer, nodes, pendingFirst, pendingLast);
+	success = success && writer.finish();
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (MeshBuffer* buffer: meshBuffers[i])
+		{
+			buffer->release();
+			delete buffer;
+		}
+	}
+
+	ThreadPool_Destroy();
+	Compute_Shutdown();
+
+	if (!success)
+	{
+		printf("Bake failed\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("Baked %d non-empty nodes in %.1fs\n", writer.numNodes(), timer.elapsedMilli() / 1000.f);
+	return EXIT_SUCCESS;
+}
+
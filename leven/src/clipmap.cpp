@@ -9,6 +9,8 @@
 #include	"random.h"
 #include	"ng_mesh_simplify.h"
 #include	"options.h"
+#include	"mesh_pack.h"
+#include	"threadpool.h"
 
 #include	<glm/ext.hpp>
 #include	<unordered_set>
@@ -17,6 +19,8 @@
 #include	<atomic>
 #include	<deque>
 #include	<mutex>
+#include	<sstream>
+#include	<string.h>
 #include	<Remotery.h>
 
 using glm::ivec3;
@@ -24,23 +28,96 @@ using glm::ivec4;
 using glm::vec4;
 using glm::vec3;
 
-// TODO bad
-const int NUM_LODS = 6;
+int g_debugDrawBuffer = -1;
 
-// i.e. the size of the largest node that will render
-const int LOD_MAX_NODE_SIZE = CLIPMAP_LEAF_SIZE * (1 << (NUM_LODS - 1));	
+// ----------------------------------------------------------------------------
 
-const float LOD_ACTIVE_DISTANCES[NUM_LODS] = 
-{ 
-	0.f,
-	CLIPMAP_LEAF_SIZE * 1.5f,
-	CLIPMAP_LEAF_SIZE * 3.5f,
-	CLIPMAP_LEAF_SIZE * 5.5f,
-	CLIPMAP_LEAF_SIZE * 7.5f,
-	CLIPMAP_LEAF_SIZE * 13.5f,
-};
+ClipmapConfig::ClipmapConfig()
+	: numLODs(NUM_LODS)
+{
+	const float defaultDistances[NUM_LODS] = { 0.f, 1.5f, 3.5f, 5.5f, 7.5f, 13.5f };
+	for (int i = 0; i < MAX_LODS; i++)
+	{
+		lodVoxelsPerChunk[i] = CLIPMAP_VOXELS_PER_CHUNK;
+		lodActiveDistances[i] = defaultDistances[glm::min(i, NUM_LODS - 1)];
+	}
+}
 
-int g_debugDrawBuffer = -1;
+// ----------------------------------------------------------------------------
+
+int ClipmapConfig::lodForNodeSize(const int size) const
+{
+	return glm::clamp(glm::log2(glm::max(1, size / CLIPMAP_LEAF_SIZE)), 0, numLODs - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+int ClipmapConfig::voxelsPerChunk(const int size) const
+{
+	return lodVoxelsPerChunk[lodForNodeSize(size)];
+}
+
+// ----------------------------------------------------------------------------
+
+int ClipmapConfig::maxNodeSize() const
+{
+	return CLIPMAP_LEAF_SIZE << (numLODs - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+static ClipmapConfig g_clipmapConfig;
+
+bool Clipmap_SetConfig(const std::string& lodVoxelsPerChunk, const std::string& lodActiveDistances)
+{
+	ClipmapConfig config;
+	std::string value;
+
+	std::stringstream distanceStream(lodActiveDistances);
+	for (int lod = 0; std::getline(distanceStream, value, ','); lod++)
+	{
+		if (lod >= MAX_LODS)
+		{
+			printf("Clipmap_SetConfig: too many LODs, the max is %d\n", MAX_LODS);
+			return false;
+		}
+
+		config.lodActiveDistances[lod] = (float)atof(value.c_str());
+		config.numLODs = lod + 1;
+	}
+
+	int lastVoxelsPerChunk = CLIPMAP_VOXELS_PER_CHUNK;
+	std::stringstream voxelsStream(lodVoxelsPerChunk);
+	for (int lod = 0; lod < config.numLODs; lod++)
+	{
+		if (std::getline(voxelsStream, value, ','))
+		{
+			lastVoxelsPerChunk = atoi(value.c_str());
+		}
+
+		// each node must have at least one voxel per LEAF_SIZE_SCALE units
+		const int voxelsPerChunk = lastVoxelsPerChunk;
+		const int maxVoxelsPerChunk = glm::min(CLIPMAP_VOXELS_PER_CHUNK << lod, COMPUTE_MAX_VOXELS_PER_CHUNK);
+		if (voxelsPerChunk < 8 || voxelsPerChunk > maxVoxelsPerChunk || (voxelsPerChunk & (voxelsPerChunk - 1)) != 0)
+		{
+			printf("Clipmap_SetConfig: invalid voxelsPerChunk %d for LOD %d, must be a power of 2 in [8, %d]\n",
+				voxelsPerChunk, lod, maxVoxelsPerChunk);
+			return false;
+		}
+
+		config.lodVoxelsPerChunk[lod] = voxelsPerChunk;
+	}
+
+	g_clipmapConfig = config;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+const ClipmapConfig& Clipmap_GetConfig()
+{
+	return g_clipmapConfig;
+}
 
 // ----------------------------------------------------------------------------
 
@@ -353,33 +430,106 @@ const vec3 ColourForMinLeafSize(const int minLeafSize)
 
 // ----------------------------------------------------------------------------
 
+void CreateSeamNodes(
+	const int voxelsPerChunk,
+	const ivec3& min,
+	const int clipmapNodeSize,
+	const SeamNodeInfo* seamNodeInfo,
+	const int count,
+	OctreeNode** seamNodes,
+	int* numSeamNodes)
+{
+	if (count > 0)
+	{
+		OctreeNode* nodeBuffer = new OctreeNode[count];
+		const int seamNodeSize = clipmapNodeSize / voxelsPerChunk;
+		for (int i = 0; i < count; i++)
+		{
+			OctreeNode* seamNode = &nodeBuffer[i];
+			const SeamNodeInfo& info = seamNodeInfo[i];
+
+			seamNode->size = seamNodeSize;
+			seamNode->min = ivec3(info.localspaceMin) * seamNodeSize + min;
+			seamNode->type = Node_Leaf;
+			seamNode->drawInfo = new OctreeDrawInfo;
+			seamNode->drawInfo->averageNormal = vec3(info.normal);
+			seamNode->drawInfo->position = vec3(info.position);
+			seamNode->drawInfo->colour = ColourForMinLeafSize(clipmapNodeSize);
+			seamNode->drawInfo->materialInfo = info.localspaceMin.w;
+		}
+
+		*seamNodes = nodeBuffer;
+		*numSeamNodes = count;
+	}
+	else
+	{
+		*seamNodes = nullptr;
+		*numSeamNodes = 0;
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static MeshSimplificationOptions NodeSimplificationOptions(
+	const int size,
+	const int voxelsPerChunk,
+	const float meshMaxError,
+	const float meshMaxEdgeLen,
+	const float meshMaxAngle)
+{
+	const float leafSize = (float)(size / voxelsPerChunk);
+
+	MeshSimplificationOptions options;
+	options.maxError = meshMaxError * leafSize;
+	options.maxEdgeSize = meshMaxEdgeLen * leafSize;
+	options.minAngleCosine = meshMaxAngle;
+	return options;
+}
+
+// ----------------------------------------------------------------------------
+
+// the mesh is simplified and the seam nodes created straight from the readback
 bool GenerateMeshDataForNode(
 	Compute_MeshGenContext* meshGen,
 	const char* const tag,
 	const ivec3& min,
 	const int clipmapNodeSize,
+	const MeshSimplificationOptions& options,
 	MeshBuffer** meshBuffer,
 	OctreeNode** seamNodes,
 	int* numSeamNodes)
 {
 	rmt_ScopedCPUSample(GenerateMeshDataForNode);
 
-	MeshBuffer* buffer = Render_AllocMeshBuffer(tag);
+	// sized when the mesh is read back
+	MeshBuffer* buffer = Render_AllocMeshBuffer(tag, 0, 0);
 	if (!buffer)
 	{
 		printf("Error: unable to alloc mesh buffer\n");
 		return false;
 	}
 
-	buffer->numTriangles = 0;
-	buffer->numVertices = 0;
+	const vec4 centrePos = vec4(vec3(min) + vec3(clipmapNodeSize / 2.f), 0.f);
+	OctreeNode* nodes = nullptr;
+	int numNodes = 0;
+	const int error = meshGen->generateChunkMesh(min, clipmapNodeSize, [&](const ChunkMeshData& data)
+	{
+		ngMeshSimplifier(data.vertices, data.numVertices, data.bounds, data.triangles, data.numTriangles,
+			buffer, centrePos, options);
+		CreateSeamNodes(meshGen->voxelsPerChunk(), min, clipmapNodeSize, 
+			data.seamNodes, data.numSeamNodes, &nodes, &numNodes);
+	});
 
-	std::vector<SeamNodeInfo> seamNodeInfo;
-	const int error = meshGen->generateChunkMesh(min, clipmapNodeSize, buffer, seamNodeInfo);
 	if (error < 0)
 	{
 		printf("Error generating mesh: %d\n", error);
 		Render_FreeMeshBuffer(buffer);
+		for (int i = 0; i < numNodes; i++)
+		{
+			delete nodes[i].drawInfo;
+		}
+
+		delete[] nodes;
 		return false;
 	}
 
@@ -395,34 +545,306 @@ bool GenerateMeshDataForNode(
 		Render_FreeMeshBuffer(buffer);
 	}
 
-	if (!seamNodeInfo.empty())
+	*seamNodes = nodes;
+	*numSeamNodes = numNodes;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void Clipmap_SimplifyNodeMesh(
+	MeshBuffer* meshBuffer,
+	const ivec3& min,
+	const int size,
+	const int voxelsPerChunk,
+	const float meshMaxError,
+	const float meshMaxEdgeLen,
+	const float meshMaxAngle)
+{
+	const vec4 centrePos = vec4(vec3(min) + vec3(size / 2.f), 0.f);
+	ngMeshSimplifier(meshBuffer, centrePos, 
+		NodeSimplificationOptions(size, voxelsPerChunk, meshMaxError, meshMaxEdgeLen, meshMaxAngle));
+}
+
+// ----------------------------------------------------------------------------
+
+// the pack meshes are simplified when baked so the buffer only needs filled from the mapping
+bool LoadMeshDataForNode(
+	const MeshPack& meshPack,
+	const ivec3& min,
+	const int clipmapNodeSize,
+	MeshBuffer** meshBuffer,
+	OctreeNode** seamNodes,
+	int* numSeamNodes)
+{
+	rmt_ScopedCPUSample(LoadMeshDataForNode);
+
+	*meshBuffer = nullptr;
+	*seamNodes = nullptr;
+	*numSeamNodes = 0;
+
+	const MeshPackNode* packNode = meshPack.findNode(min, clipmapNodeSize);
+	if (!packNode)
+	{
+		// not in the pack so the node is empty
+		return true;
+	}
+
+	if (packNode->numTriangles > 0)
 	{
-		OctreeNode* nodeBuffer = new OctreeNode[seamNodeInfo.size()];
-		const int seamNodeSize = clipmapNodeSize / meshGen->voxelsPerChunk();
-		for (int i = 0; i < seamNodeInfo.size(); i++)
+		MeshBuffer* buffer = Render_AllocMeshBuffer("clipmap", packNode->numVertices, packNode->numTriangles);
+		if (!buffer)
 		{
-			OctreeNode* seamNode = &nodeBuffer[i];
-			const SeamNodeInfo& info = seamNodeInfo[i];
+			printf("Error: unable to alloc mesh buffer\n");
+			return false;
+		}
 
-			seamNode->size = seamNodeSize;
-			seamNode->min = ivec3(info.localspaceMin) * seamNodeSize + min;
-			seamNode->type = Node_Leaf;
-			seamNode->drawInfo = new OctreeDrawInfo;
-			seamNode->drawInfo->averageNormal = vec3(info.normal);
-			seamNode->drawInfo->position = vec3(info.position);
-			seamNode->drawInfo->colour = ColourForMinLeafSize(clipmapNodeSize);
-			seamNode->drawInfo->materialInfo = info.localspaceMin.w;
+		memcpy(buffer->vertices, meshPack.vertices(packNode), packNode->numVertices * sizeof(MeshVertex));
+		memcpy(buffer->triangles, meshPack.triangles(packNode), packNode->numTriangles * sizeof(MeshTriangle));
+		buffer->numVertices = packNode->numVertices;
+		buffer->numTriangles = packNode->numTriangles;
+		*meshBuffer = buffer;
+	}
+
+	CreateSeamNodes(packNode->voxelsPerChunk, min, clipmapNodeSize, 
+		meshPack.seamNodes(packNode), packNode->numSeamNodes, seamNodes, numSeamNodes);
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+// The edited LOD 0 nodes keep their simplified mesh split into regions (see 
+// MESH_REGIONS_PER_AXIS) so the next edit only needs to regenerate, read back and 
+// simplify the regions the brush touched, the regions are then joined to create the
+// node's new mesh. Each region has its own copy of the vertices its triangles use
+// and the simplifier never moves the open boundary vertices, so the regions still
+// meet without cracks.
+// ----------------------------------------------------------------------------
+
+struct ClipmapMeshRegions
+{
+	std::vector<MeshVertex>		vertices[NUM_MESH_REGIONS];
+	std::vector<MeshTriangle>	triangles[NUM_MESH_REGIONS];
+};
+
+// ----------------------------------------------------------------------------
+
+static u64 FindTouchedMeshRegions(
+	const ClipmapNode* node, 
+	const int voxelsPerChunk,
+	const AABB& bounds)
+{
+	// a changed leaf moves the vertex of its whole cluster (up to 8 voxels, see 
+	// Compute_SetCollapseOptions) and the triangles are generated by the node at the
+	// min of each edge, so the bounds are padded to cover every changed triangle
+	const int leafSize = node->size_ / voxelsPerChunk;
+	const ivec3 padding((8 + 2) * leafSize);
+	const AABB paddedBounds(bounds.min - padding, bounds.max + padding);
+	if (!paddedBounds.overlaps(AABB(node->min_, node->size_)))
+	{
+		return 0;
+	}
+
+	const int regionSize = node->size_ / MESH_REGIONS_PER_AXIS;
+	const ivec3 nodeMax = node->min_ + ivec3(node->size_ - 1);
+	const ivec3 regionMin = (glm::clamp(paddedBounds.min, node->min_, nodeMax) - node->min_) / regionSize;
+	const ivec3 regionMax = (glm::clamp(paddedBounds.max, node->min_, nodeMax) - node->min_) / regionSize;
+
+	u64 regionMask = 0;
+	for (int z = regionMin.z; z <= regionMax.z; z++)
+	for (int y = regionMin.y; y <= regionMax.y; y++)
+	for (int x = regionMin.x; x <= regionMax.x; x++)
+	{
+		const int region = x + (y * MESH_REGIONS_PER_AXIS) + (z * MESH_REGIONS_PER_AXIS * MESH_REGIONS_PER_AXIS);
+		regionMask |= (1ULL << region);
+	}
+
+	return regionMask;
+}
+
+// ----------------------------------------------------------------------------
+
+// splits the triangles of the regionMask regions out of the chunk mesh and simplifies
+// each region on its own, replacing the regions' previous meshes. The chunk mesh is 
+// read straight from the readback, the vertices are unpacked as they're split out.
+static void UpdateMeshRegions(
+	const ChunkMeshData& chunkMesh,
+	const u64 regionMask,
+	const ClipmapNode* node,
+	const int voxelsPerChunk,
+	const float meshMaxError,
+	const float meshMaxEdgeLen,
+	const float meshMaxAngle,
+	MeshBuffer* scratch,
+	ClipmapMeshRegions* regions)
+{
+	rmt_ScopedCPUSample(UpdateMeshRegions);
+
+	std::vector<int> regionTriangles[NUM_MESH_REGIONS];
+	for (int i = 0; i < chunkMesh.numTriangles; i++)
+	{
+		regionTriangles[chunkMesh.triangleRegions[i]].push_back(i);
+	}
+
+	// no region can use more than the whole chunk mesh
+	scratch->numVertices = 0;
+	scratch->numTriangles = 0;
+	scratch->reserve(chunkMesh.numVertices, chunkMesh.numTriangles);
+
+	std::vector<int> vertexMap(chunkMesh.numVertices, -1);
+	for (int region = 0; region < NUM_MESH_REGIONS; region++)
+	{
+		if (((regionMask >> region) & 1) == 0)
+		{
+			continue;
 		}
 
-		*seamNodes = nodeBuffer;
-		*numSeamNodes = seamNodeInfo.size();
+		scratch->numVertices = 0;
+		scratch->numTriangles = 0;
+		for (const int t: regionTriangles[region])
+		{
+			MeshTriangle triangle = chunkMesh.triangles[t];
+			for (int i = 0; i < 3; i++)
+			{
+				int& vertex = vertexMap[triangle.indices_[i]];
+				if (vertex == -1)
+				{
+					vertex = scratch->numVertices++;
+					scratch->vertices[vertex] = UnpackMeshVertex(chunkMesh.vertices[triangle.indices_[i]], chunkMesh.bounds);
+				}
+
+				triangle.indices_[i] = vertex;
+			}
+
+			scratch->triangles[scratch->numTriangles++] = triangle;
+		}
+
+		// reset the entries used so the map doesn't need cleared for each region
+		for (const int t: regionTriangles[region])
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				vertexMap[chunkMesh.triangles[t].indices_[i]] = -1;
+			}
+		}
+
+		Clipmap_SimplifyNodeMesh(scratch, node->min_, node->size_, voxelsPerChunk,
+			meshMaxError, meshMaxEdgeLen, meshMaxAngle);
+
+		regions->vertices[region].assign(scratch->vertices, scratch->vertices + scratch->numVertices);
+		regions->triangles[region].assign(scratch->triangles, scratch->triangles + scratch->numTriangles);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static void JoinMeshRegions(
+	const ClipmapMeshRegions& regions,
+	MeshBuffer* meshBuffer)
+{
+	int numVertices = 0, numTriangles = 0;
+	for (int region = 0; region < NUM_MESH_REGIONS; region++)
+	{
+		numVertices += regions.vertices[region].size();
+		numTriangles += regions.triangles[region].size();
+	}
+
+	meshBuffer->numVertices = 0;
+	meshBuffer->numTriangles = 0;
+	meshBuffer->reserve(numVertices, numTriangles);
+
+	for (int region = 0; region < NUM_MESH_REGIONS; region++)
+	{
+		const std::vector<MeshVertex>& vertices = regions.vertices[region];
+		const std::vector<MeshTriangle>& triangles = regions.triangles[region];
+		const int baseVertex = meshBuffer->numVertices;
+		std::copy(begin(vertices), end(vertices), &meshBuffer->vertices[baseVertex]);
+		meshBuffer->numVertices += vertices.size();
+
+		for (const MeshTriangle& triangle: triangles)
+		{
+			meshBuffer->triangles[meshBuffer->numTriangles++] = MeshTriangle(
+				triangle.indices_[0] + baseVertex,
+				triangle.indices_[1] + baseVertex,
+				triangle.indices_[2] + baseVertex);
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+// returns false if the node should be constructed normally instead, the first call for
+// a node creates all the regions
+static bool ConstructNodeDataFromRegions(
+	Compute_MeshGenContext* meshGen,
+	ClipmapNode* node,
+	const float meshMaxError,
+	const float meshMaxEdgeLen,
+	const float meshMaxAngle)
+{
+	rmt_ScopedCPUSample(ConstructFromRegions);
+
+	MeshBuffer* meshBuffer = Render_AllocMeshBuffer("clipmap", 0, 0);
+	MeshBuffer* scratch = Render_AllocMeshBuffer("clipmap_region", 0, 0);
+	if (!meshBuffer || !scratch)
+	{
+		if (meshBuffer) Render_FreeMeshBuffer(meshBuffer);
+		if (scratch) Render_FreeMeshBuffer(scratch);
+		return false;
+	}
+
+	meshBuffer->numVertices = 0;
+	meshBuffer->numTriangles = 0;
+
+	const u64 regionMask = node->meshRegions ? node->dirtyRegions : ALL_MESH_REGIONS;
+	if (!node->meshRegions)
+	{
+		node->meshRegions = new ClipmapMeshRegions;
+	}
+
+	OctreeNode* seamNodes = nullptr;
+	int numSeamNodes = 0;
+	const int error = meshGen->generateChunkMeshRegions(node->min_, node->size_, regionMask, 
+		[&](const ChunkMeshData& data)
+	{
+		UpdateMeshRegions(data, regionMask, node, meshGen->voxelsPerChunk(),
+			meshMaxError, meshMaxEdgeLen, meshMaxAngle, scratch, node->meshRegions);
+		CreateSeamNodes(meshGen->voxelsPerChunk(), node->min_, node->size_, 
+			data.seamNodes, data.numSeamNodes, &seamNodes, &numSeamNodes);
+	});
+
+	Render_FreeMeshBuffer(scratch);
+	if (error < 0)
+	{
+		// the caller discards the regions and constructs the node normally
+		printf("Error generating mesh regions: %d\n", error);
+		Render_FreeMeshBuffer(meshBuffer);
+		for (int i = 0; i < numSeamNodes; i++)
+		{
+			delete seamNodes[i].drawInfo;
+		}
+
+		delete[] seamNodes;
+		return false;
+	}
+
+	JoinMeshRegions(*node->meshRegions, meshBuffer);
+
+	node->dirtyRegions = 0;
+	node->seamNodes = seamNodes;
+	node->numSeamNodes = numSeamNodes;
+
+	if (meshBuffer->numTriangles > 0)
+	{
+		const vec3 centrePos = vec3(node->min_) + vec3(node->size_ / 2.f);
+		node->renderMesh = Render_AllocRenderMesh("clipmap", meshBuffer, centrePos);
 	}
 	else
 	{
-		*seamNodes = nullptr;
-		*numSeamNodes = 0;
+		Render_FreeMeshBuffer(meshBuffer);
 	}
 
+	node->active_ = node->numSeamNodes != 0 || node->renderMesh;
 	return true;
 }
 
@@ -430,6 +852,7 @@ bool GenerateMeshDataForNode(
 
 int ConstructClipmapNodeData(
 	Compute_MeshGenContext* meshGen,
+	const MeshPack* meshPack,
 	ClipmapNode* node,
 	const float meshMaxError,
 	const float meshMaxEdgeLen,
@@ -442,27 +865,55 @@ int ConstructClipmapNodeData(
 	LVN_ASSERT(!node->seamMesh);
 	LVN_ASSERT(!node->seamNodes);
 
+	// nodes touched by a CSG op no longer match the baked mesh
+	if (meshPack && !Compute_HasCSGOperations(node->min_, node->size_))
+	{
+		MeshBuffer* meshBuffer = nullptr;
+		if (!LoadMeshDataForNode(*meshPack, node->min_, node->size_, 
+				&meshBuffer, &node->seamNodes, &node->numSeamNodes))
+		{
+			node->active_ = false;
+			return LVN_SUCCESS;
+		}
+
+		if (meshBuffer)
+		{
+			const vec3 centrePos = vec3(node->min_) + vec3(node->size_ / 2.f);
+			node->renderMesh = Render_AllocRenderMesh("clipmap", meshBuffer, centrePos);
+		}
+
+		node->active_ = node->numSeamNodes != 0 || node->renderMesh;
+		return LVN_SUCCESS;
+	}
+
+	// the nodes being sculpted are rebuilt a region at a time, see ClipmapMeshRegions
+	const bool edited = node->edited_;
+	node->edited_ = false;
+	if (edited && node->size_ == CLIPMAP_LEAF_SIZE &&
+		ConstructNodeDataFromRegions(meshGen, node, meshMaxError, meshMaxEdgeLen, meshMaxAngle))
+	{
+		return LVN_SUCCESS;
+	}
+
+	delete node->meshRegions;
+	node->meshRegions = nullptr;
+	node->dirtyRegions = 0;
+
+	const MeshSimplificationOptions options = NodeSimplificationOptions(node->size_, 
+		meshGen->voxelsPerChunk(), meshMaxError, meshMaxEdgeLen, meshMaxAngle);
+
 	MeshBuffer* meshBuffer = nullptr;
 	if (!GenerateMeshDataForNode(meshGen, "clipmap", 
-		node->min_, node->size_, &meshBuffer, &node->seamNodes, &node->numSeamNodes))
+		node->min_, node->size_, options, &meshBuffer, &node->seamNodes, &node->numSeamNodes))
 	{
 		node->active_ = false;
 		return LVN_SUCCESS;
 	}
 
-
 	if (meshBuffer)
 	{
-		const vec4 centrePos = vec4(vec3(node->min_) + vec3(node->size_ / 2.f), 0.f);
-		const float leafSize = LEAF_SIZE_SCALE * (node->size_ / CLIPMAP_LEAF_SIZE);
-
-		MeshSimplificationOptions options;
-		options.maxError = meshMaxError * leafSize;
-		options.maxEdgeSize = meshMaxEdgeLen * leafSize;
-		options.minAngleCosine = meshMaxAngle;
-
-		ngMeshSimplifier(meshBuffer, centrePos, options);
-		node->renderMesh = Render_AllocRenderMesh("clipmap", meshBuffer, vec3(centrePos));
+		const vec3 centrePos = vec3(node->min_) + vec3(node->size_ / 2.f);
+		node->renderMesh = Render_AllocRenderMesh("clipmap", meshBuffer, centrePos);
 	}
 
 	node->active_ = node->numSeamNodes != 0 || node->renderMesh;
@@ -483,22 +934,16 @@ MeshBuffer* ConstructCollisionNodeData(
 	LVN_ASSERT(node->numSeamNodes == 0);
 	LVN_ASSERT(!node->seamNodes);
 
-	MeshBuffer* meshBuffer = nullptr;
-	GenerateMeshDataForNode(meshGen, "collision", 
-		node->min, COLLISION_NODE_SIZE, &meshBuffer, &node->seamNodes, &node->numSeamNodes);
+	const float leafSize = LEAF_SIZE_SCALE * (COLLISION_NODE_SIZE / CLIPMAP_LEAF_SIZE);
 
-	if (meshBuffer)
-	{
-		const vec4 centrePos = vec4(vec3(node->min) + vec3(COLLISION_NODE_SIZE / 2.f), 0.f);
-		const float leafSize = LEAF_SIZE_SCALE * (COLLISION_NODE_SIZE / CLIPMAP_LEAF_SIZE);
+	MeshSimplificationOptions options;
+	options.maxError = meshMaxError * leafSize;
+	options.maxEdgeSize = meshMaxEdgeLen * leafSize;
+	options.minAngleCosine = meshMaxAngle;
 
-		MeshSimplificationOptions options;
-		options.maxError = meshMaxError * leafSize;
-		options.maxEdgeSize = meshMaxEdgeLen * leafSize;
-		options.minAngleCosine = meshMaxAngle;
-
-		ngMeshSimplifier(meshBuffer, centrePos, options);
-	}
+	MeshBuffer* meshBuffer = nullptr;
+	GenerateMeshDataForNode(meshGen, "collision", 
+		node->min, COLLISION_NODE_SIZE, options, &meshBuffer, &node->seamNodes, &node->numSeamNodes);
 
 	return meshBuffer;
 }
@@ -540,10 +985,8 @@ bool FilterSeamNode(const int childIndex, const ivec3& seamBounds, const ivec3&
 // ----------------------------------------------------------------------------
 
 void SelectSeamNodes(
-	Compute_MeshGenContext* meshGen,
 	const ivec3& min, 
 	const int hostNodeSize, 
-	const int neighbourNodeSize, 
 	const int neighbourIndex,
 	OctreeNode* seamNodes,
 	const int numSeamNodes,
@@ -552,12 +995,12 @@ void SelectSeamNodes(
 	const ivec3 seamBounds = min + ivec3(hostNodeSize);
 	const AABB aabb(min, hostNodeSize * 2);
 
-	const int size = neighbourNodeSize / (meshGen->voxelsPerChunk() * LEAF_SIZE_SCALE);
 	for (int j = 0; j < numSeamNodes; j++)
 	{
+		// the seam node size depends on the neighbour's LOD and voxelsPerChunk
 		OctreeNode* node = &seamNodes[j];
 
-		const auto max = node->min + ivec3(size * LEAF_SIZE_SCALE);
+		const auto max = node->min + ivec3(node->size);
 		if (!FilterSeamNode(neighbourIndex, seamBounds, node->min, max) ||
 			!aabb.pointIsInside(node->min))
 		{
@@ -570,8 +1013,66 @@ void SelectSeamNodes(
 
 // ----------------------------------------------------------------------------
 
+
+// ----------------------------------------------------------------------------
+// The seam nodes' vertices are used as they are and the triangles joining them are
+// generated on the GPU, see Compute_GenerateSeamMesh. The CPU octree is only used
+// when the range of node sizes makes the seam octree too deep for the GPU's codes.
+// ----------------------------------------------------------------------------
+MeshBuffer* GenerateSeamMesh(
+	const std::vector<OctreeNode*>& seamNodes,
+	const ivec3& rootMin,
+	const int rootSize,
+	const vec3& colour)
+{
+	rmt_ScopedCPUSample(GenerateSeamMesh);
+	if (seamNodes.empty())
+	{
+		return nullptr;
+	}
+
+	MeshBuffer* meshBuffer = Render_AllocMeshBuffer("seam", seamNodes.size(), 0);
+	if (!meshBuffer)
+	{
+		printf("Error: unable to alloc mesh buffer\n");
+		return nullptr;
+	}
+
+	std::vector<SeamMeshNode> nodes(seamNodes.size());
+	for (size_t i = 0; i < seamNodes.size(); i++)
+	{
+		const OctreeNode* node = seamNodes[i];
+		const OctreeDrawInfo* d = node->drawInfo;
+		nodes[i].min = node->min;
+		nodes[i].size = node->size;
+		nodes[i].corners = d->materialInfo & 0xff;
+
+		meshBuffer->vertices[i] = MeshVertex(vec4(d->position, 0.f), vec4(d->averageNormal, 0.f), 
+			vec4(colour, (float)(d->materialInfo >> 8)));
+	}
+
+	meshBuffer->numVertices = seamNodes.size();
+
+	const int error = Compute_GenerateSeamMesh(rootMin, rootSize, nodes, meshBuffer);
+	if (error >= 0 && meshBuffer->numTriangles > 0)
+	{
+		return meshBuffer;
+	}
+
+	Render_FreeMeshBuffer(meshBuffer);
+	if (error >= 0)
+	{
+		return nullptr;
+	}
+
+	Octree seamOctree;
+	OctreeNode* seamRoot = Octree_ConstructUpwards(&seamOctree, seamNodes, rootMin, rootSize);
+	return Octree_GenerateMesh(seamRoot, colour);
+}
+
+// ----------------------------------------------------------------------------
+
 void GenerateClipmapSeamMesh(
-	Compute_MeshGenContext* meshGen,
 	ClipmapNode* node, 
 	const Clipmap& clipmap,
 	const vec3& colour)
@@ -591,21 +1092,17 @@ void GenerateClipmapSeamMesh(
 		std::vector<ClipmapNode*> activeNodes = clipmap.findActiveNodes(candidateNeighbour);
 		for (auto neighbourNode: activeNodes)
 		{
-			SelectSeamNodes(meshGen, node->min_, node->size_, neighbourNode->size_, i, 
+			SelectSeamNodes(node->min_, node->size_, i, 
 				neighbourNode->seamNodes, neighbourNode->numSeamNodes, seamNodes);
 		}
 	}
 
-	Octree seamOctree;
-	Octree_ConstructUpwards(&seamOctree, seamNodes, node->min_, node->size_ * 2);
-	OctreeNode* seamRoot = seamOctree.getRoot();
-
 	LVN_ASSERT(!node->seamMesh);
 
-	const int size = node->size_ / (meshGen->voxelsPerChunk() * LEAF_SIZE_SCALE);
-	if (MeshBuffer* meshBuffer = Octree_GenerateMesh(seamRoot, colour))
+	const int seamSize = node->size_ * 2;
+	if (MeshBuffer* meshBuffer = GenerateSeamMesh(seamNodes, node->min_, seamSize, colour))
 	{
-		const vec3 centrePos = vec3(seamRoot->min) + vec3(seamRoot->size / 2.f);
+		const vec3 centrePos = vec3(node->min_) + vec3(seamSize / 2.f);
 		node->seamMesh = Render_AllocRenderMesh("clipmap_seam", meshBuffer, centrePos);	
 	}
 }
@@ -627,16 +1124,12 @@ MeshBuffer* GenerateCollisionSeamMesh(
 		if (iter != end(g_clipmapCollisionNodes) && iter->second)
 		{
 			ClipmapCollisionNode* neighbourNode = iter->second;
-			SelectSeamNodes(meshGen, node->min, COLLISION_NODE_SIZE, COLLISION_NODE_SIZE, i,
+			SelectSeamNodes(node->min, COLLISION_NODE_SIZE, i,
 				neighbourNode->seamNodes, neighbourNode->numSeamNodes, seamNodes);
 		}
 	}
 
-	Octree seamOctree;
-	OctreeNode* seamRoot = Octree_ConstructUpwards(&seamOctree, seamNodes, node->min, COLLISION_NODE_SIZE * 2);
-
-	const int size = COLLISION_NODE_SIZE / (meshGen->voxelsPerChunk() * LEAF_SIZE_SCALE);
-	return Octree_GenerateMesh(seamRoot, colour);
+	return GenerateSeamMesh(seamNodes, node->min, COLLISION_NODE_SIZE * 2, colour);
 }
 
 // ----------------------------------------------------------------------------
@@ -648,7 +1141,15 @@ void ReleaseClipmapNodeData(
 {
 	node->active_ = false;
 
-	meshGen->freeChunkOctree(node->min_, node->size_);
+	if (!node->edited_)
+	{
+		// the edited nodes' octrees were patched so are kept for the reconstruction
+		meshGen->freeChunkOctree(node->min_, node->size_);
+
+		delete node->meshRegions;
+		node->meshRegions = nullptr;
+		node->dirtyRegions = 0;
+	}
 
 	if (node->renderMesh)
 	{
@@ -692,6 +1193,7 @@ void FreeClipmapNode(ClipmapNode* n)
 {
 	LVN_ALWAYS_ASSERT("Unknown clipmap node!", g_allocatedNodes.find(n) != end(g_allocatedNodes));
 	g_allocatedNodes.erase(n);
+	delete n->meshRegions;
 	delete n;
 }
 
@@ -794,11 +1296,9 @@ void InsertEmptyCollisionNodes(ClipmapNode* node)
 
 // ----------------------------------------------------------------------------
 
-void Clipmap::constructTree()
+void Clipmap_CalculateRootNode(const AABB& worldBounds, ivec3& rootMin, int& rootSize)
 {
-	root_ = AllocClipmapNode();
-
-	const ivec3 boundsSize = worldBounds_.max - worldBounds_.min;
+	const ivec3 boundsSize = worldBounds.max - worldBounds.min;
 	const int maxSize = glm::max(boundsSize.x, glm::max(boundsSize.y, boundsSize.z));
 
 	int factor = maxSize / CLIPMAP_LEAF_SIZE;
@@ -809,10 +1309,18 @@ void Clipmap::constructTree()
 		factor *= 2;
 	}
 
-	root_->size_ = factor * CLIPMAP_LEAF_SIZE;
+	rootSize = factor * CLIPMAP_LEAF_SIZE;
 
-	const ivec3 boundsCentre = worldBounds_.min + (boundsSize / 2);
-	root_->min_ = (boundsCentre - ivec3(root_->size_ / 2)) & ~(factor - 1);
+	const ivec3 boundsCentre = worldBounds.min + (boundsSize / 2);
+	rootMin = (boundsCentre - ivec3(rootSize / 2)) & ~(factor - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+void Clipmap::constructTree()
+{
+	root_ = AllocClipmapNode();
+	Clipmap_CalculateRootNode(worldBounds_, root_->min_, root_->size_);
 
 	ConstructChildren(root_);
 	CheckForEmptyNodes(physicsMeshGen_, root_, COLLISION_NODE_SIZE);
@@ -838,16 +1346,78 @@ void Clipmap::constructTree()
 
 // ----------------------------------------------------------------------------
 
+Compute_MeshGenContext* Clipmap::meshGenForNode(const int size) const
+{
+	return lodMeshGens_[config_.lodForNodeSize(size)];
+}
+
+// ----------------------------------------------------------------------------
+
 void Clipmap::initialise(
-	const AABB& worldBounds)
+	const AABB& worldBounds,
+	const int noiseSeed,
+	const std::string& meshPackPath)
 {
 	worldBounds_ = worldBounds;
 
+	if (!meshPackPath.empty())
+	{
+		ivec3 rootMin;
+		int rootSize = 0;
+		Clipmap_CalculateRootNode(worldBounds_, rootMin, rootSize);
+		meshPack_.open(meshPackPath, noiseSeed, Compute_DensityGraphHash(), rootMin, rootSize);
+	}
+
 	g_debugDrawBuffer = Render_AllocDebugDrawBuffer();
 	g_clipmapCollisionNodeAllocator.initialise(MAX_COLLISION_NODES);
 
-	clipmapMeshGen_ = Compute_MeshGenContext::create(CLIPMAP_VOXELS_PER_CHUNK); 
-	physicsMeshGen_ = Compute_MeshGenContext::create(COLLISION_VOXELS_PER_CHUNK); 
+	// one context per resolution, the LODs with the same voxelsPerChunk share it
+	config_ = Clipmap_GetConfig();
+	clipmapMeshGens_.clear();
+
+	const auto findOrCreateMeshGen = [&](const int voxelsPerChunk) -> Compute_MeshGenContext*
+	{
+		for (Compute_MeshGenContext* meshGen: clipmapMeshGens_)
+		{
+			if (meshGen->voxelsPerChunk() == voxelsPerChunk)
+			{
+				return meshGen;
+			}
+		}
+
+		Compute_MeshGenContext* meshGen = Compute_MeshGenContext::create(voxelsPerChunk); 
+		if (meshGen)
+		{
+			clipmapMeshGens_.push_back(meshGen);
+		}
+
+		return meshGen;
+	};
+
+	for (int lod = 0; lod < config_.numLODs; lod++)
+	{
+		lodMeshGens_[lod] = findOrCreateMeshGen(config_.lodVoxelsPerChunk[lod]);
+		if (!lodMeshGens_[lod])
+		{
+			// e.g. the programs failed to build, fall back to the default resolution 
+			// rather than leave the LOD without a context
+			printf("Clipmap: unable to create a context for LOD %d (voxelsPerChunk=%d), using %d\n",
+				lod, config_.lodVoxelsPerChunk[lod], CLIPMAP_VOXELS_PER_CHUNK);
+			config_.lodVoxelsPerChunk[lod] = CLIPMAP_VOXELS_PER_CHUNK;
+			lodMeshGens_[lod] = findOrCreateMeshGen(CLIPMAP_VOXELS_PER_CHUNK);
+			LVN_ALWAYS_ASSERT("Unable to create a clipmap context", lodMeshGens_[lod]);
+		}
+	}
+
+	// the collision nodes are the same size as one of the LODs so when that LOD samples the
+	// field at the same scale the collision meshes are generated from the clipmap's context,
+	// i.e. the density fields (and octrees) around the player are cached and edited once
+	physicsMeshGen_ = meshGenForNode(COLLISION_NODE_SIZE);
+	if (physicsMeshGen_->voxelsPerChunk() != COLLISION_VOXELS_PER_CHUNK)
+	{
+		physicsMeshGen_ = Compute_MeshGenContext::create(COLLISION_VOXELS_PER_CHUNK); 
+		LVN_ALWAYS_ASSERT("Unable to create the collision context", physicsMeshGen_);
+	}
 
 	constructTree();
 }
@@ -855,7 +1425,7 @@ void Clipmap::initialise(
 // ----------------------------------------------------------------------------
 
 void DestroyClipmapNodes(
-	Compute_MeshGenContext* meshGen,
+	const Clipmap& clipmap,
 	ClipmapNode* node, 
 	std::vector<RenderMesh*>& invalidatedMeshes)
 {
@@ -868,12 +1438,12 @@ void DestroyClipmapNodes(
 	{
 		for (int i = 0; i < 8; i++)
 		{
-			DestroyClipmapNodes(meshGen, node->children_[i], invalidatedMeshes);
+			DestroyClipmapNodes(clipmap, node->children_[i], invalidatedMeshes);
 			node->children_[i] = nullptr;
 		}
 	}
 
-	ReleaseClipmapNodeData(meshGen, node, invalidatedMeshes);
+	ReleaseClipmapNodeData(clipmap.meshGenForNode(node->size_), node, invalidatedMeshes);
 	FreeClipmapNode(node);
 
 	Render_FreeDebugDrawBuffer(&g_debugDrawBuffer);
@@ -888,7 +1458,7 @@ void Clipmap::clear()
 	LVN_ALWAYS_ASSERT("Dangling nodes", touchedNodes.size() == g_allocatedNodes.size());
 
 	std::vector<RenderMesh*> invalidatedMeshes;
-	DestroyClipmapNodes(clipmapMeshGen_, root_, invalidatedMeshes);
+	DestroyClipmapNodes(*this, root_, invalidatedMeshes);
 	root_ = nullptr;
 
 	g_updatePending = false;
@@ -913,6 +1483,24 @@ void Clipmap::clear()
 
 	g_clipmapCollisionNodeAllocator.clear();
 	g_clipmapCollisionNodes.clear();
+
+	meshPack_.close();
+}
+
+// ----------------------------------------------------------------------------
+
+void Clipmap::saveWorldFile(const std::string& path)
+{
+	std::vector<Compute_MeshGenContext*> contexts = clipmapMeshGens_;
+	if (std::find(begin(contexts), end(contexts), physicsMeshGen_) == end(contexts))
+	{
+		contexts.push_back(physicsMeshGen_);
+	}
+
+	if (int error = Compute_SaveWorldFile(path, contexts))
+	{
+		printf("Error saving world file '%s': %d\n", path.c_str(), error);
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -1082,7 +1670,7 @@ float DistanceToNode(const ClipmapNode* node, const vec3& cameraPos)
 // ----------------------------------------------------------------------------
 
 void SelectActiveClipmapNodes(
-	Compute_MeshGenContext* meshGen,
+	const ClipmapConfig& config,
 	ClipmapNode* node, 
 	bool parentActive,
 	const vec3& cameraPosition,
@@ -1095,11 +1683,10 @@ void SelectActiveClipmapNodes(
 
 	const AABB aabb = AABB(node->min_, node->size_);
 	bool nodeActive = false;
-	if (!parentActive && node->size_ <= LOD_MAX_NODE_SIZE)
+	if (!parentActive && node->size_ <= config.maxNodeSize())
 	{
-		const int size = node->size_ / (meshGen->voxelsPerChunk() * LEAF_SIZE_SCALE);
-		const int distanceIndex = glm::log2(size);
-		const float d = LOD_ACTIVE_DISTANCES[distanceIndex];
+		const int lod = config.lodForNodeSize(node->size_);
+		const float d = config.lodActiveDistances[lod] * CLIPMAP_LEAF_SIZE;
 		const float nodeDistance = DistanceToNode(node, cameraPosition);
 
 		if (nodeDistance >= d)
@@ -1111,13 +1698,16 @@ void SelectActiveClipmapNodes(
 
 	if (node->active_ && !nodeActive)
 	{
+		// the node is being replaced so there is no point keeping its edit state
 		node->invalidated_ = true;
+		node->edited_ = false;
+		node->csgPending_ = false;
 	}
 
 	for (int i = 0; i < 8; i++)
 	{
 		SelectActiveClipmapNodes(
-			meshGen,
+			config,
 			node->children_[i], 
 			parentActive || nodeActive,
 			cameraPosition, 
@@ -1128,7 +1718,7 @@ void SelectActiveClipmapNodes(
 // ----------------------------------------------------------------------------
 
 void ReleaseInvalidatedNodes(
-	Compute_MeshGenContext* meshGen,
+	const Clipmap& clipmap,
 	ClipmapNode* node, 
 	std::vector<RenderMesh*>& invalidatedMeshes)
 {
@@ -1139,13 +1729,39 @@ void ReleaseInvalidatedNodes(
 
 	if (node->invalidated_)
 	{
-		ReleaseClipmapNodeData(meshGen, node, invalidatedMeshes);
+		ReleaseClipmapNodeData(clipmap.meshGenForNode(node->size_), node, invalidatedMeshes);
 		node->invalidated_ = false;
 	}
 
 	for (int i = 0; i < 8; i++)
 	{
-		ReleaseInvalidatedNodes(meshGen, node->children_[i], invalidatedMeshes);
+		ReleaseInvalidatedNodes(clipmap, node->children_[i], invalidatedMeshes);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+// the coarse nodes with deferred CSG ops are only invalidated when the update has no
+// other nodes to construct, i.e. once the edited LOD 0 nodes have been remeshed
+static void RefreshPendingCSGNodes(const std::vector<ClipmapNode*>& selectedNodes)
+{
+	for (const ClipmapNode* node: selectedNodes)
+	{
+		if (node->invalidated_ || (!node->active_ && !node->empty_))
+		{
+			// still busy constructing the nodes, the pending nodes can wait
+			return;
+		}
+	}
+
+	for (ClipmapNode* node: selectedNodes)
+	{
+		if (node->csgPending_)
+		{
+			node->csgPending_ = false;
+			node->invalidated_ = true;
+			node->empty_ = false;
+		}
 	}
 }
 
@@ -1200,14 +1816,19 @@ void Clipmap::update(
 	std::vector<ClipmapNode*> selectedNodes;
 	{
 		rmt_ScopedCPUSample(SelectNodes);
-		SelectActiveClipmapNodes(clipmapMeshGen_, root_, false, cameraPosition, selectedNodes);
+		SelectActiveClipmapNodes(config_, root_, false, cameraPosition, selectedNodes);
+	}
+
+	{
+		rmt_ScopedCPUSample(RefreshPending);
+		RefreshPendingCSGNodes(selectedNodes);
 	}
 
 	// release the nodes invalidated due to not being active or an insert/remove
 	std::vector<RenderMesh*> invalidatedMeshes;
 	{
 		rmt_ScopedCPUSample(ReleaseInvalidated);
-		ReleaseInvalidatedNodes(clipmapMeshGen_, root_, invalidatedMeshes);
+		ReleaseInvalidatedNodes(*this, root_, invalidatedMeshes);
 	}
 
 	std::vector<ClipmapNode*> filteredNodes, reserveNodes, activeNodes;
@@ -1252,12 +1873,40 @@ void Clipmap::update(
 	std::vector<ClipmapNode*> emptyNodes;
 	const auto& options = Options::get();
 
+	// with more than one device the nodes are constructed concurrently, the mesh gen
+	// context sends each node to its device
+	std::vector<int> constructErrors(filteredNodes.size(), LVN_SUCCESS);
+	const auto constructNode = [&](const size_t i)
+	{
+		constructErrors[i] = ConstructClipmapNodeData(meshGenForNode(filteredNodes[i]->size_), 
+				meshPack_.isOpen() ? &meshPack_ : nullptr, filteredNodes[i], 
+				options.meshMaxError_, options.meshMaxEdgeLen_, options.meshMinCosAngle_);
+	};
+
+	if (Compute_NumDevices() > 1)
+	{
+		JobGroup constructJobs;
+		for (size_t i = 0; i < filteredNodes.size(); i++)
+		{
+			constructJobs.schedule([&constructNode, i]() { constructNode(i); });
+		}
+
+		constructJobs.wait();
+	}
+	else
+	{
+		for (size_t i = 0; i < filteredNodes.size(); i++)
+		{
+			constructNode(i);
+		}
+	}
+
 	// need to construct the all the nodes before attempting to select the seam nodes
 	std::vector<ClipmapNode*> constructedNodes;
-	for (ClipmapNode* node: filteredNodes)
+	for (size_t i = 0; i < filteredNodes.size(); i++)
 	{
-		if (int error = ConstructClipmapNodeData(clipmapMeshGen_, node, 
-				options.meshMaxError_, options.meshMaxEdgeLen_, options.meshMinCosAngle_))
+		ClipmapNode* node = filteredNodes[i];
+		if (int error = constructErrors[i])
 		{
 			LVN_ASSERT(!node->renderMesh);
 			LVN_ASSERT(!node->seamNodes);
@@ -1293,7 +1942,7 @@ void Clipmap::update(
 		
 		for (ClipmapNode* node: emptyNodes)
 		{
-			const int size = node->size_ / (clipmapMeshGen_->voxelsPerChunk() * LEAF_SIZE_SCALE);
+			const int size = node->size_ / (config_.voxelsPerChunk(node->size_) * LEAF_SIZE_SCALE);
 			renderCmds.addCube(ColourForMinLeafSize(size), 0.2f, vec3(node->min_), node->size_);
 		}
 	}
@@ -1332,7 +1981,7 @@ void Clipmap::update(
 			n->seamMesh = nullptr;
 		}
 
-		GenerateClipmapSeamMesh(clipmapMeshGen_, n, *this, colour);
+		GenerateClipmapSeamMesh(n, *this, colour);
 	}
 
 	g_updateInfo.updatedTree = ConstructClipmapViewTree(activeNodes, root_->min_); 
@@ -1571,6 +2220,7 @@ void Clipmap::findIntersectingCollisionVolumes(
 void FindNodesInsideAABB(
 	ClipmapNode* node, 
 	const AABB& aabb, 
+	const int maxNodeSize,
 	std::vector<ClipmapNode*>& nodes)
 {
 	if (!node)
@@ -1586,11 +2236,11 @@ void FindNodesInsideAABB(
 
 	for (int i = 0; i < 8; i++)
 	{
-		FindNodesInsideAABB(node->children_[i], aabb, nodes);
+		FindNodesInsideAABB(node->children_[i], aabb, maxNodeSize, nodes);
 	}
 
 	// traversal order is arbitrary
-	if (node->size_ <= LOD_MAX_NODE_SIZE)
+	if (node->size_ <= maxNodeSize)
 	{
 		nodes.push_back(node);
 	}
@@ -1602,7 +2252,7 @@ std::vector<ClipmapNode*> Clipmap::findNodesInsideAABB(
 	const AABB& aabb) const
 {
 	std::vector<ClipmapNode*> nodes;
-	FindNodesInsideAABB(root_, aabb, nodes);
+	FindNodesInsideAABB(root_, aabb, config_.maxNodeSize(), nodes);
 	return nodes;
 }
 
@@ -1618,7 +2268,7 @@ const ivec3 CSG_BOUNDS_FUDGE(2);
 void Clipmap::queueCSGOperation(
 	const vec3& origin, 
 	const glm::vec3& brushSize, 
-	const RenderShape brushShape,
+	const CSGBrushShape brushShape,
 	const int brushMaterial, 
 	const bool isAddOperation)
 {
@@ -1662,20 +2312,30 @@ void Clipmap::processCSGOperationsImpl()
 
 //	printf("%d operations\n", operations.size());
 
-	std::unordered_set<ClipmapNode*> touchedNodes;
-	for (const CSGOperationInfo& opInfo: operations)
+	// each node is only given the ops which overlap it
+	std::vector<AABB> operationBounds;
+	std::unordered_map<ClipmapNode*, std::vector<int>> touchedNodes;
+	for (int i = 0; i < (int)operations.size(); i++)
 	{
-		std::vector<ClipmapNode*> opNodes = findNodesInsideAABB(CalcCSGOperationBounds(opInfo));
+		operationBounds.push_back(CalcCSGOperationBounds(operations[i]));
+		std::vector<ClipmapNode*> opNodes = findNodesInsideAABB(operationBounds[i]);
 		for (ClipmapNode* node: opNodes)
 		{
-			touchedNodes.insert(node);
+			touchedNodes[node].push_back(i);
 		}
 	}
 
 	std::vector<ivec3> touchedCollisionNodes;
-	for (auto clipmapNode: touchedNodes)
+	for (const auto& touched: touchedNodes)
 	{
 		rmt_ScopedCPUSample(processNode);
+		ClipmapNode* clipmapNode = touched.first;
+		const std::vector<int>& opIndices = touched.second;
+
+		// when the contexts are shared the collision apply has already edited the node's field
+		const bool sharedField = clipmapNode->size_ == COLLISION_NODE_SIZE && 
+			meshGenForNode(clipmapNode->size_) == physicsMeshGen_;
+
 		if (clipmapNode->size_ == COLLISION_NODE_SIZE)
 		{
 			const ivec3 collisionNodeMin = clipmapNode->min_ & ~(COLLISION_NODE_SIZE - 1);
@@ -1686,36 +2346,57 @@ void Clipmap::processCSGOperationsImpl()
 			}
 
 			if (int error = 
-				physicsMeshGen_->applyCSGOperations(operations, clipmapNode->min_, COLLISION_NODE_SIZE) < 0)
+				physicsMeshGen_->applyCSGOperations(operations, opIndices, clipmapNode->min_, COLLISION_NODE_SIZE) < 0)
 			{
 				printf("Error! Compute_ApplyCSGOperation failed: %s\n", GetCLErrorString(error));
 				exit(EXIT_FAILURE);
 			}
 
-			// free the current octree to force a reconstruction
-			physicsMeshGen_->freeChunkOctree(clipmapNode->min_, clipmapNode->size_);
+			// the cached octree is patched (or discarded) by the apply
+		}
+
+		if (clipmapNode->active_ && clipmapNode->size_ > CLIPMAP_LEAF_SIZE)
+		{
+			// the coarse LODs are refreshed once the fine nodes are up to date (see 
+			// RefreshPendingCSGNodes), loading the field then applies the stored ops
+			clipmapNode->csgPending_ = true;
+			continue;
 		}
 
 		if (clipmapNode->active_)
 		{
 			if (int error = 
-				clipmapMeshGen_->applyCSGOperations(operations, clipmapNode->min_, clipmapNode->size_) < 0)
+				meshGenForNode(clipmapNode->size_)->applyCSGOperations(
+					operations, opIndices, clipmapNode->min_, clipmapNode->size_) < 0)
 			{
 				printf("Error! Compute_ApplyCSGOperation failed: %s\n", GetCLErrorString(error));
 				exit(EXIT_FAILURE);
 			}
+
+			clipmapNode->edited_ = true;
+			if (clipmapNode->meshRegions)
+			{
+				const int voxelsPerChunk = config_.voxelsPerChunk(clipmapNode->size_);
+				for (const int i: opIndices)
+				{
+					clipmapNode->dirtyRegions |= 
+						FindTouchedMeshRegions(clipmapNode, voxelsPerChunk, operationBounds[i]);
+				}
+			}
+		}
+		else if (!sharedField)
+		{
+			// free the current octree to force a reconstruction
+			meshGenForNode(clipmapNode->size_)->freeChunkOctree(clipmapNode->min_, clipmapNode->size_);
 		}
-		 
-		// free the current octree to force a reconstruction
-		clipmapMeshGen_->freeChunkOctree(clipmapNode->min_, clipmapNode->size_);
 
 		clipmapNode->invalidated_ = true;
 		clipmapNode->empty_ = false;
 	}
 
-	for (const auto& opInfo: operations)
+	for (int i = 0; i < (int)operations.size(); i++)
 	{
-		Compute_StoreCSGOperation(opInfo, CalcCSGOperationBounds(opInfo));
+		Compute_StoreCSGOperation(operations[i], operationBounds[i]);
 	}
 
 	std::vector<ivec3> touchedSeamNodes;
@@ -7,14 +7,18 @@
 #include	"aabb.h"
 #include	"frustum.h"
 #include	"physics.h"
+#include	"mesh_pack.h"
+#include	"volume_constants.h"
 
 #include	<unordered_set>
 #include	<vector>
+#include	<string>
 #include	<glm/glm.hpp>
 using		glm::ivec3;
 using		glm::vec3;
 
 class RenderMesh;
+struct ClipmapMeshRegions;
 
 // ----------------------------------------------------------------------------
 
@@ -31,12 +35,16 @@ struct ClipmapNode
 	bool				active_ = false;			// TODO pack into size_?
 	bool				invalidated_ = false;
 	bool				empty_ = false;
+	bool				edited_ = false;			// invalidated by a CSG op, the octree is kept
+	bool				csgPending_ = false;		// CSG ops not yet applied, see processCSGOperationsImpl
 	ivec3				min_;
 	int					size_ = -1;
 	RenderMesh*			renderMesh = nullptr;
 	RenderMesh*			seamMesh = nullptr;
 	OctreeNode*			seamNodes = nullptr;
 	int					numSeamNodes = 0;
+	ClipmapMeshRegions*	meshRegions = nullptr;		// only for the edited LOD 0 nodes
+	u64					dirtyRegions = 0;			// the meshRegions touched since the last construct
 	ClipmapNode*		children_[8];
 };
 
@@ -65,6 +73,42 @@ struct ClipmapViewNode
 
 const vec3 ColourForMinLeafSize(const int minLeafSize);
 
+// The LOD settings chosen at startup, LOD i is the clipmap nodes of size 
+// CLIPMAP_LEAF_SIZE << i. Each distinct voxelsPerChunk value gets its own mesh 
+// gen context so e.g. the distant LODs can be generated with 32^3 nodes
+struct ClipmapConfig
+{
+	ClipmapConfig();
+
+	int			lodForNodeSize(const int size) const;
+	int			voxelsPerChunk(const int size) const;		// for the node size
+	int			maxNodeSize() const;						// i.e. the largest node that will render
+
+	int			numLODs;
+	int			lodVoxelsPerChunk[MAX_LODS];
+	float		lodActiveDistances[MAX_LODS];				// multiples of CLIPMAP_LEAF_SIZE
+};
+
+// comma separated lists with the nearest LOD first, e.g. "64,64,64,64,32,32" and 
+// "0,1.5,3.5,5.5,7.5,13.5". The number of distances sets the number of LODs and the 
+// last voxelsPerChunk is repeated for any remaining LODs, empty lists keep the defaults.
+// Only takes effect for clipmaps initialised after the call
+bool Clipmap_SetConfig(const std::string& lodVoxelsPerChunk, const std::string& lodActiveDistances);
+const ClipmapConfig& Clipmap_GetConfig();
+
+// the root node of the tree for the given bounds, the tree is fully subdivided
+// down to CLIPMAP_LEAF_SIZE nodes
+void Clipmap_CalculateRootNode(const AABB& worldBounds, ivec3& rootMin, int& rootSize);
+
+void Clipmap_SimplifyNodeMesh(
+	MeshBuffer* meshBuffer,
+	const ivec3& min,
+	const int size,
+	const int voxelsPerChunk,
+	const float meshMaxError,
+	const float meshMaxEdgeLen,
+	const float meshMaxAngle);
+
 // ----------------------------------------------------------------------------
 
 class Clipmap;
@@ -85,11 +129,17 @@ class Clipmap
 {
 public:
 
+	// when a mesh pack is given the node meshes are loaded from the pack rather 
+	// than generated, except for nodes touched by a CSG op
 	void	initialise(
-		const AABB& worldBounds);
+		const AABB& worldBounds,
+		const int noiseSeed,
+		const std::string& meshPackPath);
 
 	void	clear();
 
+	void	saveWorldFile(const std::string& path);
+
 	std::vector<RenderMesh*> findVisibleNodes(const Frustum& frustum);
 
 	ClipmapNode* findNode(const ivec3& min, const int size) const;
@@ -117,12 +167,15 @@ public:
 	void queueCSGOperation(
 		const vec3& origin, 
 		const glm::vec3& brushSize, 
-		const RenderShape brushShape,
+		const CSGBrushShape brushShape,
 		const int brushMaterial, 
 		const bool isAddOperation);
 
 	void processCSGOperations();
 
+	const ClipmapConfig& config() const { return config_; }
+	Compute_MeshGenContext* meshGenForNode(const int size) const;
+
 private:
 
 	void    constructTree();
@@ -136,8 +189,12 @@ private:
 	ClipmapViewTree     viewTree_;
 	AABB                worldBounds_;
 
-	Compute_MeshGenContext* clipmapMeshGen_ = nullptr;
-	Compute_MeshGenContext* physicsMeshGen_ = nullptr;
+	ClipmapConfig           config_;
+	Compute_MeshGenContext* lodMeshGens_[MAX_LODS];			// shared by the LODs with the same voxelsPerChunk
+	std::vector<Compute_MeshGenContext*> clipmapMeshGens_;
+	Compute_MeshGenContext* physicsMeshGen_ = nullptr;			// one of the clipmapMeshGens_ when the sample scale matches
+
+	MeshPack                meshPack_;
 };
 
 // ----------------------------------------------------------------------------
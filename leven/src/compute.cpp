@@ -12,6 +12,7 @@
 #include	"volume.h"		
 #include	"primes.h"
 #include	"lrucache.h"
+#include	"density_graph.h"
 
 #include	<Remotery.h>
 #include	"sdl_wrapper.h"
@@ -21,14 +22,11 @@
 #include	<array>
 #include	<random>
 #include	<memory>
+#include	<mutex>
 #include	<glm/gtx/integer.hpp>
 
 // ----------------------------------------------------------------------------
 
-ComputeProgram g_utilProgram;
-
-// ----------------------------------------------------------------------------
-
 int CreateBuffer(
 	cl_int permissions,
 	u32 bufferSize,
@@ -59,7 +57,10 @@ int FillBufferInt(
 	const u32 count, 
 	const cl_int value)
 {
-	cl::Kernel k_FillBuffer(g_utilProgram.get(), "FillBufferInt");
+	ComputeContext* ctx = GetComputeContext();
+	cl::Kernel& k_FillBuffer = ctx->utilKernels.fillBufferInt;
+	std::lock_guard<std::mutex> lock(ctx->utilMutex);
+
 	int index = 0;
 	CL_CALL(k_FillBuffer.setArg(index++, buffer));
 	CL_CALL(k_FillBuffer.setArg(index++, value));
@@ -76,7 +77,10 @@ int FillBufferLong(
 	const u32 count, 
 	const cl_long value)
 {
-	cl::Kernel k_FillBuffer(g_utilProgram.get(), "FillBufferLong");
+	ComputeContext* ctx = GetComputeContext();
+	cl::Kernel& k_FillBuffer = ctx->utilKernels.fillBufferLong;
+	std::lock_guard<std::mutex> lock(ctx->utilMutex);
+
 	int index = 0;
 	CL_CALL(k_FillBuffer.setArg(index++, buffer));
 	CL_CALL(k_FillBuffer.setArg(index++, value));
@@ -87,33 +91,119 @@ int FillBufferLong(
 
 // ----------------------------------------------------------------------------
 
-int InitialiseContext(ComputeContext* ctx)
+static std::string g_deviceSelection;
+
+static std::once_flag g_contextsInitialised;
+static std::vector<std::unique_ptr<ComputeContext>> g_computeContexts;
+
+#ifdef _MSC_VER
+static __declspec(thread) ComputeContext* t_currentContext = nullptr;
+#else
+static __thread ComputeContext* t_currentContext = nullptr;
+#endif
+
+// ----------------------------------------------------------------------------
+
+struct SelectedDevice
 {
-	if (ctx->context())
-	{
-		// already initialised
-		return CL_SUCCESS;
-	}
+	cl::Platform		platform;
+	cl::Device			device;
+};
 
+static bool SelectDevices(const std::string& selection, std::vector<SelectedDevice>& selected)
+{
 	std::vector<cl::Platform> platforms;
 	cl::Platform::get(&platforms);
 	if (platforms.empty())
 	{
 		printf("OpenCL: no platforms\n");
-		return LVN_CL_ERROR;
+		return false;
+	}
+
+	std::vector<std::vector<cl::Device>> platformDevices(platforms.size());
+	for (size_t p = 0; p < platforms.size(); p++)
+	{
+		platforms[p].getDevices(CL_DEVICE_TYPE_ALL, &platformDevices[p]);
+		for (size_t d = 0; d < platformDevices[p].size(); d++)
+		{
+			printf("OpenCL device %d:%d: %s\n", (int)p, (int)d, 
+				platformDevices[p][d].getInfo<CL_DEVICE_NAME>().c_str());
+		}
+	}
+
+	cl_device_type type = 0;
+	if (selection.empty() || _stricmp(selection.c_str(), "default") == 0)
+	{
+		// the original behaviour, the first GPU on the first platform
+		for (const cl::Device& device: platformDevices[0])
+		{
+			if (device.getInfo<CL_DEVICE_TYPE>() & CL_DEVICE_TYPE_GPU)
+			{
+				selected.push_back({ platforms[0], device });
+				break;
+			}
+		}
 	}
+	else if (_stricmp(selection.c_str(), "gpu") == 0) { type = CL_DEVICE_TYPE_GPU; }
+	else if (_stricmp(selection.c_str(), "cpu") == 0) { type = CL_DEVICE_TYPE_CPU; }
+	else if (_stricmp(selection.c_str(), "all") == 0) { type = CL_DEVICE_TYPE_ALL; }
+	else
+	{
+		// a list of platform:device indices
+		std::istringstream stream(selection);
+		std::string entry;
+		while (std::getline(stream, entry, ','))
+		{
+			int p = -1, d = -1;
+			if (sscanf(entry.c_str(), " %d:%d", &p, &d) != 2 ||
+				p < 0 || p >= (int)platforms.size() || d < 0 || d >= (int)platformDevices[p].size())
+			{
+				printf("OpenCL: invalid device '%s' in selection '%s'\n", entry.c_str(), selection.c_str());
+				continue;
+			}
+
+			selected.push_back({ platforms[p], platformDevices[p][d] });
+		}
+	}
+
+	if (type != 0)
+	{
+		for (size_t p = 0; p < platforms.size(); p++)
+		{
+			for (const cl::Device& device: platformDevices[p])
+			{
+				if (device.getInfo<CL_DEVICE_TYPE>() & type)
+				{
+					selected.push_back({ platforms[p], device });
+				}
+			}
+		}
+	}
+
+	if (selected.empty())
+	{
+		printf("OpenCL: no devices match the selection '%s'\n", selection.c_str());
+		return false;
+	}
+
+	return true;
+}
 
+// ----------------------------------------------------------------------------
 
+static int InitialiseContext(ComputeContext* ctx, const SelectedDevice& selected)
+{
 #ifdef USE_OPENGL_INTEROP
+	// the interop context always uses the devices driving the GL context
 	cl_context_properties properties[] =
 	{
 		CL_GL_CONTEXT_KHR, (cl_context_properties)wglGetCurrentContext(),
 		CL_WGL_HDC_KHR, (cl_context_properties)wglGetCurrentDC(),
-		CL_CONTEXT_PLATFORM, (cl_context_properties)(platforms[0])(), 0
+		CL_CONTEXT_PLATFORM, (cl_context_properties)(selected.platform)(), 0
 	};
 
 	clGetGLContextInfoKHR_fn clGetGLContextInfoKHR = 
-		(clGetGLContextInfoKHR_fn)clGetExtensionFunctionAddressForPlatform(platforms[0](), "clGetGLContextInfoKHR");
+		(clGetGLContextInfoKHR_fn)clGetExtensionFunctionAddressForPlatform(selected.platform(), "clGetGLContextInfoKHR");
 
 	cl_device_id device_ids[32]; 
 	size_t size = 0;
@@ -133,26 +223,27 @@ int InitialiseContext(ComputeContext* ctx)
 #else
 	cl_context_properties properties[] =
 	{
-		CL_CONTEXT_PLATFORM, (cl_context_properties)(platforms[0])(), 0
+		CL_CONTEXT_PLATFORM, (cl_context_properties)(selected.platform)(), 0
 	};
 
-	ctx->context = cl::Context(CL_DEVICE_TYPE_GPU, properties);
-	auto devices = ctx->context.getInfo<CL_CONTEXT_DEVICES>();
-	printf("OpenCL found %d devices\n", devices.size());
-	if (devices.empty())
+	cl_int err = CL_SUCCESS;
+	std::vector<cl::Device> devices(1, selected.device);
+	ctx->context = cl::Context(devices, properties, nullptr, nullptr, &err);
+	if (err != CL_SUCCESS)
 	{
-		return LVN_CL_ERROR;
+		printf("Couldn't create context: %s (%d)\n", GetCLErrorString(err), err);
+		return err;
 	}
 
-	ctx->device = devices[0];
+	ctx->device = selected.device;
 #endif
 
-	cl_int err = 0;
-	ctx->queue = cl::CommandQueue(ctx->context, ctx->device, 0, &err);
-	if (err < 0)
+	cl_int error = 0;
+	ctx->queue = cl::CommandQueue(ctx->context, ctx->device, 0, &error);
+	if (error < 0)
 	{
 		printf("Couldn't create queue\n");
-		return err;
+		return error;
 	}
 
 	return CL_SUCCESS;
@@ -160,42 +251,131 @@ int InitialiseContext(ComputeContext* ctx)
 
 // ----------------------------------------------------------------------------
 
-//#define CONTEXT_PER_THREAD
-#ifdef CONTEXT_PER_THREAD
-__declspec(thread) ComputeContext* context;
+static void InitialiseContexts()
+{
+	std::vector<SelectedDevice> selected;
+	if (SelectDevices(g_deviceSelection, selected))
+	{
+#ifdef USE_OPENGL_INTEROP
+		selected.resize(1);
 #endif
 
+		for (const SelectedDevice& device: selected)
+		{
+			std::unique_ptr<ComputeContext> ctx(new ComputeContext);
+			ctx->deviceIndex = g_computeContexts.size();
+			if (InitialiseContext(ctx.get(), device) == CL_SUCCESS)
+			{
+				g_computeContexts.push_back(std::move(ctx));
+			}
+		}
+	}
+
+	if (g_computeContexts.empty())
+	{
+		// keep a (broken) context so callers don't need to check, Compute_Initialise will fail
+		g_computeContexts.push_back(std::unique_ptr<ComputeContext>(new ComputeContext));
+	}
+}
+
+// ----------------------------------------------------------------------------
+
 ComputeContext* GetComputeContext()
 {
-	static std::unique_ptr<ComputeContext> computeContext = nullptr;
-
-	if (computeContext == nullptr)
+	if (t_currentContext)
 	{
-		computeContext.reset(new ComputeContext);
-		InitialiseContext(computeContext.get());
+		return t_currentContext;
 	}
 
-#ifdef CONTEXT_PER_THREAD
-	if (!context)
+	std::call_once(g_contextsInitialised, InitialiseContexts);
+	return g_computeContexts[0].get();
+}
+
+// ----------------------------------------------------------------------------
+
+ComputeContext* GetComputeContextForDevice(const int deviceIndex)
+{
+	std::call_once(g_contextsInitialised, InitialiseContexts);
+	LVN_ASSERT(deviceIndex >= 0 && deviceIndex < (int)g_computeContexts.size());
+	return g_computeContexts[deviceIndex].get();
+}
+
+// ----------------------------------------------------------------------------
+
+ScopedComputeContext::ScopedComputeContext(ComputeContext* ctx)
+	: previous_(t_currentContext)
+{
+	t_currentContext = ctx;
+}
+
+ScopedComputeContext::~ScopedComputeContext()
+{
+	t_currentContext = previous_;
+}
+
+// ----------------------------------------------------------------------------
+
+void Compute_SetDeviceSelection(const std::string& selection)
+{
+	g_deviceSelection = selection;
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_NumDevices()
+{
+	std::call_once(g_contextsInitialised, InitialiseContexts);
+	return g_computeContexts.size();
+}
+
+// ----------------------------------------------------------------------------
+
+static int CreateKernel(const ComputeProgram& program, const char* name, cl::Kernel& kernel)
+{
+	cl_int error = CL_SUCCESS;
+	kernel = cl::Kernel(program.get(), name, &error);
+	if (!kernel() || error != CL_SUCCESS)
 	{
-		context = new ComputeContext;
-		context->context = computeContext->context;
-		context->device = computeContext->device;
-		context->queue = cl::CommandQueue(computeContext->context, computeContext->device, 0);
+		printf("Error! Failed to create '%s' kernel: %s (%d)\n", name, GetCLErrorString(error), error);
+		return error != CL_SUCCESS ? error : LVN_CL_ERROR;
 	}
 
-	return context;
-#else
-	return computeContext.get();
-#endif
+	return CL_SUCCESS;
 }
 
 // ----------------------------------------------------------------------------
 
-int Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial, const int numCSGBrushes)
+static int CreateUtilKernels(ComputeContext* ctx)
 {
-	auto ctx = GetComputeContext();
-	printf("OpenCL device: %s\n", ctx->device.getInfo<CL_DEVICE_NAME>().c_str());
+	UtilKernels& k = ctx->utilKernels;
+	const ComputeProgram& util = ctx->utilProgram;
+
+	CL_CALL(CreateKernel(util, "FillBufferInt", k.fillBufferInt));
+	CL_CALL(CreateKernel(util, "FillBufferLong", k.fillBufferLong));
+	CL_CALL(CreateKernel(util, "ExclusiveLocalScan", k.exclusiveLocalScan));
+	CL_CALL(CreateKernel(util, "InclusiveLocalScan", k.inclusiveLocalScan));
+	CL_CALL(CreateKernel(util, "WriteScannedOutput", k.writeScannedOutput));
+	CL_CALL(CreateKernel(util, "CompactArray_Long", k.compactArrayLong));
+	CL_CALL(CreateKernel(util, "CompactIndexArray", k.compactIndexArray));
+	CL_CALL(CreateKernel(util, "MapSequenceIndices", k.mapSequenceIndices));
+	CL_CALL(CreateKernel(util, "ExtractWinners", k.extractWinners));
+	CL_CALL(CreateKernel(util, "MapSequenceValues", k.mapSequenceValues));
+	CL_CALL(CreateKernel(util, "ExtractLosers", k.extractLosers));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+static int InitialiseDevice(ComputeContext* ctx, const unsigned int defaultMaterial)
+{
+	if (!ctx->context())
+	{
+		return LVN_CL_ERROR;
+	}
+
+	ScopedComputeContext scope(ctx);
+	printf("OpenCL device #%d: %s\n", ctx->deviceIndex, ctx->device.getInfo<CL_DEVICE_NAME>().c_str());
 	printf("OpenCL device version: %s\n", ctx->device.getInfo<CL_DEVICE_VERSION>().c_str());
 	printf("  Global Memory Size: %d\n", ctx->device.getInfo<CL_DEVICE_GLOBAL_MEM_CACHE_SIZE>());
 	printf("  Max Memory Alloc Size: %d\n", ctx->device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>());
@@ -218,16 +398,32 @@ int Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial,
 	buildOptions << "-DCUCKOO_HASH_FN_COUNT=" << CUCKOO_HASH_FN_COUNT << " ";
 	buildOptions << "-DCUCKOO_STASH_SIZE=" << CUCKOO_STASH_SIZE << " ";
 	buildOptions << "-DCUCKOO_MAX_ITERATIONS=" << CUCKOO_MAX_ITERATIONS << " ";
-	buildOptions << "-DNUM_CSG_BRUSHES=" << numCSGBrushes << " ";
+	buildOptions << "-DCUCKOO_KEY_BITS=" << CUCKOO_KEY_BITS << " ";
 	
-	g_utilProgram.initialise("cl/compact.cl", buildOptions.str());
-	g_utilProgram.addHeader("cl/duplicate.cl");
-	g_utilProgram.addHeader("cl/scan.cl");
-	g_utilProgram.addHeader("cl/fill_buffer.cl");
-	CL_CALL(g_utilProgram.build());
+	ctx->utilProgram.initialise("cl/compact.cl", buildOptions.str());
+	ctx->utilProgram.addHeader("cl/duplicate.cl");
+	ctx->utilProgram.addHeader("cl/scan.cl");
+	ctx->utilProgram.addHeader("cl/fill_buffer.cl");
+	CL_CALL(ctx->utilProgram.build());
+	CL_CALL(CreateUtilKernels(ctx));
 
 	ctx->defaultMaterial = defaultMaterial;
 	CL_CALL(Compute_InitialiseCuckoo());
+	CL_CALL(Compute_InitialiseSeamMesh());
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial)
+{
+	const int numDevices = Compute_NumDevices();
+	for (int i = 0; i < numDevices; i++)
+	{
+		CL_CALL(InitialiseDevice(GetComputeContextForDevice(i), defaultMaterial));
+	}
+
 	CL_CALL(Compute_SetNoiseSeed(noiseSeed));
 
 	return CL_SUCCESS;
@@ -237,20 +433,152 @@ int Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial,
 
 int Compute_Shutdown()
 {
+	ComputeProgram_ClearRegistry();
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+static int CreateMeshGenKernels(MeshGenerationContext* meshGen)
+{
+	MeshGenKernels& k = meshGen->kernels;
+
+	const ComputeProgram& field = meshGen->densityFieldProgram;
+	CL_CALL(CreateKernel(field, "GenerateDefaultField", k.generateDefaultField));
+	CL_CALL(CreateKernel(field, "FindFieldEdges", k.findFieldEdges));
+	CL_CALL(CreateKernel(field, "CompactEdges", k.compactEdges));
+	CL_CALL(CreateKernel(field, "FindEdgeIntersectionInfo", k.findEdgeInfo));
+
+	const ComputeProgram& octree = meshGen->octreeProgram;
+	CL_CALL(CreateKernel(octree, "CreateLeafNodes", k.createLeafNodes));
+	CL_CALL(CreateKernel(octree, "CreateSurfaceNetsLeafNodes", k.createSurfaceNetsLeafNodes));
+	CL_CALL(CreateKernel(octree, "CreateLeafNodesForVoxels", k.createLeafNodesForVoxels));
+	CL_CALL(CreateKernel(octree, "CreateSurfaceNetsLeafNodesForVoxels", k.createSurfaceNetsLeafNodesForVoxels));
+	CL_CALL(CreateKernel(octree, "SolveQEFs", k.solveQEFs));
+	CL_CALL(CreateKernel(octree, "CollapseLeafCells", k.collapseLeafCells));
+	CL_CALL(CreateKernel(octree, "CollapseCells", k.collapseCells));
+	CL_CALL(CreateKernel(octree, "AssignNodeClusters", k.assignNodeClusters));
+	CL_CALL(CreateKernel(octree, "ResolveNodeClusters", k.resolveNodeClusters));
+	CL_CALL(CreateKernel(octree, "AssignNodeVertices", k.assignNodeVertices));
+	CL_CALL(CreateKernel(octree, "InitialiseNodeVertices", k.initialiseNodeVertices));
+	CL_CALL(CreateKernel(octree, "GenerateMesh", k.generateMesh));
+	CL_CALL(CreateKernel(octree, "SelectMeshRegions", k.selectMeshRegions));
+	CL_CALL(CreateKernel(octree, "CompactMeshTriangles", k.compactMeshTriangles));
+	CL_CALL(CreateKernel(octree, "GenerateMeshVertexBuffer", k.generateMeshVertexBuffer));
+	CL_CALL(CreateKernel(octree, "FindSeamNodes", k.findSeamNodes));
+	CL_CALL(CreateKernel(octree, "ExtractSeamNodeInfo", k.extractSeamNodeInfo));
+	CL_CALL(CreateKernel(octree, "FindEditedVoxels", k.findEditedVoxels));
+	CL_CALL(CreateKernel(octree, "RemoveEditedNodes", k.removeEditedNodes));
+	CL_CALL(CreateKernel(octree, "CompactOctreeNodes", k.compactOctreeNodes));
+	CL_CALL(CreateKernel(octree, "CompactNodeQEFs", k.compactNodeQEFs));
+
+	const ComputeProgram& csg = meshGen->csgProgram;
+	for (int i = 0; i < CSGBrush_SIZE; i++)
+	{
+		const std::string suffix = std::string("_") + Compute_CSGBrushName((CSGBrushShape)i);
+		CL_CALL(CreateKernel(csg, ("CSG_HermiteIndices" + suffix).c_str(), k.csgHermiteIndices[i]));
+		CL_CALL(CreateKernel(csg, ("FindEdgeIntersectionInfo" + suffix).c_str(), k.csgFindEdgeInfo[i]));
+	}
+
+	CL_CALL(CreateKernel(csg, "CompactPoints", k.csgCompactPoints));
+	CL_CALL(CreateKernel(csg, "UpdateFieldMaterials", k.csgUpdateFieldMaterials));
+	CL_CALL(CreateKernel(csg, "FindUpdatedEdges", k.csgFindUpdatedEdges));
+	CL_CALL(CreateKernel(csg, "RemoveInvalidIndices", k.csgRemoveInvalidIndices));
+	CL_CALL(CreateKernel(csg, "FilterValidEdges", k.csgFilterValidEdges));
+	CL_CALL(CreateKernel(csg, "PruneFieldEdges", k.csgPruneFieldEdges));
+	CL_CALL(CreateKernel(csg, "CompactFieldEdges", k.csgCompactFieldEdges));
+
+	// the args which never change, the noise image is rewritten in place when the seed changes
+	auto ctx = GetComputeContext();
+	CL_CALL(k.generateDefaultField.setArg(0, ctx->noisePermLookupImage));
+	CL_CALL(k.generateDefaultField.setArg(3, ctx->defaultMaterial));
+	CL_CALL(k.findEdgeInfo.setArg(0, ctx->noisePermLookupImage));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+const char* Compute_CSGBrushName(const CSGBrushShape brushShape)
+{
+	// must match the BrushDensity_<name> functions in apply_csg_operation.cl
+	static const char* const names[CSGBrush_SIZE] =
+	{
+		"Cube", "Sphere", "Capsule", "Torus", "Cylinder", "RoundedBox",
+	};
+
+	LVN_ASSERT(brushShape >= 0 && brushShape < CSGBrush_SIZE);
+	return names[brushShape];
+}
+
+// ----------------------------------------------------------------------------
+
+// instantiates cl/csg_brush.cl for each shape so the kernels don't need to switch
+// on the brush shape for every sample
+static std::string GenerateCSGBrushSource()
+{
+	std::stringstream source;
+	for (int i = 0; i < CSGBrush_SIZE; i++)
+	{
+		source << "#define BRUSH_SHAPE " << Compute_CSGBrushName((CSGBrushShape)i) << "\n";
+		source << "#include \"cl/csg_brush.cl\"\n";
+		source << "#undef BRUSH_SHAPE\n";
+	}
+
+	return source.str();
+}
+
+// ----------------------------------------------------------------------------
+
+// empty unless Compute_SetDensityGraph loaded a graph
+static DensityGraph g_densityGraph;
+static u64 g_densityGraphHash = 0;
+
+int Compute_SetDensityGraph(const std::string& path)
+{
+	DensityGraph graph;
+	if (!path.empty() && !graph.load(path))
+	{
+		return LVN_CL_ERROR;
+	}
+
+	g_densityGraph = graph;
+	g_densityGraphHash = graph.hash();
 	return CL_SUCCESS;
 }
 
 // ----------------------------------------------------------------------------
 
-MeshGenerationContext* Compute_CreateMeshGenContext(const int voxelsPerChunk)
+u64 Compute_DensityGraphHash()
 {
+	return g_densityGraphHash;
+}
+
+// ----------------------------------------------------------------------------
+
+MeshGenerationContext* Compute_CreateMeshGenContext(const int voxelsPerChunk, const int fieldBrickSizeLog2)
+{
+	// the edge indices are 32-bit and the node codes are limited by the cuckoo key size
+	const int indexShift = glm::log2(voxelsPerChunk) + 1;
+	const int maxOctreeDepth = (CUCKOO_KEY_BITS - 1) / 3;
+	if (voxelsPerChunk > COMPUTE_MAX_VOXELS_PER_CHUNK || ((indexShift * 3) + 2) > 31 || 
+		glm::log2(voxelsPerChunk) > maxOctreeDepth)
+	{
+		printf("Error: voxelsPerChunk=%d is too large\n", voxelsPerChunk);
+		return nullptr;
+	}
+
 	MeshGenerationContext* meshGen = new MeshGenerationContext;
 	meshGen->voxelsPerChunk = voxelsPerChunk;
 	meshGen->hermiteIndexSize = meshGen->voxelsPerChunk + 1;
 	meshGen->fieldSize = meshGen->hermiteIndexSize + 1;
-	meshGen->indexShift = glm::log2(voxelsPerChunk) + 1;
+	meshGen->indexShift = indexShift;
 	meshGen->indexMask = (1 << meshGen->indexShift) - 1;
-	const int fieldBufferSize = meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize;
+
+	meshGen->fieldBrickSizeLog2 = fieldBrickSizeLog2;
+	const int brickSize = 1 << meshGen->fieldBrickSizeLog2;
+	const int fieldBricks = (meshGen->fieldSize + brickSize - 1) / brickSize;
+	meshGen->fieldBufferSize = (fieldBricks * fieldBricks * fieldBricks) * (brickSize * brickSize * brickSize);
 	const int maxTerrainHeight = 900.f;
 
 	std::stringstream buildOptions;
@@ -260,6 +588,8 @@ MeshGenerationContext* Compute_CreateMeshGenContext(const int voxelsPerChunk)
 	buildOptions << "-DVOXELS_PER_CHUNK=" << meshGen->voxelsPerChunk << " ";
 	buildOptions << "-DLEAF_SIZE_SCALE=" << LEAF_SIZE_SCALE << " ";
 	buildOptions << "-DFIELD_DIM=" << meshGen->fieldSize << " ";
+	buildOptions << "-DFIELD_BRICK_SIZE_LOG2=" << meshGen->fieldBrickSizeLog2 << " ";
+	buildOptions << "-DFIELD_BRICKS=" << fieldBricks << " ";
 	buildOptions << "-DHERMITE_INDEX_SIZE=" << meshGen->hermiteIndexSize << " ";
 	buildOptions << "-DVOXEL_INDEX_SHIFT=" << meshGen->indexShift << " ";
 	buildOptions << "-DVOXEL_INDEX_MASK=" << meshGen->indexMask << " ";
@@ -269,45 +599,72 @@ MeshGenerationContext* Compute_CreateMeshGenContext(const int voxelsPerChunk)
 	buildOptions << "-DFIND_EDGE_INFO_STEPS=" << 16 << " ";
 	buildOptions << "-DFIND_EDGE_INFO_INCREMENT=" << (1.f/16.f) << " ";
 	buildOptions << "-DMAX_OCTREE_DEPTH=" << glm::log2(meshGen->voxelsPerChunk) << " ";
+	buildOptions << "-DMESH_REGIONS_PER_AXIS=" << MESH_REGIONS_PER_AXIS << " ";
 	buildOptions << "-DCUCKOO_EMPTY_VALUE=" << CUCKOO_EMPTY_VALUE << " ";
 	buildOptions << "-DCUCKOO_STASH_HASH_INDEX=" << CUCKOO_STASH_HASH_INDEX << " ";
 	buildOptions << "-DCUCKOO_HASH_FN_COUNT=" << CUCKOO_HASH_FN_COUNT << " ";
 	buildOptions << "-DCUCKOO_STASH_SIZE=" << CUCKOO_STASH_SIZE << " ";
 	buildOptions << "-DCUCKOO_MAX_ITERATIONS=" << CUCKOO_MAX_ITERATIONS << " ";
-	buildOptions << "-DFIELD_BUFFER_SIZE=" << fieldBufferSize << " ";
-	buildOptions << "-DNUM_CSG_BRUSHES=" << 2 << " ";
+	buildOptions << "-DCUCKOO_KEY_BITS=" << CUCKOO_KEY_BITS << " ";
+	buildOptions << "-DFIELD_BUFFER_SIZE=" << meshGen->fieldBufferSize << " ";
+
+	std::string densityFieldOptions = buildOptions.str();
+	if (!g_densityGraph.empty())
+	{
+		densityFieldOptions += "-DDENSITY_GRAPH ";
+	}
 	
-	meshGen->densityFieldProgram.initialise("cl/density_field.cl", buildOptions.str());
+	meshGen->densityFieldProgram.initialise("cl/density_field.cl", densityFieldOptions);
 	meshGen->densityFieldProgram.addHeader("cl/shared_constants.cl");
 	meshGen->densityFieldProgram.addHeader("cl/simplex.cl");
 	meshGen->densityFieldProgram.addHeader("cl/noise.cl");
-	if (int error = meshGen->densityFieldProgram.build())
+	if (!g_densityGraph.empty())
 	{
-		printf("Error: unable to build density field program for voxelsPerChunk=%d\n  '%s' (%d)\n",
-			voxelsPerChunk, GetCLErrorString(error), error);
-		return nullptr;
+		meshGen->densityFieldProgram.setGeneratedSource(g_densityGraph.generateOpenCL());
 	}
 
 	meshGen->octreeProgram.initialise("cl/octree.cl", buildOptions.str());
 	meshGen->octreeProgram.addHeader("cl/shared_constants.cl");
 	meshGen->octreeProgram.addHeader("cl/cuckoo.cl");
 	meshGen->octreeProgram.addHeader("cl/qef.cl");
-	if (int error = meshGen->octreeProgram.build())
+
+	meshGen->csgProgram.initialise("cl/apply_csg_operation.cl", buildOptions.str());
+	meshGen->csgProgram.addHeader("cl/shared_constants.cl");
+	meshGen->csgProgram.setGeneratedSource(GenerateCSGBrushSource());
+
+	// a second context with the same voxelsPerChunk gets the already built programs
+	const std::vector<ComputeProgram*> programs = 
 	{
-		printf("Error: unable to build octree program for voxelsPerChunk=%d\n  '%s' (%d)\n",
+		&meshGen->densityFieldProgram, &meshGen->octreeProgram, &meshGen->csgProgram
+	};
+
+	if (int error = ComputeProgram_BuildAll(programs))
+	{
+		printf("Error: unable to build programs for voxelsPerChunk=%d\n  '%s' (%d)\n",
 			voxelsPerChunk, GetCLErrorString(error), error);
+		delete meshGen;
 		return nullptr;
 	}
 
-	meshGen->csgProgram.initialise("cl/apply_csg_operation.cl", buildOptions.str());
-	meshGen->csgProgram.addHeader("cl/shared_constants.cl");
-	if (int error = meshGen->csgProgram.build())
+	if (int error = CreateMeshGenKernels(meshGen))
 	{
-		printf("Error: unable to build CSG program for voxelsPerChunk=%d\n  '%s' (%d)\n",
+		printf("Error: unable to create kernels for voxelsPerChunk=%d\n  '%s' (%d)\n",
 			voxelsPerChunk, GetCLErrorString(error), error);
+		delete meshGen;
 		return nullptr;
 	}
 
+	if (int error = Compute_TuneMeshGenKernels(meshGen))
+	{
+		// not fatal, the kernels will just use the driver's work-group sizes
+		printf("Warning: unable to tune kernels for voxelsPerChunk=%d\n  '%s' (%d)\n",
+			voxelsPerChunk, GetCLErrorString(error), error);
+		meshGen->kernels.generateDefaultFieldLocal = cl::NullRange;
+		meshGen->kernels.findFieldEdgesLocal = cl::NullRange;
+		meshGen->kernels.createLeafNodesLocal = cl::NullRange;
+		meshGen->kernels.csgHermiteIndicesLocal = cl::NullRange;
+	}
+
 	return meshGen;
 }
 
@@ -355,21 +712,26 @@ int Scan(cl::CommandQueue& queue, cl::Buffer& data, cl::Buffer& scanData, const
 	cl::Buffer blockSums(ctx->context, CL_MEM_READ_WRITE, sizeof(int) * blockCount);
 	CL_CALL(FillBufferInt(ctx->queue, blockSums, blockCount, 0));
 
-	const char* scanKernelName = exclusive ? "ExclusiveLocalScan" : "InclusiveLocalScan";
-	cl::Kernel localScanKernel(g_utilProgram.get(), scanKernelName);
-	CL_CALL(localScanKernel.setArg(0, blockSums));
-	CL_CALL(localScanKernel.setArg(1, blockSize * sizeof(int), 0));
-	CL_CALL(localScanKernel.setArg(2, blockSize));
-	CL_CALL(localScanKernel.setArg(3, count));
-	CL_CALL(localScanKernel.setArg(4, data));
-	CL_CALL(localScanKernel.setArg(5, scanData));
-	CL_CALL(ctx->queue.enqueueNDRangeKernel(localScanKernel, cl::NullRange, blockCount * blockSize, blockSize));
+	// the lock is only held while the args are set and the kernel enqueued as the 
+	// block sums are scanned recursively
+	{
+		cl::Kernel& localScanKernel = exclusive ? ctx->utilKernels.exclusiveLocalScan : ctx->utilKernels.inclusiveLocalScan;
+		std::lock_guard<std::mutex> lock(ctx->utilMutex);
+		CL_CALL(localScanKernel.setArg(0, blockSums));
+		CL_CALL(localScanKernel.setArg(1, blockSize * sizeof(int), 0));
+		CL_CALL(localScanKernel.setArg(2, blockSize));
+		CL_CALL(localScanKernel.setArg(3, count));
+		CL_CALL(localScanKernel.setArg(4, data));
+		CL_CALL(localScanKernel.setArg(5, scanData));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(localScanKernel, cl::NullRange, blockCount * blockSize, blockSize));
+	}
 
 	if (blockCount > 1)
 	{
 		Scan(ctx->queue, blockSums, blockSums, blockCount, false);
 
-		cl::Kernel writeOutputKernel(g_utilProgram.get(), "WriteScannedOutput");
+		cl::Kernel& writeOutputKernel = ctx->utilKernels.writeScannedOutput;
+		std::lock_guard<std::mutex> lock(ctx->utilMutex);
 		writeOutputKernel.setArg(0, scanData);
 		writeOutputKernel.setArg(1, blockSums);
 		writeOutputKernel.setArg(2, count);
@@ -412,7 +774,8 @@ int CompactArray_Long(
 	{
 		compactArray = cl::Buffer(ctx->context, CL_MEM_READ_WRITE, sizeof(cl_long) * compactCount);
 
-		cl::Kernel k(g_utilProgram.get(), "CompactArray_Long");
+		cl::Kernel& k = ctx->utilKernels.compactArrayLong;
+		std::lock_guard<std::mutex> lock(ctx->utilMutex);
 		k.setArg(0, validity);
 		k.setArg(1, valuesArray);
 		k.setArg(2, scan);
@@ -434,7 +797,8 @@ int CompactIndexArray(cl::CommandQueue& queue, cl::Buffer& indexArray,
 	if (compactCount > 0)
 	{
 		compactArray = cl::Buffer(ctx->context, CL_MEM_READ_WRITE, compactCount * sizeof(int));
-		cl::Kernel k(g_utilProgram.get(), "CompactIndexArray");
+		cl::Kernel& k = ctx->utilKernels.compactIndexArray;
+		std::lock_guard<std::mutex> lock(ctx->utilMutex);
 		k.setArg(0, validity);
 		k.setArg(1, indexArray);
 		k.setArg(2, scan);
@@ -470,10 +834,10 @@ cl::Buffer RemoveDuplicates(cl::CommandQueue& queue, cl::Buffer& inputData, cons
 	cl::Buffer losers(ctx->context, CL_MEM_READ_WRITE, prime * sizeof(int));
 	cl::Buffer losersValid(ctx->context, CL_MEM_READ_WRITE, prime * sizeof(int));
 
-	cl::Kernel mapSequenceKernel(g_utilProgram.get(), "MapSequenceIndices");
-	cl::Kernel extractWinnersKernel(g_utilProgram.get(), "ExtractWinners");
-	cl::Kernel mapValuesKernel(g_utilProgram.get(), "MapSequenceValues");
-	cl::Kernel extractLosersKernel(g_utilProgram.get(), "ExtractLosers");
+	cl::Kernel& mapSequenceKernel = ctx->utilKernels.mapSequenceIndices;
+	cl::Kernel& extractWinnersKernel = ctx->utilKernels.extractWinners;
+	cl::Kernel& mapValuesKernel = ctx->utilKernels.mapSequenceValues;
+	cl::Kernel& extractLosersKernel = ctx->utilKernels.extractLosers;
 
 	int resultsSize = 0;
 	int numItems = inputCount;
@@ -488,17 +852,20 @@ cl::Buffer RemoveDuplicates(cl::CommandQueue& queue, cl::Buffer& inputData, cons
 		
 		FillBufferInt(ctx->queue, table, prime, -1);
 
-		mapSequenceKernel.setArg(0, sequence);
-		mapSequenceKernel.setArg(1, table);
-		mapSequenceKernel.setArg(2, prime);
-		mapSequenceKernel.setArg(3, xorValue);
-		ctx->queue.enqueueNDRangeKernel(mapSequenceKernel, cl::NullRange, numItems, cl::NullRange);
-
-		extractWinnersKernel.setArg(0, table);
-		extractWinnersKernel.setArg(1, sequence);
-		extractWinnersKernel.setArg(2, winnersValid);
-		extractWinnersKernel.setArg(3, winners);
-		ctx->queue.enqueueNDRangeKernel(extractWinnersKernel, cl::NullRange, prime, cl::NullRange);
+		{
+			std::lock_guard<std::mutex> lock(ctx->utilMutex);
+			mapSequenceKernel.setArg(0, sequence);
+			mapSequenceKernel.setArg(1, table);
+			mapSequenceKernel.setArg(2, prime);
+			mapSequenceKernel.setArg(3, xorValue);
+			ctx->queue.enqueueNDRangeKernel(mapSequenceKernel, cl::NullRange, numItems, cl::NullRange);
+
+			extractWinnersKernel.setArg(0, table);
+			extractWinnersKernel.setArg(1, sequence);
+			extractWinnersKernel.setArg(2, winnersValid);
+			extractWinnersKernel.setArg(3, winners);
+			ctx->queue.enqueueNDRangeKernel(extractWinnersKernel, cl::NullRange, prime, cl::NullRange);
+		}
 
 		cl::Buffer compactWinners;
 		const int numWinners = CompactIndexArray(ctx->queue, winners, winnersValid, prime, compactWinners);
@@ -507,19 +874,22 @@ cl::Buffer RemoveDuplicates(cl::CommandQueue& queue, cl::Buffer& inputData, cons
 		(ctx->queue.enqueueCopyBuffer(compactWinners, result, 0, resultsSize * sizeof(int), numWinners * sizeof(int)));
 		resultsSize += numWinners;
 
-		mapValuesKernel.setArg(0, compactWinners);
-		mapValuesKernel.setArg(1, table);
-		mapValuesKernel.setArg(2, prime);
-		mapValuesKernel.setArg(3, xorValue);
-		(ctx->queue.enqueueNDRangeKernel(mapValuesKernel, cl::NullRange, numWinners, cl::NullRange));
-
-		extractLosersKernel.setArg(0, sequence);
-		extractLosersKernel.setArg(1, table);
-		extractLosersKernel.setArg(2, losersValid);
-		extractLosersKernel.setArg(3, losers);
-		extractLosersKernel.setArg(4, prime);
-		extractLosersKernel.setArg(5, xorValue);
-		(ctx->queue.enqueueNDRangeKernel(extractLosersKernel, cl::NullRange, numItems, cl::NullRange));
+		{
+			std::lock_guard<std::mutex> lock(ctx->utilMutex);
+			mapValuesKernel.setArg(0, compactWinners);
+			mapValuesKernel.setArg(1, table);
+			mapValuesKernel.setArg(2, prime);
+			mapValuesKernel.setArg(3, xorValue);
+			(ctx->queue.enqueueNDRangeKernel(mapValuesKernel, cl::NullRange, numWinners, cl::NullRange));
+
+			extractLosersKernel.setArg(0, sequence);
+			extractLosersKernel.setArg(1, table);
+			extractLosersKernel.setArg(2, losersValid);
+			extractLosersKernel.setArg(3, losers);
+			extractLosersKernel.setArg(4, prime);
+			extractLosersKernel.setArg(5, xorValue);
+			(ctx->queue.enqueueNDRangeKernel(extractLosersKernel, cl::NullRange, numItems, cl::NullRange));
+		}
 		
 		cl::Buffer compactLosers;
 		const int numLosers = CompactIndexArray(ctx->queue, losers, losersValid, numItems, compactLosers);
@@ -605,28 +975,68 @@ cl_float4 LeafScaleVec(const glm::vec4& v)
 Compute_MeshGenContext* Compute_MeshGenContext::create(const int voxelsPerChunk)
 {
 	Compute_MeshGenContext* ctx = new Compute_MeshGenContext;
-	ctx->privateCtx_ = Compute_CreateMeshGenContext(voxelsPerChunk);
+	for (int i = 0; i < Compute_NumDevices(); i++)
+	{
+		ComputeContext* computeCtx = GetComputeContextForDevice(i);
+		ScopedComputeContext scope(computeCtx);
+
+		MeshGenerationContext* meshGen = Compute_CreateMeshGenContext(voxelsPerChunk);
+		if (!meshGen)
+		{
+			for (MeshGenerationContext* created: ctx->privateCtxs_)
+			{
+				delete created;
+			}
+
+			delete ctx;
+			return nullptr;
+		}
+
+		meshGen->computeCtx = computeCtx;
+		ctx->privateCtxs_.push_back(meshGen);
+	}
+
 	return ctx;
 }
 
+MeshGenerationContext* Compute_MeshGenContext::contextForNode(const glm::ivec3& min, const int size) const
+{
+	if (privateCtxs_.size() == 1)
+	{
+		return privateCtxs_[0];
+	}
+
+	// any deterministic mapping keeps the caches local, hash rather than use regions
+	// so the nodes around the camera are spread evenly between the devices
+	const u32 hash = (min.x * 73856093) ^ (min.y * 19349663) ^ (min.z * 83492791) ^ (size * 2654435761U);
+	return privateCtxs_[hash % privateCtxs_.size()];
+}
+
 int Compute_MeshGenContext::voxelsPerChunk() const
 {
-	return privateCtx_->voxelsPerChunk;
+	return privateCtxs_[0]->voxelsPerChunk;
 }
 
 int Compute_MeshGenContext::applyCSGOperations(
 	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
 	const glm::ivec3& clipmapNodeMin,
 	const int clipmapNodeSize)
 {
-	return Compute_ApplyCSGOperations(privateCtx_, opInfo, clipmapNodeMin, clipmapNodeSize);
+	MeshGenerationContext* meshGen = contextForNode(clipmapNodeMin, clipmapNodeSize);
+	std::lock_guard<std::mutex> lock(meshGen->mutex);
+	ScopedComputeContext scope(meshGen->computeCtx);
+	return Compute_ApplyCSGOperations(meshGen, opInfo, opIndices, clipmapNodeMin, clipmapNodeSize);
 }
 
 int Compute_MeshGenContext::freeChunkOctree(
 	const glm::ivec3& min,
 	const int size)
 {
-	return Compute_FreeChunkOctree(privateCtx_, min, size);
+	MeshGenerationContext* meshGen = contextForNode(min, size);
+	std::lock_guard<std::mutex> lock(meshGen->mutex);
+	ScopedComputeContext scope(meshGen->computeCtx);
+	return Compute_FreeChunkOctree(meshGen, min, size);
 }
 
 int Compute_MeshGenContext::isChunkEmpty(
@@ -634,16 +1044,33 @@ int Compute_MeshGenContext::isChunkEmpty(
 	const int size,
 	bool& isEmpty)
 {
-	return Compute_ChunkIsEmpty(privateCtx_, min, size, isEmpty);
+	MeshGenerationContext* meshGen = contextForNode(min, size);
+	std::lock_guard<std::mutex> lock(meshGen->mutex);
+	ScopedComputeContext scope(meshGen->computeCtx);
+	return Compute_ChunkIsEmpty(meshGen, min, size, isEmpty);
 }
 
 int Compute_MeshGenContext::generateChunkMesh(
 	const glm::ivec3& min,
 	const int clipmapNodeSize,
-	MeshBuffer* meshBuffer,
-	std::vector<SeamNodeInfo>& seamNodeBuffer)
+	const ChunkMeshConsumer& consumer)
+{
+	MeshGenerationContext* meshGen = contextForNode(min, clipmapNodeSize);
+	std::lock_guard<std::mutex> lock(meshGen->mutex);
+	ScopedComputeContext scope(meshGen->computeCtx);
+	return Compute_GenerateChunkMesh(meshGen, min, clipmapNodeSize, ALL_MESH_REGIONS, false, consumer);
+}
+
+int Compute_MeshGenContext::generateChunkMeshRegions(
+	const glm::ivec3& min,
+	const int clipmapNodeSize,
+	const u64 regionMask,
+	const ChunkMeshConsumer& consumer)
 {
-	return Compute_GenerateChunkMesh(privateCtx_, min, clipmapNodeSize, meshBuffer, seamNodeBuffer);
+	MeshGenerationContext* meshGen = contextForNode(min, clipmapNodeSize);
+	std::lock_guard<std::mutex> lock(meshGen->mutex);
+	ScopedComputeContext scope(meshGen->computeCtx);
+	return Compute_GenerateChunkMesh(meshGen, min, clipmapNodeSize, regionMask, true, consumer);
 }
 
 // ----------------------------------------------------------------------------
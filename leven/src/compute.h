@@ -4,19 +4,39 @@
 #include	"render_types.h"
 #include	"aabb.h"
 
+#include	<functional>
 #include	<vector>
+#include	<string>
 #include	<glm/glm.hpp>
 #include	<stdint.h>
 
 // need an error value to return from compute functions that encounter an non-OpenCL error
 #define LVN_CL_ERROR (-99999)
 
+// the largest voxelsPerChunk a mesh gen context can be created with, the edge indices
+// pack the voxel's xyz (log2(voxelsPerChunk) + 1 bits each) and the axis into 31 bits
+const int COMPUTE_MAX_VOXELS_PER_CHUNK = 256;
+
 // ----------------------------------------------------------------------------
 
+// each shape has its own variant of the CSG kernels, see cl/csg_brush.cl
+enum CSGBrushShape
+{
+	CSGBrush_Cube,
+	CSGBrush_Sphere,
+	CSGBrush_Capsule,
+	CSGBrush_Torus,
+	CSGBrush_Cylinder,
+	CSGBrush_RoundedBox,
+	CSGBrush_SIZE,
+};
+
+const char* Compute_CSGBrushName(const CSGBrushShape brushShape);
+
 struct CSGOperationInfo
 {
 	int				type = 0;
-	RenderShape		brushShape = RenderShape_Cube;
+	CSGBrushShape	brushShape = CSGBrush_Cube;
 	int				material = 0;
 	float			rotateY = 0.f;
 	glm::vec4		origin;
@@ -30,19 +50,119 @@ struct SeamNodeInfo
 	glm::vec4		normal;
 };
 
+// a leaf of the octree joining the neighbouring chunks' seam nodes
+struct SeamMeshNode
+{
+	glm::ivec3		min;
+	int				size = 0;
+	int				corners = 0;		// the corner signs, i.e. the low 8 bits of the leaf's materialInfo
+};
+
+// a chunk mesh as read back, pointing into the pinned staging buffer it was mapped from
+// so only valid during the ChunkMeshConsumer call. The vertices are packed (see
+// UnpackMeshVertex) and triangleRegions is only set if the regions were requested.
+struct ChunkMeshData
+{
+	const PackedMeshVertex*		vertices = nullptr;
+	int							numVertices = 0;
+	PackedMeshBounds			bounds;
+
+	const MeshTriangle*			triangles = nullptr;
+	const int*					triangleRegions = nullptr;
+	int							numTriangles = 0;
+
+	const SeamNodeInfo*			seamNodes = nullptr;
+	int							numSeamNodes = 0;
+};
+
+// called once per generated chunk, including empty ones
+typedef std::function<void(const ChunkMeshData&)> ChunkMeshConsumer;
+
+// for consumers which need to keep the mesh, the buffer is grown as needed
+void Compute_UnpackChunkMesh(const ChunkMeshData& data, MeshBuffer* meshBuffer);
+
 // ----------------------------------------------------------------------------
 
-int	Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial, const int numCSGBrushes);
+// selects the OpenCL devices used, must be called before Compute_Initialise:
+//		"" or "default"			the first GPU on the first platform
+//		"gpu", "cpu", "all"		every device of that type on every platform
+//		"0:0,1:0"				a list of platform:device indices
+void Compute_SetDeviceSelection(const std::string& selection);
+
+int	Compute_Initialise(const int noiseSeed, const unsigned int defaultMaterial);
 int	Compute_Shutdown();
 
+int Compute_NumDevices();
+
 int Compute_SetNoiseSeed(const int noiseSeed);
 int Compute_StoreCSGOperation(const CSGOperationInfo& opInfo, const AABB& aabb);
 int Compute_ClearCSGOperations();
 
+// true if any of the stored ops (including those from the world file) touch the node
+bool Compute_HasCSGOperations(const glm::ivec3& min, const int size);
+
+// ----------------------------------------------------------------------------
+
+// the chunk meshes can be generated a region at a time (see generateChunkMeshRegions),
+// the regions split the chunk into MESH_REGIONS_PER_AXIS^3 cells, i.e. 16^3 voxels with
+// 64 voxels per chunk, and are selected with a bit mask
+const int MESH_REGIONS_PER_AXIS = 4;
+const int NUM_MESH_REGIONS = MESH_REGIONS_PER_AXIS * MESH_REGIONS_PER_AXIS * MESH_REGIONS_PER_AXIS;
+const u64 ALL_MESH_REGIONS = ~0ULL;
+
 // ----------------------------------------------------------------------------
 
 struct MeshGenerationContext;
+class Compute_MeshGenContext;
+
+// the world file holds the CSG op log and the edited density fields, opening it 
+// restores the ops without replaying them (the fields are loaded on demand) and
+// Compute_ClearCSGOperations closes it
+int Compute_OpenWorldFile(const std::string& path);
+int Compute_SaveWorldFile(const std::string& path, const std::vector<Compute_MeshGenContext*>& contexts);
+
+// evicted fields and octrees are compressed and kept in host memory up to the budget,
+// past that they are written to the scratch file (if set) or dropped
+int Compute_SetSpillOptions(const int hostBudgetMB, const std::string& scratchFilePath);
+
+// the interior leaf vertices are merged into clusters of up to 8x8x8 voxels on the GPU
+// as long as the merged vertex stays within maxError voxels of the surface, 0 disables it
+int Compute_SetCollapseOptions(const float maxError);
+
+// the mesh extractor used for each LOD (i.e. log2(node size / CLIPMAP_LEAF_SIZE)) as a comma
+// separated list of "dc" (dual contouring) or "sn" (naive surface nets, cheaper but rounds off sharp features)
+// e.g. "dc,dc,dc,dc,sn,sn", the LODs not in the list use dual contouring
+int Compute_SetMeshExtractors(const std::string& extractors);
+
+// replaces the terrain density function in cl/noise.cl with the graph loaded from the
+// file (see density_graph.h), must be called before any mesh gen contexts are created
+// and "" restores the default terrain
+int Compute_SetDensityGraph(const std::string& path);
+
+// identifies the density graph along with the noise seed, the mesh packs, world files and
+// spilled entries are only valid for the graph they were generated with (0 for the default)
+u64 Compute_DensityGraphHash();
+
+// the RGBA8 256x256 lookup the noise functions sample, i.e. the pixels of the image
+// Compute_SetNoiseSeed uploads so the CPU can evaluate the same noise
+void Compute_CreateNoisePermutationLookup(const int seed, std::vector<unsigned char>& pixels);
+
+// generates the triangles joining the seam nodes, which can be different sizes, in the
+// octree at rootMin (the nodes are the leafs, see GenerateClipmapSeamMesh). The
+// triangles index the nodes, i.e. the caller adds the vertices in the same order.
+// Returns LVN_CL_ERROR without generating anything if the nodes are too small for
+// the node codes to cover the root.
+int Compute_GenerateSeamMesh(
+	const glm::ivec3& rootMin,
+	const int rootSize,
+	const std::vector<SeamMeshNode>& nodes,
+	MeshBuffer* meshBuffer);
 
+// ----------------------------------------------------------------------------
+
+// holds a MeshGenerationContext per device, each node is always generated on the same
+// device so the cached density field and octree stay local. The calls are safe to make
+// concurrently, calls for nodes on different devices run in parallel
 class Compute_MeshGenContext
 {
 public:
@@ -51,8 +171,10 @@ public:
 
 	int voxelsPerChunk() const;
 
+	// opIndices selects the ops in the batch which touch the node
 	int applyCSGOperations(
 		const std::vector<CSGOperationInfo>& opInfo,
+		const std::vector<int>& opIndices,
 		const glm::ivec3& clipmapNodeMin,
 		const int clipmapNodeSize);
 
@@ -65,15 +187,29 @@ public:
 		const int size,
 		bool& isEmpty);
 
+	// the consumer reads the mesh straight from the readback mapping and is called with 
+	// the device locked, so should do no more than the mesh needs (e.g. simplifying it)
 	int generateChunkMesh(
 		const glm::ivec3& min,
 		const int clipmapNodeSize,
-		MeshBuffer* meshBuffer,
-		std::vector<SeamNodeInfo>& seamNodeBuffer);
+		const ChunkMeshConsumer& consumer);
+
+	// only generates the triangles belonging to the regionMask regions, each triangle's 
+	// region is the one containing the node which generated it. The vertex buffer and 
+	// seam nodes are always for the whole chunk.
+	int generateChunkMeshRegions(
+		const glm::ivec3& min,
+		const int clipmapNodeSize,
+		const u64 regionMask,
+		const ChunkMeshConsumer& consumer);
 
 private:
 
-	MeshGenerationContext*     privateCtx_;
+	friend int Compute_SaveWorldFile(const std::string& path, const std::vector<Compute_MeshGenContext*>& contexts);
+
+	MeshGenerationContext* contextForNode(const glm::ivec3& min, const int size) const;
+
+	std::vector<MeshGenerationContext*>    privateCtxs_;
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,428 @@
+#include	"compute_local.h"
+#include	"compute_program.h"
+#include	"file_utils.h"
+#include	"timer.h"
+#include	"volume_constants.h"
+
+#include	<Remotery.h>
+#include	<sstream>
+#include	<string.h>
+
+// ----------------------------------------------------------------------------
+// The 3D kernels run over the whole field/chunk, and the default tiling the driver
+// picks for e.g. 66x66x66 is often poor (or just 1x1x1 when the size has no nice
+// factors). On the first run for a device the candidate work-group sizes are timed
+// against a sample chunk and the fastest is kept, the results are written next to
+// the program binaries and keyed the same way so a driver or kernel change causes
+// the kernels to be retuned. Delete the .tune file to force a retune.
+// ----------------------------------------------------------------------------
+
+struct TunedKernel
+{
+	const char*		name = nullptr;
+	cl::Kernel*		kernel = nullptr;
+	cl::NDRange*	localSize = nullptr;
+	int				globalSize = 0;		// same in each dimension
+	cl::Buffer*		appendCount = nullptr;	// reset before each run for the append kernels
+
+	int				local[3] = { 0, 0, 0 };		// all 0 for NullRange
+	unsigned int	tunedMicro = 0;
+	unsigned int	defaultMicro = 0;
+};
+
+// ----------------------------------------------------------------------------
+
+static TunedKernel MakeTunedKernel(
+	const char* name,
+	cl::Kernel& kernel,
+	cl::NDRange& localSize,
+	const int globalSize)
+{
+	TunedKernel tuned;
+	tuned.name = name;
+	tuned.kernel = &kernel;
+	tuned.localSize = &localSize;
+	tuned.globalSize = globalSize;
+	return tuned;
+}
+
+// ----------------------------------------------------------------------------
+
+const int TUNING_ITERATIONS = 8;
+
+// anything smaller than this won't fill a SIMD unit on any of the devices we care about
+const int MIN_CANDIDATE_WORK_GROUP_SIZE = 16;
+
+const unsigned int MIN_IMPROVEMENT_PERCENT = 5;
+
+const int MAX_SAMPLE_CHUNK_SEARCH = 16;
+
+// ----------------------------------------------------------------------------
+
+static std::string TuningPath(const MeshGenerationContext* meshGen)
+{
+	// the program keys already cover the device, driver and voxelsPerChunk
+	const u64 keys[3] =
+	{
+		meshGen->densityFieldProgram.key(), meshGen->octreeProgram.key(), meshGen->csgProgram.key()
+	};
+
+	u64 hash = 0xcbf29ce484222325ULL;
+	for (const u64 key: keys)
+	{
+		hash ^= key;
+		hash *= 0x100000001b3ULL;
+	}
+
+	char name[32];
+	sprintf(name, "/%016llx.tune", (unsigned long long)hash);
+	return PROGRAM_CACHE_DIRECTORY + name;
+}
+
+// ----------------------------------------------------------------------------
+
+static cl::NDRange LocalRange(const int local[3])
+{
+	if (local[0] == 0)
+	{
+		return cl::NullRange;
+	}
+
+	return cl::NDRange(local[0], local[1], local[2]);
+}
+
+// ----------------------------------------------------------------------------
+
+static void PrintResult(const TunedKernel& tuned, const char* source)
+{
+	const float speedup = tuned.tunedMicro > 0 ? (float)tuned.defaultMicro / tuned.tunedMicro : 1.f;
+	if (tuned.local[0] == 0)
+	{
+		printf("  %-24s driver default %uus (%s)\n", tuned.name, tuned.defaultMicro, source);
+	}
+	else
+	{
+		printf("  %-24s %dx%dx%d %uus vs driver %uus, %.2fx (%s)\n", tuned.name,
+			tuned.local[0], tuned.local[1], tuned.local[2],
+			tuned.tunedMicro, tuned.defaultMicro, speedup, source);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static bool LoadTuning(const std::string& path, std::vector<TunedKernel>& tuned)
+{
+	std::string data;
+	if (!LoadTextFile(path, data))
+	{
+		return false;
+	}
+
+	int numLoaded = 0;
+	std::istringstream stream(data);
+	std::string name;
+	int local[3] = { 0, 0, 0 };
+	unsigned int tunedMicro = 0, defaultMicro = 0;
+	while (stream >> name >> local[0] >> local[1] >> local[2] >> tunedMicro >> defaultMicro)
+	{
+		for (TunedKernel& t: tuned)
+		{
+			if (name == t.name)
+			{
+				memcpy(t.local, local, sizeof(local));
+				t.tunedMicro = tunedMicro;
+				t.defaultMicro = defaultMicro;
+				numLoaded++;
+			}
+		}
+	}
+
+	// if a kernel has been added since the file was written then retune everything
+	return numLoaded == (int)tuned.size();
+}
+
+// ----------------------------------------------------------------------------
+
+static void SaveTuning(const std::string& path, const std::vector<TunedKernel>& tuned)
+{
+	if (!EnsureDirectoryExists(PROGRAM_CACHE_DIRECTORY))
+	{
+		return;
+	}
+
+	std::stringstream data;
+	for (const TunedKernel& t: tuned)
+	{
+		data << t.name << " " << t.local[0] << " " << t.local[1] << " " << t.local[2] << " "
+			<< t.tunedMicro << " " << t.defaultMicro << "\n";
+	}
+
+	const std::string str = data.str();
+	if (!SaveBinaryFile(path, str.c_str(), str.size()))
+	{
+		printf("Warning: unable to write kernel tuning file '%s'\n", path.c_str());
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static std::vector<int> Divisors(const int n, const int limit)
+{
+	std::vector<int> divisors;
+	for (int i = 1; i <= n && i <= limit; i++)
+	{
+		if ((n % i) == 0)
+		{
+			divisors.push_back(i);
+		}
+	}
+
+	return divisors;
+}
+
+// ----------------------------------------------------------------------------
+
+static int RunKernel(cl::CommandQueue& queue, const TunedKernel& tuned, const cl::NDRange& local)
+{
+	if (tuned.appendCount)
+	{
+		// otherwise the later runs would all be over capacity and skip the real work
+		CL_CALL(FillBufferInt(queue, *tuned.appendCount, 1, 0));
+	}
+
+	const cl::NDRange global(tuned.globalSize, tuned.globalSize, tuned.globalSize);
+	return queue.enqueueNDRangeKernel(*tuned.kernel, cl::NullRange, global, local);
+}
+
+// ----------------------------------------------------------------------------
+
+// returns < 0 if the kernel can't be run with this local size, e.g. too many registers
+static int TimeKernel(cl::CommandQueue& queue, const TunedKernel& tuned, const cl::NDRange& local)
+{
+	// the first run is discarded, it may include the driver's lazy setup
+	if (RunKernel(queue, tuned, local) != CL_SUCCESS || queue.finish() != CL_SUCCESS)
+	{
+		return -1;
+	}
+
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < TUNING_ITERATIONS; i++)
+	{
+		if (RunKernel(queue, tuned, local) != CL_SUCCESS)
+		{
+			return -1;
+		}
+	}
+
+	if (queue.finish() != CL_SUCCESS)
+	{
+		return -1;
+	}
+
+	return timer.elapsedMicro() / TUNING_ITERATIONS;
+}
+
+// ----------------------------------------------------------------------------
+
+static int TuneKernel(ComputeContext* ctx, TunedKernel& tuned)
+{
+	rmt_ScopedCPUSample(TuneKernel);
+
+	cl_int error = CL_SUCCESS;
+	const int maxWorkGroupSize = tuned.kernel->getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(ctx->device, &error);
+	CL_CHECK_ERROR(error, "CL_KERNEL_WORK_GROUP_SIZE");
+
+	std::vector<size_t> maxItemSizes = ctx->device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+	maxItemSizes.resize(3, 1);
+
+	const int defaultMicro = TimeKernel(ctx->queue, tuned, cl::NullRange);
+	if (defaultMicro < 0)
+	{
+		// can't even run the kernel, something is broken
+		return LVN_CL_ERROR;
+	}
+
+	memset(tuned.local, 0, sizeof(tuned.local));
+	tuned.defaultMicro = defaultMicro;
+	tuned.tunedMicro = defaultMicro;
+
+	// OpenCL 1.x requires the local size to divide the global size exactly
+	const std::vector<int> x = Divisors(tuned.globalSize, (int)maxItemSizes[0]);
+	const std::vector<int> y = Divisors(tuned.globalSize, (int)maxItemSizes[1]);
+	const std::vector<int> z = Divisors(tuned.globalSize, (int)maxItemSizes[2]);
+	for (const int lx: x)
+	for (const int ly: y)
+	for (const int lz: z)
+	{
+		const int size = lx * ly * lz;
+		if (size < MIN_CANDIDATE_WORK_GROUP_SIZE || size > maxWorkGroupSize)
+		{
+			continue;
+		}
+
+		const int micro = TimeKernel(ctx->queue, tuned, cl::NDRange(lx, ly, lz));
+		if (micro >= 0 && (unsigned int)micro < tuned.tunedMicro)
+		{
+			tuned.local[0] = lx;
+			tuned.local[1] = ly;
+			tuned.local[2] = lz;
+			tuned.tunedMicro = micro;
+		}
+	}
+
+	// the timings are noisy so only override the driver when it's a clear win
+	if ((tuned.tunedMicro * 100) > (tuned.defaultMicro * (100 - MIN_IMPROVEMENT_PERCENT)))
+	{
+		memset(tuned.local, 0, sizeof(tuned.local));
+		tuned.tunedMicro = tuned.defaultMicro;
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// the inputs and outputs for the sample chunk, held until the tuning is done
+struct SampleChunk
+{
+	GPUDensityField				field;
+	LeafNodeBuffers				leafs;
+	std::vector<cl::Buffer>		buffers;
+};
+
+// ----------------------------------------------------------------------------
+
+// binds the args for a chunk with some surface in it so the kernels do a realistic
+// amount of work, the CSG op is a sphere in the middle of the chunk
+static int BindSampleArgs(MeshGenerationContext* meshGen, SampleChunk& sample)
+{
+	auto ctx = GetComputeContext();
+	MeshGenKernels& k = meshGen->kernels;
+
+	const int numFieldSamples = meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize;
+	const int edgeBufferSize = meshGen->hermiteIndexSize * meshGen->hermiteIndexSize * meshGen->hermiteIndexSize * 3;
+	const int chunkSize = meshGen->voxelsPerChunk * LEAF_SIZE_SCALE;
+
+	// walk up and down from the origin until the chunk crosses the terrain surface,
+	// this leaves generateDefaultField bound to the sample field
+	GPUDensityField& field = sample.field;
+	for (int i = 0; i < MAX_SAMPLE_CHUNK_SEARCH && field.numEdges == 0; i++)
+	{
+		const int step = ((i + 1) / 2) * ((i & 1) ? 1 : -1);
+		field = GPUDensityField();
+		field.min = glm::ivec3(0, step * chunkSize, 0);
+		field.size = chunkSize;
+
+		CL_CALL(GenerateDefaultDensityField(meshGen, &field));
+		CL_CALL(FindDefaultEdges(meshGen, &field));
+	}
+
+	const cl_int4 fieldOffset = LeafScaleVec(field.min);
+	const int sampleScale = 1;
+
+	// FindDefaultEdges only keeps the compacted edges so needs new outputs
+	cl::Buffer d_edgeOccupancy(ctx->context, CL_MEM_READ_WRITE, edgeBufferSize * sizeof(cl_int));
+	cl::Buffer d_edgeIndices(ctx->context, CL_MEM_READ_WRITE, edgeBufferSize * sizeof(cl_int));
+	CL_CALL(k.findFieldEdges.setArg(0, fieldOffset));
+	CL_CALL(k.findFieldEdges.setArg(1, field.materials));
+	CL_CALL(k.findFieldEdges.setArg(2, d_edgeOccupancy));
+	CL_CALL(k.findFieldEdges.setArg(3, d_edgeIndices));
+
+	CL_CALL(PrepareLeafNodes(meshGen, field, &sample.leafs));
+
+	CSGOperationInfo opInfo;
+	opInfo.type = 0;
+	opInfo.brushShape = CSGBrush_Sphere;
+	opInfo.origin = glm::vec4((glm::vec3(field.min) / (float)LEAF_SIZE_SCALE) + glm::vec3(meshGen->voxelsPerChunk / 2.f), 0.f);
+	opInfo.dimensions = glm::vec4(glm::vec3(meshGen->voxelsPerChunk / 4.f), 0.f);
+
+	int opIndex = 0;
+	cl::Buffer d_operations, d_operationIndices;
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(CSGOperationInfo), &opInfo, d_operations));
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(int), &opIndex, d_operationIndices));
+	cl::Buffer d_updatedIndices(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(int));
+	cl::Buffer d_updatedPoints(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(glm::ivec4));
+	cl::Buffer d_updatedMaterials(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(int));
+	// the variants only differ in the brush density so share the sphere's result
+	cl::Kernel& k_csgHermiteIndices = k.csgHermiteIndices[CSGBrush_Sphere];
+	CL_CALL(k_csgHermiteIndices.setArg(0, fieldOffset));
+	CL_CALL(k_csgHermiteIndices.setArg(1, (u32)1));
+	CL_CALL(k_csgHermiteIndices.setArg(2, d_operationIndices));
+	CL_CALL(k_csgHermiteIndices.setArg(3, d_operations));
+	CL_CALL(k_csgHermiteIndices.setArg(4, sampleScale));
+	CL_CALL(k_csgHermiteIndices.setArg(5, field.materials));
+	CL_CALL(k_csgHermiteIndices.setArg(6, d_updatedIndices));
+	CL_CALL(k_csgHermiteIndices.setArg(7, d_updatedPoints));
+	CL_CALL(k_csgHermiteIndices.setArg(8, d_updatedMaterials));
+
+	sample.buffers =
+	{
+		d_edgeOccupancy, d_edgeIndices, d_operations, d_operationIndices, 
+		d_updatedIndices, d_updatedPoints, d_updatedMaterials
+	};
+
+	return ctx->queue.finish();
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_TuneMeshGenKernels(MeshGenerationContext* meshGen)
+{
+	rmt_ScopedCPUSample(TuneMeshGenKernels);
+
+	MeshGenKernels& k = meshGen->kernels;
+	std::vector<TunedKernel> tuned =
+	{
+		MakeTunedKernel("GenerateDefaultField", k.generateDefaultField, k.generateDefaultFieldLocal, meshGen->fieldSize),
+		MakeTunedKernel("FindFieldEdges", k.findFieldEdges, k.findFieldEdgesLocal, meshGen->hermiteIndexSize),
+		MakeTunedKernel("CreateLeafNodes", k.createLeafNodes, k.createLeafNodesLocal, meshGen->voxelsPerChunk),
+		MakeTunedKernel("CSG_HermiteIndices", k.csgHermiteIndices[CSGBrush_Sphere], k.csgHermiteIndicesLocal, meshGen->fieldSize),
+	};
+
+	auto ctx = GetComputeContext();
+	const std::string deviceName = ctx->device.getInfo<CL_DEVICE_NAME>();
+	const std::string path = TuningPath(meshGen);
+
+	const bool loaded = LoadTuning(path, tuned);
+	if (!loaded)
+	{
+		printf("Tuning kernel work-group sizes for '%s' voxelsPerChunk=%d...\n",
+			deviceName.c_str(), meshGen->voxelsPerChunk);
+
+		SampleChunk sample;
+		CL_CALL(BindSampleArgs(meshGen, sample));
+
+		// CreateLeafNodes appends to the leaf buffers so the count is reset between runs
+		for (TunedKernel& t: tuned)
+		{
+			if (t.kernel == &k.createLeafNodes)
+			{
+				t.appendCount = &sample.leafs.count;
+			}
+		}
+
+		for (TunedKernel& t: tuned)
+		{
+			CL_CALL(TuneKernel(ctx, t));
+		}
+
+		SaveTuning(path, tuned);
+	}
+	else
+	{
+		printf("Kernel work-group sizes for '%s' voxelsPerChunk=%d:\n",
+			deviceName.c_str(), meshGen->voxelsPerChunk);
+	}
+
+	for (TunedKernel& t: tuned)
+	{
+		*t.localSize = LocalRange(t.local);
+		PrintResult(t, loaded ? "cached" : "measured");
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
@@ -5,19 +5,70 @@
 
 #include	<Remotery.h>
 #include	<sstream>
+#include	<string.h>
 
 // ----------------------------------------------------------------------------
 
-int ApplyCSGOperations(
+// the clipmap applies the same batch to each node it touches so the ops are only 
+// uploaded when the batch changes, the per node op indices are written each call
+static int UploadCSGOperations(
 	MeshGenerationContext* meshGen,
 	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices)
+{
+	auto ctx = GetComputeContext();
+
+	const bool sameBatch = opInfo.size() == meshGen->csgOperations.size() &&
+		memcmp(&opInfo[0], &meshGen->csgOperations[0], opInfo.size() * sizeof(CSGOperationInfo)) == 0;
+	if (!sameBatch)
+	{
+		if ((int)opInfo.size() > meshGen->csgOperationsCapacity)
+		{
+			meshGen->csgOperationsCapacity = glm::max(64, (int)opInfo.size() * 2);
+			CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, meshGen->csgOperationsCapacity * sizeof(CSGOperationInfo),
+				nullptr, meshGen->d_csgOperations));
+		}
+
+		CL_CALL(ctx->queue.enqueueWriteBuffer(meshGen->d_csgOperations, CL_TRUE, 0, 
+			opInfo.size() * sizeof(CSGOperationInfo), &opInfo[0]));
+		meshGen->csgOperations = opInfo;
+	}
+
+	if ((int)opIndices.size() > meshGen->csgOperationIndicesCapacity)
+	{
+		meshGen->csgOperationIndicesCapacity = glm::max(64, (int)opIndices.size() * 2);
+		CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, meshGen->csgOperationIndicesCapacity * sizeof(int),
+			nullptr, meshGen->d_csgOperationIndices));
+	}
+
+	CL_CALL(ctx->queue.enqueueWriteBuffer(meshGen->d_csgOperationIndices, CL_TRUE, 0, 
+		opIndices.size() * sizeof(int), &opIndices[0]));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// the opIndices ops must all have the brushShape shape
+static int ApplyBrushOperations(
+	MeshGenerationContext* meshGen,
+	const CSGBrushShape brushShape,
+	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
 	const glm::ivec3& clipmapNodeMin,
 	const int clipmapNodeSize,
-	GPUDensityField& field)
+	GPUDensityField& field,
+	cl::Buffer* editedEdges,
+	unsigned int* numEditedEdges)
 {
-	rmt_ScopedCPUSample(ApplyCSGOperations);
+	rmt_ScopedCPUSample(ApplyBrushOperations);
+
+	if (numEditedEdges)
+	{
+		*numEditedEdges = 0;
+	}
 
-	if (opInfo.empty())
+	if (opIndices.empty())
 	{
 		return CL_SUCCESS;
 	}
@@ -25,9 +76,7 @@ int ApplyCSGOperations(
 	const cl_int4 fieldOffset = LeafScaleVec(clipmapNodeMin);
 	const int sampleScale = clipmapNodeSize / (LEAF_SIZE_SCALE * meshGen->voxelsPerChunk);
 
-	std::vector<CSGOperationInfo> fuckSake = opInfo;
-	cl::Buffer d_operations;
-	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(CSGOperationInfo) * opInfo.size(), &fuckSake[0], d_operations));
+	CL_CALL(UploadCSGOperations(meshGen, opInfo, opIndices));
 
 	auto ctx = GetComputeContext();
 	int index = 0;
@@ -37,16 +86,18 @@ int ApplyCSGOperations(
 	{
 		rmt_ScopedCPUSample(Apply);
 
-		const int fieldBufferSize = meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize; 
-		cl::Buffer d_updatedIndices(ctx->context, CL_MEM_READ_WRITE, fieldBufferSize * sizeof(int));
-		cl::Buffer d_updatedPoints(ctx->context, CL_MEM_READ_WRITE, fieldBufferSize * sizeof(glm::ivec4));
-		cl::Buffer d_updatedMaterials(ctx->context, CL_MEM_READ_WRITE, fieldBufferSize * sizeof(int));
+		// one entry per field sample rather than the (padded) field layout
+		const int numFieldSamples = meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize; 
+		cl::Buffer d_updatedIndices(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(int));
+		cl::Buffer d_updatedPoints(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(glm::ivec4));
+		cl::Buffer d_updatedMaterials(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(int));
 
 		index = 0;
-		cl::Kernel k_applyCSGOp(meshGen->csgProgram.get(), "CSG_HermiteIndices");
+		cl::Kernel& k_applyCSGOp = meshGen->kernels.csgHermiteIndices[brushShape];
 		CL_CALL(k_applyCSGOp.setArg(index++, fieldOffset));
-		CL_CALL(k_applyCSGOp.setArg(index++, (u32)opInfo.size()));
-		CL_CALL(k_applyCSGOp.setArg(index++, d_operations));
+		CL_CALL(k_applyCSGOp.setArg(index++, (u32)opIndices.size()));
+		CL_CALL(k_applyCSGOp.setArg(index++, meshGen->d_csgOperationIndices));
+		CL_CALL(k_applyCSGOp.setArg(index++, meshGen->d_csgOperations));
 		CL_CALL(k_applyCSGOp.setArg(index++, sampleScale));
 		CL_CALL(k_applyCSGOp.setArg(index++, field.materials));
 		CL_CALL(k_applyCSGOp.setArg(index++, d_updatedIndices));
@@ -54,10 +105,11 @@ int ApplyCSGOperations(
 		CL_CALL(k_applyCSGOp.setArg(index++, d_updatedMaterials));
 
 		const cl::NDRange applyCSGSize(meshGen->fieldSize, meshGen->fieldSize, meshGen->fieldSize);
-		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_applyCSGOp, cl::NullRange, applyCSGSize, cl::NullRange));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_applyCSGOp, cl::NullRange, applyCSGSize,
+			meshGen->kernels.csgHermiteIndicesLocal));
 
-		cl::Buffer d_updatedIndicesScan(ctx->context, CL_MEM_READ_WRITE, fieldBufferSize * sizeof(int));
-		numUpdatedPoints = ExclusiveScan(ctx->queue, d_updatedIndices, d_updatedIndicesScan, fieldBufferSize);
+		cl::Buffer d_updatedIndicesScan(ctx->context, CL_MEM_READ_WRITE, numFieldSamples * sizeof(int));
+		numUpdatedPoints = ExclusiveScan(ctx->queue, d_updatedIndices, d_updatedIndicesScan, numFieldSamples);
 		if (numUpdatedPoints <= 0)
 		{
 			// < 0 will be an error code
@@ -69,21 +121,23 @@ int ApplyCSGOperations(
 		d_compactUpdatedMaterials = cl::Buffer(ctx->context, CL_MEM_READ_WRITE, numUpdatedPoints * sizeof(int));
 
 		index = 0;
-		cl::Kernel k_compact(meshGen->csgProgram.get(), "CompactPoints");
+		cl::Kernel& k_compact = meshGen->kernels.csgCompactPoints;
 		CL_CALL(k_compact.setArg(index++, d_updatedIndices));
 		CL_CALL(k_compact.setArg(index++, d_updatedPoints));
 		CL_CALL(k_compact.setArg(index++, d_updatedMaterials));
 		CL_CALL(k_compact.setArg(index++, d_updatedIndicesScan));
 		CL_CALL(k_compact.setArg(index++, d_compactUpdatedPoints));
 		CL_CALL(k_compact.setArg(index++, d_compactUpdatedMaterials));
-		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_compact, cl::NullRange, fieldBufferSize, cl::NullRange));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_compact, cl::NullRange, numFieldSamples, cl::NullRange));
 
 		index = 0;
-		cl::Kernel k_UpdateMaterials(meshGen->csgProgram.get(), "UpdateFieldMaterials");
+		cl::Kernel& k_UpdateMaterials = meshGen->kernels.csgUpdateFieldMaterials;
 		CL_CALL(k_UpdateMaterials.setArg(index++, d_compactUpdatedPoints));
 		CL_CALL(k_UpdateMaterials.setArg(index++, d_compactUpdatedMaterials));
 		CL_CALL(k_UpdateMaterials.setArg(index++, field.materials));
 		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_UpdateMaterials, cl::NullRange, numUpdatedPoints, cl::NullRange));
+
+		field.edited = true;
 	}
 
 	unsigned int numCreatedEdges = 0;
@@ -98,7 +152,7 @@ int ApplyCSGOperations(
 	//	printf("# generated edges: %d\n", numGeneratedEdges);
 		cl::Buffer d_generatedEdgeIndices(ctx->context, CL_MEM_READ_WRITE, numGeneratedEdges * sizeof(int));
 
-		cl::Kernel k_findUpdatedEdges(meshGen->csgProgram.get(), "FindUpdatedEdges");
+		cl::Kernel& k_findUpdatedEdges = meshGen->kernels.csgFindUpdatedEdges;
 		CL_CALL(k_findUpdatedEdges.setArg(0, d_compactUpdatedPoints));
 		CL_CALL(k_findUpdatedEdges.setArg(1, d_generatedEdgeIndices));
 		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_findUpdatedEdges, cl::NullRange, numUpdatedPoints, cl::NullRange));
@@ -108,7 +162,7 @@ int ApplyCSGOperations(
 		// indices via a scan and compact (not sure if the order of this and the subsequent 
 		// RemoveDuplicates call matters performance wise?)
 		cl::Buffer d_edgeIndicesValid(ctx->context, CL_MEM_READ_WRITE, numGeneratedEdges * sizeof(int));
-		cl::Kernel k_removeInvalid(meshGen->csgProgram.get(), "RemoveInvalidIndices");
+		cl::Kernel& k_removeInvalid = meshGen->kernels.csgRemoveInvalidIndices;
 		CL_CALL(k_removeInvalid.setArg(0, d_generatedEdgeIndices));
 		CL_CALL(k_removeInvalid.setArg(1, d_edgeIndicesValid));
 		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_removeInvalid, cl::NullRange, numGeneratedEdges, cl::NullRange));
@@ -126,7 +180,7 @@ int ApplyCSGOperations(
 	//	printf("%d Generated %d unique\n", numGeneratedEdges, numInvalidatedEdges);
 
 		cl::Buffer d_edgeValidity(ctx->context, CL_MEM_READ_WRITE, numInvalidatedEdges * sizeof(int));
-		cl::Kernel k_FilterValid(meshGen->csgProgram.get(), "FilterValidEdges");
+		cl::Kernel& k_FilterValid = meshGen->kernels.csgFilterValidEdges;
 		CL_CALL(k_FilterValid.setArg(0, d_invalidatedEdges));
 		CL_CALL(k_FilterValid.setArg(1, field.materials));
 		CL_CALL(k_FilterValid.setArg(2, d_edgeValidity));
@@ -135,6 +189,13 @@ int ApplyCSGOperations(
 		numCreatedEdges  = CompactIndexArray(ctx->queue, d_invalidatedEdges, 
 			d_edgeValidity, numInvalidatedEdges, d_createdEdges);
 	//	printf("%d created edges\n", numCreatedEdges);
+
+		// the created edges are a subset of these so they cover every voxel touched by the ops
+		if (editedEdges && numEditedEdges)
+		{
+			*editedEdges = d_invalidatedEdges;
+			*numEditedEdges = numInvalidatedEdges;
+		}
 	}
 
 	if (numInvalidatedEdges > 0 && field.numEdges > 0)
@@ -143,7 +204,7 @@ int ApplyCSGOperations(
 
 		cl::Buffer d_fieldEdgeValidity(ctx->context, CL_MEM_READ_WRITE, field.numEdges * sizeof(int));
 
-		cl::Kernel k_PruneEdges(meshGen->csgProgram.get(), "PruneFieldEdges");
+		cl::Kernel& k_PruneEdges = meshGen->kernels.csgPruneFieldEdges;
 		CL_CALL(k_PruneEdges.setArg(0, field.edgeIndices));
 		CL_CALL(k_PruneEdges.setArg(1, d_invalidatedEdges));
 		CL_CALL(k_PruneEdges.setArg(2, numInvalidatedEdges));
@@ -159,7 +220,7 @@ int ApplyCSGOperations(
 			cl::Buffer d_prunedNormals(ctx->context, CL_MEM_READ_WRITE, numPrunedEdges * sizeof(glm::vec4));
 
 			index = 0;
-			cl::Kernel k_CompactEdges(meshGen->csgProgram.get(), "CompactFieldEdges");
+			cl::Kernel& k_CompactEdges = meshGen->kernels.csgCompactFieldEdges;
 			CL_CALL(k_CompactEdges.setArg(index++, d_fieldEdgeValidity));
 			CL_CALL(k_CompactEdges.setArg(index++, fieldEdgeScan));
 			CL_CALL(k_CompactEdges.setArg(index++, field.edgeIndices));
@@ -182,10 +243,11 @@ int ApplyCSGOperations(
 		cl::Buffer d_createdNormals = cl::Buffer(ctx->context, CL_MEM_READ_WRITE, numCreatedEdges * sizeof(glm::vec4));
 
 		index = 0;
-		cl::Kernel k_FindEdgeInfo(meshGen->csgProgram.get(), "FindEdgeIntersectionInfo");
+		cl::Kernel& k_FindEdgeInfo = meshGen->kernels.csgFindEdgeInfo[brushShape];
 		CL_CALL(k_FindEdgeInfo.setArg(index++, fieldOffset));
-		CL_CALL(k_FindEdgeInfo.setArg(index++, (u32)opInfo.size()));
-		CL_CALL(k_FindEdgeInfo.setArg(index++, d_operations));
+		CL_CALL(k_FindEdgeInfo.setArg(index++, (u32)opIndices.size()));
+		CL_CALL(k_FindEdgeInfo.setArg(index++, meshGen->d_csgOperationIndices));
+		CL_CALL(k_FindEdgeInfo.setArg(index++, meshGen->d_csgOperations));
 		CL_CALL(k_FindEdgeInfo.setArg(index++, sampleScale));
 		CL_CALL(k_FindEdgeInfo.setArg(index++, d_createdEdges));
 		CL_CALL(k_FindEdgeInfo.setArg(index++, d_createdNormals));
@@ -221,9 +283,75 @@ int ApplyCSGOperations(
 
 // ----------------------------------------------------------------------------
 
+int ApplyCSGOperations(
+	MeshGenerationContext* meshGen,
+	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
+	const glm::ivec3& clipmapNodeMin,
+	const int clipmapNodeSize,
+	GPUDensityField& field,
+	cl::Buffer* editedEdges,
+	unsigned int* numEditedEdges)
+{
+	rmt_ScopedCPUSample(ApplyCSGOperations);
+
+	if (numEditedEdges)
+	{
+		*numEditedEdges = 0;
+	}
+
+	// the kernels are specialised for each brush shape so the ops are applied in runs 
+	// of the same shape, keeping the ops in order means the later ops still win
+	auto ctx = GetComputeContext();
+	std::vector<int> run;
+	for (size_t i = 0; i < opIndices.size(); i++)
+	{
+		const CSGBrushShape brushShape = opInfo[opIndices[i]].brushShape;
+		run.push_back(opIndices[i]);
+		if ((i + 1) < opIndices.size() && opInfo[opIndices[i + 1]].brushShape == brushShape)
+		{
+			continue;
+		}
+
+		cl::Buffer d_runEdges;
+		unsigned int numRunEdges = 0;
+		CL_CALL(ApplyBrushOperations(meshGen, brushShape, opInfo, run, clipmapNodeMin, clipmapNodeSize, 
+			field, &d_runEdges, &numRunEdges));
+		run.clear();
+
+		if (!editedEdges || !numEditedEdges || numRunEdges == 0)
+		{
+			continue;
+		}
+
+		if (*numEditedEdges == 0)
+		{
+			*editedEdges = d_runEdges;
+			*numEditedEdges = numRunEdges;
+		}
+		else
+		{
+			// any duplicates are removed by PatchOctree
+			const unsigned int combinedSize = *numEditedEdges + numRunEdges;
+			cl::Buffer d_combinedEdges(ctx->context, CL_MEM_READ_WRITE, combinedSize * sizeof(int));
+			CL_CALL(ctx->queue.enqueueCopyBuffer(*editedEdges, d_combinedEdges, 0, 0, *numEditedEdges * sizeof(int)));
+			CL_CALL(ctx->queue.enqueueCopyBuffer(d_runEdges, d_combinedEdges, 0, *numEditedEdges * sizeof(int), 
+				numRunEdges * sizeof(int)));
+
+			*editedEdges = d_combinedEdges;
+			*numEditedEdges = combinedSize;
+		}
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
 int Compute_ApplyCSGOperations(
 	MeshGenerationContext* meshGen,
 	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
 	const glm::ivec3& clipmapNodeMin,
 	const int clipmapNodeSize)
 {
@@ -233,10 +361,26 @@ int Compute_ApplyCSGOperations(
 	GPUDensityField field;
 	CL_CALL(LoadDensityField(meshGen, clipmapNodeMin, clipmapNodeSize, &field));
 	
-	CL_CALL(ApplyCSGOperations(meshGen, opInfo, clipmapNodeMin, clipmapNodeSize, field));
+	cl::Buffer d_editedEdges;
+	unsigned int numEditedEdges = 0;
+	CL_CALL(ApplyCSGOperations(meshGen, opInfo, opIndices, clipmapNodeMin, clipmapNodeSize, field, 
+		&d_editedEdges, &numEditedEdges));
+
+	// the whole batch is stored, the culled ops don't touch the field anyway
 	field.lastCSGOperation += opInfo.size();
 	
 	CL_CALL(StoreDensityField(meshGen, field));
 
+	// the spilled octree is now out of date either way
+	Spill_DiscardOctree(meshGen, clipmapNodeMin, clipmapNodeSize);
+
+	bool patched = false;
+	CL_CALL(PatchOctree(meshGen, clipmapNodeMin, clipmapNodeSize, field, d_editedEdges, numEditedEdges, patched));
+	if (!patched)
+	{
+		// rebuilt from the field when next loaded
+		meshGen->octreeCache.erase(glm::ivec4(clipmapNodeMin, clipmapNodeSize));
+	}
+
 	return CL_SUCCESS;
 }
\ No newline at end of file
@@ -9,8 +9,6 @@
 
 // ----------------------------------------------------------------------------
 
-cl::Kernel	k_InsertKeys;
-
 // enforce a minimum size when the table has a small size to avoid collisions
 const unsigned int MIN_TABLE_SIZE = 2048U;		
 
@@ -23,21 +21,31 @@ int Compute_InitialiseCuckoo()
 	buildOptions << "-DCUCKOO_STASH_HASH_INDEX=" << CUCKOO_STASH_HASH_INDEX << " ";
 	buildOptions << "-DCUCKOO_HASH_FN_COUNT=" << CUCKOO_HASH_FN_COUNT << " ";
 	buildOptions << "-DCUCKOO_STASH_SIZE=" << CUCKOO_STASH_SIZE << " ";
-	buildOptions << "-DCUCKOO_MAX_ITERATIONS=" << CUCKOO_MAX_ITERATIONS;
+	buildOptions << "-DCUCKOO_MAX_ITERATIONS=" << CUCKOO_MAX_ITERATIONS << " ";
+	buildOptions << "-DCUCKOO_KEY_BITS=" << CUCKOO_KEY_BITS;
 
 	ComputeProgram program;
 	program.initialise("cl/cuckoo.cl", buildOptions.str());
 	CL_CALL(program.build());
 	
+	auto ctx = GetComputeContext();
 	cl_int error = CL_SUCCESS;
-	k_InsertKeys = cl::Kernel(program.get(), "Cuckoo_InsertKeys", &error);
-	if (!k_InsertKeys() || error != CL_SUCCESS)
+	ctx->cuckooInsertKeys = cl::Kernel(program.get(), "Cuckoo_InsertKeys", &error);
+	if (!ctx->cuckooInsertKeys() || error != CL_SUCCESS)
 	{
 		printf("Error! Failed to create 'InsertKeys' kernel: %s (%d)",
 			GetCLErrorString(error), error);
 		return error;
 	}
 
+	ctx->cuckooInsertIntKeys = cl::Kernel(program.get(), "Cuckoo_InsertIntKeys", &error);
+	if (!ctx->cuckooInsertIntKeys() || error != CL_SUCCESS)
+	{
+		printf("Error! Failed to create 'InsertIntKeys' kernel: %s (%d)",
+			GetCLErrorString(error), error);
+		return error;
+	}
+
 	return CL_SUCCESS;
 }
 
@@ -48,6 +56,10 @@ std::uniform_int_distribution<uint32_t> distribution(1 << 15, 1 << 30);
 
 int Cuckoo_InitialiseTable(CuckooData* data, const unsigned int tableSize)
 {
+	// the key's index is stored above the key bits so the largest index must not be all 
+	// ones, otherwise a key with all its bits set would be read back as CUCKOO_EMPTY_VALUE
+	LVN_ALWAYS_ASSERT("Cuckoo: too many keys for the table", tableSize < (1U << (64 - CUCKOO_KEY_BITS)));
+
 	auto ctx = GetComputeContext();
 
 	data->prime = FindNextPrime(glm::max(MIN_TABLE_SIZE, tableSize * 2));
@@ -59,10 +71,14 @@ int Cuckoo_InitialiseTable(CuckooData* data, const unsigned int tableSize)
 	CL_CALL(FillBufferLong(ctx->queue, data->stash, CUCKOO_STASH_SIZE, CUCKOO_EMPTY_VALUE));
 
 	uint32_t params[CUCKOO_HASH_FN_COUNT * 2];
-	for (int i = 0; i < CUCKOO_HASH_FN_COUNT; i++)
 	{
-		params[i * 2 + 0] = distribution(generator);
-		params[i * 2 + 1] = distribution(generator);
+		// the generator is shared too
+		std::lock_guard<std::mutex> lock(ctx->cuckooMutex);
+		for (int i = 0; i < CUCKOO_HASH_FN_COUNT; i++)
+		{
+			params[i * 2 + 0] = distribution(generator);
+			params[i * 2 + 1] = distribution(generator);
+		}
 	}
 
 	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, 
@@ -73,10 +89,20 @@ int Cuckoo_InitialiseTable(CuckooData* data, const unsigned int tableSize)
 
 // ----------------------------------------------------------------------------
 
-int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned int count)
+static int InsertKeys(
+	cl::Kernel& k_InsertKeys, 
+	CuckooData* data, 
+	const cl::Buffer& d_keys, 
+	const unsigned int count)
 {
 	ComputeContext* ctx = GetComputeContext();
 
+	if ((data->insertedKeys + count) > CUCKOO_MAX_KEYS)
+	{
+		printf("Cuckoo: too many keys (%d), the limit is %d\n", data->insertedKeys + count, CUCKOO_MAX_KEYS);
+		return LVN_CL_ERROR;
+	}
+
 	cl::Buffer d_inserted, d_stashUsed;
 	cl::Buffer d_insertedScan, d_stashUsedScan;
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(int) * count, nullptr, d_inserted));
@@ -84,6 +110,19 @@ int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(int) * count, nullptr, d_insertedScan));
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(int) * count, nullptr, d_stashUsedScan));
 
+	// the table args don't change between retries, only the hash params buffer contents,
+	// so the kernel is locked until the keys are all inserted
+	std::lock_guard<std::mutex> lock(ctx->cuckooMutex);
+
+	int index = 0;
+	CL_CALL(k_InsertKeys.setArg(index++, d_keys));
+	CL_CALL(k_InsertKeys.setArg(index++, data->table));
+	CL_CALL(k_InsertKeys.setArg(index++, data->stash));
+	CL_CALL(k_InsertKeys.setArg(index++, data->prime));
+	CL_CALL(k_InsertKeys.setArg(index++, data->hashParams));
+	CL_CALL(k_InsertKeys.setArg(index++, d_inserted));
+	CL_CALL(k_InsertKeys.setArg(index++, d_stashUsed));
+
 	int numRetries = 0;
 	int insertedCount = 0, stashUsedCount = 0;
 	do
@@ -105,14 +144,6 @@ int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned
 			CL_CALL(FillBufferLong(ctx->queue, data->stash, CUCKOO_STASH_SIZE, CUCKOO_EMPTY_VALUE));
 		}
 
-		int index = 0;
-		CL_CALL(k_InsertKeys.setArg(index++, d_keys));
-		CL_CALL(k_InsertKeys.setArg(index++, data->table));
-		CL_CALL(k_InsertKeys.setArg(index++, data->stash));
-		CL_CALL(k_InsertKeys.setArg(index++, data->prime));
-		CL_CALL(k_InsertKeys.setArg(index++, data->hashParams));
-		CL_CALL(k_InsertKeys.setArg(index++, d_inserted));
-		CL_CALL(k_InsertKeys.setArg(index++, d_stashUsed));
 		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_InsertKeys, cl::NullRange, count, cl::NullRange));
 
 		insertedCount = ExclusiveScan(ctx->queue, d_inserted, d_insertedScan, count);
@@ -138,3 +169,17 @@ int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned
 }
 
 // ----------------------------------------------------------------------------
+
+int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned int count)
+{
+	return InsertKeys(GetComputeContext()->cuckooInsertKeys, data, d_keys, count);
+}
+
+// ----------------------------------------------------------------------------
+
+int	Cuckoo_InsertIntKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned int count)
+{
+	return InsertKeys(GetComputeContext()->cuckooInsertIntKeys, data, d_keys, count);
+}
+
+// ----------------------------------------------------------------------------
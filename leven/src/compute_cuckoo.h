@@ -9,6 +9,11 @@ const int      CUCKOO_HASH_FN_COUNT = CUCKOO_STASH_HASH_INDEX + 1;
 const int      CUCKOO_STASH_SIZE = 101;
 const int      CUCKOO_MAX_ITERATIONS = 32;
 
+// the keys are 64-bit but only the low CUCKOO_KEY_BITS are stored, the rest of the
+// entry holds the value (i.e. the key's index) which limits the number of keys
+const int      CUCKOO_KEY_BITS = 40;
+const int      CUCKOO_MAX_KEYS = (1 << (64 - CUCKOO_KEY_BITS)) - 1;
+
 struct CuckooData
 {
 	cl::Buffer			table, stash;
@@ -21,6 +26,9 @@ struct CuckooData
 int Compute_InitialiseCuckoo();
 
 int Cuckoo_InitialiseTable(CuckooData* data, const unsigned int tableSize);
+
+// d_keys holds 64-bit keys for Cuckoo_InsertKeys and 32-bit keys for Cuckoo_InsertIntKeys
 int	Cuckoo_InsertKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned int count);
+int	Cuckoo_InsertIntKeys(CuckooData* data, const cl::Buffer& d_keys, const unsigned int count);
 
 #endif  // HAS_COMPUTE_CUCKOO_BEEN_INCLUDED
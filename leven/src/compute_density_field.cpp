@@ -2,6 +2,7 @@
 #include	"compute_program.h"
 #include	"volume_constants.h"
 #include	"volume_materials.h"
+#include	"world_file.h"
 #include	"timer.h"
 
 #include	<sstream>
@@ -23,6 +24,37 @@ using glm::vec4;
 std::vector<AABB> g_storedOpAABBs;		
 std::vector<CSGOperationInfo> g_storedOps;
 
+// the ops loaded from the world file are read straight from the mapped op log, 
+// g_storedOps only holds the ops made since the file was opened
+WorldFile g_worldFile;
+
+// the ops are appended while the mesh gen workers are reading them, and saving 
+// reopens the world file, so all three are only accessed with this held
+static std::mutex g_storedOpsMutex;
+
+// ----------------------------------------------------------------------------
+
+static int StoredOpCount()
+{
+	return g_worldFile.numOps() + (int)g_storedOps.size();
+}
+
+// ----------------------------------------------------------------------------
+
+static const CSGOperationInfo& StoredOp(const int index)
+{
+	const int numFileOps = g_worldFile.numOps();
+	return index < numFileOps ? g_worldFile.ops()[index].info : g_storedOps[index - numFileOps];
+}
+
+// ----------------------------------------------------------------------------
+
+static const AABB& StoredOpAABB(const int index)
+{
+	const int numFileOps = g_worldFile.numOps();
+	return index < numFileOps ? g_worldFile.ops()[index].aabb : g_storedOpAABBs[index - numFileOps];
+}
+
 // ----------------------------------------------------------------------------
 
 int perm[512]= {151,160,137,91,90,15,
@@ -87,7 +119,7 @@ unsigned int NoiseHash(const int x, const int y, const int seed)
 
 // ----------------------------------------------------------------------------
 
-int CreateNoisePermutationLookupImage(const int seed)
+void Compute_CreateNoisePermutationLookup(const int seed, std::vector<unsigned char>& pixels)
 {
 	std::array<int, 512> shuffledPerm;
 	for (int i = 0; i < 512; i++)
@@ -97,7 +129,7 @@ int CreateNoisePermutationLookupImage(const int seed)
 
 	std::shuffle(begin(shuffledPerm), end(shuffledPerm), std::default_random_engine(seed));
 
-	std::vector<unsigned char> pixels(256 * 256 * 4);
+	pixels.resize(256 * 256 * 4);
 	for (int i = 0; i < 256; i++)
 	{
 		for (int j = 0; j < 256; j++)
@@ -111,11 +143,23 @@ int CreateNoisePermutationLookupImage(const int seed)
 			pixels[offset + 3] = value;
 		}
 	}
+}
+
+// ----------------------------------------------------------------------------
+
+int CreateNoisePermutationLookupImage(const int seed)
+{
+	std::vector<unsigned char> pixels;
+	Compute_CreateNoisePermutationLookup(seed, pixels);
 
 	cl::ImageFormat format(CL_RGBA, CL_UNORM_INT8);
 
 	auto ctx = GetComputeContext();
-	ctx->noisePermLookupImage = cl::Image2D(ctx->context, CL_MEM_READ_ONLY, format, 256, 256);
+	if (!ctx->noisePermLookupImage())
+	{
+		// only created once, the mesh gen kernels hold a reference to the image
+		ctx->noisePermLookupImage = cl::Image2D(ctx->context, CL_MEM_READ_ONLY, format, 256, 256);
+	}
 
 	const cl::size_t<3> origin = Size3(0);
 	const cl::size_t<3> region = Size3(256, 256, 1);
@@ -128,7 +172,14 @@ int CreateNoisePermutationLookupImage(const int seed)
 
 int Compute_SetNoiseSeed(const int noiseSeed)
 {
-	CL_CALL(CreateNoisePermutationLookupImage(noiseSeed));
+	const int numDevices = Compute_NumDevices();
+	for (int i = 0; i < numDevices; i++)
+	{
+		ComputeContext* ctx = GetComputeContextForDevice(i);
+		ScopedComputeContext scope(ctx);
+		CL_CALL(CreateNoisePermutationLookupImage(noiseSeed));
+		ctx->noiseSeed = noiseSeed;
+	}
 
 	return CL_SUCCESS;
 }
@@ -141,21 +192,25 @@ int GenerateDefaultDensityField(MeshGenerationContext* meshGen, GPUDensityField*
 
 	auto ctx = GetComputeContext();
 
-	const int fieldBufferSize = meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize; 
-	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, fieldBufferSize * sizeof(cl_int), nullptr, field->materials));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, meshGen->fieldBufferSize * sizeof(cl_int), nullptr, field->materials));
+	if (meshGen->fieldBufferSize != (meshGen->fieldSize * meshGen->fieldSize * meshGen->fieldSize))
+	{
+		// the padding in the partial bricks is never read by the kernels, but the whole
+		// buffer is spilled/saved so it shouldn't be left uninitialised
+		CL_CALL(FillBufferInt(ctx->queue, field->materials, meshGen->fieldBufferSize, MATERIAL_AIR));
+	}
 	const cl_int4 d_fieldOffset = LeafScaleVec(field->min);
 
-	int index = 0;
+	// the noise lookup (0) and default material (3) are bound in CreateMeshGenKernels
 	const int sampleScale = field->size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
-	cl::Kernel generateFieldKernel(meshGen->densityFieldProgram.get(), "GenerateDefaultField");
-	CL_CALL(generateFieldKernel.setArg(index++, ctx->noisePermLookupImage));
-	CL_CALL(generateFieldKernel.setArg(index++, d_fieldOffset));
-	CL_CALL(generateFieldKernel.setArg(index++, sampleScale));
-	CL_CALL(generateFieldKernel.setArg(index++, ctx->defaultMaterial));
-	CL_CALL(generateFieldKernel.setArg(index++, field->materials));
+	cl::Kernel& generateFieldKernel = meshGen->kernels.generateDefaultField;
+	CL_CALL(generateFieldKernel.setArg(1, d_fieldOffset));
+	CL_CALL(generateFieldKernel.setArg(2, sampleScale));
+	CL_CALL(generateFieldKernel.setArg(4, field->materials));
 
 	cl::NDRange generateFieldSize(meshGen->fieldSize, meshGen->fieldSize, meshGen->fieldSize);
-	CL_CALL(ctx->queue.enqueueNDRangeKernel(generateFieldKernel, cl::NullRange, generateFieldSize, cl::NullRange));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(generateFieldKernel, cl::NullRange, generateFieldSize,
+		meshGen->kernels.generateDefaultFieldLocal));
 
 	return CL_SUCCESS;
 }
@@ -180,14 +235,14 @@ int FindDefaultEdges(MeshGenerationContext* meshGen, GPUDensityField* field)
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, edgeBufferSize * sizeof(cl_int), nullptr, field->edgeIndices));
 
 	int index = 0;
-	cl::Kernel k_findEdges(meshGen->densityFieldProgram.get(), "FindFieldEdges");
+	cl::Kernel& k_findEdges = meshGen->kernels.findFieldEdges;
 	CL_CALL(k_findEdges.setArg(index++, fieldOffset));
 	CL_CALL(k_findEdges.setArg(index++, field->materials));
 	CL_CALL(k_findEdges.setArg(index++, edgeOccupancy));
 	CL_CALL(k_findEdges.setArg(index++, field->edgeIndices));
 
 	cl::NDRange globalSize(meshGen->hermiteIndexSize, meshGen->hermiteIndexSize, meshGen->hermiteIndexSize);
-	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_findEdges, cl::NullRange, globalSize, cl::NullRange));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_findEdges, cl::NullRange, globalSize, meshGen->kernels.findFieldEdgesLocal));
 
 	cl::Buffer edgeScan(ctx->context, CL_MEM_READ_WRITE, edgeBufferSize * sizeof(int));
 	field->numEdges = ExclusiveScan(ctx->queue, edgeOccupancy, edgeScan, edgeBufferSize);
@@ -206,7 +261,7 @@ int FindDefaultEdges(MeshGenerationContext* meshGen, GPUDensityField* field)
 	cl::Buffer compactActiveEdges(ctx->context, CL_MEM_READ_WRITE, field->numEdges * sizeof(int));
 
 	index = 0;
-	cl::Kernel k_compactEdges(meshGen->densityFieldProgram.get(), "CompactEdges");
+	cl::Kernel& k_compactEdges = meshGen->kernels.compactEdges;
 	CL_CALL(k_compactEdges.setArg(index++, edgeOccupancy));
 	CL_CALL(k_compactEdges.setArg(index++, edgeScan));
 	CL_CALL(k_compactEdges.setArg(index++, field->edgeIndices));
@@ -218,10 +273,9 @@ int FindDefaultEdges(MeshGenerationContext* meshGen, GPUDensityField* field)
 	field->edgeIndices = compactActiveEdges;
 	field->normals = cl::Buffer(ctx->context, CL_MEM_WRITE_ONLY, sizeof(glm::vec4) * field->numEdges);
 
-	index = 0;
+	index = 1;		// the noise lookup is already bound
 	const int sampleScale = field->size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
-	cl::Kernel k_findInfo(meshGen->densityFieldProgram.get(), "FindEdgeIntersectionInfo");
-	CL_CALL(k_findInfo.setArg(index++, ctx->noisePermLookupImage));
+	cl::Kernel& k_findInfo = meshGen->kernels.findEdgeInfo;
 	CL_CALL(k_findInfo.setArg(index++, fieldOffset));
 	CL_CALL(k_findInfo.setArg(index++, sampleScale));
 	CL_CALL(k_findInfo.setArg(index++, field->edgeIndices));
@@ -232,6 +286,72 @@ int FindDefaultEdges(MeshGenerationContext* meshGen, GPUDensityField* field)
 
 // ----------------------------------------------------------------------------
 
+// upload the field from the world file, the buffers are created straight from the 
+// mapping so only the pages belonging to this region are read from disk
+int LoadBakedDensityField(MeshGenerationContext* meshGen, GPUDensityField* field, bool& loaded)
+{
+	loaded = false;
+
+	std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+
+	// the files are always written with the default layout
+	const WorldFileRegion* region = g_worldFile.findRegion(field->min, field->size, meshGen->voxelsPerChunk);
+	if (!region || meshGen->fieldBrickSizeLog2 != FIELD_BRICK_SIZE_LOG2)
+	{
+		return CL_SUCCESS;
+	}
+
+	rmt_ScopedCPUSample(LoadBakedDensityField);
+
+	if (region->materialsSize != (meshGen->fieldBufferSize * sizeof(cl_int)))
+	{
+		printf("LoadBakedDensityField: region size mismatch, regenerating field\n");
+		return CL_SUCCESS;
+	}
+
+	void* materials = (void*)g_worldFile.regionData(region->materialsOffset);
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, region->materialsSize, materials, field->materials));
+
+	if (region->numEdges > 0)
+	{
+		void* edgeIndices = (void*)g_worldFile.regionData(region->edgeIndicesOffset);
+		void* normals = (void*)g_worldFile.regionData(region->normalsOffset);
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, region->numEdges * sizeof(cl_int), edgeIndices, field->edgeIndices));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, region->numEdges * sizeof(glm::vec4), normals, field->normals));
+	}
+
+	field->numEdges = region->numEdges;
+	field->lastCSGOperation = region->lastCSGOperation;
+	field->edited = true;
+	loaded = true;
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// fields not in the cache are uploaded from the spill tier or the world file if 
+// possible, otherwise the default field is generated
+static int LoadUncachedDensityField(MeshGenerationContext* meshGen, GPUDensityField* field)
+{
+	bool loaded = false;
+	CL_CALL(Spill_LoadDensityField(meshGen, field, loaded));
+	if (!loaded)
+	{
+		CL_CALL(LoadBakedDensityField(meshGen, field, loaded));
+	}
+
+	if (!loaded)
+	{
+		CL_CALL(GenerateDefaultDensityField(meshGen, field)); 
+		CL_CALL(FindDefaultEdges(meshGen, field));
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
 int LoadDensityField(MeshGenerationContext* meshGen, const glm::ivec3& min, const int clipmapNodeSize, GPUDensityField* field)
 {
 	rmt_ScopedCPUSample(LoadDensityField);
@@ -240,6 +360,7 @@ int LoadDensityField(MeshGenerationContext* meshGen, const glm::ivec3& min, cons
 	const auto iter = meshGen->densityFieldCache.find(key);
 	if (iter != end(meshGen->densityFieldCache))
 	{
+		iter->second.lastUsed = ++meshGen->cacheTick;
 		*field = iter->second;
 		LVN_ASSERT(field->min == min);
 	}
@@ -247,26 +368,31 @@ int LoadDensityField(MeshGenerationContext* meshGen, const glm::ivec3& min, cons
 	{
 		field->min = min;
 		field->size = clipmapNodeSize;
-
-		CL_CALL(GenerateDefaultDensityField(meshGen, field)); 
-		CL_CALL(FindDefaultEdges(meshGen, field));
+		CL_CALL(LoadUncachedDensityField(meshGen, field));
 	}
 
 	const AABB fieldBB(field->min, field->size);
 	std::vector<CSGOperationInfo> csgOperations;
-	for (int i = field->lastCSGOperation; i < g_storedOps.size(); i++)
+	std::vector<int> csgOperationIndices;
 	{
-		if (fieldBB.overlaps(g_storedOpAABBs[i]))
+		std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+		const int numStoredOps = StoredOpCount();
+		for (int i = field->lastCSGOperation; i < numStoredOps; i++)
 		{
-			csgOperations.push_back(g_storedOps[i]);
+			if (fieldBB.overlaps(StoredOpAABB(i)))
+			{
+				csgOperationIndices.push_back(csgOperations.size());
+				csgOperations.push_back(StoredOp(i));
+			}
 		}
-	}
 
-	field->lastCSGOperation = g_storedOps.size();
+		field->lastCSGOperation = numStoredOps;
+	}
 
 	if (!csgOperations.empty())
 	{
-		CL_CALL(ApplyCSGOperations(meshGen, csgOperations, field->min, field->size, *field));
+		CL_CALL(ApplyCSGOperations(meshGen, csgOperations, csgOperationIndices, 
+			field->min, field->size, *field, nullptr, nullptr));
 		CL_CALL(StoreDensityField(meshGen, *field));
 	}
 
@@ -275,6 +401,32 @@ int LoadDensityField(MeshGenerationContext* meshGen, const glm::ivec3& min, cons
 
 // ----------------------------------------------------------------------------
 
+bool HasPendingCSGOperations(const glm::ivec3& min, const int size, const int lastCSGOperation)
+{
+	const AABB bb(min, size);
+
+	std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+	const int numStoredOps = StoredOpCount();
+	for (int i = lastCSGOperation; i < numStoredOps; i++)
+	{
+		if (bb.overlaps(StoredOpAABB(i)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// ----------------------------------------------------------------------------
+
+bool Compute_HasCSGOperations(const glm::ivec3& min, const int size)
+{
+	return HasPendingCSGOperations(min, size, 0);
+}
+
+// ----------------------------------------------------------------------------
+
 int Compute_ChunkIsEmpty(MeshGenerationContext* meshGen, const glm::ivec3& min, const int chunkSize, bool& isEmpty)
 {
 	const ivec4 key = ivec4(min, chunkSize);
@@ -289,9 +441,8 @@ int Compute_ChunkIsEmpty(MeshGenerationContext* meshGen, const glm::ivec3& min,
 	GPUDensityField field;
 	field.min = min;
 	field.size = chunkSize;
+	CL_CALL(LoadUncachedDensityField(meshGen, &field));
 
-	CL_CALL(GenerateDefaultDensityField(meshGen, &field));
-	CL_CALL(FindDefaultEdges(meshGen, &field));
 	CL_CALL(StoreDensityField(meshGen, field));
 	isEmpty = field.numEdges > 0;
 
@@ -303,7 +454,28 @@ int Compute_ChunkIsEmpty(MeshGenerationContext* meshGen, const glm::ivec3& min,
 int StoreDensityField(MeshGenerationContext* meshGen, const GPUDensityField& field)
 {
 	const glm::ivec4 key(field.min, field.size);
-	meshGen->densityFieldCache[key] = field;
+	GPUDensityField& cachedField = meshGen->densityFieldCache[key];
+	cachedField = field;
+	cachedField.lastUsed = ++meshGen->cacheTick;
+
+	// the cached copy is now the most recent version
+	Spill_DiscardDensityField(meshGen, field.min, field.size);
+
+	if (meshGen->densityFieldCache.size() > MAX_CACHED_DENSITY_FIELDS)
+	{
+		auto lruIter = begin(meshGen->densityFieldCache);
+		for (auto iter = begin(meshGen->densityFieldCache); iter != end(meshGen->densityFieldCache); ++iter)
+		{
+			if (iter->second.lastUsed < lruIter->second.lastUsed)
+			{
+				lruIter = iter;
+			}
+		}
+
+		CL_CALL(Spill_StoreDensityField(meshGen, lruIter->second));
+		meshGen->densityFieldCache.erase(lruIter);
+	}
+
 	return CL_SUCCESS;
 }
 
@@ -311,6 +483,7 @@ int StoreDensityField(MeshGenerationContext* meshGen, const GPUDensityField& fie
 
 int Compute_StoreCSGOperation(const CSGOperationInfo& opInfo, const AABB& aabb)
 {
+	std::lock_guard<std::mutex> lock(g_storedOpsMutex);
 	g_storedOps.push_back(opInfo);
 	g_storedOpAABBs.push_back(aabb);
 	return CL_SUCCESS;
@@ -320,8 +493,217 @@ int Compute_StoreCSGOperation(const CSGOperationInfo& opInfo, const AABB& aabb)
 
 int Compute_ClearCSGOperations()
 {
-	g_storedOps.clear();
-	g_storedOpAABBs.clear();
+	{
+		std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+		g_storedOps.clear();
+		g_storedOpAABBs.clear();
+		g_worldFile.close();
+	}
+
+	// the spilled entries are only valid for the ops they were created with
+	Spill_Clear();
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_OpenWorldFile(const std::string& path)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+		if (!g_storedOps.empty())
+		{
+			printf("Compute_OpenWorldFile: can't open '%s', there are unsaved CSG operations\n", path.c_str());
+			return LVN_CL_ERROR;
+		}
+
+		// a missing file is not an error, the file will be created when the world is saved
+		auto ctx = GetComputeContext();
+		g_worldFile.open(path, ctx->noiseSeed, Compute_DensityGraphHash());
+	}
+
+	Spill_Clear();
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+struct BakedDensityField
+{
+	WorldFileRegion			region;
+	std::vector<cl_int>		materials;
+	std::vector<cl_int>		edgeIndices;
+	std::vector<glm::vec4>	normals;
+};
+
+int Compute_SaveWorldFile(const std::string& path, const std::vector<Compute_MeshGenContext*>& contexts)
+{
+	rmt_ScopedCPUSample(SaveWorldFile);
+
+	auto ctx = GetComputeContext();
+
+	// the lock isn't held while the fields are read back, any ops stored in the 
+	// meantime aren't written and are kept once the file has been reopened
+	std::vector<WorldFileOp> ops;
+	int numFileOps = 0;
+	{
+		std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+		numFileOps = g_worldFile.numOps();
+		ops.resize(StoredOpCount());
+		for (int i = 0; i < (int)ops.size(); i++)
+		{
+			ops[i].info = StoredOp(i);
+			ops[i].aabb = StoredOpAABB(i);
+		}
+	}
+
+	const int numStoredOps = (int)ops.size();
+
+	// only the fields which have had ops applied need to be baked, the rest can be regenerated
+	std::vector<BakedDensityField> bakedFields;
+	for (Compute_MeshGenContext* context: contexts)
+	{
+		for (MeshGenerationContext* meshGen: context->privateCtxs_)
+		{
+			std::lock_guard<std::mutex> lock(meshGen->mutex);
+			ScopedComputeContext scope(meshGen->computeCtx);
+			ComputeContext* deviceCtx = meshGen->computeCtx;
+
+			const int fieldBufferSize = meshGen->fieldBufferSize;
+
+			for (const auto& iter: meshGen->densityFieldCache)
+			{
+				const GPUDensityField& field = iter.second;
+				if (!field.edited)
+				{
+					continue;
+				}
+
+				bakedFields.push_back(BakedDensityField());
+				BakedDensityField& baked = bakedFields.back();
+				baked.region.min[0] = field.min.x;
+				baked.region.min[1] = field.min.y;
+				baked.region.min[2] = field.min.z;
+				baked.region.size = field.size;
+				baked.region.voxelsPerChunk = meshGen->voxelsPerChunk;
+				baked.region.lastCSGOperation = field.lastCSGOperation;
+				baked.region.numEdges = field.numEdges;
+				baked.region.materialsSize = fieldBufferSize * sizeof(cl_int);
+
+				// the reads are blocking as baked is moved by the next push_back, and an
+				// error return would destroy the vectors with the reads still in flight
+				baked.materials.resize(fieldBufferSize);
+				CL_CALL(deviceCtx->queue.enqueueReadBuffer(field.materials, CL_TRUE, 0, 
+					baked.region.materialsSize, &baked.materials[0]));
+
+				if (field.numEdges > 0)
+				{
+					baked.edgeIndices.resize(field.numEdges);
+					baked.normals.resize(field.numEdges);
+					CL_CALL(deviceCtx->queue.enqueueReadBuffer(field.edgeIndices, CL_TRUE, 0, 
+						field.numEdges * sizeof(cl_int), &baked.edgeIndices[0]));
+					CL_CALL(deviceCtx->queue.enqueueReadBuffer(field.normals, CL_TRUE, 0, 
+						field.numEdges * sizeof(glm::vec4), &baked.normals[0]));
+				}
+			}
+
+			// edited fields which have been evicted from the cache are held by the spill tier
+			std::vector<SpilledDensityField> spilledFields;
+			CL_CALL(Spill_GetEditedDensityFields(meshGen, spilledFields));
+			for (SpilledDensityField& spilled: spilledFields)
+			{
+				bakedFields.push_back(BakedDensityField());
+				BakedDensityField& baked = bakedFields.back();
+				baked.region.min[0] = spilled.min.x;
+				baked.region.min[1] = spilled.min.y;
+				baked.region.min[2] = spilled.min.z;
+				baked.region.size = spilled.size;
+				baked.region.voxelsPerChunk = meshGen->voxelsPerChunk;
+				baked.region.lastCSGOperation = spilled.lastCSGOperation;
+				baked.region.numEdges = spilled.numEdges;
+				baked.region.materialsSize = fieldBufferSize * sizeof(cl_int);
+				baked.materials = std::move(spilled.materials);
+				baked.edgeIndices = std::move(spilled.edgeIndices);
+				baked.normals = std::move(spilled.normals);
+			}
+		}
+	}
+
+	// contexts with the same voxelsPerChunk can share regions, keep the most up to date copy
+	std::sort(begin(bakedFields), end(bakedFields), 
+		[](const BakedDensityField& a, const BakedDensityField& b)
+		{
+			if (WorldFile_RegionLess(a.region, b.region)) return true;
+			if (WorldFile_RegionLess(b.region, a.region)) return false;
+			return a.region.lastCSGOperation > b.region.lastCSGOperation;
+		});
+
+	std::vector<WorldFileRegionData> regions;
+	std::vector<WorldFileRegion> bakedRegions;
+	for (const BakedDensityField& baked: bakedFields)
+	{
+		if (!bakedRegions.empty() && !WorldFile_RegionLess(bakedRegions.back(), baked.region))
+		{
+			continue;
+		}
+
+		WorldFileRegionData data;
+		data.region = baked.region;
+		data.materials = &baked.materials[0];
+		data.edgeIndices = baked.edgeIndices.empty() ? nullptr : &baked.edgeIndices[0];
+		data.normals = baked.normals.empty() ? nullptr : &baked.normals[0];
+		regions.push_back(data);
+		bakedRegions.push_back(baked.region);
+	}
+
+	std::lock_guard<std::mutex> lock(g_storedOpsMutex);
+
+	// carry over the regions from the current file that haven't been loaded this session
+	for (int i = 0; i < g_worldFile.numRegions(); i++)
+	{
+		const WorldFileRegion& region = g_worldFile.regions()[i];
+		if (std::binary_search(begin(bakedRegions), end(bakedRegions), region, WorldFile_RegionLess))
+		{
+			continue;
+		}
+
+		WorldFileRegionData data;
+		data.region = region;
+		data.materials = g_worldFile.regionData(region.materialsOffset);
+		data.edgeIndices = g_worldFile.regionData(region.edgeIndicesOffset);
+		data.normals = g_worldFile.regionData(region.normalsOffset);
+		regions.push_back(data);
+	}
+
+	const std::string tempPath = path + ".tmp";
+	if (!WorldFile_Write(tempPath, ctx->noiseSeed, Compute_DensityGraphHash(), ops, regions))
+	{
+		return LVN_CL_ERROR;
+	}
+
+	// the old file needs to be unmapped before it can be replaced, the ops are then
+	// read from the new file so the stored ops from this session can be dropped
+	g_worldFile.close();
+	remove(path.c_str());
+
+	std::string savedPath = path;
+	if (rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		printf("Compute_SaveWorldFile: unable to rename '%s' to '%s'\n", tempPath.c_str(), path.c_str());
+		savedPath = tempPath;
+	}
+
+	if (!g_worldFile.open(savedPath, ctx->noiseSeed, Compute_DensityGraphHash()))
+	{
+		return LVN_CL_ERROR;
+	}
+
+	const int numSavedOps = numStoredOps - numFileOps;
+	g_storedOps.erase(begin(g_storedOps), begin(g_storedOps) + numSavedOps);
+	g_storedOpAABBs.erase(begin(g_storedOpAABBs), begin(g_storedOpAABBs) + numSavedOps);
+
+	printf("Compute_SaveWorldFile: saved '%s' ops=%d regions=%d\n", savedPath.c_str(), numStoredOps, (int)regions.size());
 	return CL_SUCCESS;
 }
 
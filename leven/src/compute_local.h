@@ -10,17 +10,69 @@
 #include	<string>
 #include	<stdint.h>
 #include	<glm/glm.hpp>
+#include	<mutex>
 #include	<unordered_map>
+#include	<vector>
 
 // ----------------------------------------------------------------------------
 
+// the utilProgram kernels used by FillBufferInt, Scan, CompactIndexArray etc, created
+// once per device in InitialiseDevice. Unlike the MeshGenKernels they're shared by all
+// the mesh gen contexts on the device so the args are set and the kernel enqueued under
+// ComputeContext::utilMutex
+struct UtilKernels
+{
+	// fill_buffer.cl
+	cl::Kernel          fillBufferInt;
+	cl::Kernel          fillBufferLong;
+
+	// scan.cl
+	cl::Kernel          exclusiveLocalScan;
+	cl::Kernel          inclusiveLocalScan;
+	cl::Kernel          writeScannedOutput;
+
+	// compact.cl
+	cl::Kernel          compactArrayLong;
+	cl::Kernel          compactIndexArray;
+
+	// duplicate.cl
+	cl::Kernel          mapSequenceIndices;
+	cl::Kernel          extractWinners;
+	cl::Kernel          mapSequenceValues;
+	cl::Kernel          extractLosers;
+};
+
+// ----------------------------------------------------------------------------
+
+// one per selected device, see Compute_SetDeviceSelection
 struct ComputeContext
 {
+	int                 deviceIndex = 0;
 	cl::Device          device;
 	cl::Context         context;
 	cl::CommandQueue    queue;
 	cl::Image2D         noisePermLookupImage;
+	int                 noiseSeed = 0;
 	int                 defaultMaterial = 0;
+
+	// the programs are built per device so these can't be shared between contexts
+	ComputeProgram      utilProgram;
+	UtilKernels         utilKernels;
+	std::mutex          utilMutex;
+
+	// cl/cuckoo.cl, shared like the util kernels but locked for the whole insert including
+	// the retries, which use the util kernels, so guarded separately
+	cl::Kernel          cuckooInsertKeys;
+	cl::Kernel          cuckooInsertIntKeys;
+	std::mutex          cuckooMutex;
+
+	// cl/seam_mesh.cl, the seams aren't tied to a mesh gen context so the kernels are
+	// guarded separately, see Compute_GenerateSeamMesh
+	ComputeProgram      seamProgram;
+	cl::Kernel          seamNodeCodes;
+	cl::Kernel          generateSeamMesh;
+	cl::Kernel          compactSeamTriangles;
+	std::mutex          seamMutex;
 };
 
 // ----------------------------------------------------------------------------
@@ -30,6 +82,8 @@ struct GPUDensityField
 	glm::ivec3          min;
 	int                 size = 0;
 	int                 lastCSGOperation = 0;
+	bool                edited = false;
+	u64                 lastUsed = 0;
 
 	unsigned int        numEdges = 0;
 	cl::Buffer          edgeIndices;
@@ -44,18 +98,93 @@ typedef std::unordered_map<glm::ivec4, GPUDensityField> DensityFieldCache;
 struct GPUOctree
 {
 	int             numNodes = 0;
+	int             numVertices = 0;			// less than numNodes when clusters were collapsed
+	int             lastCSGOperation = 0;		// the field's lastCSGOperation when constructed
+	u64             lastUsed = 0;
 	cl::Buffer      d_nodeCodes, d_nodeMaterials;
 	cl::Buffer      d_vertexPositions, d_vertexNormals;
+	cl::Buffer      d_nodeVertices;				// the node's mesh vertex, ~vertex if it belongs to another node
 	CuckooData      d_hashTable;
+
+	// the collapse overwrites the leaf vertices so the octrees of edited chunks keep
+	// a copy along with the QEFs to allow the next edit to be patched in, see PatchOctree
+	cl::Buffer      d_leafQEFs, d_leafPositions, d_leafNormals;
 };
 
-// TODO a better cache than this!
 typedef std::unordered_map<glm::ivec4, GPUOctree> OctreeCache;
 
+// the caches hold GPU memory so are bounded, the least recently used entries are 
+// moved to the spill tier (see compute_spill.cpp) when the limit is reached
+const int MAX_CACHED_DENSITY_FIELDS = 256;
+const int MAX_CACHED_OCTREES = 1024;
+
+// the field materials are stored in 4x4x4 bricks by default, see field_index() in
+// shared_constants.cl and Compute_CreateMeshGenContext
+const int FIELD_BRICK_SIZE_LOG2 = 2;
+
+// ----------------------------------------------------------------------------
+
+// created once per context in Compute_CreateMeshGenContext, the kernels have their
+// args set for each chunk so are guarded by MeshGenerationContext::mutex
+struct MeshGenKernels
+{
+	// density_field.cl
+	cl::Kernel          generateDefaultField;
+	cl::Kernel          findFieldEdges;
+	cl::Kernel          compactEdges;
+	cl::Kernel          findEdgeInfo;
+
+	// octree.cl
+	cl::Kernel          createLeafNodes;
+	cl::Kernel          createSurfaceNetsLeafNodes;
+	cl::Kernel          createLeafNodesForVoxels;
+	cl::Kernel          createSurfaceNetsLeafNodesForVoxels;
+	cl::Kernel          solveQEFs;
+	cl::Kernel          collapseLeafCells;
+	cl::Kernel          collapseCells;
+	cl::Kernel          assignNodeClusters;
+	cl::Kernel          resolveNodeClusters;
+	cl::Kernel          assignNodeVertices;
+	cl::Kernel          initialiseNodeVertices;
+	cl::Kernel          generateMesh;
+	cl::Kernel          selectMeshRegions;
+	cl::Kernel          compactMeshTriangles;
+	cl::Kernel          generateMeshVertexBuffer;
+	cl::Kernel          findSeamNodes;
+	cl::Kernel          extractSeamNodeInfo;
+	cl::Kernel          findEditedVoxels;
+	cl::Kernel          removeEditedNodes;
+	cl::Kernel          compactOctreeNodes;
+	cl::Kernel          compactNodeQEFs;
+
+	// apply_csg_operation.cl, the brush kernels have a variant per CSGBrushShape
+	cl::Kernel          csgHermiteIndices[CSGBrush_SIZE];
+	cl::Kernel          csgCompactPoints;
+	cl::Kernel          csgUpdateFieldMaterials;
+	cl::Kernel          csgFindUpdatedEdges;
+	cl::Kernel          csgRemoveInvalidIndices;
+	cl::Kernel          csgFilterValidEdges;
+	cl::Kernel          csgPruneFieldEdges;
+	cl::Kernel          csgCompactFieldEdges;
+	cl::Kernel          csgFindEdgeInfo[CSGBrush_SIZE];
+
+	// the work-group sizes for the 3D kernels picked by Compute_TuneMeshGenKernels,
+	// left as NullRange (i.e. the driver decides) when tuning didn't find anything better
+	cl::NDRange         generateDefaultFieldLocal;
+	cl::NDRange         findFieldEdgesLocal;
+	cl::NDRange         createLeafNodesLocal;
+	cl::NDRange         csgHermiteIndicesLocal;
+};
+
 // ----------------------------------------------------------------------------
 
 struct MeshGenerationContext
 {
+	ComputeContext*     computeCtx = nullptr;
+
+	// held while the context is in use, each context is only used by one thread at a time
+	std::mutex          mutex;
+
 	ComputeProgram      densityFieldProgram;
 	DensityFieldCache   densityFieldCache;
 
@@ -64,15 +193,67 @@ struct MeshGenerationContext
 
 	ComputeProgram      csgProgram;
 
+	// the last batch of CSG ops uploaded, see UploadCSGOperations
+	std::vector<CSGOperationInfo> csgOperations;
+	cl::Buffer          d_csgOperations;
+	int                 csgOperationsCapacity = 0;
+	cl::Buffer          d_csgOperationIndices;
+	int                 csgOperationIndicesCapacity = 0;
+
+	MeshGenKernels      kernels;
+
+	// the chunk's mesh and seam nodes are copied here and mapped once to read them
+	// back, allocated with CL_MEM_ALLOC_HOST_PTR (i.e. pinned) and grown as needed
+	cl::Buffer          d_readbackStaging;
+	size_t              readbackStagingSize = 0;
+
+	u64                 cacheTick = 0;
 	int                 voxelsPerChunk = -1;
 	int                 hermiteIndexSize = -1;
 	int                 fieldSize = -1;
+	int                 fieldBrickSizeLog2 = -1;	// 0 for the linear layout
+	int                 fieldBufferSize = -1;		// fieldSize^3 rounded up to whole bricks, see field_index()
 	int                 indexShift = -1;
 	int                 indexMask = -1;
 };
 
 // ----------------------------------------------------------------------------
 
+// the transient outputs of the CreateLeafNodes kernel, sized from the field's edge
+// count rather than the whole chunk since only the voxels on the surface are written
+struct LeafNodeBuffers
+{
+	int                 capacity = 0;
+	cl::Buffer          count;
+	cl::Buffer          codes;
+	cl::Buffer          materials;
+	cl::Buffer          normals;
+	cl::Buffer          qefs;				// dual contouring only
+	cl::Buffer          positions;			// surface nets only
+	CuckooData          edgeHashTable;
+};
+
+// allocates the buffers and binds all the CreateLeafNodes args
+int PrepareLeafNodes(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	LeafNodeBuffers* leafs);
+
+// as above for CreateSurfaceNetsLeafNodes, see cl/surface_nets.cl
+int PrepareSurfaceNetsLeafNodes(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	const cl_float4& worldSpaceOffset,
+	LeafNodeBuffers* leafs);
+
+// ----------------------------------------------------------------------------
+
+// benchmarks the candidate work-group sizes on the first run for each device and
+// program, the winners are stored alongside the program binaries (compute_autotune.cpp)
+int Compute_TuneMeshGenKernels(MeshGenerationContext* meshGen);
+
+// ----------------------------------------------------------------------------
+
 struct MeshBufferGPU
 {
 	MeshBufferGPU()
@@ -81,8 +262,10 @@ struct MeshBufferGPU
 	{
 	}
 
-	cl::Buffer            vertices, triangles;
+	cl::Buffer            vertices, triangles;	// the vertices are PackedMeshVertex
+	cl::Buffer            triangleRegions;		// only filled when requested, see SelectMeshRegions
     int	                countVertices, countTriangles;
+	PackedMeshBounds      bounds;
 };
 
 // ----------------------------------------------------------------------------
@@ -91,12 +274,22 @@ struct MeshBufferGPU
 
 Compute_MeshGenContext* Compute_CreateMeshGenerator(const int voxelsPerChunk);
 
+// a single device's context, the caller must set computeCtx (see Compute_MeshGenContext::create).
+// The brick size only needs changed to compare the field layouts (0 is the linear layout), 
+// the world files and spilled fields are only valid for the default.
+MeshGenerationContext* Compute_CreateMeshGenContext(
+	const int voxelsPerChunk, 
+	const int fieldBrickSizeLog2 = FIELD_BRICK_SIZE_LOG2);
+
 int Compute_ApplyCSGOperations(
 	MeshGenerationContext* meshGen,
 	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
 	const glm::ivec3& clipmapNodeMin,
 	const int clipmapNodeSize);
 
+int Compute_InitialiseSeamMesh();
+
 int Compute_FreeChunkOctree(
 	MeshGenerationContext* meshGen, 
 	const glm::ivec3& min, 
@@ -108,16 +301,34 @@ int Compute_ChunkIsEmpty(
 	const int chunkSize, 
 	bool& isEmpty);
 
+// only the triangles in the regionMask regions are generated, the triangles' regions
+// are only read back if readRegions is set (otherwise the mask must be ALL_MESH_REGIONS)
 int Compute_GenerateChunkMesh(
 	MeshGenerationContext* meshGen,
 	const glm::ivec3& min,
 	const int clipmapNodeSize,
-	MeshBuffer* meshBuffer,
-	std::vector<SeamNodeInfo>& seamNodeBuffer);
+	const u64 regionMask,
+	const bool readRegions,
+	const ChunkMeshConsumer& consumer);
 
 // ----------------------------------------------------------------------------
 
+// returns the context made current on this thread with ScopedComputeContext, or the
+// first device's context if there isn't one
 ComputeContext* GetComputeContext();
+ComputeContext* GetComputeContextForDevice(const int deviceIndex);
+
+class ScopedComputeContext
+{
+public:
+
+	ScopedComputeContext(ComputeContext* ctx);
+	~ScopedComputeContext();
+
+private:
+
+	ComputeContext*		previous_;
+};
 
 int CreateBuffer(
 	cl_int permissions,
@@ -164,12 +375,49 @@ int CalculateAmbientOcclusion(
 	const cl::Buffer& d_vertexNormals,
 	const int numVertices);
 
+// only the opIndices ops are applied, opInfo is uploaded once and reused by the
+// following calls with the same batch
 int ApplyCSGOperations(
 	MeshGenerationContext* meshGen,
 	const std::vector<CSGOperationInfo>& opInfo,
+	const std::vector<int>& opIndices,
 	const glm::ivec3& clipmapNodeMin,
 	const int clipmapNodeSize,
-	GPUDensityField& field);
+	GPUDensityField& field,
+	cl::Buffer* editedEdges,
+	unsigned int* numEditedEdges);
+
+// recreates the leafs of the voxels touched by the edited edges (from ApplyCSGOperations)
+// in the cached octree, patched is false when there is no octree which can be patched
+int PatchOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int clipmapNodeSize,
+	const GPUDensityField& field,
+	const cl::Buffer& editedEdges,
+	const unsigned int numEditedEdges,
+	bool& patched);
+
+// the cached octree if there is one, otherwise constructed from the chunk's field and cached
+int LoadOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int clipmapNodeSize,
+	GPUOctree* octree);
+
+int ConstructOctreeFromField(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const GPUDensityField& field,
+	GPUOctree* octree);
+
+int GenerateDefaultDensityField(
+	MeshGenerationContext* meshGen,
+	GPUDensityField* field);
+
+int FindDefaultEdges(
+	MeshGenerationContext* meshGen,
+	GPUDensityField* field);
 
 int LoadDensityField(
 	MeshGenerationContext* meshGen, 
@@ -181,6 +429,62 @@ int StoreDensityField(
 	MeshGenerationContext* meshGen, 
 	const GPUDensityField& field);
 
+bool HasPendingCSGOperations(
+	const glm::ivec3& min,
+	const int size,
+	const int lastCSGOperation);
+
+// ----------------------------------------------------------------------------
+
+struct SpilledDensityField
+{
+	glm::ivec3				min;
+	int						size = 0;
+	int						lastCSGOperation = 0;
+	unsigned int			numEdges = 0;
+	std::vector<cl_int>		materials;
+	std::vector<cl_int>		edgeIndices;
+	std::vector<glm::vec4>	normals;
+};
+
+void Spill_Clear();
+
+int Spill_StoreDensityField(
+	MeshGenerationContext* meshGen, 
+	const GPUDensityField& field);
+
+int Spill_LoadDensityField(
+	MeshGenerationContext* meshGen, 
+	GPUDensityField* field, 
+	bool& loaded);
+
+void Spill_DiscardDensityField(
+	MeshGenerationContext* meshGen, 
+	const glm::ivec3& min, 
+	const int size);
+
+int Spill_GetEditedDensityFields(
+	MeshGenerationContext* meshGen, 
+	std::vector<SpilledDensityField>& fields);
+
+int Spill_StoreOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int size,
+	const GPUOctree& octree);
+
+int Spill_LoadOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int size,
+	GPUOctree* octree,
+	bool& loaded);
+
+void Spill_DiscardOctree(
+	MeshGenerationContext* meshGen, 
+	const glm::ivec3& min, 
+	const int size);
+
 // ----------------------------------------------------------------------------
 
 cl::size_t<3> Size3(const u32 size);
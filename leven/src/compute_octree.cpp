@@ -7,6 +7,8 @@
 #include	"file_utils.h"
 #include	"glsl_svd.h"
 
+#include	<climits>
+#include	<cstring>
 #include	<vector>
 #include	<sstream>
 #include	<unordered_map>
@@ -22,6 +24,329 @@ const glm::vec3 ColourForMinLeafSize(const int minLeafSize);
 
 // ----------------------------------------------------------------------------
 
+// the max distance (in voxels) a collapsed vertex can move from the leaf vertices' 
+// tangent planes, 0 disables the collapse. Only set at startup so isn't guarded.
+static float g_collapseMaxError = 0.f;
+
+// i.e. the largest cluster is 8x8x8 voxels
+const int MAX_COLLAPSE_LEVELS = 3;
+
+int Compute_SetCollapseOptions(const float maxError)
+{
+	g_collapseMaxError = glm::max(maxError, 0.f);
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// bit N set if LOD N uses surface nets rather than dual contouring
+static int g_surfaceNetsLODs = 0;
+
+int Compute_SetMeshExtractors(const std::string& extractors)
+{
+	int surfaceNetsLODs = 0;
+
+	std::stringstream stream(extractors);
+	std::string extractor;
+	for (int lod = 0; std::getline(stream, extractor, ','); lod++)
+	{
+		if (_stricmp(extractor.c_str(), "sn") == 0)
+		{
+			surfaceNetsLODs |= (1 << lod);
+		}
+		else if (_stricmp(extractor.c_str(), "dc") != 0)
+		{
+			printf("Compute_SetMeshExtractors: unknown extractor '%s' for LOD %d\n", extractor.c_str(), lod);
+			return LVN_CL_ERROR;
+		}
+	}
+
+	g_surfaceNetsLODs = surfaceNetsLODs;
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// the LOD is from the node size rather than the sample scale as the LODs can use 
+// different voxelsPerChunk values (see ClipmapConfig)
+static bool UseSurfaceNets(const int nodeSize)
+{
+	const int lod = glm::log2(glm::max(1, nodeSize / CLIPMAP_LEAF_SIZE));
+	return lod < 32 && (g_surfaceNetsLODs & (1 << lod)) != 0;
+}
+
+// ----------------------------------------------------------------------------
+
+static int AllocateLeafNodes(
+	const GPUDensityField& field,
+	const int capacity,
+	LeafNodeBuffers* leafs)
+{
+	leafs->capacity = glm::max(1, capacity);
+
+	cl_int zero = 0;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int), &zero, leafs->count));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_ulong) * leafs->capacity, nullptr, leafs->codes));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * leafs->capacity, nullptr, leafs->materials));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * leafs->capacity, nullptr, leafs->normals));
+
+	CL_CALL(Cuckoo_InitialiseTable(&leafs->edgeHashTable, field.numEdges));
+	CL_CALL(Cuckoo_InsertIntKeys(&leafs->edgeHashTable, field.edgeIndices, field.numEdges));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+static int ChunkLeafCapacity(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field)
+{
+	// every active voxel has at least one active edge and each edge is shared by at 
+	// most 4 voxels, so this can never overflow
+	const int chunkBufferSize = meshGen->voxelsPerChunk * meshGen->voxelsPerChunk * meshGen->voxelsPerChunk;
+	return glm::min(chunkBufferSize, (int)field.numEdges * 4);
+}
+
+// ----------------------------------------------------------------------------
+
+// the CreateLeafNodesForVoxels args are the same as CreateLeafNodes so either can be bound
+static int PrepareLeafNodesForKernel(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	const int capacity,
+	cl::Kernel& createLeafNodes,
+	LeafNodeBuffers* leafs)
+{
+	CL_CALL(AllocateLeafNodes(field, capacity, leafs));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(QEFData) * leafs->capacity, nullptr, leafs->qefs));
+
+	int index = 0;
+	const int sampleScale = field.size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
+	CL_CALL(createLeafNodes.setArg(index++, field.materials));
+	CL_CALL(createLeafNodes.setArg(index++, sampleScale));
+	CL_CALL(createLeafNodes.setArg(index++, field.normals));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.table));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.stash));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.prime));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.hashParams));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.stashUsed));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->capacity));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->count));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->codes));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->materials));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->normals));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->qefs));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int PrepareLeafNodes(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	LeafNodeBuffers* leafs)
+{
+	return PrepareLeafNodesForKernel(meshGen, field, ChunkLeafCapacity(meshGen, field), 
+		meshGen->kernels.createLeafNodes, leafs);
+}
+
+// ----------------------------------------------------------------------------
+
+static int PrepareSurfaceNetsLeafNodesForKernel(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	const cl_float4& worldSpaceOffset,
+	const int capacity,
+	cl::Kernel& createLeafNodes,
+	LeafNodeBuffers* leafs)
+{
+	CL_CALL(AllocateLeafNodes(field, capacity, leafs));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * leafs->capacity, nullptr, leafs->positions));
+
+	int index = 0;
+	const int sampleScale = field.size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
+	CL_CALL(createLeafNodes.setArg(index++, field.materials));
+	CL_CALL(createLeafNodes.setArg(index++, sampleScale));
+	CL_CALL(createLeafNodes.setArg(index++, worldSpaceOffset));
+	CL_CALL(createLeafNodes.setArg(index++, field.normals));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.table));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.stash));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.prime));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.hashParams));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->edgeHashTable.stashUsed));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->capacity));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->count));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->codes));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->materials));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->positions));
+	CL_CALL(createLeafNodes.setArg(index++, leafs->normals));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int PrepareSurfaceNetsLeafNodes(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	const cl_float4& worldSpaceOffset,
+	LeafNodeBuffers* leafs)
+{
+	return PrepareSurfaceNetsLeafNodesForKernel(meshGen, field, worldSpaceOffset, ChunkLeafCapacity(meshGen, field),
+		meshGen->kernels.createSurfaceNetsLeafNodes, leafs);
+}
+
+// ----------------------------------------------------------------------------
+
+// Merges the leaf vertices into clusters while the leaf QEFs are still available, 
+// see CollapseCell in octree.cl. Fills d_nodeVertices which maps each node to its 
+// vertex in the mesh generated by GenerateMeshFromOctree, only the cluster leaders
+// get a vertex so far fewer vertices and triangles need to be read back.
+static int CollapseClusters(
+	MeshGenerationContext* meshGen,
+	const cl_float4& worldSpaceOffset,
+	const int sampleScale,
+	const float maxCollapseError,
+	const cl::Buffer& leafQEFs,
+	GPUOctree* octree)
+{
+	auto ctx = GetComputeContext();
+	MeshGenKernels& k = meshGen->kernels;
+	const int numNodes = octree->numNodes;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, octree->d_nodeVertices));
+
+	if (maxCollapseError <= 0.f)
+	{
+		CL_CALL(k.initialiseNodeVertices.setArg(0, octree->d_nodeVertices));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k.initialiseNodeVertices, cl::NullRange, numNodes, cl::NullRange));
+		octree->numVertices = numNodes;
+		return CL_SUCCESS;
+	}
+
+	// the levels are stored one after the other in the cell buffers
+	int levelOffsets[MAX_COLLAPSE_LEVELS];
+	int numLevels = 0, numCells = 0;
+	for (int dim = meshGen->voxelsPerChunk / 2; dim > 0 && numLevels < MAX_COLLAPSE_LEVELS; dim /= 2)
+	{
+		levelOffsets[numLevels++] = numCells;
+		numCells += dim * dim * dim;
+	}
+
+	cl::Buffer d_cellQEFs, d_cellPositions, d_cellNormals, d_cellStates, d_cellLeaders;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(QEFData) * numCells, nullptr, d_cellQEFs));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numCells, nullptr, d_cellPositions));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numCells, nullptr, d_cellNormals));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numCells, nullptr, d_cellStates));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numCells, nullptr, d_cellLeaders));
+	CL_CALL(FillBufferInt(ctx->queue, d_cellLeaders, numCells, INT_MAX));
+
+	// the error is measured in the same units as the leaf QEFs, i.e. scaled by the sample scale
+	const float maxError = maxCollapseError * sampleScale;
+	const float maxErrorSq = maxError * maxError;
+
+	{
+		int dim = meshGen->voxelsPerChunk / 2;
+		int index = 0;
+		CL_CALL(k.collapseLeafCells.setArg(index++, worldSpaceOffset));
+		CL_CALL(k.collapseLeafCells.setArg(index++, sampleScale));
+		CL_CALL(k.collapseLeafCells.setArg(index++, maxErrorSq));
+		CL_CALL(k.collapseLeafCells.setArg(index++, leafQEFs));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_vertexPositions));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_vertexNormals));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_hashTable.table));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_hashTable.stash));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_hashTable.prime));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_hashTable.hashParams));
+		CL_CALL(k.collapseLeafCells.setArg(index++, octree->d_hashTable.stashUsed));
+		CL_CALL(k.collapseLeafCells.setArg(index++, d_cellQEFs));
+		CL_CALL(k.collapseLeafCells.setArg(index++, d_cellPositions));
+		CL_CALL(k.collapseLeafCells.setArg(index++, d_cellNormals));
+		CL_CALL(k.collapseLeafCells.setArg(index++, d_cellStates));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k.collapseLeafCells, cl::NullRange, cl::NDRange(dim, dim, dim), cl::NullRange));
+
+		for (int level = 1; level < numLevels; level++)
+		{
+			dim /= 2;
+			index = 0;
+			CL_CALL(k.collapseCells.setArg(index++, 2 << level));
+			CL_CALL(k.collapseCells.setArg(index++, sampleScale));
+			CL_CALL(k.collapseCells.setArg(index++, maxErrorSq));
+			CL_CALL(k.collapseCells.setArg(index++, levelOffsets[level - 1]));
+			CL_CALL(k.collapseCells.setArg(index++, levelOffsets[level]));
+			CL_CALL(k.collapseCells.setArg(index++, d_cellQEFs));
+			CL_CALL(k.collapseCells.setArg(index++, d_cellPositions));
+			CL_CALL(k.collapseCells.setArg(index++, d_cellNormals));
+			CL_CALL(k.collapseCells.setArg(index++, d_cellStates));
+			CL_CALL(ctx->queue.enqueueNDRangeKernel(k.collapseCells, cl::NullRange, cl::NDRange(dim, dim, dim), cl::NullRange));
+		}
+	}
+
+	cl::Buffer d_nodeClusters, d_nodeLeaders, d_isVertex, d_vertexScan;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, d_nodeClusters));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, d_nodeLeaders));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, d_isVertex));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, d_vertexScan));
+
+	int index = 0;
+	CL_CALL(k.assignNodeClusters.setArg(index++, numLevels));
+	CL_CALL(k.assignNodeClusters.setArg(index++, octree->d_nodeCodes));
+	CL_CALL(k.assignNodeClusters.setArg(index++, d_cellStates));
+	CL_CALL(k.assignNodeClusters.setArg(index++, d_cellLeaders));
+	CL_CALL(k.assignNodeClusters.setArg(index++, d_nodeClusters));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k.assignNodeClusters, cl::NullRange, numNodes, cl::NullRange));
+
+	index = 0;
+	CL_CALL(k.resolveNodeClusters.setArg(index++, worldSpaceOffset));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_nodeClusters));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_cellLeaders));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_cellPositions));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_cellNormals));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_nodeLeaders));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, d_isVertex));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, octree->d_vertexPositions));
+	CL_CALL(k.resolveNodeClusters.setArg(index++, octree->d_vertexNormals));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k.resolveNodeClusters, cl::NullRange, numNodes, cl::NullRange));
+
+	const int numVertices = ExclusiveScan(ctx->queue, d_isVertex, d_vertexScan, numNodes);
+	if (numVertices <= 0)
+	{
+		// every cluster has a leader so there is always at least one vertex
+		return numVertices < 0 ? numVertices : LVN_CL_ERROR;
+	}
+
+	index = 0;
+	CL_CALL(k.assignNodeVertices.setArg(index++, d_nodeLeaders));
+	CL_CALL(k.assignNodeVertices.setArg(index++, d_vertexScan));
+	CL_CALL(k.assignNodeVertices.setArg(index++, octree->d_nodeVertices));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k.assignNodeVertices, cl::NullRange, numNodes, cl::NullRange));
+
+	octree->numVertices = numVertices;
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+// copies the leaf data CollapseClusters needs (and overwrites) so the octree can be 
+// patched, only done for the edited chunks as it roughly doubles the octree's size
+static int KeepLeafData(const cl::Buffer& leafQEFs, GPUOctree* octree)
+{
+	auto ctx = GetComputeContext();
+	const int numNodes = octree->numNodes;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(QEFData) * numNodes, nullptr, octree->d_leafQEFs));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numNodes, nullptr, octree->d_leafPositions));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numNodes, nullptr, octree->d_leafNormals));
+
+	CL_CALL(ctx->queue.enqueueCopyBuffer(leafQEFs, octree->d_leafQEFs, 0, 0, sizeof(QEFData) * numNodes));
+	CL_CALL(ctx->queue.enqueueCopyBuffer(octree->d_vertexPositions, octree->d_leafPositions, 0, 0, sizeof(cl_float4) * numNodes));
+	CL_CALL(ctx->queue.enqueueCopyBuffer(octree->d_vertexNormals, octree->d_leafNormals, 0, 0, sizeof(cl_float4) * numNodes));
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
 int ConstructOctreeFromField(
 	MeshGenerationContext* meshGen,
 	const glm::ivec3& min,
@@ -44,95 +369,75 @@ int ConstructOctreeFromField(
 	}
 
 	auto ctx = GetComputeContext();
+	const cl_float4 d_worldSpaceOffset = { min.x, min.y, min.z, 0 };
+	const int sampleScale = field.size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
+	const bool surfaceNets = UseSurfaceNets(field.size);
 
-	const int chunkBufferSize = meshGen->voxelsPerChunk * meshGen->voxelsPerChunk * meshGen->voxelsPerChunk;
-	cl::Buffer d_leafOccupancy(ctx->context, CL_MEM_READ_WRITE, chunkBufferSize * sizeof(int));
-	cl::Buffer d_leafEdgeInfo(ctx->context, CL_MEM_READ_WRITE, chunkBufferSize * sizeof(int));
-	cl::Buffer d_leafCodes(ctx->context, CL_MEM_READ_WRITE, chunkBufferSize * sizeof(int));
-	cl::Buffer d_leafMaterials(ctx->context, CL_MEM_READ_WRITE, chunkBufferSize * sizeof(cl_int));
-	cl::Buffer d_voxelScan(ctx->context, CL_MEM_READ_WRITE, chunkBufferSize * sizeof(int));
+	LeafNodeBuffers leafs;
 	{
-		rmt_ScopedCPUSample(Find);
+		rmt_ScopedCPUSample(Leafs);
 
-		int index = 0;
-		cl::Kernel findActiveKernel(meshGen->octreeProgram.get(), "FindActiveVoxels");
-		CL_CALL(findActiveKernel.setArg(index++, field.materials));
-		CL_CALL(findActiveKernel.setArg(index++, d_leafOccupancy));
-		CL_CALL(findActiveKernel.setArg(index++, d_leafEdgeInfo));
-		CL_CALL(findActiveKernel.setArg(index++, d_leafCodes));
-		CL_CALL(findActiveKernel.setArg(index++, d_leafMaterials));
-		CL_CALL(ctx->queue.enqueueNDRangeKernel(findActiveKernel, cl::NullRange, 
-			cl::NDRange(meshGen->voxelsPerChunk, meshGen->voxelsPerChunk, meshGen->voxelsPerChunk), cl::NullRange));
-
-		octree->numNodes = ExclusiveScan(ctx->queue, d_leafOccupancy, d_voxelScan, chunkBufferSize);
+		if (surfaceNets)
+		{
+			CL_CALL(PrepareSurfaceNetsLeafNodes(meshGen, field, d_worldSpaceOffset, &leafs));
+		}
+		else
+		{
+			CL_CALL(PrepareLeafNodes(meshGen, field, &leafs));
+		}
+
+		// the kernels have the same structure so share the tuned work-group size
+		cl::Kernel& createLeafNodes = surfaceNets ? meshGen->kernels.createSurfaceNetsLeafNodes : meshGen->kernels.createLeafNodes;
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(createLeafNodes, cl::NullRange, 
+			cl::NDRange(meshGen->voxelsPerChunk, meshGen->voxelsPerChunk, meshGen->voxelsPerChunk),
+			meshGen->kernels.createLeafNodesLocal));
+
+		// the node count is needed on the host to size the cached octree and the cuckoo
+		// table, this read replaces the one the scan of the occupancy did (it isn't an
+		// extra sync, but it isn't one less either)
+		CL_CALL(ctx->queue.enqueueReadBuffer(leafs.count, CL_TRUE, 0, sizeof(int), &octree->numNodes));
 		if (octree->numNodes <= 0)
 		{
-			// i.e. an error if < 0, == 0 is ok just no surface for this chunk
 			timer.printElapsed("no voxels");
-			const int error = octree->numNodes;
 			octree->numNodes = 0;
-			return error;
+			return CL_SUCCESS;
+		}
+
+		if (octree->numNodes > leafs.capacity)
+		{
+			printf("ConstructOctreeFromField: leaf capacity exceeded (%d > %d)\n", octree->numNodes, leafs.capacity);
+			octree->numNodes = 0;
+			return LVN_CL_ERROR;
 		}
 	}
 
-	cl::Buffer d_compactLeafEdgeInfo(ctx->context, CL_MEM_READ_WRITE, octree->numNodes * sizeof(int));
 	{
 		rmt_ScopedCPUSample(Compact);
 
-		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree->numNodes, nullptr, octree->d_nodeCodes));
+		// the octree is cached so copy out exactly sized buffers rather than holding the spare capacity
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_ulong) * octree->numNodes, nullptr, octree->d_nodeCodes));
 		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree->numNodes, nullptr, octree->d_nodeMaterials));
-
 		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * octree->numNodes, nullptr, octree->d_vertexPositions));
 		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * octree->numNodes, nullptr, octree->d_vertexNormals));
 
-		int index = 0;
-		cl::Kernel compactVoxelsKernel(meshGen->octreeProgram.get(), "CompactVoxels");
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_leafOccupancy));
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_leafEdgeInfo));
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_leafCodes));
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_leafMaterials));
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_voxelScan));
-		CL_CALL(compactVoxelsKernel.setArg(index++, octree->d_nodeCodes));
-		CL_CALL(compactVoxelsKernel.setArg(index++, d_compactLeafEdgeInfo));
-		CL_CALL(compactVoxelsKernel.setArg(index++, octree->d_nodeMaterials));
-		CL_CALL(ctx->queue.enqueueNDRangeKernel(compactVoxelsKernel, cl::NullRange, chunkBufferSize, cl::NullRange));
-	}
-
-	cl::Buffer d_qefs;
-	{
-		rmt_ScopedCPUSample(Leafs);
-
-		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(QEFData) * octree->numNodes, nullptr, d_qefs));
+		CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.codes, octree->d_nodeCodes, 0, 0, sizeof(cl_ulong) * octree->numNodes));
+		CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.materials, octree->d_nodeMaterials, 0, 0, sizeof(cl_int) * octree->numNodes));
+		CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.normals, octree->d_vertexNormals, 0, 0, sizeof(cl_float4) * octree->numNodes));
 
-		CuckooData edgeHashTable;
-		CL_CALL(Cuckoo_InitialiseTable(&edgeHashTable, field.numEdges));
-		CL_CALL(Cuckoo_InsertKeys(&edgeHashTable, field.edgeIndices, field.numEdges));
-
-		int index = 0;
-		const int sampleScale = field.size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
-		cl::Kernel createLeafNodes(meshGen->octreeProgram.get(), "CreateLeafNodes");
-		CL_CALL(createLeafNodes.setArg(index++, sampleScale));
-		CL_CALL(createLeafNodes.setArg(index++, octree->d_nodeCodes));
-		CL_CALL(createLeafNodes.setArg(index++, d_compactLeafEdgeInfo));
-		CL_CALL(createLeafNodes.setArg(index++, field.normals));
-		CL_CALL(createLeafNodes.setArg(index++, octree->d_vertexNormals));
-		CL_CALL(createLeafNodes.setArg(index++, d_qefs));
-		CL_CALL(createLeafNodes.setArg(index++, edgeHashTable.table));
-		CL_CALL(createLeafNodes.setArg(index++, edgeHashTable.stash));
-		CL_CALL(createLeafNodes.setArg(index++, edgeHashTable.prime));
-		CL_CALL(createLeafNodes.setArg(index++, edgeHashTable.hashParams));
-		CL_CALL(createLeafNodes.setArg(index++, edgeHashTable.stashUsed));
-		CL_CALL(ctx->queue.enqueueNDRangeKernel(createLeafNodes, cl::NullRange, octree->numNodes, cl::NullRange));
+		if (surfaceNets)
+		{
+			CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.positions, octree->d_vertexPositions, 0, 0, sizeof(cl_float4) * octree->numNodes));
+		}
 	}
 
+	if (!surfaceNets)
 	{
 		rmt_ScopedCPUSample(QEF);
 
-		cl_float4 d_worldSpaceOffset = { min.x, min.y, min.z, 0 };
-		cl::Kernel solveQEFs(meshGen->octreeProgram.get(), "SolveQEFs");
+		cl::Kernel& solveQEFs = meshGen->kernels.solveQEFs;
 		int index = 0;
 		CL_CALL(solveQEFs.setArg(index++, d_worldSpaceOffset));
-		CL_CALL(solveQEFs.setArg(index++, d_qefs));
+		CL_CALL(solveQEFs.setArg(index++, leafs.qefs));
 		CL_CALL(solveQEFs.setArg(index++, octree->d_vertexPositions));
 		CL_CALL(ctx->queue.enqueueNDRangeKernel(solveQEFs, cl::NullRange, octree->numNodes, cl::NullRange));
 	}
@@ -144,6 +449,17 @@ int ConstructOctreeFromField(
 		CL_CALL(Cuckoo_InsertKeys(&octree->d_hashTable, octree->d_nodeCodes, octree->numNodes));
 	}
 
+	// the surface nets leafs have no QEFs to merge
+	const float maxCollapseError = surfaceNets ? 0.f : g_collapseMaxError;
+	if (maxCollapseError > 0.f && field.edited)
+	{
+		CL_CALL(KeepLeafData(leafs.qefs, octree));
+	}
+
+	{
+		rmt_ScopedCPUSample(Collapse);
+		CL_CALL(CollapseClusters(meshGen, d_worldSpaceOffset, sampleScale, maxCollapseError, leafs.qefs, octree));
+	}
 
 	timer.printElapsed("done");
 	return CL_SUCCESS;
@@ -151,17 +467,67 @@ int ConstructOctreeFromField(
 
 // ----------------------------------------------------------------------------
 
+static int StoreOctree(MeshGenerationContext* meshGen, const ivec3& min, const int clipmapNodeSize, const GPUOctree& octree)
+{
+	const ivec4 key(min, clipmapNodeSize);
+	GPUOctree& cachedOctree = meshGen->octreeCache[key];
+	cachedOctree = octree;
+	cachedOctree.lastUsed = ++meshGen->cacheTick;
+
+	if (meshGen->octreeCache.size() > MAX_CACHED_OCTREES)
+	{
+		auto lruIter = begin(meshGen->octreeCache);
+		for (auto iter = begin(meshGen->octreeCache); iter != end(meshGen->octreeCache); ++iter)
+		{
+			if (iter->second.lastUsed < lruIter->second.lastUsed)
+			{
+				lruIter = iter;
+			}
+		}
+
+		// a coarse octree waiting on its deferred ops would only be discarded when it was 
+		// unspilled, so drop it rather than paying for the readback
+		const ivec4& lruKey = lruIter->first;
+		if (!HasPendingCSGOperations(ivec3(lruKey), lruKey.w, lruIter->second.lastCSGOperation))
+		{
+			CL_CALL(Spill_StoreOctree(meshGen, ivec3(lruKey), lruKey.w, lruIter->second));
+		}
+
+		meshGen->octreeCache.erase(lruIter);
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
 int LoadOctree(MeshGenerationContext* meshGen, const ivec3& min, const int clipmapNodeSize, GPUOctree* octree)
 {
 	rmt_ScopedCPUSample(LoadOctree);
 	const ivec4 key(min, clipmapNodeSize);
 	auto iter = meshGen->octreeCache.find(key);
+	if (iter != end(meshGen->octreeCache) &&
+		HasPendingCSGOperations(min, clipmapNodeSize, iter->second.lastCSGOperation))
+	{
+		// the ops applied lazily (i.e. to the coarse LODs) are picked up by LoadDensityField
+		meshGen->octreeCache.erase(iter);
+		iter = end(meshGen->octreeCache);
+	}
+
 	if (iter != end(meshGen->octreeCache))
 	{
+		iter->second.lastUsed = ++meshGen->cacheTick;
 		*octree = iter->second;
 		return CL_SUCCESS;
 	}
 
+	bool loaded = false;
+	CL_CALL(Spill_LoadOctree(meshGen, min, clipmapNodeSize, octree, loaded));
+	if (loaded)
+	{
+		return StoreOctree(meshGen, min, clipmapNodeSize, *octree);
+	}
+
 	GPUDensityField field;
 	CL_CALL(LoadDensityField(meshGen, min, clipmapNodeSize, &field));
 	if (field.numEdges == 0)
@@ -172,11 +538,248 @@ int LoadOctree(MeshGenerationContext* meshGen, const ivec3& min, const int clipm
 	else	
 	{
 		CL_CALL(ConstructOctreeFromField(meshGen, min, field, octree));
-		meshGen->octreeCache[key] = *octree;
+		octree->lastCSGOperation = field.lastCSGOperation;
+		CL_CALL(StoreOctree(meshGen, min, clipmapNodeSize, *octree));
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+// Rather than reconstructing the whole octree after each edit only the leafs of the 
+// voxels touched by the edited edges are recreated (and their QEFs solved), the other
+// nodes are compacted and the new leafs appended. The cuckoo table is rebuilt as the
+// node indices change and the collapse (when enabled) is rerun since the clusters 
+// depend on the neighbouring leafs, but both only touch the surface nodes and the
+// collapse cells rather than rescanning every voxel.
+// ----------------------------------------------------------------------------
+int PatchOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int clipmapNodeSize,
+	const GPUDensityField& field,
+	const cl::Buffer& editedEdges,
+	const unsigned int numEditedEdges,
+	bool& patched)
+{
+	rmt_ScopedCPUSample(PatchOctree);
+	patched = false;
+
+	const auto iter = meshGen->octreeCache.find(ivec4(min, clipmapNodeSize));
+	if (iter == end(meshGen->octreeCache) || field.numEdges == 0)
+	{
+		return CL_SUCCESS;
+	}
+
+	GPUOctree& octree = iter->second;
+	const bool surfaceNets = UseSurfaceNets(clipmapNodeSize);
+	const float maxCollapseError = surfaceNets ? 0.f : g_collapseMaxError;
+	if (octree.numNodes <= 0 || (maxCollapseError > 0.f && !octree.d_leafQEFs()))
+	{
+		// e.g. constructed before the chunk was first edited, the rebuild will keep the leaf data
+		return CL_SUCCESS;
 	}
 
-//	printf("%d octrees cached\n", meshGen->octreeCache.size());
+	if (numEditedEdges == 0)
+	{
+		octree.lastCSGOperation = field.lastCSGOperation;
+		patched = true;
+		return CL_SUCCESS;
+	}
+
+	auto ctx = GetComputeContext();
+	MeshGenKernels& k = meshGen->kernels;
+	const cl_float4 d_worldSpaceOffset = { min.x, min.y, min.z, 0 };
+	const int sampleScale = field.size / (meshGen->voxelsPerChunk * LEAF_SIZE_SCALE);
+
+	cl::Buffer d_editedVoxels;
+	unsigned int numEditedVoxels = 0;
+	{
+		rmt_ScopedCPUSample(FindVoxels);
+
+		const int numCandidates = numEditedEdges * 4;
+		cl::Buffer d_candidates, d_candidatesValid, d_compactCandidates;
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numCandidates, nullptr, d_candidates));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numCandidates, nullptr, d_candidatesValid));
+
+		CL_CALL(k.findEditedVoxels.setArg(0, editedEdges));
+		CL_CALL(k.findEditedVoxels.setArg(1, d_candidates));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k.findEditedVoxels, cl::NullRange, numEditedEdges, cl::NullRange));
+
+		// the voxels outside the chunk are written as -1, same as the CSG edges
+		CL_CALL(k.csgRemoveInvalidIndices.setArg(0, d_candidates));
+		CL_CALL(k.csgRemoveInvalidIndices.setArg(1, d_candidatesValid));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k.csgRemoveInvalidIndices, cl::NullRange, numCandidates, cl::NullRange));
+
+		const int numCompactCandidates = CompactIndexArray(ctx->queue, d_candidates, 
+			d_candidatesValid, numCandidates, d_compactCandidates);
+		if (numCompactCandidates < 0)
+		{
+			return numCompactCandidates;
+		}
+
+		if (numCompactCandidates > 0)
+		{
+			d_editedVoxels = RemoveDuplicates(ctx->queue, d_compactCandidates, numCompactCandidates, &numEditedVoxels);
+		}
+	}
+
+	if (numEditedVoxels == 0)
+	{
+		octree.lastCSGOperation = field.lastCSGOperation;
+		patched = true;
+		return CL_SUCCESS;
+	}
+
+	cl::Buffer d_nodeValid, d_nodeScan;
+	int numKeptNodes = 0;
+	{
+		rmt_ScopedCPUSample(Remove);
+
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree.numNodes, nullptr, d_nodeValid));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree.numNodes, nullptr, d_nodeScan));
+		CL_CALL(FillBufferInt(ctx->queue, d_nodeValid, octree.numNodes, 1));
+
+		int index = 0;
+		CL_CALL(k.removeEditedNodes.setArg(index++, d_editedVoxels));
+		CL_CALL(k.removeEditedNodes.setArg(index++, octree.d_hashTable.table));
+		CL_CALL(k.removeEditedNodes.setArg(index++, octree.d_hashTable.stash));
+		CL_CALL(k.removeEditedNodes.setArg(index++, octree.d_hashTable.prime));
+		CL_CALL(k.removeEditedNodes.setArg(index++, octree.d_hashTable.hashParams));
+		CL_CALL(k.removeEditedNodes.setArg(index++, octree.d_hashTable.stashUsed));
+		CL_CALL(k.removeEditedNodes.setArg(index++, d_nodeValid));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k.removeEditedNodes, cl::NullRange, numEditedVoxels, cl::NullRange));
+
+		numKeptNodes = ExclusiveScan(ctx->queue, d_nodeValid, d_nodeScan, octree.numNodes);
+		if (numKeptNodes < 0)
+		{
+			return numKeptNodes;
+		}
+	}
+
+	// each edited voxel creates at most one leaf so the capacity can't be exceeded
+	LeafNodeBuffers leafs;
+	int numNewNodes = 0;
+	{
+		rmt_ScopedCPUSample(Leafs);
+
+		cl::Kernel& createLeafNodes = surfaceNets ? k.createSurfaceNetsLeafNodesForVoxels : k.createLeafNodesForVoxels;
+		if (surfaceNets)
+		{
+			CL_CALL(PrepareSurfaceNetsLeafNodesForKernel(meshGen, field, d_worldSpaceOffset, numEditedVoxels, 
+				createLeafNodes, &leafs));
+		}
+		else
+		{
+			CL_CALL(PrepareLeafNodesForKernel(meshGen, field, numEditedVoxels, createLeafNodes, &leafs));
+			CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * leafs.capacity, nullptr, leafs.positions));
+		}
+
+		// the voxel list is always the last arg
+		const cl_uint voxelsArg = createLeafNodes.getInfo<CL_KERNEL_NUM_ARGS>() - 1;
+		CL_CALL(createLeafNodes.setArg(voxelsArg, d_editedVoxels));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(createLeafNodes, cl::NullRange, numEditedVoxels, cl::NullRange));
+		CL_CALL(ctx->queue.enqueueReadBuffer(leafs.count, CL_TRUE, 0, sizeof(int), &numNewNodes));
+
+		if (!surfaceNets && numNewNodes > 0)
+		{
+			int index = 0;
+			CL_CALL(k.solveQEFs.setArg(index++, d_worldSpaceOffset));
+			CL_CALL(k.solveQEFs.setArg(index++, leafs.qefs));
+			CL_CALL(k.solveQEFs.setArg(index++, leafs.positions));
+			CL_CALL(ctx->queue.enqueueNDRangeKernel(k.solveQEFs, cl::NullRange, numNewNodes, cl::NullRange));
+		}
+	}
 
+	const int numNodes = numKeptNodes + numNewNodes;
+	if (numNodes == 0)
+	{
+		// nothing left to patch, let LoadOctree handle the empty chunk
+		return CL_SUCCESS;
+	}
+
+	GPUOctree patchedOctree;
+	patchedOctree.numNodes = numNodes;
+	patchedOctree.lastCSGOperation = field.lastCSGOperation;
+	patchedOctree.lastUsed = ++meshGen->cacheTick;
+	{
+		rmt_ScopedCPUSample(Compact);
+
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_ulong) * numNodes, nullptr, patchedOctree.d_nodeCodes));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numNodes, nullptr, patchedOctree.d_nodeMaterials));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numNodes, nullptr, patchedOctree.d_vertexPositions));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_float4) * numNodes, nullptr, patchedOctree.d_vertexNormals));
+
+		// the collapsed octrees hold the leaf vertices separately
+		const bool collapsed = maxCollapseError > 0.f;
+		if (numKeptNodes > 0)
+		{
+			int index = 0;
+			CL_CALL(k.compactOctreeNodes.setArg(index++, d_nodeValid));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, d_nodeScan));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, octree.d_nodeCodes));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, octree.d_nodeMaterials));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, collapsed ? octree.d_leafPositions : octree.d_vertexPositions));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, collapsed ? octree.d_leafNormals : octree.d_vertexNormals));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, patchedOctree.d_nodeCodes));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, patchedOctree.d_nodeMaterials));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, patchedOctree.d_vertexPositions));
+			CL_CALL(k.compactOctreeNodes.setArg(index++, patchedOctree.d_vertexNormals));
+			CL_CALL(ctx->queue.enqueueNDRangeKernel(k.compactOctreeNodes, cl::NullRange, octree.numNodes, cl::NullRange));
+		}
+
+		if (numNewNodes > 0)
+		{
+			CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.codes, patchedOctree.d_nodeCodes, 
+				0, sizeof(cl_ulong) * numKeptNodes, sizeof(cl_ulong) * numNewNodes));
+			CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.materials, patchedOctree.d_nodeMaterials, 
+				0, sizeof(cl_int) * numKeptNodes, sizeof(cl_int) * numNewNodes));
+			CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.positions, patchedOctree.d_vertexPositions, 
+				0, sizeof(cl_float4) * numKeptNodes, sizeof(cl_float4) * numNewNodes));
+			CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.normals, patchedOctree.d_vertexNormals, 
+				0, sizeof(cl_float4) * numKeptNodes, sizeof(cl_float4) * numNewNodes));
+		}
+
+		if (collapsed)
+		{
+			cl::Buffer d_qefs;
+			CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(QEFData) * numNodes, nullptr, d_qefs));
+
+			if (numKeptNodes > 0)
+			{
+				int index = 0;
+				CL_CALL(k.compactNodeQEFs.setArg(index++, d_nodeValid));
+				CL_CALL(k.compactNodeQEFs.setArg(index++, d_nodeScan));
+				CL_CALL(k.compactNodeQEFs.setArg(index++, octree.d_leafQEFs));
+				CL_CALL(k.compactNodeQEFs.setArg(index++, d_qefs));
+				CL_CALL(ctx->queue.enqueueNDRangeKernel(k.compactNodeQEFs, cl::NullRange, octree.numNodes, cl::NullRange));
+			}
+
+			if (numNewNodes > 0)
+			{
+				CL_CALL(ctx->queue.enqueueCopyBuffer(leafs.qefs, d_qefs, 
+					0, sizeof(QEFData) * numKeptNodes, sizeof(QEFData) * numNewNodes));
+			}
+
+			CL_CALL(KeepLeafData(d_qefs, &patchedOctree));
+		}
+	}
+
+	{
+		rmt_ScopedCPUSample(Cuckoo);
+
+		CL_CALL(Cuckoo_InitialiseTable(&patchedOctree.d_hashTable, numNodes));
+		CL_CALL(Cuckoo_InsertKeys(&patchedOctree.d_hashTable, patchedOctree.d_nodeCodes, numNodes));
+	}
+
+	{
+		rmt_ScopedCPUSample(Collapse);
+		CL_CALL(CollapseClusters(meshGen, d_worldSpaceOffset, sampleScale, maxCollapseError, 
+			patchedOctree.d_leafQEFs, &patchedOctree));
+	}
+
+	octree = patchedOctree;
+	patched = true;
 	return CL_SUCCESS;
 }
 
@@ -191,6 +794,8 @@ int GenerateMeshFromOctree(
 	const glm::ivec3& min,
 	const int clipmapNodeSize,
 	const GPUOctree& octree,
+	const u64 regionMask,
+	const bool findRegions,
 	MeshBufferGPU* meshBuffer)
 {
 	rmt_ScopedCPUSample(GenerateMeshFromOctree);
@@ -202,17 +807,19 @@ int GenerateMeshFromOctree(
 	timer.start();
 	timer.disable();
 
-	const int numVertices = octree.numNodes;
-	const int indexBufferSize = numVertices * 6 * 3;
-	const int trianglesValidSize = numVertices * 3;
+	// each node can generate 2 triangles for each of the 3 axes
+	const int numVertices = octree.numVertices;
+	const int trianglesValidSize = octree.numNodes * 6;
+	const int indexBufferSize = trianglesValidSize * 3;
 	cl::Buffer d_indexBuffer, d_trianglesValid;
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * indexBufferSize, nullptr, d_indexBuffer));
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize, nullptr, d_trianglesValid));
 
 	index = 0;
-	cl::Kernel k_GenerateMesh(meshGen->octreeProgram.get(), "GenerateMesh");
+	cl::Kernel& k_GenerateMesh = meshGen->kernels.generateMesh;
 	CL_CALL(k_GenerateMesh.setArg(index++, octree.d_nodeCodes));
 	CL_CALL(k_GenerateMesh.setArg(index++, octree.d_nodeMaterials));
+	CL_CALL(k_GenerateMesh.setArg(index++, octree.d_nodeVertices));
 	CL_CALL(k_GenerateMesh.setArg(index++, d_indexBuffer));
 	CL_CALL(k_GenerateMesh.setArg(index++, d_trianglesValid));
 	CL_CALL(k_GenerateMesh.setArg(index++, octree.d_hashTable.table));
@@ -222,6 +829,21 @@ int GenerateMeshFromOctree(
 	CL_CALL(k_GenerateMesh.setArg(index++, octree.d_hashTable.stashUsed));
 	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_GenerateMesh, cl::NullRange, octree.numNodes, cl::NullRange));
 
+	cl::Buffer d_triangleRegions;
+	if (findRegions)
+	{
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize, nullptr, d_triangleRegions));
+
+		index = 0;
+		const cl_ulong d_regionMask = regionMask;
+		cl::Kernel& k_SelectMeshRegions = meshGen->kernels.selectMeshRegions;
+		CL_CALL(k_SelectMeshRegions.setArg(index++, d_regionMask));
+		CL_CALL(k_SelectMeshRegions.setArg(index++, octree.d_nodeCodes));
+		CL_CALL(k_SelectMeshRegions.setArg(index++, d_trianglesValid));
+		CL_CALL(k_SelectMeshRegions.setArg(index++, d_triangleRegions));
+		CL_CALL(ctx->queue.enqueueNDRangeKernel(k_SelectMeshRegions, cl::NullRange, trianglesValidSize, cl::NullRange));
+	}
+
 	cl::Buffer d_trianglesScan;
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize, nullptr, d_trianglesScan));
 	int numTriangles = ExclusiveScan(ctx->queue, d_trianglesValid, d_trianglesScan, trianglesValidSize); 
@@ -231,39 +853,57 @@ int GenerateMeshFromOctree(
 		return numTriangles;
 	}
 
-	numTriangles *= 2;
-	LVN_ALWAYS_ASSERT("Mesh triangle count too high", numTriangles < MAX_MESH_TRIANGLES);
-	LVN_ALWAYS_ASSERT("Mesh vertex count too high", numVertices < MAX_MESH_VERTICES);
-
 	cl::Buffer d_compactIndexBuffer;
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numTriangles * 3, nullptr, d_compactIndexBuffer));
 
 	index = 0;
-	cl::Kernel k_CompactMeshTriangles(meshGen->octreeProgram.get(), "CompactMeshTriangles");
+	cl::Kernel& k_CompactMeshTriangles = meshGen->kernels.compactMeshTriangles;
 	CL_CALL(k_CompactMeshTriangles.setArg(index++, d_trianglesValid));
 	CL_CALL(k_CompactMeshTriangles.setArg(index++, d_trianglesScan));
 	CL_CALL(k_CompactMeshTriangles.setArg(index++, d_indexBuffer));
 	CL_CALL(k_CompactMeshTriangles.setArg(index++, d_compactIndexBuffer));
 	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_CompactMeshTriangles, cl::NullRange, trianglesValidSize, cl::NullRange));
 
+	if (findRegions)
+	{
+		const int numRegionTriangles = CompactIndexArray(ctx->queue, d_triangleRegions, d_trianglesValid, 
+			trianglesValidSize, meshBuffer->triangleRegions);
+		if (numRegionTriangles != numTriangles)
+		{
+			return numRegionTriangles < 0 ? numRegionTriangles : LVN_CL_ERROR;
+		}
+	}
+
 	cl::Buffer d_vertexBuffer;
-	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(MeshVertex) * numVertices, nullptr, d_vertexBuffer));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(PackedMeshVertex) * numVertices, nullptr, d_vertexBuffer));
+
+	// the vertices are quantised across the node and half a node either side as the 
+	// QEF solutions can lie (slightly) outside the node
+	const glm::vec3 nodeMin(min);
+	const float nodeSize = (float)clipmapNodeSize;
+	const PackedMeshBounds bounds(nodeMin - (nodeSize * 0.5f), nodeMin + (nodeSize * 1.5f));
 
 	index = 0;
 	const auto colour = ColourForMinLeafSize(clipmapNodeSize / CLIPMAP_LEAF_SIZE);
 	cl_float4 d_colour = { colour.x, colour.y, colour.z, 0.f };
-	cl::Kernel k_GenerateMeshVertexBuffer(meshGen->octreeProgram.get(), "GenerateMeshVertexBuffer");
+	cl_float4 d_boundsOrigin = { bounds.origin.x, bounds.origin.y, bounds.origin.z, 0.f };
+	cl_float4 d_boundsScale = { bounds.scale.x, bounds.scale.y, bounds.scale.z, 1.f };
+	cl::Kernel& k_GenerateMeshVertexBuffer = meshGen->kernels.generateMeshVertexBuffer;
 	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, octree.d_vertexPositions));
 	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, octree.d_vertexNormals));
 	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, octree.d_nodeMaterials));
+	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, octree.d_nodeVertices));
 	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, d_colour));
+	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, d_boundsOrigin));
+	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, d_boundsScale));
 	CL_CALL(k_GenerateMeshVertexBuffer.setArg(index++, d_vertexBuffer));
-	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_GenerateMeshVertexBuffer, cl::NullRange, numVertices, cl::NullRange));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_GenerateMeshVertexBuffer, cl::NullRange, octree.numNodes, cl::NullRange));
 
 	meshBuffer->vertices = d_vertexBuffer;
 	meshBuffer->countVertices = numVertices;
 	meshBuffer->triangles = d_compactIndexBuffer;
 	meshBuffer->countTriangles = numTriangles;
+	meshBuffer->bounds = bounds;
 
 	timer.printElapsed("generated mesh");
 
@@ -274,37 +914,38 @@ int GenerateMeshFromOctree(
 
 int GatherSeamNodesFromOctree(
 	MeshGenerationContext* meshGen,
-	const glm::ivec3& nodeMin, 
+	const glm::ivec3& nodeMin,
 	const int nodeSize,
 	const GPUOctree& octree,
-	std::vector<SeamNodeInfo>& seamNodeBuffer)
+	cl::Buffer& d_seamNodeInfo,
+	int& numSeamNodes)
 {
 	rmt_ScopedCPUSample(GatherSeamNodes);
 	auto ctx = GetComputeContext();
+	numSeamNodes = 0;
 
 	cl::Buffer d_isSeamNode, d_isSeamNodeScan;
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree.numNodes, nullptr, d_isSeamNode));
 	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * octree.numNodes, nullptr, d_isSeamNodeScan));
 
 	int index = 0;
-	cl::Kernel k_FindSeamNodes(meshGen->octreeProgram.get(), "FindSeamNodes");
+	cl::Kernel& k_FindSeamNodes = meshGen->kernels.findSeamNodes;
 	CL_CALL(k_FindSeamNodes.setArg(index++, octree.d_nodeCodes));
 	CL_CALL(k_FindSeamNodes.setArg(index++, d_isSeamNode));
 	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_FindSeamNodes, cl::NullRange, octree.numNodes, cl::NullRange));
 
-	const int numSeamNodes = ExclusiveScan(ctx->queue, d_isSeamNode, d_isSeamNodeScan, octree.numNodes);
-	if (numSeamNodes <= 0)
+	const int count = ExclusiveScan(ctx->queue, d_isSeamNode, d_isSeamNodeScan, octree.numNodes);
+	if (count <= 0)
 	{
-		return numSeamNodes;
+		return count;
 	}
 
-	cl::Buffer d_seamNodeInfo;
-	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(SeamNodeInfo) * numSeamNodes, nullptr, d_seamNodeInfo));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(SeamNodeInfo) * count, nullptr, d_seamNodeInfo));
 
 	cl_int4 d_min = { nodeMin.x, nodeMin.y, nodeMin.z, 0 };
 
 	index = 0;
-	cl::Kernel k_ExtractSeamNodeInfo(meshGen->octreeProgram.get(), "ExtractSeamNodeInfo");
+	cl::Kernel& k_ExtractSeamNodeInfo = meshGen->kernels.extractSeamNodeInfo;
 	CL_CALL(k_ExtractSeamNodeInfo.setArg(index++, d_isSeamNode));
 	CL_CALL(k_ExtractSeamNodeInfo.setArg(index++, d_isSeamNodeScan));
 	CL_CALL(k_ExtractSeamNodeInfo.setArg(index++, octree.d_nodeCodes));
@@ -314,64 +955,150 @@ int GatherSeamNodesFromOctree(
 	CL_CALL(k_ExtractSeamNodeInfo.setArg(index++, d_seamNodeInfo));
 	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_ExtractSeamNodeInfo, cl::NullRange, octree.numNodes, cl::NullRange));
 
-	seamNodeBuffer.resize(numSeamNodes);
-	CL_CALL(ctx->queue.enqueueReadBuffer(d_seamNodeInfo, CL_TRUE, 
-		0, sizeof(SeamNodeInfo) * numSeamNodes, &seamNodeBuffer[0]));
-
+	numSeamNodes = count;
 	return CL_SUCCESS;
 }
 
 // ----------------------------------------------------------------------------
-
-int ExportMeshBuffer(
+// Rather than a blocking read per buffer into pageable memory the mesh, the
+// triangle regions and the seam nodes are copied into the context's pinned staging
+// buffer and mapped once. The consumer reads them straight from the mapping so
+// nothing is copied on the host unless the consumer needs to keep the data.
+// ----------------------------------------------------------------------------
+static int ReadbackChunkMesh(
+	MeshGenerationContext* meshGen,
 	const MeshBufferGPU& gpuBuffer,
-	MeshBuffer* cpuBuffer)
+	const cl::Buffer& d_seamNodeInfo,
+	const int numSeamNodes,
+	const bool readRegions,
+	const ChunkMeshConsumer& consumer)
 {
-	rmt_ScopedCPUSample(ExportMesh);
-	cpuBuffer->numVertices = gpuBuffer.countVertices;
-	cpuBuffer->numTriangles = gpuBuffer.countTriangles;
-
-	if (gpuBuffer.countVertices == 0)
+	rmt_ScopedCPUSample(ReadbackChunkMesh);
+
+	const size_t verticesSize = sizeof(PackedMeshVertex) * gpuBuffer.countVertices;
+	const size_t trianglesSize = sizeof(MeshTriangle) * gpuBuffer.countTriangles;
+	const size_t regionsSize = readRegions ? sizeof(cl_int) * gpuBuffer.countTriangles : 0;
+	const size_t seamNodesSize = sizeof(SeamNodeInfo) * numSeamNodes;
+
+	// SeamNodeInfo holds float4s so keep each section 16 byte aligned
+	const auto align = [](const size_t offset) { return (offset + 15) & ~(size_t)15; };
+	const size_t verticesOffset = 0;
+	const size_t trianglesOffset = align(verticesOffset + verticesSize);
+	const size_t regionsOffset = align(trianglesOffset + trianglesSize);
+	const size_t seamNodesOffset = align(regionsOffset + regionsSize);
+	const size_t stagingSize = seamNodesOffset + seamNodesSize;
+	if (stagingSize == 0)
 	{
+		consumer(ChunkMeshData());
 		return CL_SUCCESS;
 	}
-	
+
 	auto ctx = GetComputeContext();
+	if (stagingSize > meshGen->readbackStagingSize)
+	{
+		// grow with some headroom as the chunks' sizes vary a lot
+		const size_t size = align(stagingSize + (stagingSize / 2));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size, nullptr, meshGen->d_readbackStaging));
+		meshGen->readbackStagingSize = size;
+	}
+
+	cl::Buffer& d_staging = meshGen->d_readbackStaging;
+	if (verticesSize > 0)
+	{
+		CL_CALL(ctx->queue.enqueueCopyBuffer(gpuBuffer.vertices, d_staging, 0, verticesOffset, verticesSize));
+	}
+
+	if (trianglesSize > 0)
+	{
+		CL_CALL(ctx->queue.enqueueCopyBuffer(gpuBuffer.triangles, d_staging, 0, trianglesOffset, trianglesSize));
+	}
+
+	if (regionsSize > 0)
+	{
+		CL_CALL(ctx->queue.enqueueCopyBuffer(gpuBuffer.triangleRegions, d_staging, 0, regionsOffset, regionsSize));
+	}
 
-	CL_CALL(ctx->queue.enqueueReadBuffer(gpuBuffer.vertices, CL_FALSE, 
-		0, sizeof(MeshVertex) * gpuBuffer.countVertices, &cpuBuffer->vertices[0]));
-	CL_CALL(ctx->queue.enqueueReadBuffer(gpuBuffer.triangles, CL_TRUE, 
-		0, sizeof(MeshTriangle) * gpuBuffer.countTriangles, &cpuBuffer->triangles[0]));
+	if (seamNodesSize > 0)
+	{
+		CL_CALL(ctx->queue.enqueueCopyBuffer(d_seamNodeInfo, d_staging, 0, seamNodesOffset, seamNodesSize));
+	}
 
+	// the only sync point for the chunk's readback
+	cl_int error = CL_SUCCESS;
+	const char* mapped = (const char*)ctx->queue.enqueueMapBuffer(d_staging, CL_TRUE, CL_MAP_READ,
+		0, stagingSize, nullptr, nullptr, &error);
+	CL_CALL(error);
+
+	// nothing can fail between the map and unmap, so every path unmaps
+	ChunkMeshData data;
+	data.vertices = (const PackedMeshVertex*)(mapped + verticesOffset);
+	data.numVertices = gpuBuffer.countVertices;
+	data.bounds = gpuBuffer.bounds;
+	data.triangles = (const MeshTriangle*)(mapped + trianglesOffset);
+	data.triangleRegions = regionsSize > 0 ? (const int*)(mapped + regionsOffset) : nullptr;
+	data.numTriangles = gpuBuffer.countTriangles;
+	data.seamNodes = (const SeamNodeInfo*)(mapped + seamNodesOffset);
+	data.numSeamNodes = numSeamNodes;
+	consumer(data);
+
+	CL_CALL(ctx->queue.enqueueUnmapMemObject(d_staging, (void*)mapped));
 	return CL_SUCCESS;
 }
 
 // ----------------------------------------------------------------------------
 
+void Compute_UnpackChunkMesh(const ChunkMeshData& data, MeshBuffer* meshBuffer)
+{
+	// the previous contents aren't kept so the resize doesn't copy them
+	meshBuffer->numVertices = 0;
+	meshBuffer->numTriangles = 0;
+	meshBuffer->reserve(data.numVertices, data.numTriangles);
+
+	for (int i = 0; i < data.numVertices; i++)
+	{
+		meshBuffer->vertices[i] = UnpackMeshVertex(data.vertices[i], data.bounds);
+	}
+
+	if (data.numTriangles > 0)
+	{
+		memcpy(meshBuffer->triangles, data.triangles, sizeof(MeshTriangle) * data.numTriangles);
+	}
+
+	meshBuffer->numVertices = data.numVertices;
+	meshBuffer->numTriangles = data.numTriangles;
+}
+
+// ----------------------------------------------------------------------------
+
 int Compute_GenerateChunkMesh(
 	MeshGenerationContext* meshGen,
 	const glm::ivec3& min,
 	const int clipmapNodeSize,
-	MeshBuffer* meshBuffer,
-	std::vector<SeamNodeInfo>& seamNodeBuffer)
+	const u64 regionMask,
+	const bool readRegions,
+	const ChunkMeshConsumer& consumer)
 {
 	rmt_ScopedCPUSample(Compute_GenerateChunkMesh);
-	seamNodeBuffer.clear();
 
 	GPUOctree octree;
 	CL_CALL(LoadOctree(meshGen, min, clipmapNodeSize, &octree));
 
-	if (octree.numNodes > 0)
+	if (octree.numNodes == 0)
 	{
-		MeshBufferGPU meshBufferGPU;
-		CL_CALL(GenerateMeshFromOctree(meshGen, min, clipmapNodeSize, octree, &meshBufferGPU));
-		CL_CALL(ExportMeshBuffer(meshBufferGPU, meshBuffer));
-
-		// TODO can do this on creation now 
-		CL_CALL(GatherSeamNodesFromOctree(meshGen, min, clipmapNodeSize, octree, seamNodeBuffer));
+		consumer(ChunkMeshData());
+		return CL_SUCCESS;
 	}
 
-	return CL_SUCCESS;
+	MeshBufferGPU meshBufferGPU;
+	CL_CALL(GenerateMeshFromOctree(meshGen, min, clipmapNodeSize, octree, 
+		regionMask, readRegions, &meshBufferGPU));
+
+	// TODO can do this on creation now 
+	cl::Buffer d_seamNodeInfo;
+	int numSeamNodes = 0;
+	CL_CALL(GatherSeamNodesFromOctree(meshGen, min, clipmapNodeSize, octree, d_seamNodeInfo, numSeamNodes));
+
+	return ReadbackChunkMesh(meshGen, meshBufferGPU, d_seamNodeInfo, numSeamNodes, readRegions, consumer);
 }
 
 // ----------------------------------------------------------------------------
@@ -382,7 +1109,14 @@ int Compute_FreeChunkOctree(
 	const int clipmapNodeSize)
 {
 	const glm::ivec4 key(min, clipmapNodeSize);
-	meshGen->octreeCache.erase(key);
+	const auto iter = meshGen->octreeCache.find(key);
+	if (iter != end(meshGen->octreeCache))
+	{
+		// keep the octree in the spill tier in case the node is selected again
+		CL_CALL(Spill_StoreOctree(meshGen, min, clipmapNodeSize, iter->second));
+		meshGen->octreeCache.erase(iter);
+	}
+
 	return CL_SUCCESS;
 }
 
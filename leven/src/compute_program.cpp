@@ -4,48 +4,176 @@
 #include	"compute_local.h"
 #include	"file_utils.h"
 
+#include	<Remotery.h>
 #include	<chrono>
 #include	<ctime>
+#include	<map>
+#include	<mutex>
+#include	<sstream>
+#include	<thread>
+#include	<unordered_map>
+#include	<unordered_set>
 
-int ComputeProgram::build()
+// ----------------------------------------------------------------------------
+
+// the programs built this run, shared between all the ComputePrograms with the same key
+// on the same context: the key only identifies the device type so identical devices
+// have the same key, but a cl::Program can only be used with the context it was built for
+typedef std::pair<const ComputeContext*, u64> RegistryKey;
+static std::mutex g_registryMutex;
+static std::map<RegistryKey, cl::Program> g_programRegistry;
+
+const std::string PROGRAM_CACHE_DIRECTORY = "cl/cache";
+
+// ----------------------------------------------------------------------------
+
+static u64 HashString(const std::string& str, u64 hash)
 {
-	cl::Program::Sources sources;
-	std::string source;
+	// FNV-1a, std::hash isn't guaranteed to be stable between runs
+	for (const char c: str)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 0x100000001b3ULL;
+	}
 
-	// need to insert the headers first, of course...
-	std::vector<std::string> headerSource;
-	for (const auto& path: headerPaths_)
+	return hash;
+}
+
+// ----------------------------------------------------------------------------
+
+// the build options add -I. so #include "cl/x.cl" is resolved from the working dir,
+// the included files need to be part of the hash otherwise editing them won't
+// invalidate the cached binaries
+static void HashIncludedFiles(
+	const std::string& source,
+	std::unordered_set<std::string>& visited,
+	u64& hash)
+{
+	std::istringstream stream(source);
+	std::string line;
+	while (std::getline(stream, line))
 	{
-		if (!LoadTextFile(path, source))
+		const size_t directive = line.find("#include");
+		if (directive == std::string::npos)
 		{
-			printf("Error! Unable to load file '%s'\n", path.c_str());
 			continue;
 		}
 
-		headerSource.push_back(source);
-		const std::string& src = headerSource.back();
-		sources.push_back(std::make_pair(src.c_str(), src.length()));
+		const size_t begin = line.find('"', directive);
+		const size_t end = begin != std::string::npos ? line.find('"', begin + 1) : std::string::npos;
+		if (end == std::string::npos)
+		{
+			continue;
+		}
+
+		const std::string path = line.substr(begin + 1, end - begin - 1);
+		if (!visited.insert(path).second)
+		{
+			continue;
+		}
+
+		std::string includedSource;
+		if (LoadTextFile(path, includedSource))
+		{
+			hash = HashString(path, hash);
+			hash = HashString(includedSource, hash);
+			HashIncludedFiles(includedSource, visited, hash);
+		}
 	}
+}
 
-	if (!LoadTextFile(filePath_, source))
+// ----------------------------------------------------------------------------
+
+static u64 ProgramKey(
+	const std::vector<std::string>& sources,
+	const std::string& buildOptions,
+	const cl::Device& device)
+{
+	u64 hash = 0xcbf29ce484222325ULL;
+
+	std::unordered_set<std::string> visited;
+	for (const auto& source: sources)
 	{
-		printf("Error! Unable to load CL source file '%s'\n", filePath_.c_str());
-		return CL_BUILD_ERROR;
+		hash = HashString(source, hash);
+		HashIncludedFiles(source, visited, hash);
 	}
 
-	const std::time_t time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-	const std::string timestamp = std::ctime(&time);
-	const std::string injection = "#define LVN_TIMESTAMP /* " + timestamp + " */\n";
+	hash = HashString(buildOptions, hash);
 
-//	sources.push_back(std::make_pair(injection.c_str(), injection.length()));
-	sources.push_back(std::make_pair(source.c_str(), source.length()));
+	// a driver update can change the binary format
+	hash = HashString(device.getInfo<CL_DEVICE_NAME>(), hash);
+	hash = HashString(device.getInfo<CL_DEVICE_VERSION>(), hash);
+	hash = HashString(device.getInfo<CL_DRIVER_VERSION>(), hash);
 
-	// add the generate source last so it has access to all the on-disk code
-	if (!generatedSource_.empty())
+	return hash;
+}
+
+// ----------------------------------------------------------------------------
+
+static std::string CachePath(const u64 key)
+{
+	char name[32];
+	sprintf(name, "/%016llx.bin", (unsigned long long)key);
+	return PROGRAM_CACHE_DIRECTORY + name;
+}
+
+// ----------------------------------------------------------------------------
+
+static void SaveProgramBinary(const cl::Program& program, const u64 key)
+{
+	if (!EnsureDirectoryExists(PROGRAM_CACHE_DIRECTORY))
+	{
+		return;
+	}
+
+	// only the one device per context, see InitialiseContext
+	size_t binarySize = 0;
+	cl_int error = clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, nullptr);
+	if (error != CL_SUCCESS || binarySize == 0)
 	{
-		sources.push_back(std::make_pair(generatedSource_.c_str(), generatedSource_.length()));
+		return;
 	}
 
+	std::vector<unsigned char> binary(binarySize);
+	unsigned char* binaryPtr = &binary[0];
+	error = clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(binaryPtr), &binaryPtr, nullptr);
+	if (error != CL_SUCCESS)
+	{
+		return;
+	}
+
+	if (!SaveBinaryFile(CachePath(key), &binary[0], binary.size()))
+	{
+		printf("Warning: unable to write program cache file '%s'\n", CachePath(key).c_str());
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+int ComputeProgram::buildFromBinary(const std::vector<unsigned char>& binary)
+{
+	auto ctx = GetComputeContext();
+	std::vector<cl::Device> devices(1, ctx->device);
+
+	cl::Program::Binaries binaries;
+	binaries.push_back(std::make_pair((const void*)&binary[0], binary.size()));
+
+	std::vector<cl_int> binaryStatus;
+	cl_int error = CL_SUCCESS;
+	program_ = cl::Program(ctx->context, devices, binaries, &binaryStatus, &error);
+	if (!program_() || error != CL_SUCCESS)
+	{
+		return error != CL_SUCCESS ? error : CL_INVALID_BINARY;
+	}
+
+	// still need to 'build' a program created from a binary, but this is just a link
+	return program_.build(devices, buildOptions_.c_str());
+}
+
+// ----------------------------------------------------------------------------
+
+int ComputeProgram::buildFromSource(const cl::Program::Sources& sources)
+{
 	auto ctx = GetComputeContext();
 	cl_int error = CL_SUCCESS;
 	program_ = cl::Program(ctx->context, sources, &error);
@@ -60,7 +188,7 @@ int ComputeProgram::build()
 	error = program_.build(devices, buildOptions_.c_str());
 	if (error != CL_SUCCESS)
 	{
-		printf("Build program failed: %s (%d)\n", GetCLErrorString(error), error);
+		printf("Build program '%s' failed: %s (%d)\n", filePath_.c_str(), GetCLErrorString(error), error);
 	}
 
 //	const std::string buildLog = program_.getBuildInfo<CL_PROGRAM_BUILD_LOG>(ctx->device);
@@ -69,3 +197,137 @@ int ComputeProgram::build()
 
 	return error;
 }
+
+// ----------------------------------------------------------------------------
+
+int ComputeProgram::build()
+{
+	rmt_ScopedCPUSample(ComputeProgram_Build);
+
+	// need to insert the headers first, of course...
+	std::vector<std::string> sourceFiles;
+	for (const auto& path: headerPaths_)
+	{
+		std::string source;
+		if (!LoadTextFile(path, source))
+		{
+			printf("Error! Unable to load file '%s'\n", path.c_str());
+			continue;
+		}
+
+		sourceFiles.push_back(source);
+	}
+
+	std::string source;
+	if (!LoadTextFile(filePath_, source))
+	{
+		printf("Error! Unable to load CL source file '%s'\n", filePath_.c_str());
+		return CL_BUILD_ERROR;
+	}
+
+//	const std::time_t time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+//	const std::string timestamp = std::ctime(&time);
+//	sourceFiles.push_back("#define LVN_TIMESTAMP /* " + timestamp + " */\n");
+
+	sourceFiles.push_back(source);
+
+	// add the generate source last so it has access to all the on-disk code
+	if (!generatedSource_.empty())
+	{
+		sourceFiles.push_back(generatedSource_);
+	}
+
+	auto ctx = GetComputeContext();
+	const u64 key = ProgramKey(sourceFiles, buildOptions_, ctx->device);
+	const RegistryKey registryKey(ctx, key);
+	key_ = key;
+
+	{
+		std::lock_guard<std::mutex> lock(g_registryMutex);
+		const auto iter = g_programRegistry.find(registryKey);
+		if (iter != end(g_programRegistry))
+		{
+			program_ = iter->second;
+			return CL_SUCCESS;
+		}
+	}
+
+	std::vector<unsigned char> binary;
+	if (LoadBinaryFile(CachePath(key), binary))
+	{
+		if (buildFromBinary(binary) == CL_SUCCESS)
+		{
+			std::lock_guard<std::mutex> lock(g_registryMutex);
+			g_programRegistry[registryKey] = program_;
+			return CL_SUCCESS;
+		}
+
+		// stale or corrupt, fall back to the source and replace the file
+		printf("Warning: discarding cached binary for '%s'\n", filePath_.c_str());
+	}
+
+	cl::Program::Sources sources;
+	for (const auto& src: sourceFiles)
+	{
+		sources.push_back(std::make_pair(src.c_str(), src.length()));
+	}
+
+	if (const int error = buildFromSource(sources))
+	{
+		program_ = cl::Program();
+		return error;
+	}
+
+	SaveProgramBinary(program_, key);
+
+	std::lock_guard<std::mutex> lock(g_registryMutex);
+	g_programRegistry[registryKey] = program_;
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int ComputeProgram_BuildAll(const std::vector<ComputeProgram*>& programs)
+{
+	// the current context is per thread so needs to be passed on to the build threads
+	ComputeContext* ctx = GetComputeContext();
+
+	std::vector<int> errors(programs.size(), CL_SUCCESS);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		threads.push_back(std::thread([&, i]()
+		{
+			ScopedComputeContext scope(ctx);
+			errors[i] = programs[i]->build();
+		}));
+	}
+
+	for (auto& thread: threads)
+	{
+		thread.join();
+	}
+
+	for (const int error: errors)
+	{
+		if (error != CL_SUCCESS)
+		{
+			return error;
+		}
+	}
+
+	return CL_SUCCESS;
+}
+
+
+// ----------------------------------------------------------------------------
+
+void ComputeProgram_ClearRegistry()
+{
+	std::lock_guard<std::mutex> lock(g_registryMutex);
+	g_programRegistry.clear();
+}
+
+// ----------------------------------------------------------------------------
+
@@ -5,6 +5,13 @@
 #include	<vector>
 #include	<CL/cl.hpp>
 
+// ----------------------------------------------------------------------------
+// Programs are identified by a hash of the full source (including the files
+// pulled in with #include), the build options and the device. Identical programs
+// are built once per context and shared within it, and the binaries are cached on
+// disk so identical devices and later launches only need to load them.
+// ----------------------------------------------------------------------------
+
 class ComputeProgram
 {
 public:
@@ -17,13 +24,14 @@ public:
 		headerPaths_.clear();
 		generatedSource_ = "";
 		program_ = cl::Program();
+		key_ = 0;
 	}
 
 	void addHeader(const std::string& headerPath)
 	{
 		headerPaths_.push_back(headerPath);
 	}
-	
+
 	void setGeneratedSource(const std::string& generatedSource)
 	{
 		generatedSource_ = generatedSource;
@@ -36,15 +44,36 @@ public:
 		// use the value semantics rather than returning a ref
 		return program_;
 	}
-	
+
+	// identifies the source, options and device the program was built with
+	u64 key() const
+	{
+		return key_;
+	}
+
 private:
 
+	int buildFromSource(const cl::Program::Sources& sources);
+	int buildFromBinary(const std::vector<unsigned char>& binary);
+
 	std::string					filePath_;
 	std::string					buildOptions_;
 	std::vector<std::string>	headerPaths_;
 	std::string					generatedSource_;
 	cl::Program					program_;
+	u64							key_ = 0;
 };
 
+// ----------------------------------------------------------------------------
+
+// the cached binaries and the autotuning results (see compute_autotune.cpp)
+extern const std::string PROGRAM_CACHE_DIRECTORY;
+
+// builds the programs concurrently, returns the first error encountered
+int ComputeProgram_BuildAll(const std::vector<ComputeProgram*>& programs);
+
+// drop the shared programs, i.e. when the context is destroyed
+void ComputeProgram_ClearRegistry();
+
 #endif	//	HAS_COMPUTE_PROGRAM_H_BEEN_INCLUDED
 
@@ -0,0 +1,162 @@
+#include	"compute_local.h"
+#include	"compute_program.h"
+#include	"volume_constants.h"
+
+#include	<sstream>
+#include	<glm/gtx/integer.hpp>
+#include	<Remotery.h>
+
+// ----------------------------------------------------------------------------
+
+// the codes of the deepest nodes have to fit in the cuckoo table's keys
+const int MAX_SEAM_TREE_DEPTH = (CUCKOO_KEY_BITS - 1) / 3;
+
+// ----------------------------------------------------------------------------
+
+int Compute_InitialiseSeamMesh()
+{
+	std::stringstream buildOptions;
+	buildOptions << "-cl-fast-relaxed-math ";
+	buildOptions << "-Werror ";
+	buildOptions << "-DCUCKOO_EMPTY_VALUE=" << CUCKOO_EMPTY_VALUE << " ";
+	buildOptions << "-DCUCKOO_STASH_HASH_INDEX=" << CUCKOO_STASH_HASH_INDEX << " ";
+	buildOptions << "-DCUCKOO_HASH_FN_COUNT=" << CUCKOO_HASH_FN_COUNT << " ";
+	buildOptions << "-DCUCKOO_STASH_SIZE=" << CUCKOO_STASH_SIZE << " ";
+	buildOptions << "-DCUCKOO_MAX_ITERATIONS=" << CUCKOO_MAX_ITERATIONS << " ";
+	buildOptions << "-DCUCKOO_KEY_BITS=" << CUCKOO_KEY_BITS << " ";
+
+	auto ctx = GetComputeContext();
+	ctx->seamProgram.initialise("cl/seam_mesh.cl", buildOptions.str());
+	ctx->seamProgram.addHeader("cl/cuckoo.cl");
+	CL_CALL(ctx->seamProgram.build());
+
+	const struct { const char* name; cl::Kernel* kernel; } kernels[] =
+	{
+		{ "SeamNodeCodes", &ctx->seamNodeCodes },
+		{ "GenerateSeamMesh", &ctx->generateSeamMesh },
+		{ "CompactSeamTriangles", &ctx->compactSeamTriangles },
+	};
+
+	for (const auto& k: kernels)
+	{
+		cl_int error = CL_SUCCESS;
+		*k.kernel = cl::Kernel(ctx->seamProgram.get(), k.name, &error);
+		if (!(*k.kernel)() || error != CL_SUCCESS)
+		{
+			printf("Error! Failed to create '%s' kernel: %s (%d)\n", k.name, GetCLErrorString(error), error);
+			return error != CL_SUCCESS ? error : LVN_CL_ERROR;
+		}
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_GenerateSeamMesh(
+	const glm::ivec3& rootMin,
+	const int rootSize,
+	const std::vector<SeamMeshNode>& nodes,
+	MeshBuffer* meshBuffer)
+{
+	rmt_ScopedCPUSample(Compute_GenerateSeamMesh);
+	meshBuffer->numTriangles = 0;
+	if (nodes.empty())
+	{
+		return CL_SUCCESS;
+	}
+
+	// the node positions are in units of the smallest node so the tree is only as deep
+	// as the range of sizes needs
+	int unitSize = rootSize;
+	for (const SeamMeshNode& node: nodes)
+	{
+		unitSize = glm::min(unitSize, node.size);
+	}
+
+	const int treeDepth = glm::log2(rootSize / unitSize);
+	if (treeDepth > MAX_SEAM_TREE_DEPTH)
+	{
+		return LVN_CL_ERROR;
+	}
+
+	const int numNodes = nodes.size();
+	std::vector<cl_int4> localNodes(numNodes);
+	std::vector<cl_int> nodeCorners(numNodes);
+	for (int i = 0; i < numNodes; i++)
+	{
+		const glm::ivec3 min = (nodes[i].min - rootMin) / unitSize;
+		const cl_int4 localNode = { min.x, min.y, min.z, glm::log2(nodes[i].size / unitSize) };
+		localNodes[i] = localNode;
+		nodeCorners[i] = nodes[i].corners;
+	}
+
+	auto ctx = GetComputeContext();
+	std::lock_guard<std::mutex> lock(ctx->seamMutex);
+
+	cl::Buffer d_nodes, d_nodeCorners, d_nodeCodes;
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(cl_int4) * numNodes, &localNodes[0], d_nodes));
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(cl_int) * numNodes, &nodeCorners[0], d_nodeCorners));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_ulong) * numNodes, nullptr, d_nodeCodes));
+
+	int index = 0;
+	CL_CALL(ctx->seamNodeCodes.setArg(index++, d_nodes));
+	CL_CALL(ctx->seamNodeCodes.setArg(index++, treeDepth));
+	CL_CALL(ctx->seamNodeCodes.setArg(index++, d_nodeCodes));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(ctx->seamNodeCodes, cl::NullRange, numNodes, cl::NullRange));
+
+	CuckooData d_hashTable;
+	CL_CALL(Cuckoo_InitialiseTable(&d_hashTable, numNodes));
+	CL_CALL(Cuckoo_InsertKeys(&d_hashTable, d_nodeCodes, numNodes));
+
+	// each node can generate 2 triangles for each of its 12 edges
+	const int trianglesValidSize = numNodes * 24;
+	cl::Buffer d_indexBuffer, d_trianglesValid, d_trianglesScan;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize * 3, nullptr, d_indexBuffer));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize, nullptr, d_trianglesValid));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * trianglesValidSize, nullptr, d_trianglesScan));
+
+	const cl_int4 d_rootMin = { rootMin.x, rootMin.y, rootMin.z, 0 };
+	index = 0;
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_nodes));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_nodeCorners));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, treeDepth));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_rootMin));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, unitSize));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, CLIPMAP_LEAF_SIZE));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_indexBuffer));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_trianglesValid));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_hashTable.table));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_hashTable.stash));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_hashTable.prime));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_hashTable.hashParams));
+	CL_CALL(ctx->generateSeamMesh.setArg(index++, d_hashTable.stashUsed));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(ctx->generateSeamMesh, cl::NullRange, numNodes, cl::NullRange));
+
+	const int numTriangles = ExclusiveScan(ctx->queue, d_trianglesValid, d_trianglesScan, trianglesValidSize);
+	if (numTriangles <= 0)
+	{
+		// < 0 is an error, 0 is just an empty seam
+		return numTriangles;
+	}
+
+	cl::Buffer d_compactIndexBuffer;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, sizeof(cl_int) * numTriangles * 3, nullptr, d_compactIndexBuffer));
+
+	index = 0;
+	CL_CALL(ctx->compactSeamTriangles.setArg(index++, d_trianglesValid));
+	CL_CALL(ctx->compactSeamTriangles.setArg(index++, d_trianglesScan));
+	CL_CALL(ctx->compactSeamTriangles.setArg(index++, d_indexBuffer));
+	CL_CALL(ctx->compactSeamTriangles.setArg(index++, d_compactIndexBuffer));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(ctx->compactSeamTriangles, cl::NullRange, trianglesValidSize, cl::NullRange));
+
+	meshBuffer->reserve(0, numTriangles);
+	CL_CALL(ctx->queue.enqueueReadBuffer(d_compactIndexBuffer, CL_TRUE,
+		0, sizeof(MeshTriangle) * numTriangles, &meshBuffer->triangles[0]));
+	meshBuffer->numTriangles = numTriangles;
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
@@ -0,0 +1,909 @@
+#include	"compute_local.h"
+#include	"glsl_svd.h"
+
+#include	<stdio.h>
+#include	<string.h>
+#include	<list>
+#include	<mutex>
+#include	<unordered_map>
+#include	<Remotery.h>
+
+// ----------------------------------------------------------------------------
+// The spill tier sits behind the GPU caches in MeshGenerationContext. Fields and
+// octrees evicted from those caches are read back, compressed and kept in host
+// memory (and optionally a scratch file) so reloading them is an upload rather
+// than running the generation kernels again. Entries are keyed by the node
+// location, voxelsPerChunk and noise seed, and record the last CSG op applied
+// so only the most recent version of each entry is kept.
+// ----------------------------------------------------------------------------
+
+#ifdef _WIN32
+#define SPILL_FSEEK		_fseeki64
+#else
+#define SPILL_FSEEK		fseeko
+#endif
+
+// ----------------------------------------------------------------------------
+
+enum SpillEntryType
+{
+	SpillEntry_DensityField,
+	SpillEntry_Octree,
+};
+
+struct SpillKey
+{
+	glm::ivec4		location;				// min & size
+	int				voxelsPerChunk = 0;
+	int				fieldBrickSizeLog2 = 0;
+	int				noiseSeed = 0;
+	u64				densityGraphHash = 0;
+	int				type = SpillEntry_DensityField;
+
+	bool operator==(const SpillKey& other) const
+	{
+		return location == other.location && voxelsPerChunk == other.voxelsPerChunk &&
+			fieldBrickSizeLog2 == other.fieldBrickSizeLog2 && noiseSeed == other.noiseSeed && densityGraphHash == other.densityGraphHash && type == other.type;
+	}
+};
+
+struct SpillKeyHash
+{
+	std::size_t operator()(const SpillKey& key) const
+	{
+		const std::size_t h = std::hash<glm::ivec4>()(key.location);
+		return h ^ (key.voxelsPerChunk << 12) ^ (key.fieldBrickSizeLog2 << 20) ^ (key.noiseSeed << 3) ^ key.type ^ 
+			std::hash<u64>()(key.densityGraphHash);
+	}
+};
+
+// the keys of the entries held in host memory, least recently used first
+typedef std::list<SpillKey> SpillLRUList;
+
+struct SpillEntry
+{
+	int					lastCSGOperation = 0;
+	bool				edited = false;
+	SpillLRUList::iterator	lruIter;			// only valid while the data is in host memory
+
+	std::vector<u8>		data;					// empty when the entry has been written to the scratch file
+	s64					fileOffset = -1;
+	u32					fileSize = 0;
+};
+
+typedef std::unordered_map<SpillKey, SpillEntry, SpillKeyHash> SpillEntryMap;
+
+// the cuckoo tables have a minimum size so can be larger than the node count suggests
+const int MIN_SPILL_TABLE_SIZE = 4096;
+
+// ----------------------------------------------------------------------------
+
+static std::mutex		g_spillMutex;
+static SpillEntryMap	g_spillEntries;
+static SpillLRUList		g_spillLRU;
+static size_t			g_spillHostBytes = 0;
+static size_t			g_spillHostBudget = 256 * 1024 * 1024;
+
+static std::string		g_spillFilePath;
+static FILE*			g_spillFile = nullptr;
+static s64				g_spillFileSize = 0;
+
+// ----------------------------------------------------------------------------
+
+static SpillKey MakeSpillKey(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int size,
+	const SpillEntryType type)
+{
+	SpillKey key;
+	key.location = glm::ivec4(min, size);
+	key.voxelsPerChunk = meshGen->voxelsPerChunk;
+	key.fieldBrickSizeLog2 = meshGen->fieldBrickSizeLog2;
+	key.noiseSeed = GetComputeContext()->noiseSeed;
+	key.densityGraphHash = Compute_DensityGraphHash();
+	key.type = type;
+	return key;
+}
+
+// ----------------------------------------------------------------------------
+// The field materials are mostly long runs of air or solid so are run length
+// encoded, the edge indices and node codes are generated in ascending order and
+// are delta encoded. The cuckoo tables are around half empty so only the runs of
+// empty slots are encoded. The float data is stored as is.
+
+class SpillWriter
+{
+public:
+
+	SpillWriter(std::vector<u8>& data)
+		: data_(data)
+	{
+	}
+
+	void writeVarint(u64 value)
+	{
+		while (value >= 0x80)
+		{
+			data_.push_back((u8)(value | 0x80));
+			value >>= 7;
+		}
+
+		data_.push_back((u8)value);
+	}
+
+	void writeSigned(const s64 value)
+	{
+		writeVarint(((u64)value << 1) ^ (u64)(value >> 63));
+	}
+
+	void writeBytes(const void* src, const size_t size)
+	{
+		const u8* bytes = (const u8*)src;
+		data_.insert(end(data_), bytes, bytes + size);
+	}
+
+	void writeRunLength(const cl_int* values, const int count)
+	{
+		int i = 0;
+		while (i < count)
+		{
+			int run = 1;
+			while ((i + run) < count && values[i + run] == values[i])
+			{
+				run++;
+			}
+
+			writeVarint(run);
+			writeSigned(values[i]);
+			i += run;
+		}
+	}
+
+	template <typename T>
+	void writeDelta(const T* values, const int count)
+	{
+		s64 previous = 0;
+		for (int i = 0; i < count; i++)
+		{
+			writeSigned((s64)values[i] - previous);
+			previous = (s64)values[i];
+		}
+	}
+
+	void writeSparse(const u64* values, const int count)
+	{
+		int i = 0;
+		while (i < count)
+		{
+			int emptyRun = 0;
+			while ((i + emptyRun) < count && values[i + emptyRun] == CUCKOO_EMPTY_VALUE)
+			{
+				emptyRun++;
+			}
+
+			writeVarint(emptyRun);
+			i += emptyRun;
+
+			if (i < count)
+			{
+				writeBytes(&values[i++], sizeof(u64));
+			}
+		}
+	}
+
+private:
+
+	std::vector<u8>&	data_;
+};
+
+// ----------------------------------------------------------------------------
+
+class SpillReader
+{
+public:
+
+	SpillReader(const std::vector<u8>& data)
+		: ptr_(data.empty() ? nullptr : &data[0])
+		, end_(data.empty() ? nullptr : &data[0] + data.size())
+	{
+	}
+
+	bool ok() const
+	{
+		return ok_;
+	}
+
+	u64 readVarint()
+	{
+		u64 value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (ptr_ >= end_)
+			{
+				ok_ = false;
+				return 0;
+			}
+
+			const u8 byte = *ptr_++;
+			value |= (u64)(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return value;
+			}
+		}
+
+		ok_ = false;
+		return 0;
+	}
+
+	s64 readSigned()
+	{
+		const u64 value = readVarint();
+		return (s64)(value >> 1) ^ -(s64)(value & 1);
+	}
+
+	void readBytes(void* dst, const size_t size)
+	{
+		if ((size_t)(end_ - ptr_) < size)
+		{
+			ok_ = false;
+			return;
+		}
+
+		memcpy(dst, ptr_, size);
+		ptr_ += size;
+	}
+
+	void readRunLength(cl_int* values, const int count)
+	{
+		int i = 0;
+		while (ok_ && i < count)
+		{
+			const u64 run = readVarint();
+			const cl_int value = (cl_int)readSigned();
+			if (run == 0 || run > (u64)(count - i))
+			{
+				ok_ = false;
+				return;
+			}
+
+			for (u64 j = 0; j < run; j++)
+			{
+				values[i++] = value;
+			}
+		}
+	}
+
+	template <typename T>
+	void readDelta(T* values, const int count)
+	{
+		s64 previous = 0;
+		for (int i = 0; ok_ && i < count; i++)
+		{
+			previous += readSigned();
+			values[i] = (T)previous;
+		}
+	}
+
+	void readSparse(u64* values, const int count)
+	{
+		int i = 0;
+		while (ok_ && i < count)
+		{
+			const u64 emptyRun = readVarint();
+			if (emptyRun > (u64)(count - i))
+			{
+				ok_ = false;
+				return;
+			}
+
+			for (u64 j = 0; j < emptyRun; j++)
+			{
+				values[i++] = CUCKOO_EMPTY_VALUE;
+			}
+
+			if (i < count)
+			{
+				readBytes(&values[i++], sizeof(u64));
+			}
+		}
+	}
+
+private:
+
+	const u8*			ptr_ = nullptr;
+	const u8*			end_ = nullptr;
+	bool				ok_ = true;
+};
+
+// ----------------------------------------------------------------------------
+
+static void CloseSpillFile()
+{
+	if (g_spillFile)
+	{
+		fclose(g_spillFile);
+		remove(g_spillFilePath.c_str());
+	}
+
+	g_spillFile = nullptr;
+	g_spillFileSize = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool WriteEntryToSpillFile(SpillEntry& entry)
+{
+	if (!g_spillFile && !g_spillFilePath.empty())
+	{
+		g_spillFile = fopen(g_spillFilePath.c_str(), "w+b");
+		if (!g_spillFile)
+		{
+			printf("Spill: unable to open scratch file '%s', disabling\n", g_spillFilePath.c_str());
+			g_spillFilePath.clear();
+		}
+	}
+
+	if (!g_spillFile)
+	{
+		return false;
+	}
+
+	// the space used by discarded entries isn't reclaimed until the spill tier is cleared
+	if (SPILL_FSEEK(g_spillFile, g_spillFileSize, SEEK_SET) != 0 ||
+		fwrite(&entry.data[0], 1, entry.data.size(), g_spillFile) != entry.data.size())
+	{
+		printf("Spill: unable to write to scratch file '%s'\n", g_spillFilePath.c_str());
+		return false;
+	}
+
+	entry.fileOffset = g_spillFileSize;
+	entry.fileSize = (u32)entry.data.size();
+	g_spillFileSize += entry.fileSize;
+
+	g_spillLRU.erase(entry.lruIter);
+	g_spillHostBytes -= entry.data.size();
+	std::vector<u8>().swap(entry.data);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool ReadEntryData(const SpillEntry& entry, std::vector<u8>& data)
+{
+	if (!entry.data.empty())
+	{
+		data = entry.data;
+		return true;
+	}
+
+	if (!g_spillFile || entry.fileOffset < 0)
+	{
+		return false;
+	}
+
+	data.resize(entry.fileSize);
+	if (SPILL_FSEEK(g_spillFile, entry.fileOffset, SEEK_SET) != 0 ||
+		fread(&data[0], 1, entry.fileSize, g_spillFile) != entry.fileSize)
+	{
+		printf("Spill: unable to read from scratch file '%s'\n", g_spillFilePath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+static void EraseEntry(SpillEntryMap::iterator iter)
+{
+	if (!iter->second.data.empty())
+	{
+		g_spillLRU.erase(iter->second.lruIter);
+	}
+
+	g_spillHostBytes -= iter->second.data.size();
+	g_spillEntries.erase(iter);
+}
+
+// ----------------------------------------------------------------------------
+
+// move the least recently used entries out of host memory until the budget is met,
+// edited fields are never dropped as they may be the only copy of the edits
+static void EnforceHostBudget()
+{
+	auto lruIter = begin(g_spillLRU);
+	while (g_spillHostBytes > g_spillHostBudget && lruIter != end(g_spillLRU))
+	{
+		// step over the entry first as writing or erasing it removes it from the list
+		auto iter = g_spillEntries.find(*lruIter++);
+		SpillEntry& entry = iter->second;
+		if (entry.edited && !g_spillFile && g_spillFilePath.empty())
+		{
+			continue;
+		}
+
+		if (!WriteEntryToSpillFile(entry))
+		{
+			if (entry.edited)
+			{
+				break;
+			}
+
+			EraseEntry(iter);
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+static void InsertEntry(const SpillKey& key, SpillEntry& entry)
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+
+	auto iter = g_spillEntries.find(key);
+	if (iter != end(g_spillEntries))
+	{
+		if (iter->second.lastCSGOperation > entry.lastCSGOperation)
+		{
+			// already have a more recent version
+			return;
+		}
+
+		EraseEntry(iter);
+	}
+
+	g_spillHostBytes += entry.data.size();
+	entry.lruIter = g_spillLRU.insert(end(g_spillLRU), key);
+	g_spillEntries[key] = std::move(entry);
+
+	EnforceHostBudget();
+}
+
+// ----------------------------------------------------------------------------
+
+static bool FindEntryData(const SpillKey& key, SpillEntry& entry, std::vector<u8>& data)
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+
+	auto iter = g_spillEntries.find(key);
+	if (iter == end(g_spillEntries))
+	{
+		return false;
+	}
+
+	if (!ReadEntryData(iter->second, data))
+	{
+		EraseEntry(iter);
+		return false;
+	}
+
+	if (!iter->second.data.empty())
+	{
+		g_spillLRU.splice(end(g_spillLRU), g_spillLRU, iter->second.lruIter);
+	}
+
+	entry.lastCSGOperation = iter->second.lastCSGOperation;
+	entry.edited = iter->second.edited;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+static void DiscardEntry(const SpillKey& key)
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+
+	auto iter = g_spillEntries.find(key);
+	if (iter != end(g_spillEntries))
+	{
+		EraseEntry(iter);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+// avoid the readback when the entry would be dropped straight away
+static bool SpillEnabled()
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+	return g_spillHostBudget > 0 || !g_spillFilePath.empty();
+}
+
+// ----------------------------------------------------------------------------
+
+int Compute_SetSpillOptions(const int hostBudgetMB, const std::string& scratchFilePath)
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+
+	// bring any entries in the old scratch file back into memory before it's removed
+	for (auto iter = begin(g_spillEntries); iter != end(g_spillEntries); )
+	{
+		SpillEntry& entry = iter->second;
+		if (entry.data.empty() && !ReadEntryData(entry, entry.data))
+		{
+			iter = g_spillEntries.erase(iter);
+			continue;
+		}
+
+		if (entry.fileOffset >= 0)
+		{
+			g_spillHostBytes += entry.data.size();
+			entry.lruIter = g_spillLRU.insert(begin(g_spillLRU), iter->first);
+		}
+
+		entry.fileOffset = -1;
+		++iter;
+	}
+
+	CloseSpillFile();
+
+	g_spillHostBudget = (size_t)glm::max(hostBudgetMB, 0) * 1024 * 1024;
+	g_spillFilePath = scratchFilePath;
+	EnforceHostBudget();
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+void Spill_Clear()
+{
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+
+	g_spillEntries.clear();
+	g_spillLRU.clear();
+	g_spillHostBytes = 0;
+	CloseSpillFile();
+}
+
+// ----------------------------------------------------------------------------
+
+int Spill_StoreDensityField(MeshGenerationContext* meshGen, const GPUDensityField& field)
+{
+	if (!field.edited && !SpillEnabled())
+	{
+		return CL_SUCCESS;
+	}
+
+	rmt_ScopedCPUSample(SpillDensityField);
+
+	auto ctx = GetComputeContext();
+
+	const int fieldBufferSize = meshGen->fieldBufferSize;
+	std::vector<cl_int> materials(fieldBufferSize);
+	std::vector<cl_int> edgeIndices(field.numEdges);
+	std::vector<glm::vec4> normals(field.numEdges);
+
+	CL_CALL(ctx->queue.enqueueReadBuffer(field.materials, CL_FALSE, 0, fieldBufferSize * sizeof(cl_int), &materials[0]));
+	if (field.numEdges > 0)
+	{
+		CL_CALL(ctx->queue.enqueueReadBuffer(field.edgeIndices, CL_FALSE, 0, field.numEdges * sizeof(cl_int), &edgeIndices[0]));
+		CL_CALL(ctx->queue.enqueueReadBuffer(field.normals, CL_FALSE, 0, field.numEdges * sizeof(glm::vec4), &normals[0]));
+	}
+
+	CL_CALL(ctx->queue.finish());
+
+	SpillEntry entry;
+	entry.lastCSGOperation = field.lastCSGOperation;
+	entry.edited = field.edited;
+
+	SpillWriter writer(entry.data);
+	writer.writeVarint(field.numEdges);
+	writer.writeRunLength(&materials[0], fieldBufferSize);
+	if (field.numEdges > 0)
+	{
+		writer.writeDelta(&edgeIndices[0], field.numEdges);
+		writer.writeBytes(&normals[0], field.numEdges * sizeof(glm::vec4));
+	}
+
+	InsertEntry(MakeSpillKey(meshGen, field.min, field.size, SpillEntry_DensityField), entry);
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool DecodeDensityField(
+	MeshGenerationContext* meshGen,
+	const std::vector<u8>& data,
+	SpilledDensityField& field)
+{
+	const int fieldBufferSize = meshGen->fieldBufferSize;
+
+	SpillReader reader(data);
+	field.numEdges = (unsigned int)reader.readVarint();
+	if (!reader.ok() || field.numEdges > (unsigned int)(fieldBufferSize * 3))
+	{
+		return false;
+	}
+
+	field.materials.resize(fieldBufferSize);
+	field.edgeIndices.resize(field.numEdges);
+	field.normals.resize(field.numEdges);
+
+	reader.readRunLength(&field.materials[0], fieldBufferSize);
+	if (field.numEdges > 0)
+	{
+		reader.readDelta(&field.edgeIndices[0], field.numEdges);
+		reader.readBytes(&field.normals[0], field.numEdges * sizeof(glm::vec4));
+	}
+
+	return reader.ok();
+}
+
+// ----------------------------------------------------------------------------
+
+int Spill_LoadDensityField(MeshGenerationContext* meshGen, GPUDensityField* field, bool& loaded)
+{
+	loaded = false;
+
+	const SpillKey key = MakeSpillKey(meshGen, field->min, field->size, SpillEntry_DensityField);
+	SpillEntry entry;
+	std::vector<u8> data;
+	if (!FindEntryData(key, entry, data))
+	{
+		return CL_SUCCESS;
+	}
+
+	rmt_ScopedCPUSample(UnspillDensityField);
+
+	SpilledDensityField spilled;
+	if (!DecodeDensityField(meshGen, data, spilled))
+	{
+		printf("Spill_LoadDensityField: corrupt entry, regenerating field\n");
+		DiscardEntry(key);
+		return CL_SUCCESS;
+	}
+
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, spilled.materials.size() * sizeof(cl_int), &spilled.materials[0], field->materials));
+	if (spilled.numEdges > 0)
+	{
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, spilled.numEdges * sizeof(cl_int), &spilled.edgeIndices[0], field->edgeIndices));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, spilled.numEdges * sizeof(glm::vec4), &spilled.normals[0], field->normals));
+	}
+
+	field->numEdges = spilled.numEdges;
+	field->lastCSGOperation = entry.lastCSGOperation;
+	field->edited = entry.edited;
+	loaded = true;
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+void Spill_DiscardDensityField(MeshGenerationContext* meshGen, const glm::ivec3& min, const int size)
+{
+	DiscardEntry(MakeSpillKey(meshGen, min, size, SpillEntry_DensityField));
+}
+
+// ----------------------------------------------------------------------------
+
+int Spill_GetEditedDensityFields(MeshGenerationContext* meshGen, std::vector<SpilledDensityField>& fields)
+{
+	rmt_ScopedCPUSample(GetEditedDensityFields);
+
+	const int noiseSeed = GetComputeContext()->noiseSeed;
+	const u64 densityGraphHash = Compute_DensityGraphHash();
+
+	std::lock_guard<std::mutex> lock(g_spillMutex);
+	for (const auto& iter: g_spillEntries)
+	{
+		const SpillKey& key = iter.first;
+		const SpillEntry& entry = iter.second;
+		if (!entry.edited || key.type != SpillEntry_DensityField ||
+			key.voxelsPerChunk != meshGen->voxelsPerChunk || key.noiseSeed != noiseSeed ||
+			key.densityGraphHash != densityGraphHash)
+		{
+			continue;
+		}
+
+		std::vector<u8> data;
+		SpilledDensityField field;
+		if (!ReadEntryData(entry, data) || !DecodeDensityField(meshGen, data, field))
+		{
+			printf("Spill_GetEditedDensityFields: unable to read entry\n");
+			return LVN_CL_ERROR;
+		}
+
+		field.min = glm::ivec3(key.location);
+		field.size = key.location.w;
+		field.lastCSGOperation = entry.lastCSGOperation;
+		fields.push_back(std::move(field));
+	}
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int Spill_StoreOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int size,
+	const GPUOctree& octree)
+{
+	if (octree.numNodes <= 0 || !SpillEnabled())
+	{
+		return CL_SUCCESS;
+	}
+
+	rmt_ScopedCPUSample(SpillOctree);
+
+	auto ctx = GetComputeContext();
+
+	const int numNodes = octree.numNodes;
+	const CuckooData& hashTable = octree.d_hashTable;
+	std::vector<u64> nodeCodes(numNodes);
+	std::vector<cl_int> nodeMaterials(numNodes), nodeVertices(numNodes);
+	std::vector<glm::vec4> positions(numNodes), normals(numNodes);
+	std::vector<u64> table(hashTable.prime), stash(CUCKOO_STASH_SIZE);
+	u32 hashParams[CUCKOO_HASH_FN_COUNT * 2];
+
+	// the leaf data is only kept for the edited chunks, see KeepLeafData
+	const bool hasLeafData = octree.d_leafQEFs() != nullptr;
+	std::vector<QEFData> leafQEFs(hasLeafData ? numNodes : 0);
+	std::vector<glm::vec4> leafPositions(leafQEFs.size()), leafNormals(leafQEFs.size());
+
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_nodeCodes, CL_FALSE, 0, numNodes * sizeof(u64), &nodeCodes[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_nodeMaterials, CL_FALSE, 0, numNodes * sizeof(cl_int), &nodeMaterials[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_nodeVertices, CL_FALSE, 0, numNodes * sizeof(cl_int), &nodeVertices[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_vertexPositions, CL_FALSE, 0, numNodes * sizeof(glm::vec4), &positions[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_vertexNormals, CL_FALSE, 0, numNodes * sizeof(glm::vec4), &normals[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(hashTable.table, CL_FALSE, 0, hashTable.prime * sizeof(u64), &table[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(hashTable.stash, CL_FALSE, 0, CUCKOO_STASH_SIZE * sizeof(u64), &stash[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(hashTable.hashParams, CL_FALSE, 0, sizeof(hashParams), &hashParams[0]));
+	if (hasLeafData)
+	{
+		CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_leafQEFs, CL_FALSE, 0, numNodes * sizeof(QEFData), &leafQEFs[0]));
+		CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_leafPositions, CL_FALSE, 0, numNodes * sizeof(glm::vec4), &leafPositions[0]));
+		CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_leafNormals, CL_FALSE, 0, numNodes * sizeof(glm::vec4), &leafNormals[0]));
+	}
+
+	CL_CALL(ctx->queue.finish());
+
+	SpillEntry entry;
+	entry.lastCSGOperation = octree.lastCSGOperation;
+
+	SpillWriter writer(entry.data);
+	writer.writeVarint(numNodes);
+	writer.writeVarint(octree.numVertices);
+	writer.writeVarint(hashTable.prime);
+	writer.writeVarint(hashTable.insertedKeys);
+	writer.writeVarint(hashTable.stashUsed);
+	writer.writeDelta(&nodeCodes[0], numNodes);
+	writer.writeDelta(&nodeMaterials[0], numNodes);
+	writer.writeDelta(&nodeVertices[0], numNodes);
+	writer.writeBytes(&positions[0], numNodes * sizeof(glm::vec4));
+	writer.writeBytes(&normals[0], numNodes * sizeof(glm::vec4));
+	writer.writeSparse(&table[0], hashTable.prime);
+	writer.writeSparse(&stash[0], CUCKOO_STASH_SIZE);
+	writer.writeBytes(&hashParams[0], sizeof(hashParams));
+	writer.writeVarint(hasLeafData ? 1 : 0);
+	if (hasLeafData)
+	{
+		writer.writeBytes(&leafQEFs[0], numNodes * sizeof(QEFData));
+		writer.writeBytes(&leafPositions[0], numNodes * sizeof(glm::vec4));
+		writer.writeBytes(&leafNormals[0], numNodes * sizeof(glm::vec4));
+	}
+
+	InsertEntry(MakeSpillKey(meshGen, min, size, SpillEntry_Octree), entry);
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+int Spill_LoadOctree(
+	MeshGenerationContext* meshGen,
+	const glm::ivec3& min,
+	const int size,
+	GPUOctree* octree,
+	bool& loaded)
+{
+	loaded = false;
+
+	const SpillKey key = MakeSpillKey(meshGen, min, size, SpillEntry_Octree);
+	SpillEntry entry;
+	std::vector<u8> data;
+	if (!FindEntryData(key, entry, data))
+	{
+		return CL_SUCCESS;
+	}
+
+	// the octree is only valid if no ops have touched the node since it was constructed
+	if (HasPendingCSGOperations(min, size, entry.lastCSGOperation))
+	{
+		DiscardEntry(key);
+		return CL_SUCCESS;
+	}
+
+	rmt_ScopedCPUSample(UnspillOctree);
+
+	const int maxNodes = meshGen->voxelsPerChunk * meshGen->voxelsPerChunk * meshGen->voxelsPerChunk;
+
+	SpillReader reader(data);
+	const int numNodes = (int)reader.readVarint();
+	const int numVertices = (int)reader.readVarint();
+	const int prime = (int)reader.readVarint();
+	const int insertedKeys = (int)reader.readVarint();
+	const int stashUsed = (int)reader.readVarint();
+	if (!reader.ok() || numNodes <= 0 || numNodes > maxNodes || numVertices <= 0 || numVertices > numNodes || prime <= 0 || prime > (maxNodes * 4 + MIN_SPILL_TABLE_SIZE))
+	{
+		printf("Spill_LoadOctree: corrupt entry, reconstructing octree\n");
+		DiscardEntry(key);
+		return CL_SUCCESS;
+	}
+
+	std::vector<u64> nodeCodes(numNodes);
+	std::vector<cl_int> nodeMaterials(numNodes), nodeVertices(numNodes);
+	std::vector<glm::vec4> positions(numNodes), normals(numNodes);
+	std::vector<u64> table(prime), stash(CUCKOO_STASH_SIZE);
+	u32 hashParams[CUCKOO_HASH_FN_COUNT * 2];
+
+	reader.readDelta(&nodeCodes[0], numNodes);
+	reader.readDelta(&nodeMaterials[0], numNodes);
+	reader.readDelta(&nodeVertices[0], numNodes);
+	reader.readBytes(&positions[0], numNodes * sizeof(glm::vec4));
+	reader.readBytes(&normals[0], numNodes * sizeof(glm::vec4));
+	reader.readSparse(&table[0], prime);
+	reader.readSparse(&stash[0], CUCKOO_STASH_SIZE);
+	reader.readBytes(&hashParams[0], sizeof(hashParams));
+
+	const bool hasLeafData = reader.readVarint() != 0;
+	std::vector<QEFData> leafQEFs(hasLeafData ? numNodes : 0);
+	std::vector<glm::vec4> leafPositions(leafQEFs.size()), leafNormals(leafQEFs.size());
+	if (hasLeafData)
+	{
+		reader.readBytes(&leafQEFs[0], numNodes * sizeof(QEFData));
+		reader.readBytes(&leafPositions[0], numNodes * sizeof(glm::vec4));
+		reader.readBytes(&leafNormals[0], numNodes * sizeof(glm::vec4));
+	}
+
+	if (!reader.ok())
+	{
+		printf("Spill_LoadOctree: corrupt entry, reconstructing octree\n");
+		DiscardEntry(key);
+		return CL_SUCCESS;
+	}
+
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(u64), &nodeCodes[0], octree->d_nodeCodes));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_int), &nodeMaterials[0], octree->d_nodeMaterials));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_int), &nodeVertices[0], octree->d_nodeVertices));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_float4), &positions[0], octree->d_vertexPositions));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_float4), &normals[0], octree->d_vertexNormals));
+	if (hasLeafData)
+	{
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(QEFData), &leafQEFs[0], octree->d_leafQEFs));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_float4), &leafPositions[0], octree->d_leafPositions));
+		CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, numNodes * sizeof(cl_float4), &leafNormals[0], octree->d_leafNormals));
+	}
+
+	CuckooData& hashTable = octree->d_hashTable;
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, prime * sizeof(u64), &table[0], hashTable.table));
+	CL_CALL(CreateBuffer(CL_MEM_READ_WRITE, CUCKOO_STASH_SIZE * sizeof(u64), &stash[0], hashTable.stash));
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY, sizeof(hashParams), &hashParams[0], hashTable.hashParams));
+	hashTable.prime = prime;
+	hashTable.insertedKeys = insertedKeys;
+	hashTable.stashUsed = stashUsed;
+
+	octree->numNodes = numNodes;
+	octree->numVertices = numVertices;
+	octree->lastCSGOperation = entry.lastCSGOperation;
+	loaded = true;
+
+	// the octree is back in the GPU cache which will spill it again if needed
+	DiscardEntry(key);
+
+	return CL_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+
+void Spill_DiscardOctree(MeshGenerationContext* meshGen, const glm::ivec3& min, const int size)
+{
+	DiscardEntry(MakeSpillKey(meshGen, min, size, SpillEntry_Octree));
+}
+
+// ----------------------------------------------------------------------------
+
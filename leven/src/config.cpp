@@ -66,6 +66,56 @@ bool Config_Load(Config& cfg, const std::string& filepath)
 		{
 			ss >> cfg.shadowMapSize;
 		}
+		else if (_stricmp(key.c_str(), "WorldFile") == 0)
+		{
+			// no value disables saving
+			cfg.worldFile.clear();
+			ss >> cfg.worldFile;
+		}
+		else if (_stricmp(key.c_str(), "MeshPack") == 0)
+		{
+			cfg.meshPack.clear();
+			ss >> cfg.meshPack;
+		}
+		else if (_stricmp(key.c_str(), "SpillBudgetMB") == 0)
+		{
+			ss >> cfg.spillBudgetMB;
+		}
+		else if (_stricmp(key.c_str(), "SpillFile") == 0)
+		{
+			cfg.spillFile.clear();
+			ss >> cfg.spillFile;
+		}
+		else if (_stricmp(key.c_str(), "MeshCollapseMaxError") == 0)
+		{
+			ss >> cfg.meshCollapseMaxError;
+		}
+		else if (_stricmp(key.c_str(), "MeshExtractors") == 0)
+		{
+			cfg.meshExtractors.clear();
+			ss >> cfg.meshExtractors;
+		}
+		else if (_stricmp(key.c_str(), "DensityGraph") == 0)
+		{
+			cfg.densityGraph.clear();
+			ss >> cfg.densityGraph;
+		}
+		else if (_stricmp(key.c_str(), "LODVoxelsPerChunk") == 0)
+		{
+			cfg.lodVoxelsPerChunk.clear();
+			ss >> cfg.lodVoxelsPerChunk;
+		}
+		else if (_stricmp(key.c_str(), "LODActiveDistances") == 0)
+		{
+			cfg.lodActiveDistances.clear();
+			ss >> cfg.lodActiveDistances;
+		}
+		else if (_stricmp(key.c_str(), "ComputeDevices") == 0)
+		{
+			// the index list can't contain spaces, e.g. 0:0,1:0
+			cfg.computeDevices.clear();
+			ss >> cfg.computeDevices;
+		}
 		else if (_stricmp(key.c_str(), "FullScreen") == 0)
 		{
 			std::string value;
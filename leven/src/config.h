@@ -14,6 +14,9 @@ struct Config
 		, noiseSeed(0)
 		, useShadows(true)
 		, shadowMapSize(2048)
+		, worldFile("world.lvw")
+		, spillBudgetMB(256)
+		, meshCollapseMaxError(0.1f)
 	{
 	}
 
@@ -27,6 +30,22 @@ struct Config
 
 	bool		useShadows;
 	int			shadowMapSize;
+
+	std::string	worldFile;			// empty to disable saving
+
+	int			spillBudgetMB;
+	std::string	spillFile;			// empty to disable the scratch file
+
+	float		meshCollapseMaxError;	// see Compute_SetCollapseOptions
+	std::string	meshExtractors;			// see Compute_SetMeshExtractors
+	std::string	densityGraph;			// see Compute_SetDensityGraph, empty for the default terrain
+
+	std::string	lodVoxelsPerChunk;		// see Clipmap_SetConfig
+	std::string	lodActiveDistances;
+
+	std::string	meshPack;			// baked with leven_bake, empty to generate the meshes
+
+	std::string	computeDevices;		// see Compute_SetDeviceSelection
 };
 
 bool Config_Load(Config& cfg, const std::string& filepath);
@@ -0,0 +1,653 @@
+#include	"density_graph.h"
+
+#include	"file_utils.h"
+
+#include	<sstream>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+
+// ----------------------------------------------------------------------------
+
+// the args for each op: 'v' a vector node, 's' a scalar node or a number and 'c' a
+// number, the trailing args past minArgs copy the last arg given (i.e. "scale p 2")
+struct OpInfo
+{
+	const char*		name;
+	bool			isVector;
+	const char*		args;
+	int				minArgs;
+};
+
+static const OpInfo OP_INFO[DensityGraph::Op_SIZE] =
+{
+	{ "position",	true,	"",			0 },
+	{ "translate",	true,	"vsss",		4 },		// x y z offsets
+	{ "scale",		true,	"vsss",		2 },		// x [y z] scale
+	{ "rotatey",	true,	"vc",		2 },		// degrees
+	{ "x",			false,	"v",		1 },
+	{ "y",			false,	"v",		1 },
+	{ "z",			false,	"v",		1 },
+	{ "const",		false,	"c",		1 },
+	{ "add",		false,	"ss",		2 },
+	{ "sub",		false,	"ss",		2 },
+	{ "mul",		false,	"ss",		2 },
+	{ "div",		false,	"ss",		2 },
+	{ "min",		false,	"ss",		2 },
+	{ "max",		false,	"ss",		2 },
+	{ "neg",		false,	"s",		1 },
+	{ "abs",		false,	"s",		1 },
+	{ "clamp",		false,	"sss",		3 },		// value min max
+	{ "mix",		false,	"sss",		3 },		// a b t
+	{ "smin",		false,	"sss",		3 },		// a b k
+	{ "smax",		false,	"sss",		3 },		// a b k
+	{ "noise",		false,	"v",		1 },
+	{ "fractal",	false,	"vcccc",	5 },		// octaves frequency lacunarity persistence
+	{ "ridged",		false,	"vcccc",	5 },		// octaves lacunarity gain offset
+	{ "sphere",		false,	"vs",		2 },		// radius
+	{ "box",		false,	"vsss",		2 },		// x [y z] half size
+	{ "torus",		false,	"vss",		3 },		// small radius, large radius
+	{ "capsule",	false,	"vss",		3 },		// radius, half length
+	{ "cylinder",	false,	"vss",		3 },		// radius, half height
+};
+
+// the longest args string above, i.e. fractal and ridged
+static const int MAX_OP_ARGS = 5;
+
+// ----------------------------------------------------------------------------
+
+static bool IsNumber(const std::string& token, float& value)
+{
+	char* end = nullptr;
+	value = strtof(token.c_str(), &end);
+	return end != token.c_str() && *end == '\0';
+}
+
+// ----------------------------------------------------------------------------
+
+bool DensityGraph::load(const std::string& path)
+{
+	std::string source;
+	if (!LoadTextFile(path, source))
+	{
+		printf("DensityGraph: unable to load '%s'\n", path.c_str());
+		return false;
+	}
+
+	return parse(source, path);
+}
+
+// ----------------------------------------------------------------------------
+
+bool DensityGraph::parse(const std::string& source, const std::string& sourceName)
+{
+	nodes_.clear();
+	output_ = -1;
+
+	std::istringstream stream(source);
+	std::string line;
+	for (int lineNumber = 1; std::getline(stream, line); lineNumber++)
+	{
+		const size_t comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.resize(comment);
+		}
+
+		std::istringstream lineStream(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (lineStream >> token)
+		{
+			tokens.push_back(token);
+		}
+
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		float unused = 0.f;
+		if (tokens.size() < 2 || IsNumber(tokens[0], unused))
+		{
+			printf("DensityGraph: %s:%d: expected '<name> <op> <args...>'\n", sourceName.c_str(), lineNumber);
+			return false;
+		}
+
+		Node node;
+		node.name = tokens[0];
+		for (const Node& other: nodes_)
+		{
+			if (other.name == node.name)
+			{
+				printf("DensityGraph: %s:%d: '%s' is already defined\n", sourceName.c_str(), lineNumber, node.name.c_str());
+				return false;
+			}
+		}
+
+		int opIndex = 0;
+		while (opIndex < Op_SIZE && _stricmp(OP_INFO[opIndex].name, tokens[1].c_str()) != 0)
+		{
+			opIndex++;
+		}
+
+		if (opIndex == Op_SIZE)
+		{
+			printf("DensityGraph: %s:%d: unknown op '%s'\n", sourceName.c_str(), lineNumber, tokens[1].c_str());
+			return false;
+		}
+
+		const OpInfo& info = OP_INFO[opIndex];
+		const int maxArgs = strlen(info.args);
+		LVN_ASSERT(maxArgs <= MAX_OP_ARGS);
+		const int numArgs = tokens.size() - 2;
+		if (numArgs < info.minArgs || numArgs > maxArgs)
+		{
+			printf("DensityGraph: %s:%d: '%s' takes %d to %d args\n", sourceName.c_str(), lineNumber,
+				info.name, info.minArgs, maxArgs);
+			return false;
+		}
+
+		node.op = (Op)opIndex;
+		node.isVector = info.isVector;
+		for (int i = 0; i < maxArgs; i++)
+		{
+			const std::string& arg = tokens[2 + glm::min(i, numArgs - 1)];
+			const char type = info.args[i];
+
+			Operand operand;
+			if (IsNumber(arg, operand.value))
+			{
+				if (type == 'v')
+				{
+					printf("DensityGraph: %s:%d: '%s' arg %d must be a vector node\n", sourceName.c_str(), lineNumber, info.name, i);
+					return false;
+				}
+			}
+			else
+			{
+				for (int n = 0; n < (int)nodes_.size() && operand.node == -1; n++)
+				{
+					operand.node = nodes_[n].name == arg ? n : -1;
+				}
+
+				if (operand.node == -1)
+				{
+					printf("DensityGraph: %s:%d: unknown node '%s'\n", sourceName.c_str(), lineNumber, arg.c_str());
+					return false;
+				}
+
+				if (type == 'c' || nodes_[operand.node].isVector != (type == 'v'))
+				{
+					printf("DensityGraph: %s:%d: '%s' arg %d must be a %s\n", sourceName.c_str(), lineNumber, info.name, i,
+						type == 'c' ? "number" : type == 'v' ? "vector node" : "scalar");
+					return false;
+				}
+			}
+
+			node.args.push_back(operand);
+		}
+
+		nodes_.push_back(node);
+	}
+
+	if (nodes_.empty() || nodes_.back().isVector)
+	{
+		printf("DensityGraph: %s: the last node must be the (scalar) density\n", sourceName.c_str());
+		nodes_.clear();
+		return false;
+	}
+
+	output_ = nodes_.size() - 1;
+	fold();
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+// the ops which only depend on their scalar args, i.e. can be folded
+static bool IsArithmeticOp(const DensityGraph::Op op)
+{
+	return op >= DensityGraph::Op_Add && op <= DensityGraph::Op_SMax;
+}
+
+static float SMin(const float a, const float b, const float k)
+{
+	// as smin in cl/noise.cl
+	const float h = glm::clamp(0.5f + 0.5f * (b - a) / k, 0.f, 1.f);
+	return glm::mix(b, a, h) - k * h * (1.f - h);
+}
+
+static float EvaluateArithmeticOp(const DensityGraph::Op op, const float* a)
+{
+	switch (op)
+	{
+	case DensityGraph::Op_Add:		return a[0] + a[1];
+	case DensityGraph::Op_Sub:		return a[0] - a[1];
+	case DensityGraph::Op_Mul:		return a[0] * a[1];
+	case DensityGraph::Op_Div:		return a[0] / a[1];
+	case DensityGraph::Op_Min:		return glm::min(a[0], a[1]);
+	case DensityGraph::Op_Max:		return glm::max(a[0], a[1]);
+	case DensityGraph::Op_Neg:		return -a[0];
+	case DensityGraph::Op_Abs:		return glm::abs(a[0]);
+	case DensityGraph::Op_Clamp:	return glm::clamp(a[0], a[1], a[2]);
+	case DensityGraph::Op_Mix:		return glm::mix(a[0], a[1], a[2]);
+	case DensityGraph::Op_SMin:		return SMin(a[0], a[1], a[2]);
+	case DensityGraph::Op_SMax:		return -SMin(-a[0], -a[1], a[2]);
+	default:						break;
+	}
+
+	return 0.f;
+}
+
+// ----------------------------------------------------------------------------
+
+void DensityGraph::fold()
+{
+	// what each node resolves to: itself, another node (i.e. "mul a 1") or a constant
+	std::vector<Operand> resolved(nodes_.size());
+	for (int i = 0; i < (int)nodes_.size(); i++)
+	{
+		Node& node = nodes_[i];
+		bool allConstant = true;
+		for (Operand& arg: node.args)
+		{
+			if (arg.node != -1)
+			{
+				arg = resolved[arg.node];
+			}
+
+			allConstant = allConstant && arg.node == -1;
+		}
+
+		const auto isValue = [&](const int arg, const float value)
+		{
+			return node.args[arg].node == -1 && node.args[arg].value == value;
+		};
+
+		Operand& result = resolved[i];
+		result.node = i;
+
+		if (node.op == Op_Const)
+		{
+			result = node.args[0];
+		}
+		else if (IsArithmeticOp(node.op) && allConstant)
+		{
+			float args[3] = { 0.f, 0.f, 0.f };
+			for (size_t a = 0; a < node.args.size(); a++)
+			{
+				args[a] = node.args[a].value;
+			}
+
+			result.node = -1;
+			result.value = EvaluateArithmeticOp(node.op, args);
+		}
+		else if ((node.op == Op_Add && isValue(1, 0.f)) || (node.op == Op_Sub && isValue(1, 0.f)) ||
+			(node.op == Op_Mul && isValue(1, 1.f)) || (node.op == Op_Div && isValue(1, 1.f)))
+		{
+			result = node.args[0];
+		}
+		else if ((node.op == Op_Add && isValue(0, 0.f)) || (node.op == Op_Mul && isValue(0, 1.f)))
+		{
+			result = node.args[1];
+		}
+		else if (node.op == Op_Mul && (isValue(0, 0.f) || isValue(1, 0.f)))
+		{
+			result.node = -1;
+			result.value = 0.f;
+		}
+		else if ((node.op == Op_Translate && isValue(1, 0.f) && isValue(2, 0.f) && isValue(3, 0.f)) ||
+			(node.op == Op_Scale && isValue(1, 1.f) && isValue(2, 1.f) && isValue(3, 1.f)) ||
+			(node.op == Op_RotateY && isValue(1, 0.f)))
+		{
+			result = node.args[0];
+		}
+	}
+
+	// only keep the nodes the output depends on
+	std::vector<Node> nodes;
+	const Operand& output = resolved[output_];
+	if (output.node == -1)
+	{
+		Node constant;
+		constant.name = nodes_[output_].name;
+		constant.op = Op_Const;
+		constant.args.push_back(output);
+		nodes.push_back(constant);
+	}
+	else
+	{
+		std::vector<bool> live(nodes_.size(), false);
+		live[output.node] = true;
+		for (int i = output.node; i >= 0; i--)
+		{
+			for (const Operand& arg: nodes_[i].args)
+			{
+				if (live[i] && arg.node != -1)
+				{
+					live[arg.node] = true;
+				}
+			}
+		}
+
+		std::vector<int> remap(nodes_.size(), -1);
+		for (int i = 0; i <= output.node; i++)
+		{
+			if (live[i])
+			{
+				remap[i] = nodes.size();
+				nodes.push_back(nodes_[i]);
+				for (Operand& arg: nodes.back().args)
+				{
+					arg.node = arg.node != -1 ? remap[arg.node] : -1;
+				}
+			}
+		}
+	}
+
+	nodes_ = nodes;
+	output_ = nodes_.size() - 1;
+}
+
+// ----------------------------------------------------------------------------
+
+static std::string FloatLiteral(const float value)
+{
+	char buffer[64];
+	if (value == (float)(int)value && glm::abs(value) < 1e6f)
+	{
+		snprintf(buffer, sizeof(buffer), "%.1ff", value);
+	}
+	else
+	{
+		snprintf(buffer, sizeof(buffer), "%.9gf", value);
+	}
+
+	return value < 0.f ? "(" + std::string(buffer) + ")" : buffer;
+}
+
+// ----------------------------------------------------------------------------
+
+std::string DensityGraph::generateOpenCL() const
+{
+	const auto arg = [this](const Node& node, const int i)
+	{
+		const Operand& operand = node.args[i];
+		return operand.node == -1 ? FloatLiteral(operand.value) : "n" + std::to_string(operand.node);
+	};
+
+	std::stringstream source;
+	source << "float DensityGraph(const float4 position, read_only image2d_t permTexture)\n{\n";
+
+	for (int i = 0; i < (int)nodes_.size(); i++)
+	{
+		const Node& node = nodes_[i];
+		const auto a = [&](const int index) { return arg(node, index); };
+
+		source << "\tconst " << (node.isVector ? "float3" : "float") << " n" << i << " = ";
+		switch (node.op)
+		{
+		case Op_Position:	source << "position.xyz"; break;
+		case Op_Translate:	source << a(0) << " + (float3)(" << a(1) << ", " << a(2) << ", " << a(3) << ")"; break;
+		case Op_Scale:		source << a(0) << " * (float3)(" << a(1) << ", " << a(2) << ", " << a(3) << ")"; break;
+		case Op_X:			source << a(0) << ".x"; break;
+		case Op_Y:			source << a(0) << ".y"; break;
+		case Op_Z:			source << a(0) << ".z"; break;
+		case Op_Const:		source << a(0); break;
+		case Op_Add:		source << "(" << a(0) << " + " << a(1) << ")"; break;
+		case Op_Sub:		source << "(" << a(0) << " - " << a(1) << ")"; break;
+		case Op_Mul:		source << "(" << a(0) << " * " << a(1) << ")"; break;
+		case Op_Div:		source << "(" << a(0) << " / " << a(1) << ")"; break;
+		case Op_Min:		source << "min(" << a(0) << ", " << a(1) << ")"; break;
+		case Op_Max:		source << "max(" << a(0) << ", " << a(1) << ")"; break;
+		case Op_Neg:		source << "-" << a(0); break;
+		case Op_Abs:		source << "fabs(" << a(0) << ")"; break;
+		case Op_Clamp:		source << "clamp(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+		case Op_Mix:		source << "mix(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+		case Op_SMin:		source << "smin(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+		case Op_SMax:		source << "-smin(-" << a(0) << ", -" << a(1) << ", " << a(2) << ")"; break;
+		case Op_Noise:		source << "snoise2(" << a(0) << ".xz, permTexture)"; break;
+		case Op_Sphere:		source << "fSphere(" << a(0) << ", " << a(1) << ")"; break;
+		case Op_Box:		source << "fBox(" << a(0) << ", (float3)(" << a(1) << ", " << a(2) << ", " << a(3) << "))"; break;
+		case Op_Torus:		source << "fTorus(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+		case Op_Capsule:	source << "fCapsule(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+		case Op_Cylinder:	source << "fCylinder(" << a(0) << ", " << a(1) << ", " << a(2) << ")"; break;
+
+		case Op_RotateY:
+		{
+			// the angle is always a number so the sin/cos are folded, as RotateY in noise.cl
+			const float angle = glm::radians(node.args[1].value);
+			const std::string c = FloatLiteral(glm::cos(angle));
+			const std::string s = FloatLiteral(glm::sin(angle));
+			const std::string v = a(0);
+			source << "(float3)((" << v << ".x * " << c << ") + (" << v << ".z * " << s << "), " << v << ".y, "
+				<< "(" << v << ".z * " << c << ") - (" << v << ".x * " << s << "))";
+			break;
+		}
+
+		case Op_Fractal:
+			source << "BasicFractal(permTexture, " << (int)node.args[1].value << ", " << a(2) << ", "
+				<< a(3) << ", " << a(4) << ", " << a(0) << ".xz)";
+			break;
+
+		case Op_Ridged:
+			source << "RidgedMultiFractal(permTexture, " << (int)node.args[1].value << ", " << a(2) << ", "
+				<< a(3) << ", " << a(4) << ", " << a(0) << ".xz)";
+			break;
+
+		default:
+			break;
+		}
+
+		source << ";\t// " << node.name << "\n";
+	}
+
+	source << "\treturn n" << output_ << ";\n}\n";
+	return source.str();
+}
+
+// ----------------------------------------------------------------------------
+
+u64 DensityGraph::hash() const
+{
+	if (nodes_.empty())
+	{
+		return 0;
+	}
+
+	// FNV-1a, std::hash isn't guaranteed to be stable between runs
+	u64 hash = 0xcbf29ce484222325ULL;
+	for (const char c: generateOpenCL())
+	{
+		hash ^= (unsigned char)c;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+// ----------------------------------------------------------------------------
+// The CPU versions of the cl/simplex.cl, cl/noise.cl and cl/hg_sdf.glsl functions
+// used by the graph.
+// ----------------------------------------------------------------------------
+
+// the nearest texel from the RGBA8 lookup, i.e. a read_imagef with permSampler
+static glm::vec2 PermGradient(const std::vector<unsigned char>& lookup, const int x, const int y)
+{
+	const int offset = (((y & 255) * 256) + (x & 255)) * 4;
+	const glm::vec2 texel(lookup[offset + 0] / 255.f, lookup[offset + 1] / 255.f);
+	return (texel * 4.f) - 1.f;
+}
+
+static float SimplexNoise2(const glm::vec2& P, const std::vector<unsigned char>& lookup)
+{
+	const float F2 = 0.366025403784f;
+	const float G2 = 0.211324865405f;
+
+	const float s = (P.x + P.y) * F2;
+	const glm::vec2 Pi = glm::floor(P + s);
+	const float t = (Pi.x + Pi.y) * G2;
+	const glm::vec2 P0 = Pi - t;
+	const glm::ivec2 cell(Pi);
+
+	const glm::vec2 Pf0 = P - P0;
+	const glm::ivec2 o1 = Pf0.x > Pf0.y ? glm::ivec2(1, 0) : glm::ivec2(0, 1);
+
+	const glm::vec2 Pf1 = Pf0 - glm::vec2(o1) + G2;
+	const glm::vec2 Pf2 = Pf0 - glm::vec2(1.f - 2.f * G2);
+
+	const glm::vec2 corners[3] = { Pf0, Pf1, Pf2 };
+	const glm::ivec2 offsets[3] = { glm::ivec2(0), o1, glm::ivec2(1) };
+
+	float n = 0.f;
+	for (int i = 0; i < 3; i++)
+	{
+		float falloff = 0.5f - glm::dot(corners[i], corners[i]);
+		if (falloff >= 0.f)
+		{
+			const glm::ivec2 texel = cell + offsets[i];
+			falloff *= falloff;
+			n += falloff * falloff * glm::dot(PermGradient(lookup, texel.x, texel.y), corners[i]);
+		}
+	}
+
+	return 70.f * n;
+}
+
+static float BasicFractal(
+	const std::vector<unsigned char>& lookup,
+	const int octaves,
+	const float frequency,
+	const float lacunarity,
+	const float persistence,
+	const glm::vec2& position)
+{
+	glm::vec2 p = position * frequency;
+	float noise = 0.f;
+	float amplitude = 1.f;
+	for (int i = 0; i < octaves; i++)
+	{
+		noise += SimplexNoise2(p, lookup) * amplitude;
+		p *= lacunarity;
+		amplitude *= persistence;
+	}
+
+	return noise;
+}
+
+static float RidgedMultiFractal(
+	const std::vector<unsigned char>& lookup,
+	const int octaves,
+	const float lacunarity,
+	const float gain,
+	const float offset,
+	const glm::vec2& position)
+{
+	glm::vec2 p = position;
+
+	float signal = offset - glm::abs(SimplexNoise2(p, lookup));
+	signal *= signal;
+
+	float noise = signal;
+	float frequency = 1.f;
+	for (int i = 0; i < octaves; i++)
+	{
+		p *= lacunarity;
+
+		const float weight = glm::clamp(signal * gain, 0.f, 1.f);
+		signal = (offset - glm::abs(SimplexNoise2(p, lookup))) * weight;
+
+		// RIDGED_MULTI_H is 1
+		noise += signal * (1.f / frequency);
+		frequency *= lacunarity;
+	}
+
+	return noise * (1.f / octaves);
+}
+
+static float Box(const glm::vec3& p, const glm::vec3& b)
+{
+	const glm::vec3 d = glm::abs(p) - b;
+	const glm::vec3 inside = glm::min(d, glm::vec3(0.f));
+	return glm::length(glm::max(d, glm::vec3(0.f))) + glm::max(inside.x, glm::max(inside.y, inside.z));
+}
+
+static float Torus(const glm::vec3& p, const float smallRadius, const float largeRadius)
+{
+	return glm::length(glm::vec2(glm::length(glm::vec2(p.x, p.z)) - largeRadius, p.y)) - smallRadius;
+}
+
+static float Capsule(const glm::vec3& p, const float r, const float c)
+{
+	const float side = glm::length(glm::vec2(p.x, p.z)) - r;
+	const float cap = glm::length(glm::vec3(p.x, glm::abs(p.y) - c, p.z)) - r;
+	return glm::abs(p.y) >= c ? cap : side;
+}
+
+static float Cylinder(const glm::vec3& p, const float r, const float height)
+{
+	return glm::max(glm::length(glm::vec2(p.x, p.z)) - r, glm::abs(p.y) - height);
+}
+
+// ----------------------------------------------------------------------------
+
+float DensityGraph::evaluate(const glm::vec3& position, const std::vector<unsigned char>& permLookup) const
+{
+	// the scalars are stored in x
+	std::vector<glm::vec3> values(nodes_.size());
+	for (int i = 0; i < (int)nodes_.size(); i++)
+	{
+		const Node& node = nodes_[i];
+
+		float a[MAX_OP_ARGS] = { 0.f, 0.f, 0.f, 0.f, 0.f };
+		glm::vec3 v;
+		for (size_t n = 0; n < node.args.size(); n++)
+		{
+			const Operand& operand = node.args[n];
+			a[n] = operand.node == -1 ? operand.value : values[operand.node].x;
+			if (n == 0 && operand.node != -1)
+			{
+				v = values[operand.node];
+			}
+		}
+
+		const glm::vec2 xz(v.x, v.z);
+		glm::vec3& result = values[i];
+		switch (node.op)
+		{
+		case Op_Position:	result = position; break;
+		case Op_Translate:	result = v + glm::vec3(a[1], a[2], a[3]); break;
+		case Op_Scale:		result = v * glm::vec3(a[1], a[2], a[3]); break;
+		case Op_X:			result.x = v.x; break;
+		case Op_Y:			result.x = v.y; break;
+		case Op_Z:			result.x = v.z; break;
+		case Op_Const:		result.x = a[0]; break;
+		case Op_Noise:		result.x = SimplexNoise2(xz, permLookup); break;
+		case Op_Fractal:	result.x = BasicFractal(permLookup, (int)a[1], a[2], a[3], a[4], xz); break;
+		case Op_Ridged:		result.x = RidgedMultiFractal(permLookup, (int)a[1], a[2], a[3], a[4], xz); break;
+		case Op_Sphere:		result.x = glm::length(v) - a[1]; break;
+		case Op_Box:		result.x = Box(v, glm::vec3(a[1], a[2], a[3])); break;
+		case Op_Torus:		result.x = Torus(v, a[1], a[2]); break;
+		case Op_Capsule:	result.x = Capsule(v, a[1], a[2]); break;
+		case Op_Cylinder:	result.x = Cylinder(v, a[1], a[2]); break;
+
+		case Op_RotateY:
+		{
+			const float c = glm::cos(glm::radians(a[1]));
+			const float s = glm::sin(glm::radians(a[1]));
+			result = glm::vec3((v.x * c) + (v.z * s), v.y, (v.z * c) - (v.x * s));
+			break;
+		}
+
+		default:
+			result.x = EvaluateArithmeticOp(node.op, a);
+			break;
+		}
+	}
+
+	return values[output_].x;
+}
+
+// ----------------------------------------------------------------------------
+
@@ -0,0 +1,115 @@
+#ifndef		HAS_DENSITY_GRAPH_H_BEEN_INCLUDED
+#define		HAS_DENSITY_GRAPH_H_BEEN_INCLUDED
+
+#include	<string>
+#include	<vector>
+#include	<glm/glm.hpp>
+
+// ----------------------------------------------------------------------------
+// The terrain's density function described as a small graph loaded from a file
+// rather than the DensityFunc hardcoded in cl/noise.cl. Each line of the file is
+// a node, "<name> <op> <args...>", where the args are numbers or the names of
+// earlier nodes and the last node is the density (negative inside), e.g.
+//
+//		p			position
+//		q			scale p 0.0005
+//		n			fractal q 4 0.24 1.8754 0.433
+//		h			mul n 900
+//		py			y p
+//		density		sub py h
+//
+// The vector ops are position, translate (a domain warp when the offsets are
+// nodes), scale and rotatey. The scalar ops are x, y, z, the arithmetic ops
+// (add sub mul div min max neg abs clamp mix), the blends smin and smax, the
+// noise ops (noise, fractal, ridged, all sampled in XZ) and the hg_sdf primitives
+// (sphere box torus capsule cylinder). See the table in density_graph.cpp for
+// the args, and assets/terrain.dg for the default terrain.
+//
+// The constant nodes are folded when the graph is loaded so neither the generated
+// OpenCL (see generateOpenCL) nor the CPU evaluator do any work for them.
+// ----------------------------------------------------------------------------
+
+class DensityGraph
+{
+public:
+
+	enum Op
+	{
+		Op_Position,
+		Op_Translate,
+		Op_Scale,
+		Op_RotateY,
+		Op_X,
+		Op_Y,
+		Op_Z,
+		Op_Const,
+		Op_Add,
+		Op_Sub,
+		Op_Mul,
+		Op_Div,
+		Op_Min,
+		Op_Max,
+		Op_Neg,
+		Op_Abs,
+		Op_Clamp,
+		Op_Mix,
+		Op_SMin,
+		Op_SMax,
+		Op_Noise,
+		Op_Fractal,
+		Op_Ridged,
+		Op_Sphere,
+		Op_Box,
+		Op_Torus,
+		Op_Capsule,
+		Op_Cylinder,
+		Op_SIZE,
+	};
+
+	// a constant when node is -1
+	struct Operand
+	{
+		int				node = -1;
+		float			value = 0.f;
+	};
+
+	struct Node
+	{
+		std::string				name;
+		Op						op = Op_Const;
+		bool					isVector = false;
+		std::vector<Operand>	args;
+	};
+
+	// returns false (and prints the error) if the file can't be loaded or parsed
+	bool load(const std::string& path);
+	bool parse(const std::string& source, const std::string& sourceName);
+
+	bool empty() const { return nodes_.empty(); }
+
+	// the "float DensityGraph(const float4 position, read_only image2d_t permTexture)"
+	// function, only using the functions already in cl/noise.cl and cl/hg_sdf.glsl
+	std::string generateOpenCL() const;
+
+	// identifies the folded graph (a hash of the generated OpenCL) so the files baked
+	// with one graph aren't loaded with another, 0 for an empty graph
+	u64 hash() const;
+
+	// the CPU version of the generated function, the noise is sampled from the same
+	// permutation lookup as the GPU (see Compute_CreateNoisePermutationLookup). This
+	// walks the nodes for every sample so it's a reference to check the generated
+	// OpenCL against (see test_compute.cpp), not a replacement for the GPU fields
+	float evaluate(const glm::vec3& position, const std::vector<unsigned char>& permLookup) const;
+
+	const std::vector<Node>& nodes() const { return nodes_; }
+
+private:
+
+	void fold();
+
+	std::vector<Node>		nodes_;
+	int						output_ = -1;
+};
+
+#endif	//	HAS_DENSITY_GRAPH_H_BEEN_INCLUDED
+
@@ -4,6 +4,17 @@
 #include <fstream>
 #include <sstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 bool LoadTextFile(const std::string& path, std::string& data)
 {
 	std::ifstream file(path.c_str());
@@ -21,3 +32,171 @@ bool LoadTextFile(const std::string& path, std::string& data)
 	return true; 
 }
 
+// ----------------------------------------------------------------------------
+
+bool LoadBinaryFile(const std::string& path, std::vector<unsigned char>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool success = size > 0;
+	if (success)
+	{
+		data.resize(size);
+		success = fread(&data[0], 1, size, file) == (size_t)size;
+	}
+
+	fclose(file);
+	return success;
+}
+
+// ----------------------------------------------------------------------------
+
+bool SaveBinaryFile(const std::string& path, const void* data, const size_t size)
+{
+	const std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	const bool success = fwrite(data, 1, size, file) == size;
+	fclose(file);
+
+	remove(path.c_str());
+	if (!success || rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool EnsureDirectoryExists(const std::string& path)
+{
+#ifdef _WIN32
+	const DWORD attributes = GetFileAttributesA(path.c_str());
+	if (attributes != INVALID_FILE_ATTRIBUTES)
+	{
+		return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	}
+
+	return _mkdir(path.c_str()) == 0;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) == 0)
+	{
+		return S_ISDIR(info.st_mode);
+	}
+
+	return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle_ = file;
+	mappingHandle_ = mapping;
+	data_ = (const uint8_t*)view;
+	size_ = fileSize.QuadPart;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	fd_ = fd;
+	data_ = (const uint8_t*)view;
+	size_ = info.st_size;
+#endif
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void MappedFile::close()
+{
+	if (!data_)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle(mappingHandle_);
+	CloseHandle(fileHandle_);
+	mappingHandle_ = nullptr;
+	fileHandle_ = nullptr;
+#else
+	munmap((void*)data_, size_);
+	::close(fd_);
+	fd_ = -1;
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+
@@ -2,8 +2,52 @@
 #define		__FILE_UTILS_H__
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 bool LoadTextFile(const std::string& path, std::string& data);
 
+bool LoadBinaryFile(const std::string& path, std::vector<unsigned char>& data);
+
+// writes to a temporary file first so a partially written file is never seen
+bool SaveBinaryFile(const std::string& path, const void* data, const size_t size);
+
+// only creates the last directory in the path, the parent must exist
+bool EnsureDirectoryExists(const std::string& path);
+
+// ----------------------------------------------------------------------------
+
+// Read-only memory mapping of a whole file, pages are only faulted in when
+// they are touched so large files can be opened without reading them
+class MappedFile
+{
+public:
+
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return data_ != nullptr; }
+	const uint8_t* data() const { return data_; }
+	uint64_t size() const { return size_; }
+
+private:
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const uint8_t*		data_ = nullptr;
+	uint64_t			size_ = 0;
+
+#ifdef _WIN32
+	void*				fileHandle_ = nullptr;
+	void*				mappingHandle_ = nullptr;
+#else
+	int					fd_ = -1;
+#endif
+};
+
 #endif	//	__FILE_UTILS_H__
 
@@ -24,6 +24,7 @@
 #include	"timer.h"
 #include	"materials.h"
 #include	"gui.h"
+#include	"clipmap.h"
 
 Config g_config;
 
@@ -416,18 +417,34 @@ int main(int argc, char** argv)
 	const vec3 cameraStartPosition(0.f, 3000.f, 0.f);
 	Camera_SetPosition(cameraStartPosition);
 
-	const int error = Compute_Initialise(guiOptions.noiseSeed, 0, 2);
+	Compute_SetDeviceSelection(g_config.computeDevices);
+	const int error = Compute_Initialise(guiOptions.noiseSeed, 0);
 	if (error)
 	{
 		printf("Compute_Initialise: a fatal error occured: %d\n", error);
 		return EXIT_FAILURE;
 	}
 
+	Compute_SetSpillOptions(g_config.spillBudgetMB, g_config.spillFile);
+	Compute_SetCollapseOptions(g_config.meshCollapseMaxError);
+	Compute_SetMeshExtractors(g_config.meshExtractors);
+
+	if (Compute_SetDensityGraph(g_config.densityGraph))
+	{
+		printf("Unable to load the density graph '%s', using the default terrain\n", g_config.densityGraph.c_str());
+	}
+
+	if (!Clipmap_SetConfig(g_config.lodVoxelsPerChunk, g_config.lodActiveDistances))
+	{
+		printf("Invalid LOD config, using the defaults\n");
+	}
+
 	// use a wider FOV for the culling so clipmap nodes just offscreen are still selected
 	glm::mat4 volumeProjection = glm::perspective(90.f, 
 		viewParams.aspectRatio, viewParams.nearDistance, viewParams.farDistance);
 
-	Viewer_Initialise(guiOptions.worldBrickCountXZ, volumeProjection, materials.size());
+	Viewer_Initialise(guiOptions.worldBrickCountXZ, volumeProjection, materials.size(), 
+		guiOptions.noiseSeed, g_config.worldFile, g_config.meshPack);
 	GUI_Initialise(window);
 
 	printf("----------------------------------------------------------\n");
@@ -590,7 +607,8 @@ int main(int argc, char** argv)
 			}
 			
 //			Camera_SetPosition(cameraStartPosition);
-			Viewer_Initialise(guiOptions.worldBrickCountXZ, volumeProjection, materials.size());
+			Viewer_Initialise(guiOptions.worldBrickCountXZ, volumeProjection, materials.size(), 
+				guiOptions.noiseSeed, g_config.worldFile, g_config.meshPack);
 		}
 	}
 
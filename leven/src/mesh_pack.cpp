@@ -0,0 +1,288 @@
+#include	"mesh_pack.h"
+
+#include	<algorithm>
+
+// ----------------------------------------------------------------------------
+
+static uint64_t SpreadBits(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | (x << 32)) & 0x1f00000000ffffULL;
+	x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+	x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+	x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+	x = (x | (x << 2)) & 0x1249249249249249ULL;
+	return x;
+}
+
+// ----------------------------------------------------------------------------
+
+uint64_t MeshPack_NodeKey(const glm::ivec3& rootMin, const glm::ivec3& min, const int size)
+{
+	const glm::ivec3 p = (min - rootMin) / size;
+	const uint64_t morton = SpreadBits(p.x) | (SpreadBits(p.y) << 1) | (SpreadBits(p.z) << 2);
+
+	// the node sizes are powers of two so the log2 fits in the top bits, the node coords
+	// inside the root are far below 2^19 so the Morton code fits in the remaining bits
+	return ((uint64_t)glm::log2(size) << 58) | (morton & ((1ULL << 58) - 1));
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshPack::open(
+	const std::string& path, 
+	const int noiseSeed, 
+	const u64 densityGraphHash, 
+	const glm::ivec3& rootMin, 
+	const int rootSize)
+{
+	close();
+
+	if (!mapping_.open(path))
+	{
+		printf("MeshPack: unable to open '%s'\n", path.c_str());
+		return false;
+	}
+
+	const MeshPackHeader* header = (const MeshPackHeader*)mapping_.data();
+	if (mapping_.size() < sizeof(MeshPackHeader) ||
+		header->magic != MESH_PACK_MAGIC || header->version != MESH_PACK_VERSION)
+	{
+		printf("MeshPack: '%s' is not a valid mesh pack\n", path.c_str());
+		mapping_.close();
+		return false;
+	}
+
+	if (header->noiseSeed != noiseSeed || header->densityGraphHash != densityGraphHash || header->rootSize != rootSize ||
+		header->rootMin[0] != rootMin.x || header->rootMin[1] != rootMin.y || header->rootMin[2] != rootMin.z)
+	{
+		printf("MeshPack: '%s' was baked for a different world (seed %d, graph %016llx), ignoring\n", 
+			path.c_str(), header->noiseSeed, (unsigned long long)header->densityGraphHash);
+		mapping_.close();
+		return false;
+	}
+
+	if ((header->indexOffset + (header->numNodes * sizeof(MeshPackNode))) > mapping_.size())
+	{
+		printf("MeshPack: '%s' is truncated\n", path.c_str());
+		mapping_.close();
+		return false;
+	}
+
+	header_ = header;
+	index_ = (const MeshPackNode*)(mapping_.data() + header_->indexOffset);
+	printf("MeshPack: opened '%s' nodes=%d\n", path.c_str(), header_->numNodes);
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void MeshPack::close()
+{
+	header_ = nullptr;
+	index_ = nullptr;
+	mapping_.close();
+}
+
+// ----------------------------------------------------------------------------
+
+const MeshPackNode* MeshPack::findNode(const glm::ivec3& min, const int size) const
+{
+	if (!header_ || header_->numNodes == 0)
+	{
+		return nullptr;
+	}
+
+	const glm::ivec3 rootMin(header_->rootMin[0], header_->rootMin[1], header_->rootMin[2]);
+	const uint64_t key = MeshPack_NodeKey(rootMin, min, size);
+
+	const MeshPackNode* first = index_;
+	const MeshPackNode* last = index_ + header_->numNodes;
+	const MeshPackNode* iter = std::lower_bound(first, last, key,
+		[](const MeshPackNode& node, const uint64_t key)
+		{
+			return node.key < key;
+		});
+
+	if (iter == last || iter->key != key)
+	{
+		return nullptr;
+	}
+
+	return iter;
+}
+
+// ----------------------------------------------------------------------------
+
+const MeshVertex* MeshPack::vertices(const MeshPackNode* node) const
+{
+	return (const MeshVertex*)(mapping_.data() + node->verticesOffset);
+}
+
+// ----------------------------------------------------------------------------
+
+const MeshTriangle* MeshPack::triangles(const MeshPackNode* node) const
+{
+	return (const MeshTriangle*)(mapping_.data() + node->trianglesOffset);
+}
+
+// ----------------------------------------------------------------------------
+
+const SeamNodeInfo* MeshPack::seamNodes(const MeshPackNode* node) const
+{
+	return (const SeamNodeInfo*)(mapping_.data() + node->seamNodesOffset);
+}
+
+// ----------------------------------------------------------------------------
+
+static uint64_t AlignOffset(const uint64_t offset)
+{
+	return (offset + (MESH_PACK_ALIGNMENT - 1)) & ~(MESH_PACK_ALIGNMENT - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+MeshPackWriter::~MeshPackWriter()
+{
+	if (file_)
+	{
+		// never finished so the file is incomplete
+		fclose(file_);
+		remove(path_.c_str());
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshPackWriter::open(
+	const std::string& path,
+	const int noiseSeed,
+	const u64 densityGraphHash,
+	const glm::ivec3& rootMin,
+	const int rootSize)
+{
+	path_ = path;
+	file_ = fopen(path.c_str(), "wb");
+	if (!file_)
+	{
+		printf("MeshPack: unable to open '%s' for writing\n", path.c_str());
+		return false;
+	}
+
+	header_ = MeshPackHeader();
+	header_.noiseSeed = noiseSeed;
+	header_.densityGraphHash = densityGraphHash;
+	header_.rootMin[0] = rootMin.x;
+	header_.rootMin[1] = rootMin.y;
+	header_.rootMin[2] = rootMin.z;
+	header_.rootSize = rootSize;
+
+	// the header is written again once the index offset is known
+	fileOffset_ = 0;
+	index_.clear();
+	return write(0, &header_, sizeof(header_));
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshPackWriter::write(const uint64_t offset, const void* data, const uint64_t size)
+{
+	static const char zeros[MESH_PACK_ALIGNMENT] = { 0 };
+
+	while (fileOffset_ < offset)
+	{
+		const uint64_t padding = std::min<uint64_t>(offset - fileOffset_, MESH_PACK_ALIGNMENT);
+		if (fwrite(zeros, 1, padding, file_) != padding)
+		{
+			return false;
+		}
+
+		fileOffset_ += padding;
+	}
+
+	if (size > 0 && fwrite(data, 1, size, file_) != size)
+	{
+		return false;
+	}
+
+	fileOffset_ += size;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshPackWriter::addNode(
+	const glm::ivec3& min,
+	const int size,
+	const int voxelsPerChunk,
+	const MeshBuffer* meshBuffer,
+	const std::vector<SeamNodeInfo>& seamNodes)
+{
+	const int numVertices = meshBuffer ? meshBuffer->numVertices : 0;
+	const int numTriangles = meshBuffer ? meshBuffer->numTriangles : 0;
+	if ((numVertices == 0 || numTriangles == 0) && seamNodes.empty())
+	{
+		return true;
+	}
+
+	const glm::ivec3 rootMin(header_.rootMin[0], header_.rootMin[1], header_.rootMin[2]);
+
+	MeshPackNode node;
+	node.key = MeshPack_NodeKey(rootMin, min, size);
+	node.min[0] = min.x;
+	node.min[1] = min.y;
+	node.min[2] = min.z;
+	node.size = size;
+	node.voxelsPerChunk = voxelsPerChunk;
+	node.numVertices = numTriangles > 0 ? numVertices : 0;
+	node.numTriangles = numVertices > 0 ? numTriangles : 0;
+	node.numSeamNodes = seamNodes.size();
+	node.verticesOffset = AlignOffset(fileOffset_);
+	node.trianglesOffset = node.verticesOffset + (node.numVertices * sizeof(MeshVertex));
+	node.seamNodesOffset = node.trianglesOffset + (node.numTriangles * sizeof(MeshTriangle));
+
+	const bool success =
+		write(node.verticesOffset, node.numVertices ? &meshBuffer->vertices[0] : nullptr, node.numVertices * sizeof(MeshVertex)) &&
+		write(node.trianglesOffset, node.numTriangles ? &meshBuffer->triangles[0] : nullptr, node.numTriangles * sizeof(MeshTriangle)) &&
+		write(node.seamNodesOffset, seamNodes.empty() ? nullptr : &seamNodes[0], seamNodes.size() * sizeof(SeamNodeInfo));
+	if (!success)
+	{
+		printf("MeshPack: error writing '%s'\n", path_.c_str());
+		return false;
+	}
+
+	index_.push_back(node);
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshPackWriter::finish()
+{
+	std::sort(begin(index_), end(index_),
+		[](const MeshPackNode& a, const MeshPackNode& b)
+		{
+			return a.key < b.key;
+		});
+
+	header_.numNodes = index_.size();
+	header_.indexOffset = AlignOffset(fileOffset_);
+
+	bool success = write(header_.indexOffset, index_.empty() ? nullptr : &index_[0], index_.size() * sizeof(MeshPackNode));
+	success = success && fseek(file_, 0, SEEK_SET) == 0 && fwrite(&header_, sizeof(header_), 1, file_) == 1;
+
+	fclose(file_);
+	file_ = nullptr;
+
+	if (!success)
+	{
+		printf("MeshPack: error writing '%s'\n", path_.c_str());
+		remove(path_.c_str());
+	}
+
+	return success;
+}
+
+// ----------------------------------------------------------------------------
+
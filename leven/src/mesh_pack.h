@@ -0,0 +1,128 @@
+#ifndef		HAS_MESH_PACK_H_BEEN_INCLUDED
+#define		HAS_MESH_PACK_H_BEEN_INCLUDED
+
+#include	"compute.h"
+#include	"file_utils.h"
+#include	"render_types.h"
+
+#include	<stdio.h>
+#include	<string>
+#include	<vector>
+#include	<glm/glm.hpp>
+
+// ----------------------------------------------------------------------------
+// The mesh pack holds the simplified clipmap node meshes and seam nodes for every
+// LOD of a world, generated offline by leven_bake (see bake_main.cpp). The file
+// is memory mapped by the clipmap and the node data is read straight from the
+// mapping so streaming the world in is only I/O:
+//
+//		MeshPackHeader
+//		node data						vertices, triangles and seam nodes, page aligned per node
+//		MeshPackNode[numNodes]			index, sorted by MeshPack_NodeKey
+//
+// Nodes with no mesh and no seam nodes are not stored, so any node inside the
+// pack's root node which is missing from the index is empty.
+// ----------------------------------------------------------------------------
+
+const uint32_t MESH_PACK_MAGIC = 0x504d564c;		// "LVMP"
+const uint32_t MESH_PACK_VERSION = 3;		// 3: density graph hash
+const uint64_t MESH_PACK_ALIGNMENT = 4096;
+
+struct MeshPackHeader
+{
+	uint32_t		magic = MESH_PACK_MAGIC;
+	uint32_t		version = MESH_PACK_VERSION;
+	int32_t			noiseSeed = 0;
+	int32_t			rootMin[3];
+	int32_t			rootSize = 0;
+	uint32_t		numNodes = 0;
+	uint64_t		indexOffset = 0;
+	uint64_t		densityGraphHash = 0;	// see Compute_DensityGraphHash
+};
+
+struct MeshPackNode
+{
+	uint64_t		key = 0;
+	int32_t			min[3];
+	int32_t			size = 0;
+	uint32_t		numVertices = 0;
+	uint32_t		numTriangles = 0;
+	uint32_t		numSeamNodes = 0;
+	int32_t			voxelsPerChunk = 0;		// the LODs can be baked at different resolutions
+	uint64_t		verticesOffset = 0;
+	uint64_t		trianglesOffset = 0;
+	uint64_t		seamNodesOffset = 0;
+};
+
+// orders the nodes by size and then along a Morton curve so neighbouring nodes
+// of the same LOD are close together in the file
+uint64_t MeshPack_NodeKey(const glm::ivec3& rootMin, const glm::ivec3& min, const int size);
+
+// ----------------------------------------------------------------------------
+
+class MeshPack
+{
+public:
+
+	bool open(
+		const std::string& path, 
+		const int noiseSeed, 
+		const u64 densityGraphHash, 
+		const glm::ivec3& rootMin, 
+		const int rootSize);
+	void close();
+
+	bool isOpen() const { return header_ != nullptr; }
+
+	const MeshPackNode* findNode(const glm::ivec3& min, const int size) const;
+
+	const MeshVertex* vertices(const MeshPackNode* node) const;
+	const MeshTriangle* triangles(const MeshPackNode* node) const;
+	const SeamNodeInfo* seamNodes(const MeshPackNode* node) const;
+
+private:
+
+	MappedFile				mapping_;
+	const MeshPackHeader*	header_ = nullptr;
+	const MeshPackNode*		index_ = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+
+// the nodes can be added in any order, the index is sorted when the pack is finished
+class MeshPackWriter
+{
+public:
+
+	~MeshPackWriter();
+
+	bool open(
+		const std::string& path,
+		const int noiseSeed,
+		const u64 densityGraphHash,
+		const glm::ivec3& rootMin,
+		const int rootSize);
+
+	bool addNode(
+		const glm::ivec3& min,
+		const int size,
+		const int voxelsPerChunk,
+		const MeshBuffer* meshBuffer,
+		const std::vector<SeamNodeInfo>& seamNodes);
+
+	bool finish();
+
+	int numNodes() const { return index_.size(); }
+
+private:
+
+	bool write(const uint64_t offset, const void* data, const uint64_t size);
+
+	std::string					path_;
+	FILE*						file_ = nullptr;
+	uint64_t					fileOffset_ = 0;
+	MeshPackHeader				header_;
+	std::vector<MeshPackNode>	index_;
+};
+
+#endif	//	HAS_MESH_PACK_H_BEEN_INCLUDED
@@ -438,27 +438,15 @@ static void CompactVertices(
 
 // ----------------------------------------------------------------------------
 
-void ngMeshSimplifier(
+// the vertices are relative to worldSpaceOffset, the simplified mesh is written to
+// the buffer which must be able to hold the input mesh
+static void SimplifyMesh(
+	LinearBuffer<MeshVertex>& vertices,
+	LinearBuffer<MeshTriangle>& triangles,
 	MeshBuffer* mesh,
 	const vec4& worldSpaceOffset,
 	const MeshSimplificationOptions& options)
 {
-	if (mesh->numTriangles < 100 || mesh->numVertices < 100)
-	{
-		return;
-	}
-
-	LinearBuffer<MeshVertex> vertices(mesh->numVertices);
-	vertices.copy(&mesh->vertices[0], mesh->numVertices);
-
-	LinearBuffer<MeshTriangle> triangles(mesh->numTriangles);
-	triangles.copy(&mesh->triangles[0], mesh->numTriangles);
-
-	for (MeshVertex& v: vertices)
-	{
-		v.xyz -= worldSpaceOffset;
-	}
-
 	mesh->numVertices = 0;
 	mesh->numTriangles = 0;
 
@@ -538,3 +526,73 @@ void ngMeshSimplifier(
 	}
 }
 
+// ----------------------------------------------------------------------------
+
+void ngMeshSimplifier(
+	MeshBuffer* mesh,
+	const vec4& worldSpaceOffset,
+	const MeshSimplificationOptions& options)
+{
+	if (mesh->numTriangles < 100 || mesh->numVertices < 100)
+	{
+		return;
+	}
+
+	LinearBuffer<MeshVertex> vertices(mesh->numVertices);
+	vertices.copy(&mesh->vertices[0], mesh->numVertices);
+
+	LinearBuffer<MeshTriangle> triangles(mesh->numTriangles);
+	triangles.copy(&mesh->triangles[0], mesh->numTriangles);
+
+	for (MeshVertex& v: vertices)
+	{
+		v.xyz -= worldSpaceOffset;
+	}
+
+	SimplifyMesh(vertices, triangles, mesh, worldSpaceOffset, options);
+}
+
+// ----------------------------------------------------------------------------
+
+void ngMeshSimplifier(
+	const PackedMeshVertex* packedVertices,
+	const int numVertices,
+	const PackedMeshBounds& bounds,
+	const MeshTriangle* packedTriangles,
+	const int numTriangles,
+	MeshBuffer* mesh,
+	const vec4& worldSpaceOffset,
+	const MeshSimplificationOptions& options)
+{
+	// the previous contents aren't kept so the resize doesn't copy them
+	mesh->numVertices = 0;
+	mesh->numTriangles = 0;
+	mesh->reserve(numVertices, numTriangles);
+
+	if (numTriangles < 100 || numVertices < 100)
+	{
+		for (int i = 0; i < numVertices; i++)
+		{
+			mesh->vertices[i] = UnpackMeshVertex(packedVertices[i], bounds);
+		}
+
+		std::copy(packedTriangles, packedTriangles + numTriangles, mesh->triangles);
+		mesh->numVertices = numVertices;
+		mesh->numTriangles = numTriangles;
+		return;
+	}
+
+	// the working copies are filled straight from the source, which is only read
+	LinearBuffer<MeshVertex> vertices(numVertices);
+	for (int i = 0; i < numVertices; i++)
+	{
+		MeshVertex v = UnpackMeshVertex(packedVertices[i], bounds);
+		v.xyz -= worldSpaceOffset;
+		vertices.push_back(v);
+	}
+
+	LinearBuffer<MeshTriangle> triangles(numTriangles);
+	triangles.copy(packedTriangles, numTriangles);
+
+	SimplifyMesh(vertices, triangles, mesh, worldSpaceOffset, options);
+}
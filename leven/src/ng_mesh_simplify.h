@@ -34,5 +34,17 @@ void ngMeshSimplifier(
 	const vec4& worldSpaceOffset,
 	const MeshSimplificationOptions& options);
 
+// as above for a read only packed mesh (e.g. the chunk mesh readback, see ChunkMeshData),
+// the result is written to the mesh buffer which is grown as needed
+void ngMeshSimplifier(
+	const PackedMeshVertex* vertices,
+	const int numVertices,
+	const PackedMeshBounds& bounds,
+	const MeshTriangle* triangles,
+	const int numTriangles,
+	MeshBuffer* mesh,
+	const vec4& worldSpaceOffset,
+	const MeshSimplificationOptions& options);
+
 #endif	//	HAS_MESH_SIMPLIFY_H_BEEN_INCUDED
 
@@ -13,6 +13,7 @@
 #include	<algorithm>
 #include	<unordered_map>
 #include	<glm/ext.hpp>
+#include	<glm/gtx/integer.hpp>
 
 using		glm::ivec3;
 using		glm::vec3;
@@ -25,64 +26,69 @@ uint64_t HashOctreeMin(const ivec3& min)
 	return min.x | ((uint64_t)min.y << 20) | ((uint64_t)min.z << 40);
 }
 
+// ----------------------------------------------------------------------------
+// The octree is built bottom up one level at a time. Each level's nodes are kept
+// sorted by their Morton code relative to the root, so the children of a parent are
+// always adjacent and the parents come out in Morton order too: a single pass per
+// level creates the parents, and merging them with the input nodes of the parents'
+// size gives the next level.
+// ----------------------------------------------------------------------------
+
+struct LinearOctreeNode
+{
+	uint64_t		code;			// the Morton code of the node's min at its level
+	OctreeNode*		node;
+};
+
+// ----------------------------------------------------------------------------
+
+static uint64_t SpreadBits(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | (x << 32)) & 0x1f00000000ffffULL;
+	x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+	x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+	x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+	x = (x | (x << 2)) & 0x1249249249249249ULL;
+	return x;
+}
+
 // ----------------------------------------------------------------------------
 
-std::vector<OctreeNode*> ConstructParents(
+// the low 3 bits are the child index, i.e. match CHILD_MIN_OFFSETS
+static uint64_t MortonCode(const ivec3& p)
+{
+	return SpreadBits(p.z) | (SpreadBits(p.y) << 1) | (SpreadBits(p.x) << 2);
+}
+
+// ----------------------------------------------------------------------------
+
+static void ConstructParents(
 	Octree* octree,
-	const std::vector<OctreeNode*>& nodes, 
+	const std::vector<LinearOctreeNode>& nodes, 
 	const int parentSize, 
-	const ivec3& rootMin
-	)
+	const ivec3& rootMin,
+	std::vector<LinearOctreeNode>& parents)
 {
-	std::unordered_map<uint64_t, OctreeNode*> parentsHashmap;
-
-	std::for_each(begin(nodes), end(nodes), [&](OctreeNode* node)
+	parents.clear();
+	for (const LinearOctreeNode& n: nodes)
 	{
-		// because the octree is regular we can calculate the parent min
-		const ivec3 localPos = (node->min - rootMin);
-		const ivec3 parentPos = node->min - (localPos % parentSize);
-		
-		const uint64_t parentIndex = HashOctreeMin(parentPos - rootMin);
-		OctreeNode* parentNode = nullptr;
-
-		auto iter =  parentsHashmap.find(parentIndex);
-		if (iter == end(parentsHashmap))
+		const uint64_t parentCode = n.code >> 3;
+		if (parents.empty() || parents.back().code != parentCode)
 		{
-			parentNode = octree->allocNode();
+			const ivec3 localPos = (n.node->min - rootMin);
+
+			OctreeNode* parentNode = octree->allocNode();
 			parentNode->type = Node_Internal;
-			parentNode->min = parentPos;
+			parentNode->min = n.node->min - (localPos % parentSize);
 			parentNode->size = parentSize;
 
-			parentsHashmap.insert(std::pair<uint64_t, OctreeNode*>(parentIndex, parentNode));
-		}
-		else
-		{
-			parentNode = iter->second;
+			LinearOctreeNode parent = { parentCode, parentNode };
+			parents.push_back(parent);
 		}
 
-		bool foundParentNode = false;
-		for (int i = 0; i < 8; i++)
-		{
-			const ivec3 childPos = parentPos + ((parentSize / 2) * CHILD_MIN_OFFSETS[i]);
-			if (childPos == node->min)
-			{
-//				LVN_ALWAYS_ASSERT("Duplicate node", parentNode->children[i] == nullptr);
-				parentNode->children[i] = node;
-				foundParentNode = true;
-				break;
-			}
-		}
-
-		LVN_ALWAYS_ASSERT("No parent node found", foundParentNode);
-	});
-
-	std::vector<OctreeNode*> parents;
-	std::for_each(begin(parentsHashmap), end(parentsHashmap), [&](std::pair<uint64_t, OctreeNode*> pair)
-	{
-		parents.push_back(pair.second);
-	});
-
-	return parents;
+		parents.back().node->children[n.code & 7] = n.node;
+	}
 }
 
 // ----------------------------------------------------------------------------
@@ -99,44 +105,46 @@ OctreeNode* Octree_ConstructUpwards(
 		return nullptr;
 	}
 
-	std::vector<OctreeNode*> nodes(begin(inputNodes), end(inputNodes));
-	std::sort(begin(nodes), end(nodes), 
-		[](OctreeNode*& lhs, OctreeNode*& rhs)
-		{
-			return lhs->size < rhs->size;
-		});
-
-	// the input nodes may be different sizes if a seam octree is being constructed
-	// in that case we need to process the input nodes in stages along with the newly
-	// constructed parent nodes until the all the nodes have the same size
-	while (nodes.front()->size != nodes.back()->size)
-	{
-		// find the end of this run
-		auto iter = begin(nodes);
-		int size = (*iter)->size;
-		do
-		{
-			++iter;
-		} while ((*iter)->size == size);
+	// the input nodes may be different sizes if a seam octree is being constructed,
+	// the levels are relative to the smallest
+	int minSize = rootNodeSize;
+	for (const OctreeNode* node: inputNodes)
+	{
+		minSize = glm::min(minSize, node->size);
+	}
 
-		// construct the new parent nodes for this run
-		std::vector<OctreeNode*> newNodes(begin(nodes), iter);
-		newNodes = ConstructParents(octree, newNodes, size * 2, rootMin);
+	const int numLevels = glm::log2(rootNodeSize / minSize) + 1;
+	std::vector<std::vector<LinearOctreeNode>> inputLevels(numLevels);
+	for (OctreeNode* node: inputNodes)
+	{
+		const int level = glm::log2(node->size / minSize);
+		const LinearOctreeNode n = { MortonCode((node->min - rootMin) / node->size), node };
+		inputLevels[level].push_back(n);
+	}
 
-		// set up for the next iteration: the parents produced plus any remaining input nodes
-		newNodes.insert(end(newNodes), iter, end(nodes));
-		std::swap(nodes, newNodes);
+	const auto compareCodes = [](const LinearOctreeNode& lhs, const LinearOctreeNode& rhs)
+	{
+		return lhs.code < rhs.code;
+	};
+
+	for (auto& level: inputLevels)
+	{
+		std::sort(begin(level), end(level), compareCodes);
 	}
 
-	int parentSize = nodes.front()->size * 2;
-	while (parentSize <= rootNodeSize)
+	std::vector<LinearOctreeNode> nodes, parents;
+	nodes.swap(inputLevels[0]);
+	for (int level = 1; level < numLevels; level++)
 	{
-		nodes = ConstructParents(octree, nodes, parentSize, rootMin);
-		parentSize *= 2;
+		ConstructParents(octree, nodes, minSize << level, rootMin, parents);
+
+		nodes.resize(parents.size() + inputLevels[level].size());
+		std::merge(begin(parents), end(parents), begin(inputLevels[level]), end(inputLevels[level]), 
+			begin(nodes), compareCodes);
 	}
 
 	LVN_ALWAYS_ASSERT("There can be only one! (root node)", nodes.size() == 1);
-	OctreeNode* root = nodes.front();
+	OctreeNode* root = nodes.front().node;
 	LVN_ASSERT(root);
 
 	LVN_ASSERT(root->min.x == rootMin.x);
@@ -223,6 +231,7 @@ void GenerateVertexIndices(OctreeNode*& node, const vec3& colour, MeshBuffer* bu
 			exit(EXIT_FAILURE);
 		}
 
+		buffer->reserve(buffer->numVertices + 1, 0);
 		d->index = buffer->numVertices;
 		buffer->vertices[buffer->numVertices++] = 
 			MeshVertex(vec4(d->position, 0.f), vec4(d->averageNormal, 0.f), 
@@ -268,6 +277,7 @@ void ContourProcessEdge(OctreeNode* node[4], int dir, MeshBuffer* buffer)
 		return;
 	}
 
+	buffer->reserve(0, buffer->numTriangles + 2);
 	if (!flip)
 	{
 		buffer->triangles[buffer->numTriangles++] = MeshTriangle(indices[0], indices[1], indices[3]);
@@ -521,16 +531,14 @@ MeshBuffer* Octree_GenerateMesh(
 		return nullptr;
 	}
 
-	MeshBuffer* buffer = Render_AllocMeshBuffer("octree");
+	// grown as the vertices and triangles are added
+	MeshBuffer* buffer = Render_AllocMeshBuffer("octree", 0, 0);
 	if (!buffer)
 	{
 		printf("Error! Could not allocate mesh buffer\n");
 		return nullptr;
 	}
 
-	buffer->numTriangles = 0;
-	buffer->numVertices = 0;
-
 	GenerateVertexIndices(root, colour, buffer);
 	ContourCellProc(root, buffer);
 
@@ -146,7 +146,7 @@ RenderMesh* CreateSkyBoxMesh()
 		0.f, 1.f, 0.f, 
 	};
 
-	MeshBuffer* buffer = Render_AllocMeshBuffer("skybox");
+	MeshBuffer* buffer = Render_AllocMeshBuffer("skybox", 24, 12);
 	buffer->numTriangles = 12;
 	buffer->numVertices = 24;
 
@@ -169,7 +169,7 @@ RenderMesh* CreateSkyBoxMesh()
 	RenderMesh* mesh = new RenderMesh;
 	mesh->uploadData(MeshBuffer::initialiseVertexArray, 
 		sizeof(MeshVertex), buffer->numVertices, buffer->vertices, 
-		buffer->numTriangles * 3, buffer->triangles);
+		buffer->numTriangles * 3, buffer->triangles, GL_UNSIGNED_INT);
 
 	Render_FreeMeshBuffer(buffer);
 
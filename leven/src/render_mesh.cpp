@@ -4,6 +4,9 @@
 #include	"pool_allocator.h"
 
 #include	<mutex>
+#include	<algorithm>
+#include	<cfloat>
+#include	<cstddef>
 #include	<unordered_set>
 #include	<Remotery.h>
 
@@ -19,6 +22,94 @@ std::mutex g_meshBufferMutex;
 
 // ----------------------------------------------------------------------------
 
+// The mesh buffer arrays are allocated in power of 2 size classes, the freed arrays 
+// are kept on a list per class for the next buffer of that size. Most of the chunk 
+// and seam meshes are small so this keeps the buffers close to the mesh sizes while 
+// avoiding a heap allocation for each mesh. The lists are capped by their total size
+// rather than a count per class as a few large freed arrays outweigh many small ones.
+template <typename T>
+class MeshArrayAllocator
+{
+public:
+
+	T* alloc(const int count, int& capacity)
+	{
+		const int sizeClass = glm::max(MIN_SIZE_CLASS, SizeClass(count));
+		capacity = 1 << sizeClass;
+
+		std::vector<T*>& freeList = freeLists_[sizeClass];
+		if (!freeList.empty())
+		{
+			T* array = freeList.back();
+			freeList.pop_back();
+			freeBytes_ -= capacity * sizeof(T);
+			return array;
+		}
+
+		return new T[capacity];
+	}
+
+	void free(T* array, const int capacity)
+	{
+		if (!array)
+		{
+			return;
+		}
+
+		const size_t size = capacity * sizeof(T);
+		if ((freeBytes_ + size) <= MAX_FREE_BYTES)
+		{
+			freeLists_[SizeClass(capacity)].push_back(array);
+			freeBytes_ += size;
+		}
+		else
+		{
+			delete[] array;
+		}
+	}
+
+	void clear()
+	{
+		for (std::vector<T*>& freeList: freeLists_)
+		{
+			for (T* array: freeList)
+			{
+				delete[] array;
+			}
+
+			freeList.clear();
+		}
+
+		freeBytes_ = 0;
+	}
+
+private:
+
+	static const int MIN_SIZE_CLASS = 6;			// i.e. 64 elements
+	static const int NUM_SIZE_CLASSES = 31;
+	static const size_t MAX_FREE_BYTES = 32 * 1024 * 1024;
+
+	static int SizeClass(const int count)
+	{
+		int sizeClass = 0;
+		while ((1 << sizeClass) < count)
+		{
+			sizeClass++;
+		}
+
+		return sizeClass;
+	}
+
+	std::vector<T*>		freeLists_[NUM_SIZE_CLASSES];
+	size_t				freeBytes_ = 0;
+};
+
+MeshArrayAllocator<MeshVertex> g_meshVertexAlloc;
+MeshArrayAllocator<MeshTriangle> g_meshTriangleAlloc;
+std::mutex g_meshArrayMutex;
+
+// ----------------------------------------------------------------------------
+
 void InitialiseRenderMesh()
 {
 	g_renderMeshAlloc.initialise(MAX_RENDER_MESH);
@@ -33,6 +124,8 @@ void InitialiseRenderMesh()
 void DestroyRenderMesh()
 {
 	g_meshBufferAlloc.clear();
+	g_meshVertexAlloc.clear();
+	g_meshTriangleAlloc.clear();
 
 	for (RenderMesh* mesh: g_activeMeshes)
 	{
@@ -47,17 +140,24 @@ void DestroyRenderMesh()
 
 // ----------------------------------------------------------------------------
 
-MeshBuffer* Render_AllocMeshBuffer(const char* const tag)
+MeshBuffer* Render_AllocMeshBuffer(const char* const tag, const int maxVertices, const int maxTriangles)
 {
-	std::lock_guard<std::mutex> lock(g_meshBufferMutex);
-	MeshBuffer* b = g_meshBufferAlloc.alloc();
+	MeshBuffer* b = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(g_meshBufferMutex);
+		b = g_meshBufferAlloc.alloc();
+	}
+
 	if (!b)
 	{
 		printf("Error! Could not alloc mesh buffer\n");
 		return nullptr;
 	}
 
+	// the pool's free list overwrites the buffer
+	*b = MeshBuffer();
 	b->tag = tag;
+	b->reserve(maxVertices, maxTriangles);
 	return b;
 }
 
@@ -65,12 +165,68 @@ MeshBuffer* Render_AllocMeshBuffer(const char* const tag)
 
 void Render_FreeMeshBuffer(MeshBuffer* buffer)
 {
+	if (!buffer)
+	{
+		return;
+	}
+
+	buffer->release();
+
 	std::lock_guard<std::mutex> lock(g_meshBufferMutex);
 	g_meshBufferAlloc.free(buffer);
 }
 
 // ----------------------------------------------------------------------------
 
+void MeshBuffer::reserve(const int maxVertices, const int maxTriangles)
+{
+	if (maxVertices <= vertexCapacity && maxTriangles <= triangleCapacity)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_meshArrayMutex);
+	if (maxVertices > vertexCapacity)
+	{
+		int capacity = 0;
+		MeshVertex* array = g_meshVertexAlloc.alloc(maxVertices, capacity);
+		std::copy(vertices, vertices + numVertices, array);
+		g_meshVertexAlloc.free(vertices, vertexCapacity);
+
+		vertices = array;
+		vertexCapacity = capacity;
+	}
+
+	if (maxTriangles > triangleCapacity)
+	{
+		int capacity = 0;
+		MeshTriangle* array = g_meshTriangleAlloc.alloc(maxTriangles, capacity);
+		std::copy(triangles, triangles + numTriangles, array);
+		g_meshTriangleAlloc.free(triangles, triangleCapacity);
+
+		triangles = array;
+		triangleCapacity = capacity;
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+void MeshBuffer::release()
+{
+	{
+		std::lock_guard<std::mutex> lock(g_meshArrayMutex);
+		g_meshVertexAlloc.free(vertices, vertexCapacity);
+		g_meshTriangleAlloc.free(triangles, triangleCapacity);
+	}
+
+	vertices = nullptr;
+	triangles = nullptr;
+	numVertices = numTriangles = 0;
+	vertexCapacity = triangleCapacity = 0;
+}
+
+// ----------------------------------------------------------------------------
+
 RenderMesh* AllocRenderMesh()
 {
 	RenderMesh* mesh = nullptr;
@@ -91,21 +247,85 @@ RenderMesh* AllocRenderMesh()
 
 // ----------------------------------------------------------------------------
 
+// the MeshBuffer converted to the upload format by the thread allocating the render 
+// mesh, so the render thread only has to upload it
+struct PackedMeshData
+{
+	PackedMeshBounds				bounds;
+	std::vector<PackedMeshVertex>	vertices;
+	std::vector<uint16_t>			shortIndices;		// used when the vertex count allows it
+	std::vector<int>				indices;
+};
+
+// ----------------------------------------------------------------------------
+
+static PackedMeshData* PackMeshBuffer(const MeshBuffer* buffer)
+{
+	rmt_ScopedCPUSample(PackMesh);
+
+	vec3 min(FLT_MAX), max(-FLT_MAX);
+	for (int i = 0; i < buffer->numVertices; i++)
+	{
+		min = glm::min(min, vec3(buffer->vertices[i].xyz));
+		max = glm::max(max, vec3(buffer->vertices[i].xyz));
+	}
+
+	PackedMeshData* data = new PackedMeshData;
+	data->bounds = PackedMeshBounds(min, max);
+	data->vertices.resize(buffer->numVertices);
+	for (int i = 0; i < buffer->numVertices; i++)
+	{
+		data->vertices[i] = PackMeshVertex(buffer->vertices[i], data->bounds);
+	}
+
+	const int numIndices = buffer->numTriangles * 3;
+	const int* indices = buffer->triangles[0].indices_;
+	if (buffer->numVertices <= (UINT16_MAX + 1))
+	{
+		data->shortIndices.resize(numIndices);
+		for (int i = 0; i < numIndices; i++)
+		{
+			data->shortIndices[i] = (uint16_t)indices[i];
+		}
+	}
+	else
+	{
+		data->indices.assign(indices, indices + numIndices);
+	}
+
+	return data;
+}
+
+// ----------------------------------------------------------------------------
+
 static bool InitialiseMesh(
 	RenderMesh* mesh,
-	void (*initVertexArrayFn)(),
-	const u32 vertexSize,
-	MeshBuffer* buffer)
+	PackedMeshData* data)
 {
 	rmt_ScopedCPUSample(InitMesh);
 
-	// TODO setPosition broken since the vertices are specified with absolute/world coords!
-	//	mesh->setPosition(position);
-	mesh->uploadData(MeshBuffer::initialiseVertexArray, 
-		sizeof(MeshVertex), buffer->numVertices, buffer->vertices, 
-		buffer->numTriangles * 3, buffer->triangles);
+	if (!data->shortIndices.empty())
+	{
+		mesh->uploadData(PackedMeshVertex::initialiseVertexArray, 
+			sizeof(PackedMeshVertex), data->vertices.size(), &data->vertices[0], 
+			data->shortIndices.size(), &data->shortIndices[0], GL_UNSIGNED_SHORT);
+	}
+	else
+	{
+		mesh->uploadData(PackedMeshVertex::initialiseVertexArray, 
+			sizeof(PackedMeshVertex), data->vertices.size(), &data->vertices[0], 
+			data->indices.size(), &data->indices[0], GL_UNSIGNED_INT);
+	}
+
+	// the model transform unpacks the positions, set after the upload as that resets it
+	mat3 transform(1.f);
+	transform[0][0] = data->bounds.scale.x;
+	transform[1][1] = data->bounds.scale.y;
+	transform[2][2] = data->bounds.scale.z;
+	mesh->setPosition(data->bounds.origin);
+	mesh->setTransform(transform);
 
-	Render_FreeMeshBuffer(buffer);
+	delete data;
 	return true;			
 }
 
@@ -124,8 +344,9 @@ RenderMesh* Render_AllocRenderMesh(const char* const tag, MeshBuffer* buffer, co
 	RenderMesh* mesh = AllocRenderMesh();
 	if (mesh)
 	{
-		PushRenderCommand(
-			std::bind(InitialiseMesh, mesh, MeshBuffer::initialiseVertexArray, sizeof(MeshVertex), buffer));
+		PackedMeshData* data = PackMeshBuffer(buffer);
+		Render_FreeMeshBuffer(buffer);
+		PushRenderCommand(std::bind(InitialiseMesh, mesh, data));
 	}
 	else
 	{
@@ -154,7 +375,7 @@ RenderMesh* Render_AllocRenderMesh(const char* const tag, ActorMeshBuffer* buffe
 		{
 			mesh->uploadData(ActorMeshBuffer::initialiseVertexArray, 
 				sizeof(ActorVertex), buffer->numVertices, buffer->vertices, 
-				buffer->numIndices, buffer->indices);
+				buffer->numIndices, buffer->indices, GL_UNSIGNED_INT);
 
 			Render_ReleaseActorMeshBuffer(buffer);
 			return true;			
@@ -209,6 +430,28 @@ void MeshBuffer::initialiseVertexArray()
 
 // ----------------------------------------------------------------------------
 
+void PackedMeshVertex::initialiseVertexArray()
+{
+	rmt_ScopedCPUSample(InitVertexAttrib_Packed);
+
+	// xyz, unnormalised as the mesh's transform unpacks them
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(PackedMeshVertex), 
+		(void*)offsetof(PackedMeshVertex, position));
+	
+	// octahedral normal
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedMeshVertex), 
+		(void*)offsetof(PackedMeshVertex, normal));
+
+	// colour, the material is in w
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedMeshVertex), 
+		(void*)offsetof(PackedMeshVertex, colour));
+}
+
+// ----------------------------------------------------------------------------
+
 void ActorMeshBuffer::initialiseVertexArray()
 {
 	rmt_ScopedCPUSample(InitVertexAttrib_Actor);
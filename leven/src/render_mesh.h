@@ -14,7 +14,9 @@ using		glm::mat3;
 
 // ----------------------------------------------------------------------------
 
-MeshBuffer* Render_AllocMeshBuffer(const char* const tag);
+// the arrays are allocated for the given counts and grown with MeshBuffer::reserve,
+// i.e. 0 when the size isn't known in advance
+MeshBuffer* Render_AllocMeshBuffer(const char* const tag, const int maxVertices, const int maxTriangles);
 void Render_FreeMeshBuffer(MeshBuffer* buffer);
 
 // ----------------------------------------------------------------------------
@@ -82,7 +84,8 @@ public:
 		const int numVertices, 
 		const void* vertexData,
 		const int numIndices, 
-		const void* indexData)
+		const void* indexData,
+		const GLenum indexType)
 	{
 		rmt_ScopedCPUSample(UploadData);
 
@@ -100,11 +103,13 @@ public:
 			glBindBuffer(GL_ARRAY_BUFFER, vbuffer_);
 			glBufferData(GL_ARRAY_BUFFER, vertexSize * numVertices, vertexData, GL_STATIC_DRAW);
 
+			const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(int);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibuffer_);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * numIndices, indexData, GL_STATIC_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize * numIndices, indexData, GL_STATIC_DRAW);
 
 			numVertices_ = numVertices;
 			numTriangles_ = numIndices / 3;
+			indexType_ = indexType;
 
 			glBindVertexArray(0);
 		}
@@ -125,7 +130,7 @@ public:
 		program.setUniform("u_colour", colour_);
 
 		glBindVertexArray(vao_);
-		glDrawElements(GL_TRIANGLES, numTriangles_ * 3, GL_UNSIGNED_INT, (void*)(0));
+		glDrawElements(GL_TRIANGLES, numTriangles_ * 3, indexType_, (void*)(0));
 	}
 
 private:
@@ -174,6 +179,7 @@ private:
 	vec3        position_;
 	int	        numVertices_ = 0;
 	int         numTriangles_ = 0;
+	GLenum      indexType_ = GL_UNSIGNED_INT;
 	mat3		transform_{1.f};
 	vec4        colour_{1.f};
 };
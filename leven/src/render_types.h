@@ -2,6 +2,7 @@
 #define		HAS_RENDER_TYPES_H_BEEN_INCLUDED
 
 #include	<glm/glm.hpp>
+#include	<stdint.h>
 
 using		glm::vec4;
 using		glm::vec3;
@@ -59,34 +60,140 @@ struct MeshTriangle
 
 // ----------------------------------------------------------------------------
 
-#ifdef LEVEN
-const int MAX_MESH_VERTICES = 14 * 1024;
-#else
-const int MAX_MESH_VERTICES = 1 << 23;			// i.e. 8 million
-#endif
+// The compact vertex the meshes are uploaded (see Render_AllocRenderMesh) and read back
+// from the GPU with, 16 bytes rather than 48: the position is quantised to 16 bits
+// across the bounds (see PackedMeshBounds), the normal is octahedral encoded and the
+// colour is 8 bits per channel with the material in w. Must match cl/octree.cl.
+struct PackedMeshVertex
+{
+	static void initialiseVertexArray();
+
+	uint16_t			position[4];		// w is unused
+	int16_t				normal[2];
+	uint8_t				colour[4];
+};
+
+static_assert(sizeof(PackedMeshVertex) == 16, "PackedMeshVertex must match the OpenCL struct");
+
+// the unpacked position is origin + (position * scale)
+struct PackedMeshBounds
+{
+	PackedMeshBounds()
+	{
+	}
+
+	PackedMeshBounds(const glm::vec3& min, const glm::vec3& max)
+		: origin(min)
+		, scale(glm::max(max - min, glm::vec3(1e-3f)) / 65535.f)
+	{
+	}
+
+	glm::vec3			origin;
+	glm::vec3			scale;
+};
+
+inline glm::vec2 OctahedralEncode(const glm::vec3& n)
+{
+	const float sum = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+	if (sum <= 0.f)
+	{
+		return glm::vec2(0.f);
+	}
 
-const int MAX_MESH_TRIANGLES = MAX_MESH_VERTICES * 2;
+	const glm::vec3 p = n / sum;
+	if (p.z >= 0.f)
+	{
+		return glm::vec2(p.x, p.y);
+	}
 
+	return glm::vec2(
+		(1.f - glm::abs(p.y)) * (p.x >= 0.f ? 1.f : -1.f),
+		(1.f - glm::abs(p.x)) * (p.y >= 0.f ? 1.f : -1.f));
+}
+
+inline glm::vec3 OctahedralDecode(const glm::vec2& e)
+{
+	glm::vec3 n(e.x, e.y, 1.f - glm::abs(e.x) - glm::abs(e.y));
+	if (n.z < 0.f)
+	{
+		n.x = (1.f - glm::abs(e.y)) * (e.x >= 0.f ? 1.f : -1.f);
+		n.y = (1.f - glm::abs(e.x)) * (e.y >= 0.f ? 1.f : -1.f);
+	}
+
+	return glm::normalize(n);
+}
+
+inline PackedMeshVertex PackMeshVertex(const MeshVertex& vertex, const PackedMeshBounds& bounds)
+{
+	PackedMeshVertex packed;
+
+	const glm::vec3 q = glm::clamp((glm::vec3(vertex.xyz) - bounds.origin) / bounds.scale, 0.f, 65535.f);
+	packed.position[0] = (uint16_t)(q.x + 0.5f);
+	packed.position[1] = (uint16_t)(q.y + 0.5f);
+	packed.position[2] = (uint16_t)(q.z + 0.5f);
+	packed.position[3] = 0;
+
+	const glm::vec2 n = OctahedralEncode(glm::vec3(vertex.normal));
+	packed.normal[0] = (int16_t)glm::round(glm::clamp(n.x, -1.f, 1.f) * 32767.f);
+	packed.normal[1] = (int16_t)glm::round(glm::clamp(n.y, -1.f, 1.f) * 32767.f);
+
+	const glm::vec3 c = glm::clamp(glm::vec3(vertex.colour), 0.f, 1.f);
+	packed.colour[0] = (uint8_t)((c.x * 255.f) + 0.5f);
+	packed.colour[1] = (uint8_t)((c.y * 255.f) + 0.5f);
+	packed.colour[2] = (uint8_t)((c.z * 255.f) + 0.5f);
+	packed.colour[3] = (uint8_t)vertex.colour.w;			// the material
+
+	return packed;
+}
+
+inline MeshVertex UnpackMeshVertex(const PackedMeshVertex& packed, const PackedMeshBounds& bounds)
+{
+	const glm::vec3 q(packed.position[0], packed.position[1], packed.position[2]);
+	const glm::vec2 n(packed.normal[0] / 32767.f, packed.normal[1] / 32767.f);
+	const glm::vec3 c(packed.colour[0], packed.colour[1], packed.colour[2]);
+
+	return MeshVertex(
+		glm::vec4(bounds.origin + (q * bounds.scale), 1.f),
+		glm::vec4(OctahedralDecode(n), 0.f),
+		glm::vec4(c / 255.f, (float)packed.colour[3]));
+}
+
+// ----------------------------------------------------------------------------
+
+// The vertex and triangle arrays are sized to the mesh, see Render_AllocMeshBuffer
 class MeshBuffer
 {
 public:
 
 	MeshBuffer()
-		: numVertices(0)
+		: tag(nullptr)
+		, vertices(nullptr)
+		, numVertices(0)
+		, vertexCapacity(0)
+		, triangles(nullptr)
 		, numTriangles(0)
-		, tag(nullptr)
+		, triangleCapacity(0)
 	{
 	}
 
 	static void initialiseVertexArray();
 
+	// grows the arrays (keeping the current contents) to hold at least the given counts
+	void reserve(const int maxVertices, const int maxTriangles);
+
+	// returns the arrays to the allocator, only needed for buffers not allocated with 
+	// Render_AllocMeshBuffer (Render_FreeMeshBuffer releases them)
+	void release();
+
 	const char*			tag;			
 
-	MeshVertex			vertices[MAX_MESH_VERTICES];
+	MeshVertex*			vertices;
 	int					numVertices;
+	int					vertexCapacity;
 
-	MeshTriangle		triangles[MAX_MESH_TRIANGLES];
+	MeshTriangle*		triangles;
 	int					numTriangles;
+	int					triangleCapacity;
 };
 
 
@@ -0,0 +1,241 @@
+#include	"surface_nets.h"
+
+#include	"contour_constants.h"
+#include	"volume_constants.h"
+#include	"volume_materials.h"
+
+#include	<algorithm>
+#include	<glm/gtx/integer.hpp>
+
+// ----------------------------------------------------------------------------
+
+// the nodes sharing the edge processed for each axis, see GenerateMesh in octree.cl
+static const glm::ivec3 EDGE_NODE_OFFSETS[3][4] =
+{
+	{ glm::ivec3(0, 0, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 1, 0), glm::ivec3(0, 1, 1) },
+	{ glm::ivec3(0, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(0, 0, 1), glm::ivec3(1, 0, 1) },
+	{ glm::ivec3(0, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(1, 0, 0), glm::ivec3(1, 1, 0) },
+};
+
+// ----------------------------------------------------------------------------
+
+int SurfaceNets_EdgeKey(const glm::ivec3& corner, const int axis, const int voxelsPerChunk)
+{
+	// matches EncodeVoxelIndex in octree.cl with the shift set in Compute_MeshGenContext::create
+	const int shift = glm::log2(voxelsPerChunk) + 1;
+	const int voxelIndex = corner.x | (corner.y << shift) | (corner.z << (shift * 2));
+	return (voxelIndex << 2) | axis;
+}
+
+// ----------------------------------------------------------------------------
+
+// a straight port of FindDominantMaterial in octree.cl so the two versions agree
+static int FindDominantMaterial(const int cornerMaterials[8])
+{
+	int data[8];
+	std::copy(cornerMaterials, cornerMaterials + 8, data);
+	std::sort(data, data + 8);
+
+	int current = data[0];
+	int count = 1;
+	int maxCount = 0;
+	int maxMaterial = 0;
+
+	for (int i = 1; i < 8; i++)
+	{
+		const int m = data[i];
+		if (m == (int)MATERIAL_AIR || m == (int)MATERIAL_NONE)
+		{
+			continue;
+		}
+
+		if (current != m)
+		{
+			if (count > maxCount)
+			{
+				maxCount = count;
+				maxMaterial = current;
+			}
+
+			current = m;
+			count = 1;
+		}
+		else
+		{
+			count++;
+		}
+	}
+
+	if (count > maxCount)
+	{
+		maxMaterial = current;
+	}
+
+	return maxMaterial;
+}
+
+// ----------------------------------------------------------------------------
+
+void SurfaceNets_GenerateMesh(
+	const SurfaceNetsField& field,
+	const glm::vec3& colour,
+	MeshBuffer* meshBuffer,
+	std::vector<SeamNodeInfo>& seamNodes)
+{
+	meshBuffer->numVertices = 0;
+	meshBuffer->numTriangles = 0;
+	seamNodes.clear();
+
+	const int voxelsPerChunk = field.voxelsPerChunk;
+	const int fieldSize = voxelsPerChunk + 1;
+	const int sampleScale = field.size / (voxelsPerChunk * LEAF_SIZE_SCALE);
+	const glm::vec3 worldSpaceOffset(field.min);
+
+	const auto voxelIndex = [&](const glm::ivec3& p)
+	{
+		return p.x + (p.y * voxelsPerChunk) + (p.z * voxelsPerChunk * voxelsPerChunk);
+	};
+
+	// the vertex index and the GPU style material info ((material << 8) | corners) per voxel
+	std::vector<int> vertexIndices(voxelsPerChunk * voxelsPerChunk * voxelsPerChunk, -1);
+	std::vector<int> voxelMaterials(vertexIndices.size(), 0);
+
+	for (int z = 0; z < voxelsPerChunk; z++)
+	for (int y = 0; y < voxelsPerChunk; y++)
+	for (int x = 0; x < voxelsPerChunk; x++)
+	{
+		const glm::ivec3 pos(x, y, z);
+
+		int cornerMaterials[8];
+		int corners = 0;
+		for (int i = 0; i < 8; i++)
+		{
+			const glm::ivec3 p = pos + CHILD_MIN_OFFSETS[i];
+			cornerMaterials[i] = field.materials[p.x + (p.y * fieldSize) + (p.z * fieldSize * fieldSize)];
+			corners |= ((cornerMaterials[i] == (int)MATERIAL_AIR ? 0 : 1) << i);
+		}
+
+		if (corners == 0 || corners == 255)
+		{
+			continue;
+		}
+
+		glm::vec3 position(0.f), normal(0.f);
+		int edgeCount = 0;
+		for (int i = 0; i < 12; i++)
+		{
+			const int e0 = edgevmap[i][0];
+			const int e1 = edgevmap[i][1];
+			if (((corners >> e0) & 1) == ((corners >> e1) & 1))
+			{
+				continue;
+			}
+
+			// the first 4 edges are the X axis, the next 4 Y and the last 4 Z
+			const glm::ivec3 p0 = pos + CHILD_MIN_OFFSETS[e0];
+			const auto iter = field.edges.find(SurfaceNets_EdgeKey(p0, i / 4, voxelsPerChunk));
+			if (iter == end(field.edges))
+			{
+				continue;
+			}
+
+			const glm::vec4& edgeData = iter->second;
+			const glm::vec3 p1(pos + CHILD_MIN_OFFSETS[e1]);
+			position += glm::mix(glm::vec3(p0), p1, edgeData.w) * (float)sampleScale;
+			normal += glm::vec3(edgeData);
+			edgeCount++;
+		}
+
+		meshBuffer->reserve(meshBuffer->numVertices + 1, 0);
+
+		// same transform as the GPU version
+		position /= (float)glm::max(edgeCount, 1);
+		position = (position * (float)LEAF_SIZE_SCALE) + worldSpaceOffset;
+		normal /= (float)glm::max(edgeCount, 1);
+
+		const int material = (FindDominantMaterial(cornerMaterials) << 8) | corners;
+		const int index = meshBuffer->numVertices++;
+		meshBuffer->vertices[index] = MeshVertex(glm::vec4(position, 1.f), glm::vec4(normal, 0.f),
+			glm::vec4(colour, (float)(material >> 8)));
+
+		vertexIndices[voxelIndex(pos)] = index;
+		voxelMaterials[voxelIndex(pos)] = material;
+
+		const bool isSeamNode =
+			x == 0 || x == (voxelsPerChunk - 1) ||
+			y == 0 || y == (voxelsPerChunk - 1) ||
+			z == 0 || z == (voxelsPerChunk - 1);
+		if (isSeamNode)
+		{
+			SeamNodeInfo info;
+			info.localspaceMin = glm::ivec4(pos, material);
+			info.position = meshBuffer->vertices[index].xyz;
+			info.normal = meshBuffer->vertices[index].normal;
+			seamNodes.push_back(info);
+		}
+	}
+
+	// the quads are generated exactly as in GenerateMesh/ProcessEdge
+	const int windings[2][6] =
+	{
+		{ 0, 1, 3, 0, 3, 2 },
+		{ 0, 3, 1, 0, 2, 3 },
+	};
+
+	for (int z = 0; z < voxelsPerChunk; z++)
+	for (int y = 0; y < voxelsPerChunk; y++)
+	for (int x = 0; x < voxelsPerChunk; x++)
+	{
+		const glm::ivec3 pos(x, y, z);
+		if (vertexIndices[voxelIndex(pos)] == -1)
+		{
+			continue;
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// the edges on the chunk's max faces are handled by the seams
+			if (pos[(axis + 1) % 3] == (voxelsPerChunk - 1) ||
+				pos[(axis + 2) % 3] == (voxelsPerChunk - 1))
+			{
+				continue;
+			}
+
+			const int corners = voxelMaterials[voxelIndex(pos)] & 0xff;
+			const int edge = (axis * 4) + 3;
+			const int m1 = (corners >> edgevmap[edge][0]) & 1;
+			const int m2 = (corners >> edgevmap[edge][1]) & 1;
+			if (m1 == m2)
+			{
+				continue;
+			}
+
+			int nodeIndices[4];
+			bool found = true;
+			for (int n = 0; n < 4 && found; n++)
+			{
+				nodeIndices[n] = vertexIndices[voxelIndex(pos + EDGE_NODE_OFFSETS[axis][n])];
+				found = nodeIndices[n] != -1;
+			}
+
+			if (!found)
+			{
+				continue;
+			}
+
+			meshBuffer->reserve(0, meshBuffer->numTriangles + 2);
+
+			const int* winding = windings[m1 != 0 ? 1 : 0];
+			for (int t = 0; t < 2; t++)
+			{
+				meshBuffer->triangles[meshBuffer->numTriangles++] = MeshTriangle(
+					nodeIndices[winding[(t * 3) + 0]],
+					nodeIndices[winding[(t * 3) + 1]],
+					nodeIndices[winding[(t * 3) + 2]]);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+
@@ -0,0 +1,42 @@
+#ifndef		HAS_SURFACE_NETS_H_BEEN_INCLUDED
+#define		HAS_SURFACE_NETS_H_BEEN_INCLUDED
+
+#include	"compute.h"
+#include	"render_types.h"
+
+#include	<unordered_map>
+#include	<vector>
+#include	<glm/glm.hpp>
+
+// ----------------------------------------------------------------------------
+// The CPU version of the naive surface nets extractor in cl/surface_nets.cl for
+// fields held on the host. Each active voxel's vertex is the average of its edge
+// crossings, the vertices, triangles and seam nodes follow the same conventions
+// as the GPU version so the meshes can be stitched with the existing seam code.
+// ----------------------------------------------------------------------------
+
+struct SurfaceNetsField
+{
+	int									voxelsPerChunk = 0;
+	glm::ivec3							min;				// world space
+	int									size = 0;			// i.e. the clipmap node size
+
+	// the (voxelsPerChunk + 1)^3 corner materials, x + (y * N) + (z * N * N)
+	std::vector<int>					materials;
+
+	// the normal in xyz and the crossing in w for the edges with a sign change,
+	// keyed by SurfaceNets_EdgeKey (i.e. the GPU edge indices)
+	std::unordered_map<int, glm::vec4>	edges;
+};
+
+int SurfaceNets_EdgeKey(const glm::ivec3& corner, const int axis, const int voxelsPerChunk);
+
+// the buffer is grown as needed
+void SurfaceNets_GenerateMesh(
+	const SurfaceNetsField& field,
+	const glm::vec3& colour,
+	MeshBuffer* meshBuffer,
+	std::vector<SeamNodeInfo>& seamNodes);
+
+#endif	//	HAS_SURFACE_NETS_H_BEEN_INCLUDED
+
@@ -5,11 +5,18 @@
 #include	"compute_sort.h"
 #include	"timer.h"
 #include	"volume_constants.h"
+#include	"volume_materials.h"
+#include	"density_graph.h"
+#include	"compute_program.h"
+#include	"surface_nets.h"
 
 #include	"testdata/octree_keys_3.cpp"
 #include	"testdata/duplicate_data_3.cpp"
 
+#include	<algorithm>
 #include	<random>
+#include	<sstream>
+#include	<tuple>
 
 #define CL_REQUIRE(f) REQUIRE((f) == CL_SUCCESS)
 
@@ -19,7 +26,7 @@ int EnsureComputeInitialised()
 	if (!s_initialised)
 	{
 		s_initialised = true;
-		return Compute_Initialise(0x7d3af, 0, 2);
+		return Compute_Initialise(0x7d3af, 0);
 	}
 
 	return CL_SUCCESS;
@@ -71,18 +78,587 @@ TEST_CASE("Compute (Cuckoo)", "[compute] [hashtable]")
 {
 	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
 
+	// use keys wider than 32 bits to check the keys aren't truncated
 	const int KEY_COUNT = 100;
-	std::vector<uint32_t> keys(KEY_COUNT);
+	std::vector<uint64_t> keys(KEY_COUNT);
 	for (int i = 0; i < 100; i++)
 	{
-		keys[i] = i;
+		keys[i] = (1ULL << 36) | (i * 7919);
 	}
 
 	cl::Buffer d_keys;
 	REQUIRE(CreateBuffer(CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, 
-		sizeof(uint32_t) * KEY_COUNT, &keys[0], d_keys) == CL_SUCCESS);	
+		sizeof(uint64_t) * KEY_COUNT, &keys[0], d_keys) == CL_SUCCESS);	
 
 	CuckooData cuckooData;
 	REQUIRE(Cuckoo_InitialiseTable(&cuckooData, KEY_COUNT) == CL_SUCCESS);
 	REQUIRE(Cuckoo_InsertKeys(&cuckooData, d_keys, KEY_COUNT) == CL_SUCCESS);
+
+	std::vector<uint64_t> table(cuckooData.prime), stash(CUCKOO_STASH_SIZE);
+	auto ctx = GetComputeContext();
+	REQUIRE(ctx->queue.enqueueReadBuffer(cuckooData.table, CL_TRUE, 0, 
+		sizeof(uint64_t) * table.size(), &table[0]) == CL_SUCCESS);
+	REQUIRE(ctx->queue.enqueueReadBuffer(cuckooData.stash, CL_TRUE, 0, 
+		sizeof(uint64_t) * stash.size(), &stash[0]) == CL_SUCCESS);
+	table.insert(end(table), begin(stash), end(stash));
+
+	// every key should be stored once along with its index
+	const uint64_t keyMask = (1ULL << CUCKOO_KEY_BITS) - 1;
+	std::vector<int> found(KEY_COUNT, 0);
+	for (const uint64_t entry: table)
+	{
+		if (entry == CUCKOO_EMPTY_VALUE)
+		{
+			continue;
+		}
+
+		const int value = (int)(entry >> CUCKOO_KEY_BITS);
+		REQUIRE(value < KEY_COUNT);
+		REQUIRE((entry & keyMask) == keys[value]);
+		found[value]++;
+	}
+
+	for (int i = 0; i < KEY_COUNT; i++)
+	{
+		REQUIRE(found[i] == 1);
+	}
+}
+
+TEST_CASE("Compute (Density Graph)", "[compute]")
+{
+	const std::string source =
+		"p		position\n"
+		"q		translate p 0 -10 0\n"
+		"r		mul 4 2			# folded\n"
+		"r1		add r 0\n"
+		"s		sphere q r1\n"
+		"unused	noise p\n"
+		"d		mul s 1\n";
+
+	DensityGraph graph;
+	REQUIRE(graph.parse(source, "test"));
+
+	// only the sphere is left once the constants and identities are folded
+	REQUIRE(graph.nodes().size() == 3);
+	REQUIRE(graph.nodes().back().op == DensityGraph::Op_Sphere);
+	REQUIRE(graph.nodes().back().args[1].node == -1);
+	REQUIRE(graph.nodes().back().args[1].value == 8.f);
+
+	std::vector<unsigned char> permLookup;
+	Compute_CreateNoisePermutationLookup(0x7d3af, permLookup);
+	REQUIRE(graph.evaluate(glm::vec3(0.f, 10.f, 0.f), permLookup) == Approx(-8.f));
+	REQUIRE(graph.evaluate(glm::vec3(0.f, 10.f, 20.f), permLookup) == Approx(12.f));
+
+	REQUIRE(graph.generateOpenCL().find("fSphere(") != std::string::npos);
+
+	REQUIRE(!graph.parse("p position\nd sphere p missing\n", "test"));
+	REQUIRE(!graph.parse("p position\n", "test"));
+}
+
+// evaluates the graph with the generated OpenCL at each of the positions
+int SampleDensityGraphGPU(
+	const DensityGraph& graph,
+	const std::vector<glm::vec4>& positions,
+	std::vector<float>& densities)
+{
+	auto ctx = GetComputeContext();
+
+	std::stringstream source;
+	source << graph.generateOpenCL();
+	source << "kernel void SampleDensityGraph(read_only image2d_t permTexture, global float4* positions, global float* densities)\n";
+	source << "{\n";
+	source << "\tconst int index = get_global_id(0);\n";
+	source << "\tdensities[index] = DensityGraph(positions[index], permTexture);\n";
+	source << "}\n";
+
+	ComputeProgram program;
+	program.initialise("cl/noise.cl", "-cl-fast-relaxed-math -Werror -DDENSITY_GRAPH -DMAX_TERRAIN_HEIGHT=900 ");
+	program.addHeader("cl/simplex.cl");
+	program.setGeneratedSource(source.str());
+	CL_CALL(program.build());
+
+	cl_int error = CL_SUCCESS;
+	cl::Kernel k_SampleDensityGraph(program.get(), "SampleDensityGraph", &error);
+	CL_CALL(error);
+
+	const int count = positions.size();
+	cl::Buffer d_positions, d_densities;
+	CL_CALL(CreateBuffer(CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(glm::vec4) * count, (void*)&positions[0], d_positions));
+	CL_CALL(CreateBuffer(CL_MEM_WRITE_ONLY, sizeof(float) * count, nullptr, d_densities));
+
+	CL_CALL(k_SampleDensityGraph.setArg(0, ctx->noisePermLookupImage));
+	CL_CALL(k_SampleDensityGraph.setArg(1, d_positions));
+	CL_CALL(k_SampleDensityGraph.setArg(2, d_densities));
+	CL_CALL(ctx->queue.enqueueNDRangeKernel(k_SampleDensityGraph, cl::NullRange, count, cl::NullRange));
+
+	densities.resize(count);
+	CL_CALL(ctx->queue.enqueueReadBuffer(d_densities, CL_TRUE, 0, sizeof(float) * count, &densities[0]));
+
+	return CL_SUCCESS;
+}
+
+TEST_CASE("Compute (Density Graph Noise)", "[compute]")
+{
+	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
+
+	// the same lookup as the image the GPU samples
+	std::vector<unsigned char> permLookup;
+	Compute_CreateNoisePermutationLookup(GetComputeContext()->noiseSeed, permLookup);
+
+	const std::vector<glm::vec4> positions = 
+	{
+		glm::vec4(0.f, 0.f, 0.f, 0.f),
+		glm::vec4(1234.5f, 300.f, -876.25f, 0.f),
+		glm::vec4(-5000.f, 600.f, 3210.f, 0.f),
+		glm::vec4(777.f, 50.f, 9999.f, 0.f),
+		glm::vec4(-321.f, 450.f, -4321.f, 0.f),
+		glm::vec4(20000.f, 800.f, -15000.f, 0.f),
+	};
+
+	DensityGraph graph;
+	SECTION("Fractal and ridged")
+	{
+		// the noise ops have the most args, all of them used
+		const std::string source =
+			"p		position\n"
+			"q		scale p 0.001\n"
+			"f		fractal q 4 0.5 2 0.5\n"
+			"r		ridged q 3 2 1.5 1\n"
+			"d		add f r\n";
+
+		REQUIRE(graph.parse(source, "test"));
+		REQUIRE(graph.nodes().size() == 5);
+	}
+
+	SECTION("terrain.dg")
+	{
+		REQUIRE(graph.load("assets/terrain.dg"));
+	}
+
+	std::vector<float> densities;
+	CL_REQUIRE(SampleDensityGraphGPU(graph, positions, densities));
+
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		const float cpuDensity = graph.evaluate(glm::vec3(positions[i]), permLookup);
+		REQUIRE(glm::abs(cpuDensity - densities[i]) < 0.05f);
+	}
+}
+
+TEST_CASE("Compute (Seam Mesh)", "[compute]")
+{
+	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
+
+	// four nodes around an X edge which crosses the chunk boundary at z=CLIPMAP_LEAF_SIZE,
+	// in the GenerateMesh order, with only the shared corner inside the volume
+	const auto makeNode = [](const glm::ivec3& min, const int size, const int corner)
+	{
+		SeamMeshNode node;
+		node.min = min;
+		node.size = size;
+		node.corners = 1 << corner;
+		return node;
+	};
+
+	const int z = CLIPMAP_LEAF_SIZE;
+	MeshBuffer meshBuffer;
+
+	SECTION("Same size")
+	{
+		const std::vector<SeamMeshNode> nodes = 
+		{
+			makeNode(glm::ivec3(0, 0, z - 4), 4, 3),
+			makeNode(glm::ivec3(0, 0, z), 4, 2),
+			makeNode(glm::ivec3(0, 4, z - 4), 4, 1),
+			makeNode(glm::ivec3(0, 4, z), 4, 0),
+		};
+
+		CL_REQUIRE(Compute_GenerateSeamMesh(glm::ivec3(0), CLIPMAP_LEAF_SIZE * 2, nodes, &meshBuffer));
+	}
+
+	SECTION("Mixed sizes")
+	{
+		// the last node is larger, the edge still belongs to the first
+		const std::vector<SeamMeshNode> nodes = 
+		{
+			makeNode(glm::ivec3(0, 4, z - 4), 4, 3),
+			makeNode(glm::ivec3(0, 4, z), 4, 2),
+			makeNode(glm::ivec3(0, 8, z - 4), 4, 1),
+			makeNode(glm::ivec3(0, 8, z), 8, 0),
+		};
+
+		CL_REQUIRE(Compute_GenerateSeamMesh(glm::ivec3(0), CLIPMAP_LEAF_SIZE * 2, nodes, &meshBuffer));
+	}
+
+	// the first node's edge starts inside so the winding is flipped, see ContourProcessEdge
+	REQUIRE(meshBuffer.numTriangles == 2);
+	REQUIRE(meshBuffer.triangles[0].indices_[0] == 0);
+	REQUIRE(meshBuffer.triangles[0].indices_[1] == 3);
+	REQUIRE(meshBuffer.triangles[0].indices_[2] == 1);
+	REQUIRE(meshBuffer.triangles[1].indices_[0] == 0);
+	REQUIRE(meshBuffer.triangles[1].indices_[1] == 2);
+	REQUIRE(meshBuffer.triangles[1].indices_[2] == 3);
+
+	meshBuffer.release();
+}
+
+struct TestOctreeNode
+{
+	cl_ulong		code = 0;
+	int				material = 0;
+	glm::vec4		position, normal;
+};
+
+// sorted by code as the patched octree holds the nodes in a different order
+int ReadOctreeNodes(
+	ComputeContext* ctx,
+	const GPUOctree& octree,
+	const bool leafData,
+	std::vector<TestOctreeNode>& nodes)
+{
+	const int count = octree.numNodes;
+	std::vector<cl_ulong> codes(count);
+	std::vector<int> materials(count);
+	std::vector<glm::vec4> positions(count), normals(count);
+
+	// the collapse overwrites the vertices so compare the leafs' instead
+	const cl::Buffer& d_positions = leafData ? octree.d_leafPositions : octree.d_vertexPositions;
+	const cl::Buffer& d_normals = leafData ? octree.d_leafNormals : octree.d_vertexNormals;
+
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_nodeCodes, CL_TRUE, 0, sizeof(cl_ulong) * count, &codes[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(octree.d_nodeMaterials, CL_TRUE, 0, sizeof(int) * count, &materials[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(d_positions, CL_TRUE, 0, sizeof(glm::vec4) * count, &positions[0]));
+	CL_CALL(ctx->queue.enqueueReadBuffer(d_normals, CL_TRUE, 0, sizeof(glm::vec4) * count, &normals[0]));
+
+	nodes.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		nodes[i].code = codes[i];
+		nodes[i].material = materials[i];
+		nodes[i].position = positions[i];
+		nodes[i].normal = normals[i];
+	}
+
+	std::sort(begin(nodes), end(nodes), 
+		[](const TestOctreeNode& a, const TestOctreeNode& b) { return a.code < b.code; });
+
+	return CL_SUCCESS;
+}
+
+TEST_CASE("Compute (Patch Octree)", "[compute] [csg]")
+{
+	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
+	ComputeContext* ctx = GetComputeContext();
+
+	float maxCollapseError = 0.f;
+	SECTION("Leafs")
+	{
+		maxCollapseError = 0.f;
+	}
+
+	SECTION("Collapsed")
+	{
+		maxCollapseError = 0.1f;
+	}
+
+	const bool collapsed = maxCollapseError > 0.f;
+	Compute_SetCollapseOptions(maxCollapseError);
+
+	MeshGenerationContext* meshGen = Compute_CreateMeshGenContext(CLIPMAP_VOXELS_PER_CHUNK);
+	REQUIRE(meshGen);
+	meshGen->computeCtx = ctx;
+
+	// walk away from the origin until a chunk crossing the surface is found, as the autotuner does
+	const int size = CLIPMAP_LEAF_SIZE;
+	glm::ivec3 min(0);
+	GPUOctree octree;
+	for (int i = 0; i < 32 && octree.numNodes == 0; i++)
+	{
+		const int step = ((i + 1) / 2) * ((i & 1) ? 1 : -1);
+		min = glm::ivec3(0, step * size, 0);
+		CL_REQUIRE(LoadOctree(meshGen, min, size, &octree));
+	}
+
+	REQUIRE(octree.numNodes > 0);
+
+	// centre the brushes on the vertex closest to the middle of the chunk so the edits 
+	// always touch the surface without reaching the chunk bounds
+	std::vector<TestOctreeNode> nodes;
+	CL_REQUIRE(ReadOctreeNodes(ctx, octree, false, nodes));
+
+	const glm::vec3 chunkCentre = glm::vec3(min) + glm::vec3(size / 2);
+	glm::vec3 brushCentre = glm::vec3(nodes[0].position);
+	for (const TestOctreeNode& node: nodes)
+	{
+		if (glm::distance(glm::vec3(node.position), chunkCentre) < glm::distance(brushCentre, chunkCentre))
+		{
+			brushCentre = glm::vec3(node.position);
+		}
+	}
+
+	// same as Clipmap's ops, i.e. in voxel space with the CSG_OFFSET
+	const auto makeOp = [&](const float brushSize)
+	{
+		CSGOperationInfo opInfo;
+		opInfo.type = 1;
+		opInfo.brushShape = CSGBrush_Sphere;
+		opInfo.material = MATERIAL_AIR;
+		opInfo.origin = glm::vec4((brushCentre / (float)LEAF_SIZE_SCALE) + glm::vec3(0.5f), 0.f);
+		opInfo.dimensions = glm::vec4(glm::vec3(brushSize / 2.f), 0.f) / (float)LEAF_SIZE_SCALE;
+		return opInfo;
+	};
+
+	if (collapsed)
+	{
+		// the leaf data is only kept once the chunk has been edited so the first edit is a rebuild
+		CL_REQUIRE(Compute_ApplyCSGOperations(meshGen, { makeOp(4.f * LEAF_SIZE_SCALE) }, { 0 }, min, size));
+		CL_REQUIRE(LoadOctree(meshGen, min, size, &octree));
+		REQUIRE(octree.d_leafQEFs());
+	}
+
+	CL_REQUIRE(Compute_ApplyCSGOperations(meshGen, { makeOp(8.f * LEAF_SIZE_SCALE) }, { 0 }, min, size));
+
+	// the octree is discarded when it couldn't be patched
+	const auto iter = meshGen->octreeCache.find(glm::ivec4(min, size));
+	REQUIRE(iter != end(meshGen->octreeCache));
+	const GPUOctree patchedOctree = iter->second;
+
+	GPUDensityField field;
+	GPUOctree rebuiltOctree;
+	CL_REQUIRE(LoadDensityField(meshGen, min, size, &field));
+	CL_REQUIRE(ConstructOctreeFromField(meshGen, min, field, &rebuiltOctree));
+
+	REQUIRE(patchedOctree.numNodes == rebuiltOctree.numNodes);
+	REQUIRE(patchedOctree.numVertices == rebuiltOctree.numVertices);
+
+	std::vector<TestOctreeNode> patchedNodes, rebuiltNodes;
+	CL_REQUIRE(ReadOctreeNodes(ctx, patchedOctree, collapsed, patchedNodes));
+	CL_REQUIRE(ReadOctreeNodes(ctx, rebuiltOctree, collapsed, rebuiltNodes));
+
+	for (int i = 0; i < rebuiltOctree.numNodes; i++)
+	{
+		REQUIRE(patchedNodes[i].code == rebuiltNodes[i].code);
+		REQUIRE(patchedNodes[i].material == rebuiltNodes[i].material);
+		REQUIRE(glm::distance(glm::vec3(patchedNodes[i].position), glm::vec3(rebuiltNodes[i].position)) < 1e-3f);
+		REQUIRE(glm::distance(glm::vec3(patchedNodes[i].normal), glm::vec3(rebuiltNodes[i].normal)) < 1e-3f);
+	}
+
+	Compute_SetCollapseOptions(0.f);
+	delete meshGen;
+}
+
+// i.e. field_index in cl/shared_constants.cl
+static int TestFieldIndex(const glm::ivec3& pos, const int brickSizeLog2, const int fieldBricks)
+{
+	const auto part1By2 = [](unsigned int n)
+	{
+		n &= 0x000003ff;
+		n = (n ^ (n << 16)) & 0xff0000ff;
+		n = (n ^ (n <<  8)) & 0x0300f00f;
+		n = (n ^ (n <<  4)) & 0x030c30c3;
+		n = (n ^ (n <<  2)) & 0x09249249;
+		return n;
+	};
+
+	const int brickMask = (1 << brickSizeLog2) - 1;
+	const glm::ivec3 brick = pos >> brickSizeLog2;
+	const int brickIndex = brick.x + (brick.y * fieldBricks) + (brick.z * fieldBricks * fieldBricks);
+	const unsigned int sampleIndex = (part1By2(pos.z & brickMask) << 2) + 
+		(part1By2(pos.y & brickMask) << 1) + part1By2(pos.x & brickMask);
+	return (brickIndex << (brickSizeLog2 * 3)) | sampleIndex;
+}
+
+// copies the GPU field into the linear layout SurfaceNets_GenerateMesh expects
+int ReadSurfaceNetsField(
+	MeshGenerationContext* meshGen,
+	const GPUDensityField& field,
+	SurfaceNetsField& cpuField)
+{
+	auto ctx = GetComputeContext();
+
+	std::vector<int> materials(meshGen->fieldBufferSize);
+	std::vector<int> edgeIndices(field.numEdges);
+	std::vector<glm::vec4> normals(field.numEdges);
+	CL_CALL(ctx->queue.enqueueReadBuffer(field.materials, CL_TRUE, 0, sizeof(int) * materials.size(), &materials[0]));
+	if (field.numEdges > 0)
+	{
+		CL_CALL(ctx->queue.enqueueReadBuffer(field.edgeIndices, CL_TRUE, 0, sizeof(int) * field.numEdges, &edgeIndices[0]));
+		CL_CALL(ctx->queue.enqueueReadBuffer(field.normals, CL_TRUE, 0, sizeof(glm::vec4) * field.numEdges, &normals[0]));
+	}
+
+	const int size = meshGen->voxelsPerChunk + 1;
+	const int brickSize = 1 << meshGen->fieldBrickSizeLog2;
+	const int fieldBricks = (meshGen->fieldSize + brickSize - 1) / brickSize;
+
+	cpuField.voxelsPerChunk = meshGen->voxelsPerChunk;
+	cpuField.min = field.min;
+	cpuField.size = field.size;
+	cpuField.materials.resize(size * size * size);
+	for (int z = 0; z < size; z++)
+	for (int y = 0; y < size; y++)
+	for (int x = 0; x < size; x++)
+	{
+		cpuField.materials[x + (y * size) + (z * size * size)] = materials[TestFieldIndex(glm::ivec3(x, y, z), meshGen->fieldBrickSizeLog2, fieldBricks)];
+	}
+
+	// the edge indices are already SurfaceNets_EdgeKey values
+	cpuField.edges.clear();
+	for (unsigned int i = 0; i < field.numEdges; i++)
+	{
+		cpuField.edges[edgeIndices[i]] = normals[i];
+	}
+
+	return CL_SUCCESS;
+}
+
+TEST_CASE("Compute (Surface Nets)", "[compute]")
+{
+	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
+	CL_REQUIRE(Compute_SetMeshExtractors("sn"));
+
+	MeshGenerationContext* meshGen = Compute_CreateMeshGenContext(CLIPMAP_VOXELS_PER_CHUNK);
+	REQUIRE(meshGen);
+	meshGen->computeCtx = GetComputeContext();
+
+	// find a chunk crossing the surface as in the Patch Octree test
+	const int size = CLIPMAP_LEAF_SIZE;
+	glm::ivec3 min(0);
+	GPUOctree octree;
+	for (int i = 0; i < 32 && octree.numNodes == 0; i++)
+	{
+		const int step = ((i + 1) / 2) * ((i & 1) ? 1 : -1);
+		min = glm::ivec3(0, step * size, 0);
+		CL_REQUIRE(LoadOctree(meshGen, min, size, &octree));
+	}
+
+	REQUIRE(octree.numNodes > 0);
+
+	MeshBuffer gpuMesh;
+	std::vector<SeamNodeInfo> gpuSeamNodes;
+	CL_REQUIRE(Compute_GenerateChunkMesh(meshGen, min, size, ALL_MESH_REGIONS, false, [&](const ChunkMeshData& data)
+	{
+		Compute_UnpackChunkMesh(data, &gpuMesh);
+		gpuSeamNodes.assign(data.seamNodes, data.seamNodes + data.numSeamNodes);
+	}));
+
+	GPUDensityField field;
+	SurfaceNetsField cpuField;
+	CL_REQUIRE(LoadDensityField(meshGen, min, size, &field));
+	CL_REQUIRE(ReadSurfaceNetsField(meshGen, field, cpuField));
+
+	MeshBuffer cpuMesh;
+	std::vector<SeamNodeInfo> cpuSeamNodes;
+	SurfaceNets_GenerateMesh(cpuField, glm::vec3(0.f), &cpuMesh, cpuSeamNodes);
+
+	REQUIRE(cpuMesh.numVertices == gpuMesh.numVertices);
+	REQUIRE(cpuMesh.numTriangles == gpuMesh.numTriangles);
+	REQUIRE(cpuSeamNodes.size() == gpuSeamNodes.size());
+
+	// the seam nodes aren't packed so can be compared directly, in the same order 
+	const auto seamNodeLess = [](const SeamNodeInfo& a, const SeamNodeInfo& b)
+	{
+		const glm::ivec4& p = a.localspaceMin;
+		const glm::ivec4& q = b.localspaceMin;
+		return std::tie(p.x, p.y, p.z) < std::tie(q.x, q.y, q.z);
+	};
+
+	std::sort(begin(cpuSeamNodes), end(cpuSeamNodes), seamNodeLess);
+	std::sort(begin(gpuSeamNodes), end(gpuSeamNodes), seamNodeLess);
+	for (size_t i = 0; i < cpuSeamNodes.size(); i++)
+	{
+		REQUIRE(cpuSeamNodes[i].localspaceMin == gpuSeamNodes[i].localspaceMin);
+		REQUIRE(glm::distance(glm::vec3(cpuSeamNodes[i].position), glm::vec3(gpuSeamNodes[i].position)) < 1e-3f);
+		REQUIRE(glm::distance(glm::vec3(cpuSeamNodes[i].normal), glm::vec3(gpuSeamNodes[i].normal)) < 1e-3f);
+	}
+
+	// the GPU vertices are quantised across the chunk (see PackedMeshVertex) and in a 
+	// different order, so look for a match within the packing error
+	const float tolerance = glm::length(glm::vec3((float)size / 65535.f)) * 2.f;
+	for (int i = 0; i < cpuMesh.numVertices; i++)
+	{
+		const glm::vec3 position(cpuMesh.vertices[i].xyz);
+		bool found = false;
+		for (int j = 0; j < gpuMesh.numVertices && !found; j++)
+		{
+			found = glm::distance(position, glm::vec3(gpuMesh.vertices[j].xyz)) < tolerance &&
+				cpuMesh.vertices[i].colour.w == gpuMesh.vertices[j].colour.w;
+		}
+
+		REQUIRE(found);
+	}
+
+	cpuMesh.release();
+	gpuMesh.release();
+	Compute_SetMeshExtractors("");
+	delete meshGen;
+}
+
+// Times the field generation and the meshing of the same chunks with the linear and the
+// bricked field layouts (see field_index in cl/shared_constants.cl). Hidden, run it 
+// explicitly with the [benchmark] tag.
+TEST_CASE("Compute (Field Layout) Benchmark", "[.] [benchmark] [compute]")
+{
+	REQUIRE(EnsureComputeInitialised() == CL_SUCCESS);
+	ComputeContext* ctx = GetComputeContext();
+
+	// a 4x4 block of columns around the origin, most of the columns cross the surface 
+	const int size = CLIPMAP_LEAF_SIZE;
+	std::vector<glm::ivec3> chunks;
+	for (int x = -2; x < 2; x++)
+	for (int y = -2; y < 2; y++)
+	for (int z = -2; z < 2; z++)
+	{
+		chunks.push_back(glm::ivec3(x, y, z) * size);
+	}
+
+	int layoutTriangles[2] = { 0, 0 };
+	const int brickSizes[2] = { 0, FIELD_BRICK_SIZE_LOG2 };
+	for (int layout = 0; layout < 2; layout++)
+	{
+		MeshGenerationContext* meshGen = Compute_CreateMeshGenContext(CLIPMAP_VOXELS_PER_CHUNK, brickSizes[layout]);
+		REQUIRE(meshGen);
+		meshGen->computeCtx = ctx;
+
+		// the first launches of each kernel are slower, warm up away from the timed chunks
+		const auto countTriangles = [&](const ChunkMeshData& data) { layoutTriangles[layout] += data.numTriangles; };
+		for (int y = -2; y < 2; y++)
+		{
+			CL_REQUIRE(Compute_GenerateChunkMesh(meshGen, glm::ivec3(64, y, 64) * size, size, ALL_MESH_REGIONS, false, 
+				[](const ChunkMeshData&) {}));
+		}
+
+		CL_REQUIRE(ctx->queue.finish());
+
+		// LoadDensityField returns once the field's edges have been read back but finish 
+		// anyway so none of the work is counted in the meshing time
+		Timer timer;
+		timer.start();
+		for (const glm::ivec3& min: chunks)
+		{
+			GPUDensityField field;
+			CL_REQUIRE(LoadDensityField(meshGen, min, size, &field));
+		}
+
+		CL_REQUIRE(ctx->queue.finish());
+		const unsigned int fieldMicro = timer.elapsedMicro();
+
+		// the fields are cached so this is the octree construction and mesh generation
+		timer.start();
+		for (const glm::ivec3& min: chunks)
+		{
+			CL_REQUIRE(Compute_GenerateChunkMesh(meshGen, min, size, ALL_MESH_REGIONS, false, countTriangles));
+		}
+
+		CL_REQUIRE(ctx->queue.finish());
+		const unsigned int meshMicro = timer.elapsedMicro();
+
+		printf("%s layout: %d chunks, field generation %.1f us/chunk, meshing %.1f us/chunk (%d triangles)\n",
+			layout == 0 ? "linear" : "bricked", (int)chunks.size(), (float)fieldMicro / chunks.size(), 
+			(float)meshMicro / chunks.size(), layoutTriangles[layout]);
+
+		delete meshGen;
+	}
+
+	// the layout must not change the meshes for the timings to be comparable
+	REQUIRE(layoutTriangles[0] == layoutTriangles[1]);
 }
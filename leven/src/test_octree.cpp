@@ -0,0 +1,298 @@
+#include	<catch.hpp>
+#include	"octree.h"
+#include	"timer.h"
+
+#include	"testdata/seam_nodes_0.cpp"
+
+#include	<algorithm>
+#include	<random>
+#include	<stdio.h>
+#include	<unordered_map>
+#include	<vector>
+
+// ----------------------------------------------------------------------------
+
+// a seam-like input for a host node at the origin: the host's leafs along its max
+// faces, and the leafs on the other side of the faces which are a LOD larger (or two
+// for the edge and corner neighbours) as with the clipmap's neighbouring nodes
+static void CreateSeamInput(const int hostSize, std::vector<OctreeNode>& nodes)
+{
+	const int hostLeafSize = 4;
+	for (int x = 0; x < hostSize * 2; x += hostLeafSize)
+	for (int y = 0; y < hostSize * 2; y += hostLeafSize)
+	for (int z = 0; z < hostSize * 2; z += hostLeafSize)
+	{
+		const glm::ivec3 min(x, y, z);
+		const bool outside[3] = { x >= hostSize, y >= hostSize, z >= hostSize };
+		const int numOutside = outside[0] + outside[1] + outside[2];
+
+		const int size = hostLeafSize << glm::min(numOutside, 2);
+		if ((min % size) != glm::ivec3(0))
+		{
+			continue;
+		}
+
+		// the leafs touching the seam, i.e. the host's max faces or the neighbours' min faces
+		const bool onSeam = numOutside == 0 ?
+			x == (hostSize - hostLeafSize) || y == (hostSize - hostLeafSize) || z == (hostSize - hostLeafSize) :
+			(outside[0] && x == hostSize) || (outside[1] && y == hostSize) || (outside[2] && z == hostSize);
+		if (!onSeam)
+		{
+			continue;
+		}
+
+		OctreeNode node;
+		node.type = Node_Leaf;
+		node.min = min;
+		node.size = size;
+		nodes.push_back(node);
+	}
+}
+
+// ----------------------------------------------------------------------------
+
+// the node reached by following the children from the root
+static const OctreeNode* FindNode(const OctreeNode* root, const OctreeNode& node)
+{
+	const OctreeNode* n = root;
+	while (n && n->size > node.size)
+	{
+		const int childSize = n->size / 2;
+		const glm::ivec3 p = (node.min - n->min) / childSize;
+		n = n->children[(p.x << 2) | (p.y << 1) | p.z];
+	}
+
+	return n;
+}
+
+// ----------------------------------------------------------------------------
+
+// The hash map construction Octree_ConstructUpwards used before the levels were
+// Morton sorted, kept as the benchmark's baseline. Each parent is found by hashing
+// its min and the child index by comparing the child mins.
+static std::vector<OctreeNode*> HashMap_ConstructParents(
+	Octree* octree,
+	const std::vector<OctreeNode*>& nodes, 
+	const int parentSize, 
+	const glm::ivec3& rootMin)
+{
+	std::unordered_map<uint64_t, OctreeNode*> parentsHashmap;
+	for (OctreeNode* node: nodes)
+	{
+		const glm::ivec3 localPos = (node->min - rootMin);
+		const glm::ivec3 parentPos = node->min - (localPos % parentSize);
+		const glm::ivec3 parentLocalPos = parentPos - rootMin;
+		const uint64_t parentIndex = parentLocalPos.x | ((uint64_t)parentLocalPos.y << 20) | ((uint64_t)parentLocalPos.z << 40);
+
+		OctreeNode*& parentNode = parentsHashmap[parentIndex];
+		if (!parentNode)
+		{
+			parentNode = octree->allocNode();
+			parentNode->type = Node_Internal;
+			parentNode->min = parentPos;
+			parentNode->size = parentSize;
+		}
+
+		for (int i = 0; i < 8; i++)
+		{
+			const glm::ivec3 childPos = parentPos + ((parentSize / 2) * CHILD_MIN_OFFSETS[i]);
+			if (childPos == node->min)
+			{
+				parentNode->children[i] = node;
+				break;
+			}
+		}
+	}
+
+	std::vector<OctreeNode*> parents;
+	for (const auto& pair: parentsHashmap)
+	{
+		parents.push_back(pair.second);
+	}
+
+	return parents;
+}
+
+// ----------------------------------------------------------------------------
+
+static OctreeNode* HashMap_ConstructUpwards(
+	Octree* octree,
+	const std::vector<OctreeNode*>& inputNodes, 
+	const glm::ivec3& rootMin,
+	const int rootNodeSize)
+{
+	if (inputNodes.empty())
+	{
+		return nullptr;
+	}
+
+	std::vector<OctreeNode*> nodes(begin(inputNodes), end(inputNodes));
+	std::sort(begin(nodes), end(nodes), 
+		[](const OctreeNode* lhs, const OctreeNode* rhs)
+		{
+			return lhs->size < rhs->size;
+		});
+
+	// the runs of smaller nodes are constructed until all the nodes are the same size
+	while (nodes.front()->size != nodes.back()->size)
+	{
+		auto iter = begin(nodes);
+		const int size = (*iter)->size;
+		do
+		{
+			++iter;
+		} while ((*iter)->size == size);
+
+		std::vector<OctreeNode*> newNodes(begin(nodes), iter);
+		newNodes = HashMap_ConstructParents(octree, newNodes, size * 2, rootMin);
+		newNodes.insert(end(newNodes), iter, end(nodes));
+		std::swap(nodes, newNodes);
+	}
+
+	for (int parentSize = nodes.front()->size * 2; parentSize <= rootNodeSize; parentSize *= 2)
+	{
+		nodes = HashMap_ConstructParents(octree, nodes, parentSize, rootMin);
+	}
+
+	if (nodes.size() != 1)
+	{
+		return nullptr;
+	}
+
+	octree->setRoot(nodes.front());
+	return nodes.front();
+}
+
+// ----------------------------------------------------------------------------
+
+TEST_CASE("Octree (Construct Upwards)", "[octree]")
+{
+	const int hostSize = 256;
+	std::vector<OctreeNode> inputNodes;
+	CreateSeamInput(hostSize, inputNodes);
+
+	std::vector<OctreeNode*> nodes;
+	for (OctreeNode& node: inputNodes)
+	{
+		nodes.push_back(&node);
+	}
+
+	Octree octree;
+	const OctreeNode* root = Octree_ConstructUpwards(&octree, nodes, glm::ivec3(0), hostSize * 2);
+	REQUIRE(root);
+	REQUIRE(root == octree.getRoot());
+	REQUIRE(root->min == glm::ivec3(0));
+	REQUIRE(root->size == hostSize * 2);
+
+	for (const OctreeNode& node: inputNodes)
+	{
+		REQUIRE(FindNode(root, node) == &node);
+	}
+
+	// the benchmark's baseline must build the same tree for the timings to be comparable
+	Octree baseline;
+	const OctreeNode* baselineRoot = HashMap_ConstructUpwards(&baseline, nodes, glm::ivec3(0), hostSize * 2);
+	REQUIRE(baselineRoot);
+	for (const OctreeNode& node: inputNodes)
+	{
+		REQUIRE(FindNode(baselineRoot, node) == &node);
+	}
+
+	Octree empty;
+	REQUIRE(!Octree_ConstructUpwards(&empty, std::vector<OctreeNode*>(), glm::ivec3(0), hostSize * 2));
+}
+
+// ----------------------------------------------------------------------------
+
+typedef OctreeNode* (*ConstructUpwardsFunc)(Octree*, const std::vector<OctreeNode*>&, const glm::ivec3&, const int);
+
+struct BenchmarkSeam
+{
+	glm::ivec3					rootMin;
+	int							rootSize = 0;
+	std::vector<OctreeNode>		nodes;
+};
+
+// ----------------------------------------------------------------------------
+
+static unsigned int TimeConstruction(
+	ConstructUpwardsFunc construct, 
+	BenchmarkSeam& seam,
+	const int iterations)
+{
+	std::vector<OctreeNode*> nodes;
+	for (OctreeNode& node: seam.nodes)
+	{
+		nodes.push_back(&node);
+	}
+
+	Timer timer;
+	timer.start();
+	for (int i = 0; i < iterations; i++)
+	{
+		for (OctreeNode& node: seam.nodes)
+		{
+			// the children are left set on the previous iteration's nodes otherwise
+			std::fill(node.children, node.children + 8, nullptr);
+		}
+
+		Octree octree;
+		REQUIRE(construct(&octree, nodes, seam.rootMin, seam.rootSize));
+	}
+
+	return timer.elapsedMicro();
+}
+
+// ----------------------------------------------------------------------------
+
+// Times Octree_ConstructUpwards against the hash map baseline on the recorded seam
+// (see testdata/gen_seam_data.py) and the procedural seams. Hidden, run it explicitly 
+// with the [benchmark] tag.
+TEST_CASE("Octree (Construct Upwards) Benchmark", "[.] [benchmark] [octree]")
+{
+	const int ITERATIONS = 16;
+
+	// the root min and size, the node count and then each node's min and size
+	std::vector<BenchmarkSeam> seams;
+	{
+		const int* data = SEAM_NODES_0;
+		BenchmarkSeam seam;
+		seam.rootMin = glm::ivec3(data[0], data[1], data[2]);
+		seam.rootSize = data[3];
+		seam.nodes.resize(data[4]);
+		data += 5;
+		for (OctreeNode& node: seam.nodes)
+		{
+			node.type = Node_Leaf;
+			node.min = glm::ivec3(data[0], data[1], data[2]);
+			node.size = data[3];
+			data += 4;
+		}
+
+		seams.push_back(seam);
+	}
+
+	// shuffled as the clipmap's seam nodes aren't in any particular order either
+	std::mt19937 prng(42);
+	for (const int hostSize: { 64, 256 })
+	{
+		BenchmarkSeam seam;
+		seam.rootMin = glm::ivec3(0);
+		seam.rootSize = hostSize * 2;
+		CreateSeamInput(hostSize, seam.nodes);
+		std::shuffle(begin(seam.nodes), end(seam.nodes), prng);
+		seams.push_back(seam);
+	}
+
+	for (BenchmarkSeam& seam: seams)
+	{
+		const unsigned int baselineMicro = TimeConstruction(HashMap_ConstructUpwards, seam, ITERATIONS);
+		const unsigned int sortedMicro = TimeConstruction(Octree_ConstructUpwards, seam, ITERATIONS);
+
+		printf("%d nodes: hash map %.1f us, Morton sorted %.1f us (%.2fx)\n",
+			(int)seam.nodes.size(), (float)baselineMicro / ITERATIONS, (float)sortedMicro / ITERATIONS, 
+			(float)baselineMicro / glm::max(sortedMicro, 1u));
+	}
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+import sys
+import os
+import re
+
+# Builds a clipmap seam from the recorded chunks in octree_keys_*.cpp for the octree
+# benchmark in test_octree.cpp. The recordings hold every node code of a 64^3 chunk's
+# octree, the leafs (the longest codes) are the chunk's active voxels.
+#
+# The host chunk is at the origin with its 7 neighbours around its max corner, as in
+# GenerateClipmapSeamMesh. The +X neighbour is subdivided into 8 chunks a LOD smaller
+# so the seam mixes two node sizes. Each chunk's seam nodes are the leafs on its faces
+# (see FindSeamNodes in octree.cl) and are selected as SelectSeamNodes does. The chunks
+# are different parts of the terrain so the surfaces don't line up across the faces,
+# only the node counts and the distribution within each chunk are recorded ones.
+#
+# The output matches the RECORD format the benchmark used to read from disk: the root
+# min and size, the node count and then the min and size of each node.
+
+VOXELS_PER_CHUNK = 64
+LEAF_SIZE_SCALE = 4
+CLIPMAP_LEAF_SIZE = LEAF_SIZE_SCALE * VOXELS_PER_CHUNK
+
+CHILD_MIN_OFFSETS = [
+	(0, 0, 0), (0, 0, 1), (0, 1, 0), (0, 1, 1),
+	(1, 0, 0), (1, 0, 1), (1, 1, 0), (1, 1, 1),
+]
+
+RECORDINGS = [3, 28, 42, 91, 109, 119, 122, 136, 141, 146, 168, 184]
+
+def load_leafs(index):
+	with open('octree_keys_%d.cpp' % index, 'r') as f:
+		codes = [int(c, 16) for c in re.findall(r'0x[0-9a-fA-F]+', f.read())]
+
+	leafLength = max(c.bit_length() for c in codes)
+	leafs = []
+	for code in codes:
+		if code.bit_length() != leafLength:
+			continue
+
+		# see CodeForPosition in octree.cl, only the last 6 levels are used by a 64^3 chunk
+		x = y = z = 0
+		for level in range(5, -1, -1):
+			c = (code >> (level * 3)) & 7
+			x = (x << 1) | ((c >> 2) & 1)
+			y = (y << 1) | ((c >> 1) & 1)
+			z = (z << 1) | (c & 1)
+
+		leafs.append((x, y, z))
+
+	return leafs
+
+def chunk_seam_nodes(index, chunkMin, chunkSize):
+	last = VOXELS_PER_CHUNK - 1
+	leafSize = chunkSize // VOXELS_PER_CHUNK
+	nodes = []
+	for p in load_leafs(index):
+		if 0 in p or last in p:
+			nodes.append((tuple(chunkMin[i] + (p[i] * leafSize) for i in range(3)), leafSize))
+	return nodes
+
+def filter_seam_node(childIndex, seamBounds, nodeMin, nodeMax):
+	onMax = [nodeMax[i] == seamBounds[i] for i in range(3)]
+	onMin = [nodeMin[i] == seamBounds[i] for i in range(3)]
+	if childIndex == 0:
+		return onMax[0] or onMax[1] or onMax[2]
+
+	# the axes the neighbour is offset along, see FilterSeamNode in clipmap.cpp
+	offset = CHILD_MIN_OFFSETS[childIndex]
+	axes = [i for i in range(3) if offset[i]]
+	if childIndex == 7:
+		return all(onMin)
+	return any(onMin[i] for i in axes)
+
+def gen_seam_data(output_filename):
+	hostSize = CLIPMAP_LEAF_SIZE * 2
+	hostMin = (0, 0, 0)
+	seamBounds = tuple(hostMin[i] + hostSize for i in range(3))
+	recording = iter(RECORDINGS * 2)
+
+	selected = []
+	for childIndex, offset in enumerate(CHILD_MIN_OFFSETS):
+		neighbourMin = tuple(hostMin[i] + (offset[i] * hostSize) for i in range(3))
+		if childIndex == 4:
+			chunkSize = hostSize // 2
+			chunks = [tuple(neighbourMin[i] + (o[i] * chunkSize) for i in range(3)) for o in CHILD_MIN_OFFSETS]
+		else:
+			chunkSize = hostSize
+			chunks = [neighbourMin]
+
+		for chunkMin in chunks:
+			for nodeMin, size in chunk_seam_nodes(next(recording), chunkMin, chunkSize):
+				nodeMax = tuple(nodeMin[i] + size for i in range(3))
+				inside = all(hostMin[i] <= nodeMin[i] < hostMin[i] + (hostSize * 2) for i in range(3))
+				if inside and filter_seam_node(childIndex, seamBounds, nodeMin, nodeMax):
+					selected.append((nodeMin, size))
+
+	output_file = open(output_filename, 'w')
+	output_file.write('// generated by gen_seam_data.py, see test_octree.cpp\n')
+	output_file.write('const int %s[] =\n{\n' % os.path.splitext(os.path.basename(output_filename))[0].upper())
+	output_file.write('\t%d, %d, %d, %d, %d,\n' % (hostMin + (hostSize * 2, len(selected))))
+	for nodeMin, size in selected:
+		output_file.write('\t%d, %d, %d, %d,\n' % (nodeMin + (size,)))
+	output_file.write('};\n')
+	output_file.close()
+
+
+if __name__=='__main__':
+	sys.exit(gen_seam_data(sys.argv[1]))
@@ -0,0 +1,1498 @@
+// generated by gen_seam_data.py, see test_octree.cpp
+const int SEAM_NODES_0[] =
+{
+	0, 0, 0, 1024, 1493,
+	504, 432, 0, 8,
+	504, 440, 0, 8,
+	360, 504, 0, 8,
+	368, 504, 0, 8,
+	376, 504, 0, 8,
+	384, 504, 0, 8,
+	392, 504, 0, 8,
+	504, 424, 8, 8,
+	504, 432, 8, 8,
+	504, 416, 16, 8,
+	504, 424, 16, 8,
+	504, 408, 24, 8,
+	504, 416, 24, 8,
+	504, 400, 32, 8,
+	504, 408, 32, 8,
+	504, 392, 40, 8,
+	504, 400, 40, 8,
+	504, 384, 48, 8,
+	504, 392, 48, 8,
+	504, 376, 56, 8,
+	504, 384, 56, 8,
+	504, 376, 64, 8,
+	504, 368, 72, 8,
+	504, 376, 72, 8,
+	504, 368, 80, 8,
+	504, 360, 88, 8,
+	504, 368, 88, 8,
+	504, 352, 96, 8,
+	504, 360, 96, 8,
+	504, 344, 104, 8,
+	504, 352, 104, 8,
+	504, 328, 112, 8,
+	504, 336, 112, 8,
+	504, 344, 112, 8,
+	504, 320, 120, 8,
+	504, 328, 120, 8,
+	504, 312, 128, 8,
+	504, 320, 128, 8,
+	504, 304, 136, 8,
+	504, 312, 136, 8,
+	504, 296, 144, 8,
+	504, 304, 144, 8,
+	504, 288, 152, 8,
+	504, 296, 152, 8,
+	504, 280, 160, 8,
+	504, 288, 160, 8,
+	504, 272, 168, 8,
+	504, 280, 168, 8,
+	504, 264, 176, 8,
+	504, 272, 176, 8,
+	504, 280, 176, 8,
+	504, 256, 184, 8,
+	504, 264, 184, 8,
+	504, 248, 192, 8,
+	504, 256, 192, 8,
+	504, 248, 200, 8,
+	504, 256, 200, 8,
+	504, 240, 208, 8,
+	504, 248, 208, 8,
+	504, 232, 216, 8,
+	504, 240, 216, 8,
+	504, 232, 224, 8,
+	504, 224, 232, 8,
+	504, 232, 232, 8,
+	504, 216, 240, 8,
+	504, 224, 240, 8,
+	504, 208, 248, 8,
+	504, 216, 248, 8,
+	504, 208, 256, 8,
+	504, 200, 264, 8,
+	504, 208, 264, 8,
+	504, 200, 272, 8,
+	504, 192, 280, 8,
+	504, 200, 280, 8,
+	504, 192, 288, 8,
+	504, 200, 288, 8,
+	504, 184, 296, 8,
+	504, 192, 296, 8,
+	504, 176, 304, 8,
+	504, 184, 304, 8,
+	504, 168, 312, 8,
+	504, 176, 312, 8,
+	504, 160, 320, 8,
+	504, 168, 320, 8,
+	504, 160, 328, 8,
+	504, 168, 328, 8,
+	504, 152, 336, 8,
+	504, 160, 336, 8,
+	504, 152, 344, 8,
+	504, 144, 352, 8,
+	504, 152, 352, 8,
+	504, 136, 360, 8,
+	504, 144, 360, 8,
+	504, 128, 368, 8,
+	504, 136, 368, 8,
+	504, 144, 368, 8,
+	504, 120, 376, 8,
+	504, 128, 376, 8,
+	504, 136, 376, 8,
+	504, 112, 384, 8,
+	504, 120, 384, 8,
+	504, 128, 384, 8,
+	504, 112, 392, 8,
+	504, 120, 392, 8,
+	504, 104, 400, 8,
+	504, 112, 400, 8,
+	504, 96, 408, 8,
+	504, 104, 408, 8,
+	504, 96, 416, 8,
+	504, 104, 416, 8,
+	504, 88, 424, 8,
+	504, 96, 424, 8,
+	504, 88, 432, 8,
+	504, 96, 432, 8,
+	504, 80, 440, 8,
+	504, 88, 440, 8,
+	504, 72, 448, 8,
+	504, 80, 448, 8,
+	504, 64, 456, 8,
+	504, 72, 456, 8,
+	504, 64, 464, 8,
+	504, 56, 472, 8,
+	504, 64, 472, 8,
+	504, 56, 480, 8,
+	504, 48, 488, 8,
+	504, 56, 488, 8,
+	504, 40, 496, 8,
+	504, 48, 496, 8,
+	0, 8, 504, 8,
+	8, 8, 504, 8,
+	16, 8, 504, 8,
+	24, 8, 504, 8,
+	32, 8, 504, 8,
+	40, 8, 504, 8,
+	48, 8, 504, 8,
+	56, 8, 504, 8,
+	64, 8, 504, 8,
+	72, 8, 504, 8,
+	80, 8, 504, 8,
+	88, 8, 504, 8,
+	96, 8, 504, 8,
+	104, 8, 504, 8,
+	112, 8, 504, 8,
+	120, 8, 504, 8,
+	128, 8, 504, 8,
+	136, 8, 504, 8,
+	144, 8, 504, 8,
+	152, 8, 504, 8,
+	16, 16, 504, 8,
+	24, 16, 504, 8,
+	32, 16, 504, 8,
+	40, 16, 504, 8,
+	48, 16, 504, 8,
+	56, 16, 504, 8,
+	64, 16, 504, 8,
+	72, 16, 504, 8,
+	80, 16, 504, 8,
+	88, 16, 504, 8,
+	96, 16, 504, 8,
+	104, 16, 504, 8,
+	112, 16, 504, 8,
+	120, 16, 504, 8,
+	128, 16, 504, 8,
+	136, 16, 504, 8,
+	144, 16, 504, 8,
+	152, 16, 504, 8,
+	160, 16, 504, 8,
+	168, 16, 504, 8,
+	176, 16, 504, 8,
+	184, 16, 504, 8,
+	152, 24, 504, 8,
+	160, 24, 504, 8,
+	168, 24, 504, 8,
+	176, 24, 504, 8,
+	184, 24, 504, 8,
+	192, 24, 504, 8,
+	200, 24, 504, 8,
+	208, 24, 504, 8,
+	184, 32, 504, 8,
+	192, 32, 504, 8,
+	200, 32, 504, 8,
+	208, 32, 504, 8,
+	216, 32, 504, 8,
+	224, 32, 504, 8,
+	432, 32, 504, 8,
+	440, 32, 504, 8,
+	448, 32, 504, 8,
+	456, 32, 504, 8,
+	464, 32, 504, 8,
+	472, 32, 504, 8,
+	480, 32, 504, 8,
+	488, 32, 504, 8,
+	496, 32, 504, 8,
+	208, 40, 504, 8,
+	216, 40, 504, 8,
+	224, 40, 504, 8,
+	232, 40, 504, 8,
+	240, 40, 504, 8,
+	408, 40, 504, 8,
+	416, 40, 504, 8,
+	424, 40, 504, 8,
+	432, 40, 504, 8,
+	440, 40, 504, 8,
+	448, 40, 504, 8,
+	456, 40, 504, 8,
+	464, 40, 504, 8,
+	472, 40, 504, 8,
+	480, 40, 504, 8,
+	488, 40, 504, 8,
+	496, 40, 504, 8,
+	504, 40, 504, 8,
+	224, 48, 504, 8,
+	232, 48, 504, 8,
+	240, 48, 504, 8,
+	248, 48, 504, 8,
+	256, 48, 504, 8,
+	312, 48, 504, 8,
+	320, 48, 504, 8,
+	328, 48, 504, 8,
+	336, 48, 504, 8,
+	344, 48, 504, 8,
+	352, 48, 504, 8,
+	360, 48, 504, 8,
+	368, 48, 504, 8,
+	376, 48, 504, 8,
+	384, 48, 504, 8,
+	392, 48, 504, 8,
+	400, 48, 504, 8,
+	408, 48, 504, 8,
+	416, 48, 504, 8,
+	424, 48, 504, 8,
+	504, 48, 504, 8,
+	240, 56, 504, 8,
+	248, 56, 504, 8,
+	256, 56, 504, 8,
+	264, 56, 504, 8,
+	272, 56, 504, 8,
+	280, 56, 504, 8,
+	288, 56, 504, 8,
+	296, 56, 504, 8,
+	304, 56, 504, 8,
+	312, 56, 504, 8,
+	320, 56, 504, 8,
+	328, 56, 504, 8,
+	336, 56, 504, 8,
+	344, 56, 504, 8,
+	352, 56, 504, 8,
+	360, 56, 504, 8,
+	368, 56, 504, 8,
+	376, 56, 504, 8,
+	384, 56, 504, 8,
+	392, 56, 504, 8,
+	400, 56, 504, 8,
+	408, 56, 504, 8,
+	416, 56, 504, 8,
+	256, 64, 504, 8,
+	264, 64, 504, 8,
+	272, 64, 504, 8,
+	280, 64, 504, 8,
+	288, 64, 504, 8,
+	296, 64, 504, 8,
+	304, 64, 504, 8,
+	312, 64, 504, 8,
+	264, 72, 504, 8,
+	272, 72, 504, 8,
+	0, 336, 512, 8,
+	8, 336, 512, 8,
+	16, 336, 512, 8,
+	24, 336, 512, 8,
+	32, 336, 512, 8,
+	0, 344, 512, 8,
+	8, 344, 512, 8,
+	16, 344, 512, 8,
+	24, 344, 512, 8,
+	32, 344, 512, 8,
+	40, 344, 512, 8,
+	48, 344, 512, 8,
+	56, 344, 512, 8,
+	64, 344, 512, 8,
+	56, 352, 512, 8,
+	64, 352, 512, 8,
+	72, 352, 512, 8,
+	80, 352, 512, 8,
+	88, 352, 512, 8,
+	72, 360, 512, 8,
+	80, 360, 512, 8,
+	88, 360, 512, 8,
+	96, 360, 512, 8,
+	104, 360, 512, 8,
+	88, 368, 512, 8,
+	96, 368, 512, 8,
+	104, 368, 512, 8,
+	112, 368, 512, 8,
+	104, 376, 512, 8,
+	112, 376, 512, 8,
+	120, 376, 512, 8,
+	128, 376, 512, 8,
+	120, 384, 512, 8,
+	128, 384, 512, 8,
+	136, 384, 512, 8,
+	144, 384, 512, 8,
+	128, 392, 512, 8,
+	136, 392, 512, 8,
+	144, 392, 512, 8,
+	152, 392, 512, 8,
+	160, 392, 512, 8,
+	144, 400, 512, 8,
+	152, 400, 512, 8,
+	160, 400, 512, 8,
+	168, 400, 512, 8,
+	160, 408, 512, 8,
+	168, 408, 512, 8,
+	176, 408, 512, 8,
+	184, 408, 512, 8,
+	496, 408, 512, 8,
+	504, 408, 512, 8,
+	176, 416, 512, 8,
+	184, 416, 512, 8,
+	192, 416, 512, 8,
+	448, 416, 512, 8,
+	456, 416, 512, 8,
+	464, 416, 512, 8,
+	472, 416, 512, 8,
+	480, 416, 512, 8,
+	488, 416, 512, 8,
+	496, 416, 512, 8,
+	504, 416, 512, 8,
+	192, 424, 512, 8,
+	200, 424, 512, 8,
+	208, 424, 512, 8,
+	216, 424, 512, 8,
+	224, 424, 512, 8,
+	232, 424, 512, 8,
+	240, 424, 512, 8,
+	248, 424, 512, 8,
+	408, 424, 512, 8,
+	416, 424, 512, 8,
+	424, 424, 512, 8,
+	432, 424, 512, 8,
+	440, 424, 512, 8,
+	448, 424, 512, 8,
+	456, 424, 512, 8,
+	464, 424, 512, 8,
+	472, 424, 512, 8,
+	480, 424, 512, 8,
+	488, 424, 512, 8,
+	208, 432, 512, 8,
+	216, 432, 512, 8,
+	232, 432, 512, 8,
+	240, 432, 512, 8,
+	248, 432, 512, 8,
+	256, 432, 512, 8,
+	392, 432, 512, 8,
+	400, 432, 512, 8,
+	408, 432, 512, 8,
+	416, 432, 512, 8,
+	424, 432, 512, 8,
+	432, 432, 512, 8,
+	440, 432, 512, 8,
+	248, 440, 512, 8,
+	256, 440, 512, 8,
+	264, 440, 512, 8,
+	272, 440, 512, 8,
+	280, 440, 512, 8,
+	288, 440, 512, 8,
+	296, 440, 512, 8,
+	304, 440, 512, 8,
+	312, 440, 512, 8,
+	320, 440, 512, 8,
+	376, 440, 512, 8,
+	384, 440, 512, 8,
+	392, 440, 512, 8,
+	400, 440, 512, 8,
+	272, 448, 512, 8,
+	280, 448, 512, 8,
+	288, 448, 512, 8,
+	296, 448, 512, 8,
+	304, 448, 512, 8,
+	312, 448, 512, 8,
+	320, 448, 512, 8,
+	328, 448, 512, 8,
+	336, 448, 512, 8,
+	344, 448, 512, 8,
+	352, 448, 512, 8,
+	360, 448, 512, 8,
+	368, 448, 512, 8,
+	376, 448, 512, 8,
+	384, 448, 512, 8,
+	344, 456, 512, 8,
+	352, 456, 512, 8,
+	360, 456, 512, 8,
+	368, 456, 512, 8,
+	376, 456, 512, 8,
+	400, 512, 512, 8,
+	408, 512, 512, 8,
+	416, 512, 512, 8,
+	408, 520, 512, 8,
+	416, 520, 512, 8,
+	408, 528, 512, 8,
+	416, 528, 512, 8,
+	424, 528, 512, 8,
+	416, 536, 512, 8,
+	424, 536, 512, 8,
+	432, 536, 512, 8,
+	424, 544, 512, 8,
+	432, 544, 512, 8,
+	424, 552, 512, 8,
+	432, 552, 512, 8,
+	440, 552, 512, 8,
+	432, 560, 512, 8,
+	440, 560, 512, 8,
+	448, 560, 512, 8,
+	440, 568, 512, 8,
+	448, 568, 512, 8,
+	456, 568, 512, 8,
+	440, 576, 512, 8,
+	448, 576, 512, 8,
+	456, 576, 512, 8,
+	464, 576, 512, 8,
+	448, 584, 512, 8,
+	456, 584, 512, 8,
+	464, 584, 512, 8,
+	456, 592, 512, 8,
+	464, 592, 512, 8,
+	472, 592, 512, 8,
+	464, 600, 512, 8,
+	472, 600, 512, 8,
+	480, 600, 512, 8,
+	464, 608, 512, 8,
+	472, 608, 512, 8,
+	480, 608, 512, 8,
+	472, 616, 512, 8,
+	480, 616, 512, 8,
+	488, 616, 512, 8,
+	472, 624, 512, 8,
+	480, 624, 512, 8,
+	488, 624, 512, 8,
+	480, 632, 512, 8,
+	488, 632, 512, 8,
+	496, 632, 512, 8,
+	488, 640, 512, 8,
+	496, 640, 512, 8,
+	504, 640, 512, 8,
+	488, 648, 512, 8,
+	496, 648, 512, 8,
+	504, 648, 512, 8,
+	496, 656, 512, 8,
+	504, 656, 512, 8,
+	504, 664, 512, 8,
+	392, 512, 520, 8,
+	400, 512, 520, 8,
+	408, 512, 520, 8,
+	384, 512, 528, 8,
+	392, 512, 528, 8,
+	400, 512, 528, 8,
+	376, 512, 536, 8,
+	384, 512, 536, 8,
+	392, 512, 536, 8,
+	368, 512, 544, 8,
+	376, 512, 544, 8,
+	384, 512, 544, 8,
+	360, 512, 552, 8,
+	368, 512, 552, 8,
+	376, 512, 552, 8,
+	352, 512, 560, 8,
+	360, 512, 560, 8,
+	368, 512, 560, 8,
+	344, 512, 568, 8,
+	352, 512, 568, 8,
+	336, 512, 576, 8,
+	344, 512, 576, 8,
+	328, 512, 584, 8,
+	336, 512, 584, 8,
+	312, 512, 592, 8,
+	320, 512, 592, 8,
+	328, 512, 592, 8,
+	304, 512, 600, 8,
+	312, 512, 600, 8,
+	320, 512, 600, 8,
+	288, 512, 608, 8,
+	296, 512, 608, 8,
+	304, 512, 608, 8,
+	312, 512, 608, 8,
+	280, 512, 616, 8,
+	288, 512, 616, 8,
+	296, 512, 616, 8,
+	264, 512, 624, 8,
+	272, 512, 624, 8,
+	280, 512, 624, 8,
+	288, 512, 624, 8,
+	256, 512, 632, 8,
+	264, 512, 632, 8,
+	272, 512, 632, 8,
+	240, 512, 640, 8,
+	248, 512, 640, 8,
+	256, 512, 640, 8,
+	264, 512, 640, 8,
+	232, 512, 648, 8,
+	240, 512, 648, 8,
+	248, 512, 648, 8,
+	216, 512, 656, 8,
+	224, 512, 656, 8,
+	232, 512, 656, 8,
+	240, 512, 656, 8,
+	208, 512, 664, 8,
+	216, 512, 664, 8,
+	224, 512, 664, 8,
+	200, 512, 672, 8,
+	208, 512, 672, 8,
+	216, 512, 672, 8,
+	192, 512, 680, 8,
+	200, 512, 680, 8,
+	208, 512, 680, 8,
+	176, 512, 688, 8,
+	184, 512, 688, 8,
+	192, 512, 688, 8,
+	200, 512, 688, 8,
+	168, 512, 696, 8,
+	176, 512, 696, 8,
+	184, 512, 696, 8,
+	152, 512, 704, 8,
+	160, 512, 704, 8,
+	168, 512, 704, 8,
+	176, 512, 704, 8,
+	136, 512, 712, 8,
+	144, 512, 712, 8,
+	152, 512, 712, 8,
+	160, 512, 712, 8,
+	120, 512, 720, 8,
+	128, 512, 720, 8,
+	136, 512, 720, 8,
+	144, 512, 720, 8,
+	152, 512, 720, 8,
+	112, 512, 728, 8,
+	120, 512, 728, 8,
+	128, 512, 728, 8,
+	136, 512, 728, 8,
+	88, 512, 736, 8,
+	96, 512, 736, 8,
+	104, 512, 736, 8,
+	112, 512, 736, 8,
+	120, 512, 736, 8,
+	64, 512, 744, 8,
+	72, 512, 744, 8,
+	80, 512, 744, 8,
+	88, 512, 744, 8,
+	96, 512, 744, 8,
+	104, 512, 744, 8,
+	32, 512, 752, 8,
+	40, 512, 752, 8,
+	48, 512, 752, 8,
+	56, 512, 752, 8,
+	64, 512, 752, 8,
+	72, 512, 752, 8,
+	80, 512, 752, 8,
+	88, 512, 752, 8,
+	0, 512, 760, 8,
+	8, 512, 760, 8,
+	16, 512, 760, 8,
+	24, 512, 760, 8,
+	32, 512, 760, 8,
+	40, 512, 760, 8,
+	48, 512, 760, 8,
+	56, 512, 760, 8,
+	0, 512, 768, 8,
+	8, 512, 768, 8,
+	16, 512, 768, 8,
+	24, 512, 768, 8,
+	512, 0, 44, 4,
+	512, 0, 48, 4,
+	512, 4, 48, 4,
+	512, 0, 52, 4,
+	512, 4, 52, 4,
+	512, 4, 56, 4,
+	512, 8, 56, 4,
+	512, 8, 60, 4,
+	512, 8, 64, 4,
+	512, 12, 64, 4,
+	512, 12, 68, 4,
+	512, 16, 68, 4,
+	512, 16, 72, 4,
+	512, 20, 72, 4,
+	512, 16, 76, 4,
+	512, 20, 76, 4,
+	512, 24, 76, 4,
+	512, 20, 80, 4,
+	512, 24, 80, 4,
+	512, 28, 80, 4,
+	512, 28, 84, 4,
+	512, 32, 84, 4,
+	512, 32, 88, 4,
+	512, 36, 88, 4,
+	512, 36, 92, 4,
+	512, 40, 92, 4,
+	512, 40, 96, 4,
+	512, 44, 96, 4,
+	512, 44, 100, 4,
+	512, 48, 100, 4,
+	512, 48, 104, 4,
+	512, 52, 104, 4,
+	512, 48, 108, 4,
+	512, 52, 108, 4,
+	512, 56, 108, 4,
+	512, 52, 112, 4,
+	512, 56, 112, 4,
+	512, 56, 116, 4,
+	512, 60, 116, 4,
+	512, 60, 120, 4,
+	512, 64, 120, 4,
+	512, 68, 120, 4,
+	512, 64, 124, 4,
+	512, 68, 124, 4,
+	512, 72, 124, 4,
+	512, 72, 128, 4,
+	512, 76, 128, 4,
+	512, 76, 132, 4,
+	512, 80, 132, 4,
+	512, 84, 132, 4,
+	512, 80, 136, 4,
+	512, 84, 136, 4,
+	512, 88, 136, 4,
+	512, 88, 140, 4,
+	512, 92, 140, 4,
+	512, 96, 140, 4,
+	512, 96, 144, 4,
+	512, 100, 144, 4,
+	512, 100, 148, 4,
+	512, 104, 148, 4,
+	512, 108, 148, 4,
+	512, 104, 152, 4,
+	512, 108, 152, 4,
+	512, 112, 152, 4,
+	512, 108, 156, 4,
+	512, 112, 156, 4,
+	512, 116, 156, 4,
+	512, 112, 160, 4,
+	512, 116, 160, 4,
+	512, 120, 160, 4,
+	512, 116, 164, 4,
+	512, 120, 164, 4,
+	512, 120, 168, 4,
+	512, 124, 168, 4,
+	512, 124, 172, 4,
+	512, 128, 172, 4,
+	512, 128, 176, 4,
+	512, 132, 176, 4,
+	512, 132, 180, 4,
+	512, 136, 180, 4,
+	512, 136, 184, 4,
+	512, 140, 184, 4,
+	512, 144, 184, 4,
+	512, 140, 188, 4,
+	512, 144, 188, 4,
+	512, 148, 188, 4,
+	512, 144, 192, 4,
+	512, 148, 192, 4,
+	512, 152, 192, 4,
+	512, 152, 196, 4,
+	512, 156, 196, 4,
+	512, 160, 196, 4,
+	512, 156, 200, 4,
+	512, 160, 200, 4,
+	512, 164, 200, 4,
+	512, 164, 204, 4,
+	512, 168, 204, 4,
+	512, 168, 208, 4,
+	512, 172, 208, 4,
+	512, 176, 208, 4,
+	512, 176, 212, 4,
+	512, 180, 212, 4,
+	512, 180, 216, 4,
+	512, 184, 216, 4,
+	512, 184, 220, 4,
+	512, 188, 220, 4,
+	512, 188, 224, 4,
+	512, 192, 224, 4,
+	512, 192, 228, 4,
+	512, 196, 228, 4,
+	512, 200, 228, 4,
+	512, 200, 232, 4,
+	512, 204, 232, 4,
+	512, 204, 236, 4,
+	512, 208, 236, 4,
+	512, 212, 236, 4,
+	512, 212, 240, 4,
+	512, 216, 240, 4,
+	512, 220, 240, 4,
+	512, 216, 244, 4,
+	512, 220, 244, 4,
+	512, 224, 244, 4,
+	512, 224, 248, 4,
+	512, 228, 248, 4,
+	512, 232, 248, 4,
+	512, 232, 252, 4,
+	512, 236, 252, 4,
+	512, 240, 252, 4,
+	512, 244, 256, 4,
+	512, 240, 260, 4,
+	512, 244, 260, 4,
+	512, 240, 264, 4,
+	512, 244, 264, 4,
+	512, 236, 268, 4,
+	512, 240, 268, 4,
+	512, 244, 268, 4,
+	512, 232, 272, 4,
+	512, 236, 272, 4,
+	512, 240, 272, 4,
+	512, 228, 276, 4,
+	512, 232, 276, 4,
+	512, 236, 276, 4,
+	512, 228, 280, 4,
+	512, 232, 280, 4,
+	512, 224, 284, 4,
+	512, 228, 284, 4,
+	512, 220, 288, 4,
+	512, 224, 288, 4,
+	512, 216, 292, 4,
+	512, 220, 292, 4,
+	512, 208, 296, 4,
+	512, 212, 296, 4,
+	512, 216, 296, 4,
+	512, 204, 300, 4,
+	512, 208, 300, 4,
+	512, 212, 300, 4,
+	512, 196, 304, 4,
+	512, 200, 304, 4,
+	512, 204, 304, 4,
+	512, 188, 308, 4,
+	512, 192, 308, 4,
+	512, 196, 308, 4,
+	512, 200, 308, 4,
+	512, 180, 312, 4,
+	512, 184, 312, 4,
+	512, 188, 312, 4,
+	512, 192, 312, 4,
+	512, 176, 316, 4,
+	512, 180, 316, 4,
+	512, 184, 316, 4,
+	512, 172, 320, 4,
+	512, 176, 320, 4,
+	512, 180, 320, 4,
+	512, 168, 324, 4,
+	512, 172, 324, 4,
+	512, 176, 324, 4,
+	512, 160, 328, 4,
+	512, 164, 328, 4,
+	512, 168, 328, 4,
+	512, 172, 328, 4,
+	512, 156, 332, 4,
+	512, 160, 332, 4,
+	512, 164, 332, 4,
+	512, 152, 336, 4,
+	512, 156, 336, 4,
+	512, 160, 336, 4,
+	512, 144, 340, 4,
+	512, 148, 340, 4,
+	512, 152, 340, 4,
+	512, 144, 344, 4,
+	512, 148, 344, 4,
+	512, 140, 348, 4,
+	512, 144, 348, 4,
+	512, 136, 352, 4,
+	512, 140, 352, 4,
+	512, 132, 356, 4,
+	512, 136, 356, 4,
+	512, 140, 356, 4,
+	512, 132, 360, 4,
+	512, 136, 360, 4,
+	512, 128, 364, 4,
+	512, 132, 364, 4,
+	512, 128, 368, 4,
+	512, 132, 368, 4,
+	512, 128, 372, 4,
+	512, 124, 376, 4,
+	512, 128, 376, 4,
+	512, 120, 380, 4,
+	512, 124, 380, 4,
+	512, 120, 384, 4,
+	512, 124, 384, 4,
+	512, 116, 388, 4,
+	512, 120, 388, 4,
+	512, 112, 392, 4,
+	512, 116, 392, 4,
+	512, 108, 396, 4,
+	512, 112, 396, 4,
+	512, 104, 400, 4,
+	512, 108, 400, 4,
+	512, 100, 404, 4,
+	512, 104, 404, 4,
+	512, 96, 408, 4,
+	512, 100, 408, 4,
+	512, 88, 412, 4,
+	512, 92, 412, 4,
+	512, 96, 412, 4,
+	512, 80, 416, 4,
+	512, 84, 416, 4,
+	512, 88, 416, 4,
+	512, 76, 420, 4,
+	512, 80, 420, 4,
+	512, 84, 420, 4,
+	512, 72, 424, 4,
+	512, 76, 424, 4,
+	512, 68, 428, 4,
+	512, 72, 428, 4,
+	512, 64, 432, 4,
+	512, 68, 432, 4,
+	512, 60, 436, 4,
+	512, 64, 436, 4,
+	512, 60, 440, 4,
+	512, 56, 444, 4,
+	512, 60, 444, 4,
+	512, 56, 448, 4,
+	512, 52, 452, 4,
+	512, 56, 452, 4,
+	512, 52, 456, 4,
+	512, 48, 460, 4,
+	512, 52, 460, 4,
+	512, 44, 464, 4,
+	512, 48, 464, 4,
+	512, 44, 468, 4,
+	512, 48, 468, 4,
+	512, 40, 472, 4,
+	512, 44, 472, 4,
+	512, 40, 476, 4,
+	512, 44, 476, 4,
+	512, 36, 480, 4,
+	512, 40, 480, 4,
+	512, 36, 484, 4,
+	512, 40, 484, 4,
+	512, 32, 488, 4,
+	512, 36, 488, 4,
+	512, 28, 492, 4,
+	512, 32, 492, 4,
+	512, 28, 496, 4,
+	512, 32, 496, 4,
+	512, 24, 500, 4,
+	512, 28, 500, 4,
+	512, 24, 504, 4,
+	512, 28, 504, 4,
+	512, 24, 508, 4,
+	512, 28, 508, 4,
+	512, 380, 0, 4,
+	512, 384, 0, 4,
+	512, 388, 0, 4,
+	512, 384, 4, 4,
+	512, 388, 4, 4,
+	512, 392, 4, 4,
+	512, 392, 8, 4,
+	512, 392, 12, 4,
+	512, 396, 12, 4,
+	512, 392, 16, 4,
+	512, 396, 16, 4,
+	512, 396, 20, 4,
+	512, 396, 24, 4,
+	512, 400, 24, 4,
+	512, 396, 28, 4,
+	512, 400, 28, 4,
+	512, 404, 28, 4,
+	512, 396, 32, 4,
+	512, 400, 32, 4,
+	512, 404, 32, 4,
+	512, 400, 36, 4,
+	512, 404, 36, 4,
+	512, 408, 36, 4,
+	512, 400, 40, 4,
+	512, 404, 40, 4,
+	512, 408, 40, 4,
+	512, 404, 44, 4,
+	512, 408, 44, 4,
+	512, 404, 48, 4,
+	512, 404, 52, 4,
+	512, 400, 56, 4,
+	512, 404, 56, 4,
+	512, 396, 60, 4,
+	512, 400, 60, 4,
+	512, 404, 60, 4,
+	512, 396, 64, 4,
+	512, 400, 64, 4,
+	512, 392, 68, 4,
+	512, 396, 68, 4,
+	512, 388, 72, 4,
+	512, 392, 72, 4,
+	512, 388, 76, 4,
+	512, 392, 76, 4,
+	512, 384, 80, 4,
+	512, 388, 80, 4,
+	512, 384, 84, 4,
+	512, 388, 84, 4,
+	512, 384, 88, 4,
+	512, 384, 92, 4,
+	512, 384, 96, 4,
+	512, 388, 96, 4,
+	512, 384, 100, 4,
+	512, 388, 100, 4,
+	512, 384, 104, 4,
+	512, 388, 104, 4,
+	512, 384, 108, 4,
+	512, 388, 108, 4,
+	512, 380, 112, 4,
+	512, 384, 112, 4,
+	512, 388, 112, 4,
+	512, 380, 116, 4,
+	512, 384, 116, 4,
+	512, 380, 120, 4,
+	512, 384, 120, 4,
+	512, 380, 124, 4,
+	512, 376, 128, 4,
+	512, 380, 128, 4,
+	512, 376, 132, 4,
+	512, 380, 132, 4,
+	512, 376, 136, 4,
+	512, 380, 136, 4,
+	512, 376, 140, 4,
+	512, 380, 140, 4,
+	512, 376, 144, 4,
+	512, 372, 148, 4,
+	512, 376, 148, 4,
+	512, 364, 152, 4,
+	512, 368, 152, 4,
+	512, 372, 152, 4,
+	512, 360, 156, 4,
+	512, 364, 156, 4,
+	512, 368, 156, 4,
+	512, 352, 160, 4,
+	512, 356, 160, 4,
+	512, 360, 160, 4,
+	512, 344, 164, 4,
+	512, 348, 164, 4,
+	512, 352, 164, 4,
+	512, 340, 168, 4,
+	512, 344, 168, 4,
+	512, 348, 168, 4,
+	512, 336, 172, 4,
+	512, 340, 172, 4,
+	512, 344, 172, 4,
+	512, 332, 176, 4,
+	512, 336, 176, 4,
+	512, 328, 180, 4,
+	512, 332, 180, 4,
+	512, 320, 184, 4,
+	512, 324, 184, 4,
+	512, 328, 184, 4,
+	512, 316, 188, 4,
+	512, 320, 188, 4,
+	512, 324, 188, 4,
+	512, 312, 192, 4,
+	512, 316, 192, 4,
+	512, 320, 192, 4,
+	512, 304, 196, 4,
+	512, 308, 196, 4,
+	512, 312, 196, 4,
+	512, 316, 196, 4,
+	512, 300, 200, 4,
+	512, 304, 200, 4,
+	512, 308, 200, 4,
+	512, 312, 200, 4,
+	512, 296, 204, 4,
+	512, 300, 204, 4,
+	512, 304, 204, 4,
+	512, 308, 204, 4,
+	512, 292, 208, 4,
+	512, 296, 208, 4,
+	512, 300, 208, 4,
+	512, 288, 212, 4,
+	512, 292, 212, 4,
+	512, 296, 212, 4,
+	512, 280, 216, 4,
+	512, 284, 216, 4,
+	512, 288, 216, 4,
+	512, 292, 216, 4,
+	512, 276, 220, 4,
+	512, 280, 220, 4,
+	512, 284, 220, 4,
+	512, 268, 224, 4,
+	512, 272, 224, 4,
+	512, 276, 224, 4,
+	512, 264, 228, 4,
+	512, 268, 228, 4,
+	512, 272, 228, 4,
+	512, 260, 232, 4,
+	512, 264, 232, 4,
+	512, 256, 236, 4,
+	512, 260, 236, 4,
+	512, 256, 240, 4,
+	512, 420, 256, 4,
+	512, 424, 256, 4,
+	512, 420, 260, 4,
+	512, 424, 260, 4,
+	512, 416, 264, 4,
+	512, 420, 264, 4,
+	512, 416, 268, 4,
+	512, 420, 268, 4,
+	512, 416, 272, 4,
+	512, 412, 276, 4,
+	512, 416, 276, 4,
+	512, 412, 280, 4,
+	512, 412, 284, 4,
+	512, 408, 288, 4,
+	512, 412, 288, 4,
+	512, 408, 292, 4,
+	512, 412, 292, 4,
+	512, 408, 296, 4,
+	512, 408, 300, 4,
+	512, 404, 304, 4,
+	512, 408, 304, 4,
+	512, 404, 308, 4,
+	512, 408, 308, 4,
+	512, 404, 312, 4,
+	512, 408, 312, 4,
+	512, 404, 316, 4,
+	512, 408, 316, 4,
+	512, 404, 320, 4,
+	512, 408, 320, 4,
+	512, 408, 324, 4,
+	512, 408, 328, 4,
+	512, 408, 332, 4,
+	512, 408, 336, 4,
+	512, 412, 336, 4,
+	512, 408, 340, 4,
+	512, 412, 340, 4,
+	512, 412, 344, 4,
+	512, 416, 344, 4,
+	512, 416, 348, 4,
+	512, 420, 348, 4,
+	512, 416, 352, 4,
+	512, 420, 352, 4,
+	512, 416, 356, 4,
+	512, 420, 356, 4,
+	512, 416, 360, 4,
+	512, 420, 360, 4,
+	512, 420, 364, 4,
+	512, 420, 368, 4,
+	512, 424, 368, 4,
+	512, 424, 372, 4,
+	512, 424, 376, 4,
+	512, 424, 380, 4,
+	512, 424, 384, 4,
+	512, 424, 388, 4,
+	512, 420, 392, 4,
+	512, 424, 392, 4,
+	512, 416, 396, 4,
+	512, 420, 396, 4,
+	512, 412, 400, 4,
+	512, 416, 400, 4,
+	512, 412, 404, 4,
+	512, 408, 408, 4,
+	512, 412, 408, 4,
+	512, 404, 412, 4,
+	512, 408, 412, 4,
+	512, 396, 416, 4,
+	512, 400, 416, 4,
+	512, 404, 416, 4,
+	512, 388, 420, 4,
+	512, 392, 420, 4,
+	512, 396, 420, 4,
+	512, 384, 424, 4,
+	512, 388, 424, 4,
+	512, 392, 424, 4,
+	512, 376, 428, 4,
+	512, 380, 428, 4,
+	512, 384, 428, 4,
+	512, 368, 432, 4,
+	512, 372, 432, 4,
+	512, 376, 432, 4,
+	512, 364, 436, 4,
+	512, 368, 436, 4,
+	512, 356, 440, 4,
+	512, 360, 440, 4,
+	512, 364, 440, 4,
+	512, 352, 444, 4,
+	512, 356, 444, 4,
+	512, 348, 448, 4,
+	512, 352, 448, 4,
+	512, 344, 452, 4,
+	512, 348, 452, 4,
+	512, 336, 456, 4,
+	512, 340, 456, 4,
+	512, 344, 456, 4,
+	512, 332, 460, 4,
+	512, 336, 460, 4,
+	512, 340, 460, 4,
+	512, 328, 464, 4,
+	512, 332, 464, 4,
+	512, 336, 464, 4,
+	512, 328, 468, 4,
+	512, 332, 468, 4,
+	512, 328, 472, 4,
+	512, 324, 476, 4,
+	512, 328, 476, 4,
+	512, 320, 480, 4,
+	512, 324, 480, 4,
+	512, 320, 484, 4,
+	512, 316, 488, 4,
+	512, 320, 488, 4,
+	512, 312, 492, 4,
+	512, 316, 492, 4,
+	512, 312, 496, 4,
+	512, 308, 500, 4,
+	512, 312, 500, 4,
+	512, 308, 504, 4,
+	512, 304, 508, 4,
+	512, 308, 508, 4,
+	512, 368, 512, 8,
+	520, 368, 512, 8,
+	528, 368, 512, 8,
+	536, 368, 512, 8,
+	544, 368, 512, 8,
+	552, 368, 512, 8,
+	560, 368, 512, 8,
+	568, 368, 512, 8,
+	512, 376, 512, 8,
+	520, 376, 512, 8,
+	528, 376, 512, 8,
+	536, 376, 512, 8,
+	544, 376, 512, 8,
+	552, 376, 512, 8,
+	560, 376, 512, 8,
+	568, 376, 512, 8,
+	576, 376, 512, 8,
+	584, 376, 512, 8,
+	576, 384, 512, 8,
+	584, 384, 512, 8,
+	592, 384, 512, 8,
+	600, 384, 512, 8,
+	592, 392, 512, 8,
+	600, 392, 512, 8,
+	608, 392, 512, 8,
+	616, 392, 512, 8,
+	608, 400, 512, 8,
+	616, 400, 512, 8,
+	624, 400, 512, 8,
+	616, 408, 512, 8,
+	624, 408, 512, 8,
+	632, 408, 512, 8,
+	640, 408, 512, 8,
+	632, 416, 512, 8,
+	640, 416, 512, 8,
+	648, 416, 512, 8,
+	656, 416, 512, 8,
+	664, 416, 512, 8,
+	672, 416, 512, 8,
+	680, 416, 512, 8,
+	688, 416, 512, 8,
+	696, 416, 512, 8,
+	704, 416, 512, 8,
+	712, 416, 512, 8,
+	720, 416, 512, 8,
+	728, 416, 512, 8,
+	640, 424, 512, 8,
+	648, 424, 512, 8,
+	656, 424, 512, 8,
+	664, 424, 512, 8,
+	672, 424, 512, 8,
+	680, 424, 512, 8,
+	704, 424, 512, 8,
+	712, 424, 512, 8,
+	720, 424, 512, 8,
+	728, 424, 512, 8,
+	736, 424, 512, 8,
+	728, 432, 512, 8,
+	736, 432, 512, 8,
+	744, 432, 512, 8,
+	752, 432, 512, 8,
+	992, 432, 512, 8,
+	1000, 432, 512, 8,
+	1008, 432, 512, 8,
+	1016, 432, 512, 8,
+	744, 440, 512, 8,
+	752, 440, 512, 8,
+	760, 440, 512, 8,
+	976, 440, 512, 8,
+	984, 440, 512, 8,
+	992, 440, 512, 8,
+	1000, 440, 512, 8,
+	1008, 440, 512, 8,
+	1016, 440, 512, 8,
+	760, 448, 512, 8,
+	768, 448, 512, 8,
+	968, 448, 512, 8,
+	976, 448, 512, 8,
+	984, 448, 512, 8,
+	992, 448, 512, 8,
+	1000, 448, 512, 8,
+	768, 456, 512, 8,
+	776, 456, 512, 8,
+	784, 456, 512, 8,
+	792, 456, 512, 8,
+	960, 456, 512, 8,
+	968, 456, 512, 8,
+	976, 456, 512, 8,
+	984, 456, 512, 8,
+	784, 464, 512, 8,
+	792, 464, 512, 8,
+	800, 464, 512, 8,
+	808, 464, 512, 8,
+	816, 464, 512, 8,
+	824, 464, 512, 8,
+	936, 464, 512, 8,
+	944, 464, 512, 8,
+	952, 464, 512, 8,
+	960, 464, 512, 8,
+	968, 464, 512, 8,
+	976, 464, 512, 8,
+	792, 472, 512, 8,
+	800, 472, 512, 8,
+	808, 472, 512, 8,
+	816, 472, 512, 8,
+	824, 472, 512, 8,
+	832, 472, 512, 8,
+	840, 472, 512, 8,
+	920, 472, 512, 8,
+	928, 472, 512, 8,
+	936, 472, 512, 8,
+	944, 472, 512, 8,
+	952, 472, 512, 8,
+	960, 472, 512, 8,
+	968, 472, 512, 8,
+	824, 480, 512, 8,
+	832, 480, 512, 8,
+	840, 480, 512, 8,
+	848, 480, 512, 8,
+	912, 480, 512, 8,
+	920, 480, 512, 8,
+	928, 480, 512, 8,
+	936, 480, 512, 8,
+	944, 480, 512, 8,
+	840, 488, 512, 8,
+	848, 488, 512, 8,
+	856, 488, 512, 8,
+	864, 488, 512, 8,
+	872, 488, 512, 8,
+	880, 488, 512, 8,
+	904, 488, 512, 8,
+	912, 488, 512, 8,
+	920, 488, 512, 8,
+	848, 496, 512, 8,
+	856, 496, 512, 8,
+	864, 496, 512, 8,
+	872, 496, 512, 8,
+	880, 496, 512, 8,
+	888, 496, 512, 8,
+	896, 496, 512, 8,
+	904, 496, 512, 8,
+	912, 496, 512, 8,
+	872, 504, 512, 8,
+	880, 504, 512, 8,
+	888, 504, 512, 8,
+	896, 504, 512, 8,
+	904, 504, 512, 8,
+	512, 360, 520, 8,
+	512, 368, 520, 8,
+	512, 360, 528, 8,
+	512, 352, 536, 8,
+	512, 360, 536, 8,
+	512, 344, 544, 8,
+	512, 352, 544, 8,
+	512, 344, 552, 8,
+	512, 336, 560, 8,
+	512, 344, 560, 8,
+	512, 336, 568, 8,
+	512, 328, 576, 8,
+	512, 336, 576, 8,
+	512, 328, 584, 8,
+	512, 328, 592, 8,
+	512, 320, 600, 8,
+	512, 328, 600, 8,
+	512, 312, 608, 8,
+	512, 320, 608, 8,
+	512, 304, 616, 8,
+	512, 312, 616, 8,
+	512, 304, 624, 8,
+	512, 296, 632, 8,
+	512, 304, 632, 8,
+	512, 296, 640, 8,
+	512, 288, 648, 8,
+	512, 296, 648, 8,
+	512, 288, 656, 8,
+	512, 288, 664, 8,
+	512, 280, 672, 8,
+	512, 288, 672, 8,
+	512, 280, 680, 8,
+	512, 280, 688, 8,
+	512, 280, 696, 8,
+	512, 272, 704, 8,
+	512, 280, 704, 8,
+	512, 264, 712, 8,
+	512, 272, 712, 8,
+	512, 256, 720, 8,
+	512, 264, 720, 8,
+	512, 248, 728, 8,
+	512, 256, 728, 8,
+	512, 240, 736, 8,
+	512, 248, 736, 8,
+	512, 232, 744, 8,
+	512, 240, 744, 8,
+	512, 224, 752, 8,
+	512, 232, 752, 8,
+	512, 216, 760, 8,
+	512, 224, 760, 8,
+	512, 216, 768, 8,
+	512, 224, 768, 8,
+	512, 216, 776, 8,
+	512, 208, 784, 8,
+	512, 216, 784, 8,
+	512, 208, 792, 8,
+	512, 216, 792, 8,
+	512, 208, 800, 8,
+	512, 216, 800, 8,
+	512, 208, 808, 8,
+	512, 216, 808, 8,
+	512, 200, 816, 8,
+	512, 208, 816, 8,
+	512, 200, 824, 8,
+	512, 208, 824, 8,
+	512, 192, 832, 8,
+	512, 200, 832, 8,
+	512, 176, 840, 8,
+	512, 184, 840, 8,
+	512, 192, 840, 8,
+	512, 168, 848, 8,
+	512, 176, 848, 8,
+	512, 184, 848, 8,
+	512, 152, 856, 8,
+	512, 160, 856, 8,
+	512, 168, 856, 8,
+	512, 144, 864, 8,
+	512, 152, 864, 8,
+	512, 160, 864, 8,
+	512, 136, 872, 8,
+	512, 144, 872, 8,
+	512, 120, 880, 8,
+	512, 128, 880, 8,
+	512, 136, 880, 8,
+	512, 112, 888, 8,
+	512, 120, 888, 8,
+	512, 128, 888, 8,
+	512, 112, 896, 8,
+	512, 120, 896, 8,
+	512, 104, 904, 8,
+	512, 112, 904, 8,
+	512, 96, 912, 8,
+	512, 104, 912, 8,
+	512, 88, 920, 8,
+	512, 96, 920, 8,
+	512, 80, 928, 8,
+	512, 88, 928, 8,
+	512, 72, 936, 8,
+	512, 80, 936, 8,
+	512, 64, 944, 8,
+	512, 72, 944, 8,
+	512, 56, 952, 8,
+	512, 64, 952, 8,
+	512, 48, 960, 8,
+	512, 56, 960, 8,
+	512, 40, 968, 8,
+	512, 48, 968, 8,
+	512, 32, 976, 8,
+	512, 40, 976, 8,
+	512, 32, 984, 8,
+	512, 24, 992, 8,
+	512, 32, 992, 8,
+	512, 16, 1000, 8,
+	512, 24, 1000, 8,
+	512, 8, 1008, 8,
+	512, 16, 1008, 8,
+	512, 8, 1016, 8,
+	512, 848, 0, 8,
+	512, 856, 0, 8,
+	512, 848, 8, 8,
+	512, 856, 8, 8,
+	512, 848, 16, 8,
+	512, 856, 16, 8,
+	512, 848, 24, 8,
+	512, 856, 24, 8,
+	512, 848, 32, 8,
+	512, 856, 32, 8,
+	512, 848, 40, 8,
+	512, 856, 40, 8,
+	512, 856, 48, 8,
+	512, 856, 56, 8,
+	512, 856, 64, 8,
+	512, 856, 72, 8,
+	512, 856, 80, 8,
+	512, 848, 88, 8,
+	512, 856, 88, 8,
+	512, 840, 96, 8,
+	512, 848, 96, 8,
+	512, 856, 96, 8,
+	512, 832, 104, 8,
+	512, 840, 104, 8,
+	512, 848, 104, 8,
+	512, 824, 112, 8,
+	512, 832, 112, 8,
+	512, 840, 112, 8,
+	512, 816, 120, 8,
+	512, 824, 120, 8,
+	512, 832, 120, 8,
+	512, 808, 128, 8,
+	512, 816, 128, 8,
+	512, 824, 128, 8,
+	512, 808, 136, 8,
+	512, 816, 136, 8,
+	512, 800, 144, 8,
+	512, 808, 144, 8,
+	512, 792, 152, 8,
+	512, 800, 152, 8,
+	512, 792, 160, 8,
+	512, 800, 160, 8,
+	512, 784, 168, 8,
+	512, 792, 168, 8,
+	512, 784, 176, 8,
+	512, 792, 176, 8,
+	512, 776, 184, 8,
+	512, 784, 184, 8,
+	512, 776, 192, 8,
+	512, 768, 200, 8,
+	512, 776, 200, 8,
+	512, 768, 208, 8,
+	512, 776, 208, 8,
+	512, 768, 216, 8,
+	512, 760, 224, 8,
+	512, 768, 224, 8,
+	512, 760, 232, 8,
+	512, 768, 232, 8,
+	512, 760, 240, 8,
+	512, 752, 248, 8,
+	512, 760, 248, 8,
+	512, 752, 256, 8,
+	512, 760, 256, 8,
+	512, 752, 264, 8,
+	512, 752, 272, 8,
+	512, 744, 280, 8,
+	512, 752, 280, 8,
+	512, 744, 288, 8,
+	512, 752, 288, 8,
+	512, 744, 296, 8,
+	512, 736, 304, 8,
+	512, 744, 304, 8,
+	512, 736, 312, 8,
+	512, 744, 312, 8,
+	512, 736, 320, 8,
+	512, 744, 320, 8,
+	512, 736, 328, 8,
+	512, 736, 336, 8,
+	512, 736, 344, 8,
+	512, 744, 344, 8,
+	512, 736, 352, 8,
+	512, 744, 352, 8,
+	512, 736, 360, 8,
+	512, 744, 360, 8,
+	512, 744, 368, 8,
+	512, 744, 376, 8,
+	512, 744, 384, 8,
+	512, 752, 384, 8,
+	512, 744, 392, 8,
+	512, 752, 392, 8,
+	512, 752, 400, 8,
+	512, 760, 400, 8,
+	512, 760, 408, 8,
+	512, 768, 408, 8,
+	512, 768, 416, 8,
+	512, 776, 416, 8,
+	512, 784, 416, 8,
+	512, 776, 424, 8,
+	512, 784, 424, 8,
+	512, 768, 432, 8,
+	512, 776, 432, 8,
+	512, 760, 440, 8,
+	512, 768, 440, 8,
+	512, 776, 440, 8,
+	512, 744, 448, 8,
+	512, 752, 448, 8,
+	512, 760, 448, 8,
+	512, 768, 448, 8,
+	512, 736, 456, 8,
+	512, 744, 456, 8,
+	512, 752, 456, 8,
+	512, 728, 464, 8,
+	512, 736, 464, 8,
+	512, 744, 464, 8,
+	512, 720, 472, 8,
+	512, 728, 472, 8,
+	512, 736, 472, 8,
+	512, 712, 480, 8,
+	512, 720, 480, 8,
+	512, 728, 480, 8,
+	512, 704, 488, 8,
+	512, 712, 488, 8,
+	512, 720, 488, 8,
+	512, 704, 496, 8,
+	512, 712, 496, 8,
+	512, 696, 504, 8,
+	512, 704, 504, 8,
+};
@@ -46,7 +46,13 @@ int g_debugRayCastBuffer = -1;
 
 // ----------------------------------------------------------------------------
 
-bool Viewer_Initialise(const int worldBrickCountXZ, const glm::mat4& projection, const int numMaterials)
+bool Viewer_Initialise(
+	const int worldBrickCountXZ, 
+	const glm::mat4& projection, 
+	const int numMaterials, 
+	const int noiseSeed,
+	const std::string& worldFilePath,
+	const std::string& meshPackPath)
 {
 	printf("Viewer_Initialise\n");
 
@@ -61,16 +67,11 @@ bool Viewer_Initialise(const int worldBrickCountXZ, const glm::mat4& projection,
 	g_brushDrawBuffer = Render_AllocDebugDrawBuffer();
 	g_debugRayCastBuffer = Render_AllocDebugDrawBuffer();
 
-	const ivec3 worldOrigin(0);
-	const int BRICK_SIZE = 8;
-	const int worldSizeXZ = worldBrickCountXZ * BRICK_SIZE * CLIPMAP_LEAF_SIZE;
-	const int worldSizeY = 4 * BRICK_SIZE * CLIPMAP_LEAF_SIZE;
-	const ivec3 worldSize(worldSizeXZ, worldSizeY, worldSizeXZ);
-	const AABB worldBounds(worldOrigin - (worldSize / 2), worldOrigin + (worldSize / 2));
+	const AABB worldBounds = WorldBoundsForBrickCount(worldBrickCountXZ);
 
 	Render_SetWorldBounds(worldBounds.min, worldBounds.max);
 	Physics_Initialise(worldBounds);
-	g_volume.initialise(ivec3(Camera_GetPosition()), worldBounds);
+	g_volume.initialise(ivec3(Camera_GetPosition()), worldBounds, noiseSeed, worldFilePath, meshPackPath);
 	Actor_Initialise(worldBounds);
 
 	Physics_SpawnPlayer(vec3(-500.f, 4000.f, -500.f));
@@ -258,7 +259,8 @@ void Viewer_Update(const float deltaT, const ViewerMode viewerMode)
 	if (g_editContext.editMode != EditMode_Disabled)
 	{
 		const vec3 colour = g_editContext.editMode == EditMode_CSG ? RenderColour_Red : RenderColour_Green;
-		if (g_editContext.brushShape == RenderShape_Cube)
+		// there are only debug shapes for the cube and sphere
+		if (g_editContext.brushShape == CSGBrush_Cube || g_editContext.brushShape == CSGBrush_RoundedBox)
 		{
 			renderCmds.addCube(colour, 0.2f, brushPos - halfSize, g_editContext.brushSize.x);
 		}
@@ -317,8 +319,8 @@ void Viewer_CycleBrushMaterial(const bool cycleForwards)
 
 void Viewer_SelectNextBrush()
 {
-	// ugh
-	g_editContext.brushShape = RenderShape((g_editContext.brushShape + 1) % 2);
+	g_editContext.brushShape = CSGBrushShape((g_editContext.brushShape + 1) % CSGBrush_SIZE);
+	printf("Brush: %s\n", Compute_CSGBrushName(g_editContext.brushShape));
 }
 
 // ----------------------------------------------------------------------------
@@ -16,7 +16,13 @@ enum ViewerMode
 	ViewerMode_Collision,
 };
 
-bool		Viewer_Initialise(const int worldBrickCountXZ, const glm::mat4& projectionMatrix, const int numMaterials);
+bool		Viewer_Initialise(
+				const int worldBrickCountXZ, 
+				const glm::mat4& projectionMatrix, 
+				const int numMaterials, 
+				const int noiseSeed,
+				const std::string& worldFilePath,
+				const std::string& meshPackPath);
 void		Viewer_Shutdown();
 
 void		Viewer_Update(const float deltaT, const ViewerMode viewerMode);
@@ -62,7 +68,7 @@ struct EditContext
 	ivec3			brushSize { MIN_BRUSH_SIZE };
 	ivec3			brushPosition;
 	vec3			brushNormal;
-	RenderShape		brushShape = RenderShape_Cube;
+	CSGBrushShape	brushShape = CSGBrush_Cube;
 	int				brushMaterial = 0;
 };
 
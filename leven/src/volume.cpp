@@ -42,6 +42,18 @@ const ivec3 ChunkMinForPosition(const int x, const int y, const int z)
 
 // ----------------------------------------------------------------------------
 
+const AABB WorldBoundsForBrickCount(const int worldBrickCountXZ)
+{
+	const ivec3 worldOrigin(0);
+	const int BRICK_SIZE = 8;
+	const int worldSizeXZ = worldBrickCountXZ * BRICK_SIZE * CLIPMAP_LEAF_SIZE;
+	const int worldSizeY = 4 * BRICK_SIZE * CLIPMAP_LEAF_SIZE;
+	const ivec3 worldSize(worldSizeXZ, worldSizeY, worldSizeXZ);
+	return AABB(worldOrigin - (worldSize / 2), worldOrigin + (worldSize / 2));
+}
+
+// ----------------------------------------------------------------------------
+
 std::thread g_taskThread;
 std::atomic<bool> g_taskThreadQuit = false;
 
@@ -123,9 +135,20 @@ void ScheduleTask(TaskType type, TaskFunction task)
 
 // ----------------------------------------------------------------------------
 
-void Volume::initialise(const ivec3& cameraPosition, const AABB& worldBounds)
+void Volume::initialise(
+	const ivec3& cameraPosition, 
+	const AABB& worldBounds, 
+	const int noiseSeed,
+	const std::string& worldFilePath,
+	const std::string& meshPackPath)
 {
-	clipmap_.initialise(worldBounds);
+	worldFilePath_ = worldFilePath;
+	if (!worldFilePath_.empty())
+	{
+		Compute_OpenWorldFile(worldFilePath_);
+	}
+
+	clipmap_.initialise(worldBounds, noiseSeed, meshPackPath);
 
 	g_taskThreadQuit = false;
 	g_taskThread = std::thread(TaskThreadFunction);
@@ -144,6 +167,11 @@ void Volume::destroy()
 	g_taskCondition.notify_one();
 	g_taskThread.join();
 
+	if (!worldFilePath_.empty())
+	{
+		clipmap_.saveWorldFile(worldFilePath_);
+	}
+
 	clipmap_.clear();
 
 	Compute_ClearCSGOperations();
@@ -153,7 +181,7 @@ void Volume::destroy()
 
 void Volume::processCSGOperations()
 {
-	ScheduleTask(Task_CSG, std::bind(&Clipmap::processCSGOperations, clipmap_));
+	ScheduleTask(Task_CSG, std::bind(&Clipmap::processCSGOperations, &clipmap_));
 }
 
 // ----------------------------------------------------------------------------
@@ -161,7 +189,7 @@ void Volume::processCSGOperations()
 void Volume::applyCSGOperation(
 	const vec3& origin, 
 	const glm::vec3& brushSize, 
-	const RenderShape brushShape,
+	const CSGBrushShape brushShape,
 	const int brushMaterial, 
 	const bool rotateToCamera,
 	const bool isAddOperation)
@@ -7,6 +7,7 @@
 #include	<memory>
 #include	<mutex>
 #include	<functional>
+#include	<string>
 
 #include	<glm/glm.hpp>
 using glm::vec3;
@@ -29,13 +30,21 @@ using glm::ivec2;
 const ivec3 ChunkMinForPosition(const ivec3& p);
 const ivec3 ChunkMinForPosition(const int x, const int y, const int z);
 
+// the world is worldBrickCountXZ bricks wide and 4 bricks high, centred on the origin
+const AABB WorldBoundsForBrickCount(const int worldBrickCountXZ);
+
 // ----------------------------------------------------------------------------
 
 class Volume
 {
 public:
 
-	void initialise(const glm::ivec3& cameraPosition, const AABB& worldBounds);
+	void initialise(
+		const glm::ivec3& cameraPosition, 
+		const AABB& worldBounds, 
+		const int noiseSeed,
+		const std::string& worldFilePath,
+		const std::string& meshPackPath);
 	void destroy();
 
 	void updateChunkLOD(const glm::vec3& currentPos, const Frustum& frustum);
@@ -52,7 +61,7 @@ public:
 	void applyCSGOperation(
 		const vec3& origin, 
 		const glm::vec3& brushSize, 
-		const RenderShape renderShape,
+		const CSGBrushShape brushShape,
 		const int brushMaterial, 
 		const bool rotateToCamera,
 		const bool isAddOperation);
@@ -66,6 +75,7 @@ private:
 	void processCSGOperationsImpl();
 
 	Clipmap					clipmap_;
+	std::string				worldFilePath_;
 };
 
 #endif	//	HAS_VOLUME_H_BEEN_INCLUDED
@@ -7,8 +7,8 @@
 const int LEAF_SIZE_LOG2 = 2;
 const int LEAF_SIZE_SCALE = 1 << LEAF_SIZE_LOG2;
 
-// 64^3 or 128^3 seems a good size, 256^3 works
-// 512^3 and above starts running into problems with buffer sizes etc
+// 64^3 or 128^3 seems a good size, 256^3 works (the node codes are 64-bit)
+// 512^3 and above overflows the 32-bit edge indices
 // 64^3 seems to be preferable due to clipmap limations (can't display part of an octree) 
 // and CSG ops seem more responsive with 64^3 -- worth testing both when upgrading things in future
 const int CLIPMAP_VOXELS_PER_CHUNK = 64;
@@ -21,6 +21,10 @@ const int CLIPMAP_LEAF_SIZE = LEAF_SIZE_SCALE * CLIPMAP_VOXELS_PER_CHUNK;
 const int COLLISION_VOXELS_PER_CHUNK = 128 / 2;
 const int COLLISION_NODE_SIZE = CLIPMAP_LEAF_SIZE * (4 / 2);
 
+// the default number of LODs, ClipmapConfig can use up to MAX_LODS
+const int NUM_LODS = 6;
+const int MAX_LODS = 8;
+
 const glm::ivec3 CHILD_MIN_OFFSETS[] =
 {
 	// needs to match the vertMap from Dual Contouring impl
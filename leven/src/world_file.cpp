@@ -0,0 +1,267 @@
+#include	"world_file.h"
+
+#include	<stdio.h>
+#include	<algorithm>
+
+// ----------------------------------------------------------------------------
+
+bool WorldFile_RegionLess(const WorldFileRegion& a, const WorldFileRegion& b)
+{
+	if (a.voxelsPerChunk != b.voxelsPerChunk) return a.voxelsPerChunk < b.voxelsPerChunk;
+	if (a.size != b.size) return a.size < b.size;
+	if (a.min[0] != b.min[0]) return a.min[0] < b.min[0];
+	if (a.min[1] != b.min[1]) return a.min[1] < b.min[1];
+	return a.min[2] < b.min[2];
+}
+
+// ----------------------------------------------------------------------------
+
+// written so a corrupt offset or count can't overflow and wrap back inside the mapping
+static bool ExtentIsInside(const uint64_t offset, const uint64_t count, const uint64_t elementSize, const uint64_t mappingSize)
+{
+	return offset <= mappingSize && count <= ((mappingSize - offset) / elementSize);
+}
+
+// ----------------------------------------------------------------------------
+
+bool WorldFile::open(const std::string& path, const int noiseSeed, const u64 densityGraphHash)
+{
+	close();
+
+	if (!mapping_.open(path))
+	{
+		return false;
+	}
+
+	if (mapping_.size() < sizeof(WorldFileHeader))
+	{
+		printf("WorldFile: '%s' is truncated\n", path.c_str());
+		mapping_.close();
+		return false;
+	}
+
+	const WorldFileHeader* header = (const WorldFileHeader*)mapping_.data();
+	if (header->magic != WORLD_FILE_MAGIC || header->version != WORLD_FILE_VERSION)
+	{
+		printf("WorldFile: '%s' is not a valid world file (version=%d)\n", path.c_str(), header->version);
+		mapping_.close();
+		return false;
+	}
+
+	if (header->noiseSeed != noiseSeed || header->densityGraphHash != densityGraphHash)
+	{
+		// the baked regions are only valid for the seed and graph they were generated with
+		printf("WorldFile: '%s' was saved with seed %d and graph %016llx, ignoring\n", 
+			path.c_str(), header->noiseSeed, (unsigned long long)header->densityGraphHash);
+		mapping_.close();
+		return false;
+	}
+
+	const uint64_t mappingSize = mapping_.size();
+	if (!ExtentIsInside(header->opLogOffset, header->numOps, sizeof(WorldFileOp), mappingSize) ||
+		!ExtentIsInside(header->regionIndexOffset, header->numRegions, sizeof(WorldFileRegion), mappingSize))
+	{
+		printf("WorldFile: '%s' is truncated\n", path.c_str());
+		mapping_.close();
+		return false;
+	}
+
+	// the region data is uploaded straight from the mapping, see LoadBakedDensityField
+	const WorldFileRegion* regions = (const WorldFileRegion*)(mapping_.data() + header->regionIndexOffset);
+	for (uint32_t i = 0; i < header->numRegions; i++)
+	{
+		const WorldFileRegion& region = regions[i];
+		if (!ExtentIsInside(region.materialsOffset, region.materialsSize, 1, mappingSize) ||
+			!ExtentIsInside(region.edgeIndicesOffset, region.numEdges, sizeof(int32_t), mappingSize) ||
+			!ExtentIsInside(region.normalsOffset, region.numEdges, sizeof(glm::vec4), mappingSize))
+		{
+			printf("WorldFile: '%s' is truncated or corrupt (region %d)\n", path.c_str(), i);
+			mapping_.close();
+			return false;
+		}
+	}
+
+	header_ = header;
+	printf("WorldFile: opened '%s' ops=%d regions=%d\n", path.c_str(), header_->numOps, header_->numRegions);
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void WorldFile::close()
+{
+	header_ = nullptr;
+	mapping_.close();
+}
+
+// ----------------------------------------------------------------------------
+
+const WorldFileOp* WorldFile::ops() const
+{
+	if (!header_)
+	{
+		return nullptr;
+	}
+
+	return (const WorldFileOp*)(mapping_.data() + header_->opLogOffset);
+}
+
+// ----------------------------------------------------------------------------
+
+const WorldFileRegion* WorldFile::regions() const
+{
+	if (!header_)
+	{
+		return nullptr;
+	}
+
+	return (const WorldFileRegion*)(mapping_.data() + header_->regionIndexOffset);
+}
+
+// ----------------------------------------------------------------------------
+
+const WorldFileRegion* WorldFile::findRegion(
+	const glm::ivec3& min, 
+	const int size, 
+	const int voxelsPerChunk) const
+{
+	if (!header_ || header_->numRegions == 0)
+	{
+		return nullptr;
+	}
+
+	WorldFileRegion key;
+	key.min[0] = min.x;
+	key.min[1] = min.y;
+	key.min[2] = min.z;
+	key.size = size;
+	key.voxelsPerChunk = voxelsPerChunk;
+
+	// binary search the index so only the index pages on the search path are touched
+	const WorldFileRegion* first = regions();
+	const WorldFileRegion* last = first + header_->numRegions;
+	const WorldFileRegion* iter = std::lower_bound(first, last, key, WorldFile_RegionLess);
+	if (iter == last || WorldFile_RegionLess(key, *iter))
+	{
+		return nullptr;
+	}
+
+	return iter;
+}
+
+// ----------------------------------------------------------------------------
+
+static uint64_t AlignOffset(const uint64_t offset)
+{
+	return (offset + (WORLD_FILE_ALIGNMENT - 1)) & ~(WORLD_FILE_ALIGNMENT - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool WriteAt(FILE* file, uint64_t& fileOffset, const uint64_t offset, const void* data, const uint64_t size)
+{
+	static const char zeros[WORLD_FILE_ALIGNMENT] = { 0 };
+
+	while (fileOffset < offset)
+	{
+		const uint64_t padding = std::min<uint64_t>(offset - fileOffset, WORLD_FILE_ALIGNMENT);
+		if (fwrite(zeros, 1, padding, file) != padding)
+		{
+			return false;
+		}
+
+		fileOffset += padding;
+	}
+
+	if (size > 0 && fwrite(data, 1, size, file) != size)
+	{
+		return false;
+	}
+
+	fileOffset += size;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool WorldFile_Write(
+	const std::string& path, 
+	const int noiseSeed,
+	const u64 densityGraphHash,
+	const std::vector<WorldFileOp>& ops,
+	std::vector<WorldFileRegionData>& regions)
+{
+	std::sort(begin(regions), end(regions), 
+		[](const WorldFileRegionData& a, const WorldFileRegionData& b)
+		{
+			return WorldFile_RegionLess(a.region, b.region);
+		});
+
+	WorldFileHeader header;
+	header.noiseSeed = noiseSeed;
+	header.densityGraphHash = densityGraphHash;
+	header.numOps = ops.size();
+	header.numRegions = regions.size();
+	header.opLogOffset = AlignOffset(sizeof(WorldFileHeader));
+	header.regionIndexOffset = AlignOffset(header.opLogOffset + (ops.size() * sizeof(WorldFileOp)));
+
+	// each region's data starts on a new page so loading it never touches the neighbouring regions
+	uint64_t dataOffset = AlignOffset(header.regionIndexOffset + (regions.size() * sizeof(WorldFileRegion)));
+	std::vector<WorldFileRegion> index(regions.size());
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		WorldFileRegion& region = regions[i].region;
+		const uint64_t edgeIndicesSize = region.numEdges * sizeof(int32_t);
+
+		region.materialsOffset = dataOffset;
+		region.edgeIndicesOffset = AlignOffset(region.materialsOffset + region.materialsSize);
+		region.normalsOffset = region.edgeIndicesOffset + edgeIndicesSize;
+		dataOffset = AlignOffset(region.normalsOffset + (region.numEdges * sizeof(glm::vec4)));
+
+		index[i] = region;
+	}
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		printf("WorldFile: unable to open '%s' for writing\n", path.c_str());
+		return false;
+	}
+
+	uint64_t fileOffset = 0;
+	bool success = WriteAt(file, fileOffset, 0, &header, sizeof(header));
+	if (success && !ops.empty())
+	{
+		success = WriteAt(file, fileOffset, header.opLogOffset, &ops[0], ops.size() * sizeof(WorldFileOp));
+	}
+
+	if (success && !index.empty())
+	{
+		success = WriteAt(file, fileOffset, header.regionIndexOffset, &index[0], index.size() * sizeof(WorldFileRegion));
+	}
+
+	for (size_t i = 0; success && i < regions.size(); i++)
+	{
+		const WorldFileRegionData& data = regions[i];
+		const WorldFileRegion& region = data.region;
+
+		success = 
+			WriteAt(file, fileOffset, region.materialsOffset, data.materials, region.materialsSize) &&
+			WriteAt(file, fileOffset, region.edgeIndicesOffset, data.edgeIndices, region.numEdges * sizeof(int32_t)) &&
+			WriteAt(file, fileOffset, region.normalsOffset, data.normals, region.numEdges * sizeof(glm::vec4));
+	}
+
+	fclose(file);
+
+	if (!success)
+	{
+		printf("WorldFile: error writing '%s'\n", path.c_str());
+		remove(path.c_str());
+	}
+
+	return success;
+}
+
+// ----------------------------------------------------------------------------
+
@@ -0,0 +1,115 @@
+#ifndef		HAS_WORLD_FILE_H_BEEN_INCLUDED
+#define		HAS_WORLD_FILE_H_BEEN_INCLUDED
+
+#include	"compute.h"
+#include	"file_utils.h"
+#include	"aabb.h"
+
+#include	<string>
+#include	<vector>
+#include	<glm/glm.hpp>
+
+// ----------------------------------------------------------------------------
+// The world file stores the edits made to a world so they survive a restart.
+// The file is memory mapped and everything after the header is page aligned:
+//
+//		WorldFileHeader
+//		WorldFileOp[numOps]				the CSG op log, in the order the ops were applied
+//		WorldFileRegion[numRegions]		index table, sorted with WorldFile_RegionLess
+//		region data						baked materials, edge indices and normals
+//
+// The baked regions are density fields which already have the ops up to
+// lastCSGOperation applied, so loading a region only replays the newer ops and
+// only the pages for the regions that are requested are ever read.
+// ----------------------------------------------------------------------------
+
+const uint32_t WORLD_FILE_MAGIC = 0x574e564c;		// "LVNW"
+const uint32_t WORLD_FILE_VERSION = 3;		// 2: bricked field layout, 3: density graph hash
+const uint64_t WORLD_FILE_ALIGNMENT = 4096;
+
+struct WorldFileHeader
+{
+	uint32_t		magic = WORLD_FILE_MAGIC;
+	uint32_t		version = WORLD_FILE_VERSION;
+	int32_t			noiseSeed = 0;
+	uint32_t		numOps = 0;
+	uint32_t		numRegions = 0;
+	uint32_t		pad = 0;
+	uint64_t		opLogOffset = 0;
+	uint64_t		regionIndexOffset = 0;
+	uint64_t		densityGraphHash = 0;	// see Compute_DensityGraphHash
+};
+
+struct WorldFileOp
+{
+	CSGOperationInfo	info;
+	AABB				aabb;
+};
+
+struct WorldFileRegion
+{
+	int32_t			min[3];
+	int32_t			size = 0;
+	int32_t			voxelsPerChunk = 0;
+	int32_t			lastCSGOperation = 0;
+	uint32_t		numEdges = 0;
+	uint32_t		materialsSize = 0;
+	uint64_t		materialsOffset = 0;
+	uint64_t		edgeIndicesOffset = 0;
+	uint64_t		normalsOffset = 0;
+};
+
+bool WorldFile_RegionLess(const WorldFileRegion& a, const WorldFileRegion& b);
+
+// ----------------------------------------------------------------------------
+
+class WorldFile
+{
+public:
+
+	bool open(const std::string& path, const int noiseSeed, const u64 densityGraphHash);
+	void close();
+
+	bool isOpen() const { return header_ != nullptr; }
+
+	int numOps() const { return header_ ? header_->numOps : 0; }
+	const WorldFileOp* ops() const;
+
+	int numRegions() const { return header_ ? header_->numRegions : 0; }
+	const WorldFileRegion* regions() const;
+
+	const WorldFileRegion* findRegion(
+		const glm::ivec3& min, 
+		const int size, 
+		const int voxelsPerChunk) const;
+
+	const void* regionData(const uint64_t offset) const { return mapping_.data() + offset; }
+
+private:
+
+	MappedFile				mapping_;
+	const WorldFileHeader*	header_ = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+
+// the data pointers only need to remain valid for the duration of WorldFile_Write,
+// the offsets in the region are calculated when the file is written
+struct WorldFileRegionData
+{
+	WorldFileRegion		region;
+	const void*			materials = nullptr;
+	const void*			edgeIndices = nullptr;
+	const void*			normals = nullptr;
+};
+
+bool WorldFile_Write(
+	const std::string& path, 
+	const int noiseSeed,
+	const u64 densityGraphHash,
+	const std::vector<WorldFileOp>& ops,
+	std::vector<WorldFileRegionData>& regions);
+
+// ----------------------------------------------------------------------------
+
+#endif	//	HAS_WORLD_FILE_H_BEEN_INCLUDED